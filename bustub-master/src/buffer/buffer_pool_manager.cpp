@@ -17,6 +17,8 @@
 
 namespace bustub {
 
+thread_local BufferPoolStats *BufferPoolManager::thread_stats_ = nullptr;
+
 BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager)
     : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
   // We allocate a consecutive memory space for the buffer pool.
@@ -30,11 +32,12 @@ BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager
 }
 
 BufferPoolManager::~BufferPoolManager() {
+  StopBackgroundWriter();
   delete[] pages_;
   delete replacer_;
 }
 
-Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) {
+Page *BufferPoolManager::FetchPageImpl(page_id_t page_id, BufferRing *ring, std::shared_future<void> *ready) {
   // 1.     Search the page table for the requested page (P).
   // 1.1    If P exists, pin it and return it immediately.
   // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
@@ -42,69 +45,82 @@ Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) {
   // 2.     If R is dirty, write it back to the disk.
   // 3.     Delete R from the page table and insert P.
   // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  std::lock_guard<std::mutex> lock(latch_);
+  std::unique_lock<std::mutex> lock(latch_);
+  BufferPoolStats *stats = thread_stats_;
+  if (ready != nullptr) {
+    *ready = std::shared_future<void>();
+  }
+  if (stats != nullptr) {
+    stats->fetches_++;
+  }
 
   // 如果页表中存在该页
-  if (page_table_.find(page_id) != page_table_.end()) {
-      frame_id_t frame_id = page_table_[page_id];
+  auto iter = page_table_.find(page_id);
+  if (iter != page_table_.end()) {
+      frame_id_t frame_id = iter->second;
       pages_[frame_id].pin_count_++;
+      replacer_->Pin(frame_id);
+      // The page may still be on its way from disk, see FetchPageAsync().
+      auto read = reads_.find(frame_id);
+      if (read != reads_.end()) {
+        if (read->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+          reads_.erase(read);
+        } else if (ready != nullptr) {
+          *ready = read->second;
+        } else {
+          std::shared_future<void> pending = read->second;
+          lock.unlock();
+          pending.wait();
+        }
+      }
       return pages_ + frame_id;
   }
-  else {
-      frame_id_t frame = -1;
-      if (!free_list_.empty()) {
-          frame = free_list_.front();
-          free_list_.pop_front();
-      }
-      else {
-          // replacer中没有淘汰页
-          if (!replacer_->Victim(&frame))
-              return nullptr;
-      }
-
-      page_id_t old_page_id = -1;
-      for (auto iter = page_table_.begin(); iter != page_table_.end(); ++iter) {
-          if (iter->second == frame) {
-              old_page_id = iter->first;
-              page_table_.erase(iter);
-              break;
-          }
-      }
-      page_table_[page_id] = frame;
-      // 将脏页写回硬盘
-      if (old_page_id != -1 && pages_[frame].is_dirty_) {
-          lsn_t page_lsn = pages_[frame].GetLSN();
-          while (page_lsn < log_manager_->GetPersistentLSN())
-            log_manager_->ForceFlush();
-
-          disk_manager_->WritePage(old_page_id, pages_[frame].data_);
-      }
+  if (stats != nullptr) {
+    stats->misses_++;
+  }
 
-      // 更新页面信息
-      pages_[frame].is_dirty_ = false;
-      pages_[frame].page_id_ = page_id;
-      pages_[frame].pin_count_ = 1;
-      // 从硬盘读取信息到内存页
-      disk_manager_->ReadPage(page_id, pages_[frame].data_);
-      return pages_ + frame;
+  frame_id_t frame = -1;
+  if (ring == nullptr || !GetRingFrame(ring, page_id, &frame)) {
+    if (!GetFreeFrame(&frame))
+        return nullptr;
+    if (ring != nullptr) {
+      ring->frames_[ring->next_] = frame;
+      ring->page_ids_[ring->next_] = page_id;
+      ring->next_ = (ring->next_ + 1) % ring->frames_.size();
+    }
   }
+  page_table_[page_id] = frame;
 
-  return nullptr;
+  // 更新页面信息
+  pages_[frame].is_dirty_ = false;
+  pages_[frame].page_id_ = page_id;
+  pages_[frame].pin_count_ = 1;
+  // 从硬盘读取信息到内存页
+  if (ready == nullptr) {
+    disk_manager_->ReadPage(page_id, pages_[frame].data_);
+  } else {
+    *ready = disk_manager_->ReadPageAsync(page_id, pages_[frame].data_);
+    reads_[frame] = *ready;
+  }
+  return pages_ + frame;
 }
 
 bool BufferPoolManager::UnpinPageImpl(page_id_t page_id, bool is_dirty) {
     std::lock_guard<std::mutex> lock(latch_);
-        
-    frame_id_t frame_id = page_table_[page_id];
+
+    auto iter = page_table_.find(page_id);
+    if (iter == page_table_.end())
+        return false;
+    frame_id_t frame_id = iter->second;
     if (pages_[frame_id].pin_count_ <= 0)
         return false;
 
-    pages_[frame_id].is_dirty_ = is_dirty;
+    // 只有写回硬盘才能清除脏标记
+    pages_[frame_id].is_dirty_ = pages_[frame_id].is_dirty_ || is_dirty;
     pages_[frame_id].pin_count_--;
 
     // 如果pin count为0,将该frame放到replacer
     if (pages_[frame_id].pin_count_ == 0) {
-        // std::cout << "replacer Unpin: " << frame_id << std::endl;
         replacer_->Unpin(frame_id);
     }
     return true;
@@ -116,16 +132,12 @@ bool BufferPoolManager::FlushPageImpl(page_id_t page_id) {
   if (page_id == INVALID_PAGE_ID)
       return false;
 
-  if (page_table_.find(page_id) != page_table_.end()) {
-      frame_id_t frame_id = page_table_[page_id];
-      if (pages_[frame_id].is_dirty_) {
-          lsn_t page_lsn = pages_[frame_id].GetLSN();
-          while (page_lsn < log_manager_->GetPersistentLSN())
-            log_manager_->ForceFlush();
-
-          disk_manager_->WritePage(page_id, pages_[frame_id].data_);
-          pages_[frame_id].is_dirty_ = false;
-      }
+  std::lock_guard<std::mutex> lock(latch_);
+  auto iter = page_table_.find(page_id);
+  if (iter == page_table_.end())
+      return false;
+  if (pages_[iter->second].is_dirty_) {
+      WriteBack(page_id, iter->second);
   }
   return true;
 }
@@ -138,37 +150,12 @@ Page *BufferPoolManager::NewPageImpl(page_id_t *page_id) {
   // 4.   Set the page ID output parameter. Return a pointer to P.
   std::lock_guard<std::mutex> lock(latch_);
 
-  *page_id = disk_manager_->AllocatePage();
   frame_id_t frame = -1;
+  if (!GetFreeFrame(&frame))
+      return nullptr;
 
-  // 查看free_list是否有可以用页
-  if (!free_list_.empty()) {
-      frame = free_list_.front();
-      free_list_.pop_front();
-  }
-  else {
-      // replacer中没有淘汰页
-      if (!replacer_->Victim(&frame))
-          return nullptr;
-  }
-
-
-  page_id_t old_page_id = -1;
-  for (auto iter = page_table_.begin(); iter != page_table_.end(); ++iter) {
-      if (iter->second == frame) {
-            old_page_id = iter->first;
-            page_table_.erase(iter);
-            break;
-      }
-  }
+  *page_id = disk_manager_->AllocatePage();
   page_table_[*page_id] = frame;
-  if (old_page_id != -1 && pages_[frame].is_dirty_) {
-      lsn_t page_lsn = pages_[frame].GetLSN();
-      while (page_lsn < log_manager_->GetPersistentLSN())
-        log_manager_->ForceFlush();
-
-      disk_manager_->WritePage(old_page_id, pages_[frame].data_);
-  }
 
   // 更新页面信息
   pages_[frame].is_dirty_ = false;
@@ -187,18 +174,26 @@ bool BufferPoolManager::DeletePageImpl(page_id_t page_id) {
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
   std::lock_guard<std::mutex> lock(latch_);
 
-  if (page_table_.find(page_id) == page_table_.end())
+  auto iter = page_table_.find(page_id);
+  if (iter == page_table_.end()) {
+      disk_manager_->DeallocatePage(page_id);
       return true;
+  }
 
-  frame_id_t frame_id = page_table_[page_id];
-  if (pages_[frame_id].pin_count_)
+  frame_id_t frame_id = iter->second;
+  if (pages_[frame_id].pin_count_ > 0)
       return false;
-  else {
-      page_table_.erase(page_id);
-      pages_[frame_id].ResetMemory();
-      free_list_.push_back(frame_id);
-      return true;
-  }
+
+  // 从replacer中移除,避免该frame同时出现在free list和replacer中
+  replacer_->Pin(frame_id);
+  FinishRead(frame_id);
+  page_table_.erase(iter);
+  pages_[frame_id].page_id_ = INVALID_PAGE_ID;
+  pages_[frame_id].is_dirty_ = false;
+  pages_[frame_id].ResetMemory();
+  free_list_.push_back(frame_id);
+  disk_manager_->DeallocatePage(page_id);
+  return true;
 }
 
 void BufferPoolManager::FlushAllPagesImpl() {
@@ -206,14 +201,116 @@ void BufferPoolManager::FlushAllPagesImpl() {
   std::lock_guard<std::mutex> lock(latch_);
   for (const auto &e : page_table_) {
       if (pages_[e.second].is_dirty_) {
-          lsn_t page_lsn = pages_[e.second].GetLSN();
-          while (page_lsn > log_manager_->GetPersistentLSN())
-            log_manager_->ForceFlush();
+          WriteBack(e.first, e.second);
+      }
+  }
+}
+
+bool BufferPoolManager::GetFreeFrame(frame_id_t *frame_id) {
+  // 查看free_list是否有可以用页
+  if (!free_list_.empty()) {
+      *frame_id = free_list_.front();
+      free_list_.pop_front();
+      return true;
+  }
+  // replacer中没有淘汰页
+  if (!replacer_->Victim(frame_id))
+      return false;
+
+  FinishRead(*frame_id);
+  Page *victim = pages_ + *frame_id;
+  // 将脏页写回硬盘
+  if (victim->is_dirty_) {
+      WriteBack(victim->page_id_, *frame_id);
+  }
+  page_table_.erase(victim->page_id_);
+  return true;
+}
+
+bool BufferPoolManager::GetRingFrame(BufferRing *ring, page_id_t page_id, frame_id_t *frame_id) {
+  size_t slot = ring->next_;
+  frame_id_t frame = ring->frames_[slot];
+  if (frame == -1 || pages_[frame].page_id_ != ring->page_ids_[slot] || pages_[frame].pin_count_ > 0) {
+    return false;
+  }
+  // Take the frame out of the replacer and evict its page, like GetFreeFrame does for a victim.
+  replacer_->Pin(frame);
+  FinishRead(frame);
+  if (pages_[frame].is_dirty_) {
+    WriteBack(pages_[frame].page_id_, frame);
+  }
+  page_table_.erase(pages_[frame].page_id_);
+  ring->page_ids_[slot] = page_id;
+  ring->next_ = (slot + 1) % ring->frames_.size();
+  *frame_id = frame;
+  return true;
+}
+
+void BufferPoolManager::FinishRead(frame_id_t frame_id) {
+  auto read = reads_.find(frame_id);
+  if (read != reads_.end()) {
+    // Unpinned, so whoever fetched the page waited for the read already.
+    read->second.wait();
+    reads_.erase(read);
+  }
+}
 
-          disk_manager_->WritePage(e.first, pages_[e.second].data_);
-          pages_[e.second].is_dirty_ = false;
+void BufferPoolManager::StartBackgroundWriter(std::chrono::milliseconds interval) {
+  StopBackgroundWriter();
+  background_writer_ = TaskPool::GetShared()->SchedulePeriodic(interval, [this] { WriteBackUnpinned(); });
+}
+
+void BufferPoolManager::StopBackgroundWriter() {
+  TaskPool::GetShared()->CancelPeriodic(background_writer_);
+  background_writer_ = TaskPool::NO_PERIODIC_TASK;
+}
+
+void BufferPoolManager::WriteBackUnpinned() {
+  std::vector<std::pair<page_id_t, frame_id_t>> dirty;
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    for (const auto &entry : page_table_) {
+      if (pages_[entry.second].is_dirty_ && pages_[entry.second].pin_count_ == 0) {
+        dirty.emplace_back(entry);
       }
+    }
+  }
+  for (const auto &entry : dirty) {
+    Page *page = &pages_[entry.second];
+    {
+      std::lock_guard<std::mutex> lock(latch_);
+      // The page may have been evicted, pinned or written since.
+      auto iter = page_table_.find(entry.first);
+      if (iter == page_table_.end() || iter->second != entry.second || !page->is_dirty_ || page->pin_count_ > 0) {
+        continue;
+      }
+      // Pin the frame so that it is not recycled during the write. The dirty flag is cleared first: a change made
+      // from now on is either in the write, as writers hold the write latch, or followed by a dirty unpin.
+      page->pin_count_++;
+      replacer_->Pin(entry.second);
+      page->is_dirty_ = false;
+    }
+    page->RLatch();
+    if (enable_logging && log_manager_ != nullptr) {
+      while (page->GetLSN() > log_manager_->GetPersistentLSN()) {
+        log_manager_->ForceFlush();
+      }
+    }
+    disk_manager_->WritePage(entry.first, page->GetData());
+    page->RUnlatch();
+    UnpinPageImpl(entry.first, false);
+    num_background_writes_++;
+  }
+}
+
+void BufferPoolManager::WriteBack(page_id_t page_id, frame_id_t frame_id) {
+  // WAL: 页面的日志必须先于页面落盘
+  if (enable_logging && log_manager_ != nullptr) {
+      while (pages_[frame_id].GetLSN() > log_manager_->GetPersistentLSN())
+          log_manager_->ForceFlush();
   }
+  disk_manager_->WritePage(page_id, pages_[frame_id].data_);
+  pages_[frame_id].is_dirty_ = false;
 }
 
 }  // namespace bustub
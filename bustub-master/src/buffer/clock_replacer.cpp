@@ -26,6 +26,8 @@ bool ClockReplacer::Victim(frame_id_t *frame_id) {
         return false;
 
     while (true) {
+        if (static_cast<size_t>(cur_ptr_) >= clock_set_.size())
+            cur_ptr_ = 0;
         if (clock_set_[cur_ptr_].second == 0) {
             *frame_id = clock_set_[cur_ptr_].first;
             clock_set_.erase((clock_set_.begin() + cur_ptr_));
@@ -43,7 +45,9 @@ void ClockReplacer::Pin(frame_id_t frame_id) {
     for (unsigned long i = 0; i < clock_set_.size(); i++) {
         if (clock_set_[i].first == frame_id) {
             clock_set_.erase(clock_set_.begin() + i);
-            cur_ptr_ = i;
+            // 保持时钟指针指向同一个frame
+            if (i < static_cast<unsigned long>(cur_ptr_))
+                cur_ptr_--;
             return;
         }
     }
@@ -0,0 +1,461 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// materialized_view.cpp
+//
+// Identification: src/catalog/materialized_view.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "catalog/materialized_view.h"
+
+#include <string>
+#include <utility>
+
+#include "common/exception.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return the type of the stored state of an aggregate, which AggregationExecutor starts at an INTEGER */
+TypeId StateType(AggregationType agg_type, const AbstractExpression *input) {
+  TypeId type = input->GetReturnType();
+  if (agg_type == AggregationType::CountAggregate || (type != TypeId::BIGINT && type != TypeId::DECIMAL)) {
+    return TypeId::INTEGER;
+  }
+  return type;
+}
+
+bool IsTrue(CmpBool cmp) { return cmp == CmpBool::CmpTrue; }
+
+}  // namespace
+
+MaterializedView::MaterializedView(const AggregationPlanNode *plan, TableHeap *base, const Schema *base_schema,
+                                   TableHeap *storage, Transaction *txn)
+    : plan_(plan), base_(base), base_schema_(base_schema), storage_(storage), storage_schema_(StorageSchema(plan)) {
+  CheckPlan(plan);
+  // Fill the view as if one transaction inserted every row of the base table.
+  Deltas deltas;
+  AggregateKey key;
+  std::vector<Value> inputs;
+  for (auto it = base_->Begin(txn); it != base_->End(); ++it) {
+    if (Evaluate(*it, &key, &inputs)) {
+      Combine(&deltas, key, inputs, 1);
+    }
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  if (txn->GetState() == TransactionState::ABORTED) {
+    // The scan ended early; fill the view once it can be rebuilt.
+    stale_ = true;
+    return;
+  }
+  Apply(deltas);
+}
+
+uint32_t MaterializedView::CheckPlan(const AggregationPlanNode *plan) {
+  if (plan->GetChildPlan()->GetType() != PlanType::SeqScan) {
+    throw Exception(ExceptionType::NOT_IMPLEMENTED, "A materialized view must aggregate a sequential scan.");
+  }
+  if (plan->GetSampleRate() < 1) {
+    throw Exception(ExceptionType::NOT_IMPLEMENTED, "A materialized view cannot sample its input.");
+  }
+  for (const auto &agg_type : plan->GetAggregateTypes()) {
+    if (agg_type != AggregationType::CountAggregate && agg_type != AggregationType::SumAggregate &&
+        agg_type != AggregationType::MinAggregate && agg_type != AggregationType::MaxAggregate) {
+      throw Exception(ExceptionType::NOT_IMPLEMENTED, "A materialized view only maintains COUNT, SUM, MIN and MAX.");
+    }
+  }
+  return static_cast<const SeqScanPlanNode *>(plan->GetChildPlan())->GetTableOid();
+}
+
+Schema MaterializedView::StorageSchema(const AggregationPlanNode *plan) {
+  std::vector<Column> columns;
+  for (uint32_t i = 0; i < plan->GetGroupBys().size(); i++) {
+    TypeId type = plan->GetGroupByAt(i)->GetReturnType();
+    std::string name = "group_" + std::to_string(i);
+    if (type == TypeId::VARCHAR) {
+      columns.emplace_back(name, type, VARCHAR_LENGTH);
+    } else {
+      columns.emplace_back(name, type);
+    }
+  }
+  const auto &agg_types = plan->GetAggregateTypes();
+  for (uint32_t i = 0; i < agg_types.size(); i++) {
+    columns.emplace_back("agg_" + std::to_string(i), StateType(agg_types[i], plan->GetAggregateAt(i)));
+  }
+  for (uint32_t i = 0; i < agg_types.size(); i++) {
+    columns.emplace_back("nulls_" + std::to_string(i), TypeId::INTEGER);
+  }
+  columns.emplace_back("count", TypeId::INTEGER);
+  return Schema(columns);
+}
+
+size_t MaterializedView::GetNumGroups() {
+  std::lock_guard<std::mutex> guard(latch_);
+  Refresh();
+  return groups_.size();
+}
+
+bool MaterializedView::Lookup(const std::vector<Value> &group_bys, std::vector<Value> *aggregates) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!Refresh()) {
+    throw Exception("The materialized view is stale until no transaction changes its base table.");
+  }
+  auto group = groups_.find(AggregateKey{group_bys});
+  if (group == groups_.end()) {
+    return false;
+  }
+  GroupState state;
+  if (!ReadGroup(group->second, &state)) {
+    throw Exception("The materialized view could not read a group.");
+  }
+  Finalize(state, aggregates);
+  return true;
+}
+
+bool MaterializedView::Snapshot(Transaction *txn, std::vector<Group> *groups) {
+  std::lock_guard<std::mutex> guard(latch_);
+  groups->clear();
+  if (!Refresh()) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  groups->reserve(groups_.size());
+  for (auto iter = storage_->Begin(txn); iter != storage_->End(); ++iter) {
+    groups->emplace_back();
+    SplitRow(*iter, &groups->back().group_bys_, &groups->back().aggregates_);
+  }
+  // The iterator ends early if a page cannot be read or a row cannot be locked.
+  return groups->size() == groups_.size();
+}
+
+void MaterializedView::SplitRow(const Tuple &row, std::vector<Value> *group_bys, std::vector<Value> *aggregates) const {
+  GroupState state;
+  ParseRow(row, group_bys, &state);
+  Finalize(state, aggregates);
+}
+
+bool MaterializedView::Evaluate(const Tuple &row, AggregateKey *key, std::vector<Value> *inputs) const {
+  const auto *scan_plan = static_cast<const SeqScanPlanNode *>(plan_->GetChildPlan());
+  if (scan_plan->GetPredicate() != nullptr && !scan_plan->GetPredicate()->Evaluate(&row, base_schema_).GetAs<bool>()) {
+    return false;
+  }
+  // Project the row like the scan does, then evaluate the aggregation on the projected tuple.
+  const Schema *scan_schema = scan_plan->OutputSchema();
+  std::vector<Value> values;
+  values.reserve(scan_schema->GetColumnCount());
+  for (const auto &col : scan_schema->GetColumns()) {
+    values.push_back(col.GetExpr()->Evaluate(&row, base_schema_));
+  }
+  Tuple scanned(values, scan_schema);
+  key->group_bys_.clear();
+  for (const auto &expr : plan_->GetGroupBys()) {
+    key->group_bys_.push_back(expr->Evaluate(&scanned, scan_schema));
+  }
+  inputs->clear();
+  for (const auto &expr : plan_->GetAggregates()) {
+    inputs->push_back(expr->Evaluate(&scanned, scan_schema));
+  }
+  return true;
+}
+
+MaterializedView::GroupState MaterializedView::InitialState() const {
+  GroupState state;
+  for (const auto &agg_type : plan_->GetAggregateTypes()) {
+    switch (agg_type) {
+      case AggregationType::MinAggregate:
+        state.values_.push_back(ValueFactory::GetIntegerValue(BUSTUB_INT32_MAX));
+        break;
+      case AggregationType::MaxAggregate:
+        state.values_.push_back(ValueFactory::GetIntegerValue(BUSTUB_INT32_MIN));
+        break;
+      default:
+        state.values_.push_back(ValueFactory::GetIntegerValue(0));
+        break;
+    }
+    state.nulls_.push_back(0);
+    state.removed_.push_back(ValueFactory::GetNullValueByType(TypeId::INTEGER));
+  }
+  return state;
+}
+
+void MaterializedView::Combine(Deltas *deltas, const AggregateKey &key, const std::vector<Value> &inputs,
+                               int32_t sign) const {
+  auto it = deltas->find(key);
+  if (it == deltas->end()) {
+    it = deltas->emplace(key, InitialState()).first;
+  }
+  GroupState *delta = &it->second;
+  delta->count_ += sign;
+  const auto &agg_types = plan_->GetAggregateTypes();
+  for (uint32_t i = 0; i < agg_types.size(); i++) {
+    const Value &input = inputs[i];
+    Value *value = &delta->values_[i];
+    if (agg_types[i] == AggregationType::CountAggregate) {
+      // Count counts every row, like AggregationExecutor.
+      *value = value->Add(ValueFactory::GetIntegerValue(sign));
+      continue;
+    }
+    if (input.IsNull()) {
+      delta->nulls_[i] += sign;
+      continue;
+    }
+    Value *removed = &delta->removed_[i];
+    switch (agg_types[i]) {
+      case AggregationType::SumAggregate:
+        *value = sign > 0 ? value->Add(input) : value->Subtract(input);
+        break;
+      case AggregationType::MinAggregate:
+        if (sign > 0) {
+          *value = value->Min(input);
+        } else {
+          *removed = removed->IsNull() ? input : removed->Min(input);
+        }
+        break;
+      case AggregationType::MaxAggregate:
+        if (sign > 0) {
+          *value = value->Max(input);
+        } else {
+          *removed = removed->IsNull() ? input : removed->Max(input);
+        }
+        break;
+      default:
+        UNREACHABLE("CheckPlan() rejects the other aggregates.");
+    }
+  }
+}
+
+void MaterializedView::Record(const Tuple &row, int32_t sign, Transaction *txn) {
+  AggregateKey key;
+  std::vector<Value> inputs;
+  if (!Evaluate(row, &key, &inputs)) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  txn_id_t txn_id = txn->GetTransactionId();
+  std::unique_ptr<Deltas> &deltas = pending_[txn_id];
+  if (deltas == nullptr) {
+    deltas = std::make_unique<Deltas>();
+    txn->AddCompletionCallback([this, txn_id](bool committed) { Complete(txn_id, committed); });
+  }
+  Combine(deltas.get(), key, inputs, sign);
+}
+
+void MaterializedView::Complete(txn_id_t txn_id, bool committed) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = pending_.find(txn_id);
+  if (it == pending_.end()) {
+    return;
+  }
+  std::unique_ptr<Deltas> deltas = std::move(it->second);
+  pending_.erase(it);
+  // A stale view drops the deltas, the rebuild reads them from the base table.
+  if (committed && !stale_) {
+    Apply(*deltas);
+  }
+  Refresh();
+}
+
+void MaterializedView::Apply(const Deltas &deltas) {
+  const auto &agg_types = plan_->GetAggregateTypes();
+  std::vector<AggregateKey> recompute_keys;
+  for (const auto &entry : deltas) {
+    const GroupState &delta = entry.second;
+    auto group = groups_.find(entry.first);
+    GroupState state = InitialState();
+    if (group != groups_.end() && !ReadGroup(group->second, &state)) {
+      break;
+    }
+    state.count_ += delta.count_;
+    BUSTUB_ASSERT(state.count_ >= 0, "A group lost more rows than it had.");
+    if (state.count_ == 0) {
+      if (group != groups_.end() && !RemoveGroup(group)) {
+        break;
+      }
+      continue;
+    }
+    bool recompute = false;
+    for (uint32_t i = 0; i < agg_types.size(); i++) {
+      Value *value = &state.values_[i];
+      const Value &removed = delta.removed_[i];
+      state.nulls_[i] += delta.nulls_[i];
+      switch (agg_types[i]) {
+        case AggregationType::CountAggregate:
+        case AggregationType::SumAggregate:
+          *value = value->Add(delta.values_[i]);
+          break;
+        case AggregationType::MinAggregate:
+          // A deleted value no greater than the minimum may have been the minimum.
+          recompute = recompute || (!removed.IsNull() && IsTrue(removed.CompareLessThanEquals(*value)));
+          *value = value->Min(delta.values_[i]);
+          break;
+        case AggregationType::MaxAggregate:
+          recompute = recompute || (!removed.IsNull() && IsTrue(removed.CompareGreaterThanEquals(*value)));
+          *value = value->Max(delta.values_[i]);
+          break;
+        default:
+          UNREACHABLE("CheckPlan() rejects the other aggregates.");
+      }
+    }
+    if (!WriteGroup(entry.first, state)) {
+      break;
+    }
+    if (recompute) {
+      recompute_keys.push_back(entry.first);
+    }
+  }
+  if (!stale_ && !recompute_keys.empty()) {
+    Recompute(recompute_keys);
+  }
+  storage_txn_.GetWriteSet()->clear();
+}
+
+void MaterializedView::Recompute(const std::vector<AggregateKey> &keys) {
+  Deltas fresh;
+  for (const auto &key : keys) {
+    fresh.emplace(key, InitialState());
+  }
+  AggregateKey key;
+  std::vector<Value> inputs;
+  for (auto it = base_->Begin(&storage_txn_); it != base_->End(); ++it) {
+    if (Evaluate(*it, &key, &inputs) && fresh.count(key) != 0) {
+      Combine(&fresh, key, inputs, 1);
+    }
+  }
+  // The iterator aborts the transaction when it cannot read a page, so the extremes may have been missed.
+  if (storage_txn_.GetState() == TransactionState::ABORTED) {
+    stale_ = true;
+    return;
+  }
+  const auto &agg_types = plan_->GetAggregateTypes();
+  for (const auto &entry : fresh) {
+    GroupState state;
+    if (!ReadGroup(groups_.at(entry.first), &state)) {
+      return;
+    }
+    for (uint32_t i = 0; i < agg_types.size(); i++) {
+      if (agg_types[i] == AggregationType::MinAggregate || agg_types[i] == AggregationType::MaxAggregate) {
+        state.values_[i] = entry.second.values_[i];
+      }
+    }
+    if (!WriteGroup(entry.first, state)) {
+      return;
+    }
+  }
+}
+
+bool MaterializedView::Refresh() {
+  // Only the deltas of running transactions tell the base table apart from the committed rows.
+  if (stale_ && pending_.empty()) {
+    Rebuild();
+  }
+  return !stale_;
+}
+
+void MaterializedView::Rebuild() {
+  // A failed read or write aborted the storage transaction; start it over.
+  storage_txn_.SetState(TransactionState::GROWING);
+  storage_txn_.GetWriteSet()->clear();
+  while (!groups_.empty()) {
+    if (!RemoveGroup(groups_.begin())) {
+      return;
+    }
+  }
+  // Fill the view like the constructor does.
+  Deltas deltas;
+  AggregateKey key;
+  std::vector<Value> inputs;
+  for (auto it = base_->Begin(&storage_txn_); it != base_->End(); ++it) {
+    if (Evaluate(*it, &key, &inputs)) {
+      Combine(&deltas, key, inputs, 1);
+    }
+  }
+  if (storage_txn_.GetState() == TransactionState::ABORTED) {
+    return;
+  }
+  stale_ = false;
+  Apply(deltas);
+}
+
+void MaterializedView::ParseRow(const Tuple &row, std::vector<Value> *group_bys, GroupState *state) const {
+  const uint32_t num_group_bys = plan_->GetGroupBys().size();
+  const uint32_t num_aggregates = plan_->GetAggregates().size();
+  if (group_bys != nullptr) {
+    group_bys->clear();
+    for (uint32_t i = 0; i < num_group_bys; i++) {
+      group_bys->push_back(row.GetValue(&storage_schema_, i));
+    }
+  }
+  state->values_.clear();
+  state->nulls_.clear();
+  for (uint32_t i = 0; i < num_aggregates; i++) {
+    state->values_.push_back(row.GetValue(&storage_schema_, num_group_bys + i));
+    state->nulls_.push_back(row.GetValue(&storage_schema_, num_group_bys + num_aggregates + i).GetAs<int32_t>());
+  }
+  state->count_ = row.GetValue(&storage_schema_, num_group_bys + 2 * num_aggregates).GetAs<int32_t>();
+}
+
+void MaterializedView::Finalize(const GroupState &state, std::vector<Value> *aggregates) const {
+  aggregates->clear();
+  for (uint32_t i = 0; i < state.values_.size(); i++) {
+    const Value &value = state.values_[i];
+    aggregates->push_back(state.nulls_[i] > 0 ? ValueFactory::GetNullValueByType(value.GetTypeId()) : value);
+  }
+}
+
+bool MaterializedView::ReadGroup(const RID &rid, GroupState *state) {
+  Tuple row;
+  if (!storage_->GetTuple(rid, &row, &storage_txn_)) {
+    stale_ = true;
+    return false;
+  }
+  ParseRow(row, nullptr, state);
+  return true;
+}
+
+bool MaterializedView::WriteGroup(const AggregateKey &key, const GroupState &state) {
+  const uint32_t num_group_bys = key.group_bys_.size();
+  std::vector<Value> values(key.group_bys_);
+  for (uint32_t i = 0; i < state.values_.size(); i++) {
+    values.push_back(state.values_[i].CastAs(storage_schema_.GetColumn(num_group_bys + i).GetType()));
+  }
+  for (const auto &nulls : state.nulls_) {
+    values.push_back(ValueFactory::GetIntegerValue(nulls));
+  }
+  values.push_back(ValueFactory::GetIntegerValue(state.count_));
+  Tuple row(values, &storage_schema_);
+  auto group = groups_.find(key);
+  if (group != groups_.end()) {
+    // The row keeps its size, so it is updated in place.
+    if (!storage_->UpdateTuple(row, group->second, &storage_txn_)) {
+      stale_ = true;
+      return false;
+    }
+    return true;
+  }
+  RID rid;
+  if (!storage_->InsertTuple(row, &rid, &storage_txn_)) {
+    stale_ = true;
+    return false;
+  }
+  groups_.emplace(key, rid);
+  return true;
+}
+
+bool MaterializedView::RemoveGroup(std::unordered_map<AggregateKey, RID>::iterator group) {
+  if (!storage_->MarkDelete(group->second, &storage_txn_)) {
+    stale_ = true;
+    return false;
+  }
+  storage_->ApplyDelete(group->second, &storage_txn_);
+  groups_.erase(group);
+  return true;
+}
+
+}  // namespace bustub
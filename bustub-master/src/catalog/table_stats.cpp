@@ -0,0 +1,268 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_stats.cpp
+//
+// Identification: src/catalog/table_stats.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "catalog/table_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "common/hyperloglog.h"
+
+namespace bustub {
+
+namespace {
+
+bool Less(const Value &a, const Value &b) { return a.CompareLessThan(b) == CmpBool::CmpTrue; }
+
+bool Equal(const Value &a, const Value &b) { return a.CompareEquals(b) == CmpBool::CmpTrue; }
+
+/** @return the value as a number, false if its type has no meaningful distance between values */
+bool ToDouble(const Value &value, double *out) {
+  switch (value.GetTypeId()) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      *out = value.GetAs<int8_t>();
+      return true;
+    case TypeId::SMALLINT:
+      *out = value.GetAs<int16_t>();
+      return true;
+    case TypeId::INTEGER:
+      *out = value.GetAs<int32_t>();
+      return true;
+    case TypeId::BIGINT:
+      *out = static_cast<double>(value.GetAs<int64_t>());
+      return true;
+    case TypeId::DECIMAL:
+      *out = value.GetAs<double>();
+      return true;
+    case TypeId::TIMESTAMP:
+      *out = static_cast<double>(value.GetAs<uint64_t>());
+      return true;
+    default:
+      return false;
+  }
+}
+
+/** @return the number of values that occur exactly once in sorted_values */
+size_t CountSingletons(const std::vector<Value> &sorted_values) {
+  size_t singletons = 0;
+  for (size_t i = 0; i < sorted_values.size();) {
+    size_t j = i + 1;
+    while (j < sorted_values.size() && Equal(sorted_values[i], sorted_values[j])) {
+      j++;
+    }
+    singletons += j - i == 1 ? 1 : 0;
+    i = j;
+  }
+  return singletons;
+}
+
+}  // namespace
+
+Histogram::Histogram(const std::vector<Value> &sorted_values) {
+  size_t num_values = sorted_values.size();
+  if (num_values == 0) {
+    return;
+  }
+  min_ = sorted_values.front();
+  size_t num_buckets = std::min<size_t>(MAX_BUCKETS, num_values);
+  upper_bounds_.reserve(num_buckets);
+  cumulative_counts_.reserve(num_buckets);
+  for (size_t b = 1; b <= num_buckets; b++) {
+    size_t end = b * num_values / num_buckets;
+    upper_bounds_.push_back(sorted_values[end - 1]);
+    cumulative_counts_.push_back(end);
+  }
+}
+
+double Histogram::EstimateLessThan(const Value &value, bool inclusive) const {
+  if (upper_bounds_.empty() || Less(value, min_) || (!inclusive && Equal(value, min_))) {
+    return 0;
+  }
+  // The first bucket that can hold values not below (or, if inclusive, above) value; all buckets before it count.
+  auto bucket = inclusive ? std::upper_bound(upper_bounds_.begin(), upper_bounds_.end(), value, Less)
+                          : std::lower_bound(upper_bounds_.begin(), upper_bounds_.end(), value, Less);
+  if (bucket == upper_bounds_.end()) {
+    return 1;
+  }
+  auto i = static_cast<uint32_t>(bucket - upper_bounds_.begin());
+  size_t below = i == 0 ? 0 : cumulative_counts_[i - 1];
+  size_t in_bucket = cumulative_counts_[i] - below;
+
+  // Assume the values of the bucket are spread evenly between its bounds; without a distance, take half of them.
+  const Value &lower = i == 0 ? min_ : upper_bounds_[i - 1];
+  double lo;
+  double hi;
+  double x;
+  double fraction = 0.5;
+  if (ToDouble(lower, &lo) && ToDouble(upper_bounds_[i], &hi) && ToDouble(value, &x)) {
+    fraction = hi > lo ? std::min(1.0, std::max(0.0, (x - lo) / (hi - lo))) : 0;
+  }
+  return (static_cast<double>(below) + fraction * static_cast<double>(in_bucket)) /
+         static_cast<double>(cumulative_counts_.back());
+}
+
+double Histogram::EstimateFrequentValue(const Value &value) const {
+  auto first = std::lower_bound(upper_bounds_.begin(), upper_bounds_.end(), value, Less);
+  auto last = std::upper_bound(first, upper_bounds_.end(), value, Less);
+  if (last - first < 2) {
+    return 0;
+  }
+  // Every bucket after the first one bounded by value holds nothing but value. The run of value also ends the first
+  // bucket and may start the next one, on average half a bucket each.
+  auto first_idx = first - upper_bounds_.begin();
+  auto last_idx = last - upper_bounds_.begin() - 1;
+  double total = static_cast<double>(cumulative_counts_.back());
+  double count = static_cast<double>(cumulative_counts_[last_idx] - cumulative_counts_[first_idx]);
+  return std::min(1.0, (count + total / static_cast<double>(upper_bounds_.size())) / total);
+}
+
+ColumnStats ColumnStats::FromValues(std::vector<Value> *values, size_t num_nulls) {
+  std::sort(values->begin(), values->end(), Less);
+  ColumnStats stats;
+  stats.num_values_ = values->size();
+  stats.num_nulls_ = num_nulls;
+  for (size_t i = 0; i < values->size(); i++) {
+    if (i == 0 || !Equal((*values)[i - 1], (*values)[i])) {
+      stats.num_distinct_++;
+    }
+  }
+  stats.histogram_ = Histogram(*values);
+  return stats;
+}
+
+double ColumnStats::EstimateEqual(const Value &value) const {
+  const Histogram &h = histogram_;
+  if (num_distinct_ == 0 || Less(value, h.GetMin()) || Less(h.GetUpperBound(h.GetNumBuckets() - 1), value)) {
+    return 0;
+  }
+  double frequent = h.EstimateFrequentValue(value);
+  double fraction = frequent > 0 ? frequent : 1.0 / static_cast<double>(num_distinct_);
+  return (1 - GetNullFraction()) * fraction;
+}
+
+std::unique_ptr<TableStats> TableStats::Analyze(TableHeap *table, const Schema &schema, Transaction *txn) {
+  uint32_t num_columns = schema.GetColumnCount();
+  std::vector<std::vector<Value>> values(num_columns);
+  std::vector<size_t> num_nulls(num_columns, 0);
+  auto stats = std::make_unique<TableStats>();
+  for (auto it = table->Begin(txn); it != table->End(); ++it) {
+    stats->num_rows_++;
+    for (uint32_t col = 0; col < num_columns; col++) {
+      Value value = it->GetValue(&schema, col);
+      if (value.IsNull()) {
+        num_nulls[col]++;
+      } else {
+        values[col].emplace_back(std::move(value));
+      }
+    }
+  }
+  stats->num_sampled_rows_ = stats->num_rows_;
+  stats->columns_.reserve(num_columns);
+  for (uint32_t col = 0; col < num_columns; col++) {
+    stats->columns_.push_back(ColumnStats::FromValues(&values[col], num_nulls[col]));
+    std::vector<Value>().swap(values[col]);
+  }
+  return stats;
+}
+
+std::unique_ptr<TableStats> TableStats::AnalyzeSample(TableHeap *table, const Schema &schema, Transaction *txn,
+                                                      size_t sample_pages, size_t sample_rows, uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  uint32_t num_columns = schema.GetColumnCount();
+
+  // Pick sample_pages of the pages, each set of them equally likely, in table order (selection sampling).
+  size_t num_pages = table->GetNumPages(txn);
+  size_t wanted = std::min(sample_pages, num_pages);
+  std::vector<page_id_t> page_ids;
+  page_ids.reserve(wanted);
+  for (size_t i = 0; i < num_pages && page_ids.size() < wanted; i++) {
+    if (rng() % (num_pages - i) < wanted - page_ids.size()) {
+      page_ids.push_back(table->GetPageId(i));
+    }
+  }
+
+  // Stream every row of the sampled pages through the sketches and the reservoir.
+  std::vector<HyperLogLog> sketches(num_columns);
+  std::vector<size_t> num_nulls(num_columns, 0);
+  std::vector<Tuple> reservoir;
+  reservoir.reserve(std::min<size_t>(sample_rows, 1 << 16));
+  size_t rows_read = 0;
+  size_t pages_read = 0;
+  auto sample = [&](Tuple *tuple) {
+    rows_read++;
+    for (uint32_t col = 0; col < num_columns; col++) {
+      Value value = tuple->GetValue(&schema, col);
+      if (value.IsNull()) {
+        num_nulls[col]++;
+      } else {
+        sketches[col].Add(value);
+      }
+    }
+    if (reservoir.size() < sample_rows) {
+      reservoir.emplace_back(std::move(*tuple));
+    } else {
+      size_t slot = rng() % rows_read;
+      if (slot < sample_rows) {
+        reservoir[slot] = std::move(*tuple);
+      }
+    }
+    return true;
+  };
+  BufferRing ring(SAMPLE_RING_SIZE);
+  for (page_id_t page_id : page_ids) {
+    page_id_t next_page_id;
+    if (!table->ScanPage(page_id, &schema, nullptr, nullptr, sample, txn, &next_page_id, nullptr, &ring)) {
+      break;
+    }
+    pages_read++;
+  }
+
+  auto stats = std::make_unique<TableStats>();
+  double scale = pages_read == 0 ? 0 : static_cast<double>(num_pages) / static_cast<double>(pages_read);
+  stats->num_rows_ = std::llround(static_cast<double>(rows_read) * scale);
+  stats->num_sampled_rows_ = reservoir.size();
+  stats->columns_.reserve(num_columns);
+  for (uint32_t col = 0; col < num_columns; col++) {
+    std::vector<Value> values;
+    size_t sampled_nulls = 0;
+    for (const auto &tuple : reservoir) {
+      Value value = tuple.GetValue(&schema, col);
+      if (value.IsNull()) {
+        sampled_nulls++;
+      } else {
+        values.emplace_back(std::move(value));
+      }
+    }
+    ColumnStats column = ColumnStats::FromValues(&values, sampled_nulls);
+    column.num_nulls_ = std::min<size_t>(stats->num_rows_, std::llround(static_cast<double>(num_nulls[col]) * scale));
+    column.num_values_ = stats->num_rows_ - column.num_nulls_;
+
+    double distinct = sketches[col].Estimate();
+    if (pages_read < num_pages && !values.empty()) {
+      // Duj1: values seen once in the sample stand for the values that the sample missed.
+      auto n = static_cast<double>(values.size());
+      auto d = static_cast<double>(column.num_distinct_);
+      auto f1 = static_cast<double>(CountSingletons(values));
+      auto total = static_cast<double>(std::max<size_t>(column.num_values_, values.size()));
+      distinct = std::max(distinct, n * d / (n - f1 + f1 * n / total));
+    }
+    column.num_distinct_ =
+        std::min<size_t>(column.num_values_, std::max<size_t>(values.empty() ? 0 : 1, std::llround(distinct)));
+    stats->columns_.push_back(std::move(column));
+  }
+  return stats;
+}
+
+}  // namespace bustub
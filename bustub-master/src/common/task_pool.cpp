@@ -0,0 +1,296 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// task_pool.cpp
+//
+// Identification: src/common/task_pool.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/task_pool.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace bustub {
+
+namespace {
+
+/** The pool of the worker running on this thread, nullptr on other threads. */
+thread_local TaskPool *current_pool = nullptr;
+/** The index of the worker running on this thread. */
+thread_local size_t current_worker = 0;
+
+}  // namespace
+
+TaskPool::TaskPool(size_t num_workers) {
+  BUSTUB_ASSERT(num_workers > 0, "A task pool needs a worker.");
+  for (size_t i = 0; i < num_workers; i++) {
+    workers_.emplace_back(std::make_unique<Worker>());
+  }
+  for (size_t i = 0; i < num_workers; i++) {
+    threads_.emplace_back(&TaskPool::Run, this, i);
+  }
+}
+
+TaskPool::~TaskPool() {
+  {
+    std::lock_guard<std::mutex> guard(sleep_latch_);
+    shutdown_ = true;
+    deadlines_.clear();
+    UpdateNextDeadline();
+  }
+  sleep_cv_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+TaskPool *TaskPool::GetShared() {
+  static TaskPool pool(std::max<size_t>(2, std::thread::hardware_concurrency()));
+  return &pool;
+}
+
+TaskPoolStats TaskPool::GetStats() const {
+  TaskPoolStats stats;
+  stats.foreground_tasks_ = num_tasks_[static_cast<int>(TaskPriority::FOREGROUND)];
+  stats.background_tasks_ = num_tasks_[static_cast<int>(TaskPriority::BACKGROUND)];
+  stats.steals_ = num_steals_;
+  stats.periodic_runs_ = num_periodic_runs_;
+  stats.queued_ = num_queued_;
+  return stats;
+}
+
+void TaskPool::Post(std::function<void()> task, TaskPriority priority) {
+  // A worker keeps the tasks it posts, the others are spread round robin over the inboxes.
+  bool from_worker = current_pool == this;
+  size_t worker_idx = from_worker ? current_worker : next_worker_++ % workers_.size();
+  Worker *worker = workers_[worker_idx].get();
+  {
+    std::lock_guard<std::mutex> guard(worker->latch_);
+    int p = static_cast<int>(priority);
+    (from_worker ? worker->queues_[p] : worker->inbox_[p]).push_back(std::move(task));
+    num_queued_++;
+  }
+  if (num_sleeping_ > 0) {
+    // Taking the latch orders the notification after the check of a worker that is about to sleep.
+    { std::lock_guard<std::mutex> guard(sleep_latch_); }
+    sleep_cv_.notify_one();
+  }
+}
+
+void TaskPool::ParallelFor(size_t n, const std::function<void(size_t)> &fn, TaskPriority priority) {
+  if (n == 0) {
+    return;
+  }
+  // The calls are claimed from a shared counter, so the helpers that start late find nothing left and return.
+  struct State {
+    explicit State(size_t n) : n_(n) {}
+    const size_t n_;
+    std::atomic<size_t> next_{0};
+    std::mutex latch_;
+    std::condition_variable cv_;
+    size_t done_{0};
+    std::exception_ptr exception_;
+  };
+  auto state = std::make_shared<State>(n);
+  // The helpers only call fn for claimed calls, which finish before ParallelFor() returns.
+  const std::function<void(size_t)> *body = &fn;
+  auto work = [state, body] {
+    size_t finished = 0;
+    std::exception_ptr exception;
+    for (size_t i = state->next_++; i < state->n_; i = state->next_++) {
+      try {
+        (*body)(i);
+      } catch (...) {
+        if (exception == nullptr) {
+          exception = std::current_exception();
+        }
+      }
+      finished++;
+    }
+    if (finished > 0) {
+      std::lock_guard<std::mutex> guard(state->latch_);
+      state->done_ += finished;
+      if (state->exception_ == nullptr) {
+        state->exception_ = exception;
+      }
+      if (state->done_ == state->n_) {
+        state->cv_.notify_all();
+      }
+    }
+  };
+  size_t num_helpers = std::min(n - 1, workers_.size());
+  for (size_t i = 0; i < num_helpers; i++) {
+    Post(work, priority);
+  }
+  work();
+  std::unique_lock<std::mutex> lock(state->latch_);
+  state->cv_.wait(lock, [&state] { return state->done_ == state->n_; });
+  if (state->exception_ != nullptr) {
+    std::rethrow_exception(state->exception_);
+  }
+}
+
+periodic_task_id_t TaskPool::SchedulePeriodic(std::chrono::milliseconds interval, std::function<void()> task,
+                                              TaskPriority priority) {
+  std::lock_guard<std::mutex> guard(sleep_latch_);
+  periodic_task_id_t id = next_periodic_id_++;
+  PeriodicTask &periodic = periodic_tasks_[id];
+  periodic.interval_ = interval;
+  periodic.task_ = std::move(task);
+  periodic.priority_ = priority;
+  periodic.deadline_ = Clock::now() + interval;
+  deadlines_.emplace(periodic.deadline_, id);
+  UpdateNextDeadline();
+  // A sleeping worker may wait for a later deadline.
+  sleep_cv_.notify_one();
+  return id;
+}
+
+void TaskPool::CancelPeriodic(periodic_task_id_t id) {
+  std::unique_lock<std::mutex> lock(sleep_latch_);
+  auto it = periodic_tasks_.find(id);
+  if (it == periodic_tasks_.end()) {
+    return;
+  }
+  PeriodicTask &periodic = it->second;
+  periodic.cancelled_ = true;
+  periodic_cv_.wait(lock, [&periodic] { return !periodic.running_; });
+  deadlines_.erase({periodic.deadline_, id});
+  periodic_tasks_.erase(it);
+  UpdateNextDeadline();
+}
+
+void TaskPool::Run(size_t worker_idx) {
+  current_pool = this;
+  current_worker = worker_idx;
+  std::function<void()> task;
+  TaskPriority priority;
+  while (true) {
+    if (Clock::now().time_since_epoch().count() >= next_deadline_) {
+      QueueDuePeriodicTasks();
+    }
+    if (TakeTask(worker_idx, &task, &priority)) {
+      RunTask(task, priority);
+      task = nullptr;
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleep_latch_);
+    num_sleeping_++;
+    if (num_queued_ == 0) {
+      if (shutdown_) {
+        num_sleeping_--;
+        return;
+      }
+      if (deadlines_.empty()) {
+        sleep_cv_.wait(lock);
+      } else {
+        sleep_cv_.wait_until(lock, deadlines_.begin()->first);
+      }
+    }
+    num_sleeping_--;
+  }
+}
+
+bool TaskPool::TakeTask(size_t worker_idx, std::function<void()> *task, TaskPriority *priority) {
+  if (num_queued_ == 0) {
+    return false;
+  }
+  const size_t num_workers = workers_.size();
+  for (int p = 0; p < 2; p++) {
+    {
+      Worker *own = workers_[worker_idx].get();
+      std::lock_guard<std::mutex> guard(own->latch_);
+      auto &queue = own->queues_[p];
+      auto &inbox = own->inbox_[p];
+      if (!queue.empty() || !inbox.empty()) {
+        if (!queue.empty()) {
+          *task = std::move(queue.back());
+          queue.pop_back();
+        } else {
+          *task = std::move(inbox.front());
+          inbox.pop_front();
+        }
+        num_queued_--;
+        *priority = static_cast<TaskPriority>(p);
+        return true;
+      }
+    }
+    for (size_t i = 1; i < num_workers; i++) {
+      Worker *victim = workers_[(worker_idx + i) % num_workers].get();
+      std::lock_guard<std::mutex> guard(victim->latch_);
+      for (auto *queue : {&victim->queues_[p], &victim->inbox_[p]}) {
+        if (!queue->empty()) {
+          *task = std::move(queue->front());
+          queue->pop_front();
+          num_queued_--;
+          num_steals_++;
+          *priority = static_cast<TaskPriority>(p);
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+void TaskPool::RunTask(const std::function<void()> &task, TaskPriority priority) {
+  num_tasks_[static_cast<int>(priority)]++;
+  task();
+}
+
+void TaskPool::QueueDuePeriodicTasks() {
+  std::vector<std::pair<periodic_task_id_t, TaskPriority>> due;
+  {
+    std::lock_guard<std::mutex> guard(sleep_latch_);
+    auto now = Clock::now();
+    while (!deadlines_.empty() && deadlines_.begin()->first <= now) {
+      periodic_task_id_t id = deadlines_.begin()->second;
+      deadlines_.erase(deadlines_.begin());
+      PeriodicTask &periodic = periodic_tasks_.at(id);
+      periodic.running_ = true;
+      due.emplace_back(id, periodic.priority_);
+    }
+    UpdateNextDeadline();
+  }
+  for (const auto &run : due) {
+    periodic_task_id_t id = run.first;
+    Post([this, id] { RunPeriodic(id); }, run.second);
+  }
+}
+
+void TaskPool::RunPeriodic(periodic_task_id_t id) {
+  PeriodicTask *periodic;
+  {
+    // The entry stays until the task is cancelled, which waits for this run.
+    std::lock_guard<std::mutex> guard(sleep_latch_);
+    periodic = &periodic_tasks_.at(id);
+    if (periodic->cancelled_) {
+      periodic->running_ = false;
+      periodic_cv_.notify_all();
+      return;
+    }
+  }
+  periodic->task_();
+  num_periodic_runs_++;
+  std::lock_guard<std::mutex> guard(sleep_latch_);
+  periodic->running_ = false;
+  if (periodic->cancelled_ || shutdown_) {
+    periodic_cv_.notify_all();
+    return;
+  }
+  periodic->deadline_ = Clock::now() + periodic->interval_;
+  deadlines_.emplace(periodic->deadline_, id);
+  UpdateNextDeadline();
+}
+
+void TaskPool::UpdateNextDeadline() {
+  next_deadline_ = deadlines_.empty() ? Clock::time_point::max().time_since_epoch().count()
+                                      : deadlines_.begin()->first.time_since_epoch().count();
+}
+
+}  // namespace bustub
@@ -54,6 +54,7 @@ void TransactionManager::Commit(Transaction *txn) {
     write_set->pop_back();
   }
   write_set->clear();
+  RunCompletionCallbacks(txn, true);
 
   if (enable_logging) {
     // TODO(student): add logging here
@@ -89,6 +90,7 @@ void TransactionManager::Abort(Transaction *txn) {
     write_set->pop_back();
   }
   write_set->clear();
+  RunCompletionCallbacks(txn, false);
 
   if (enable_logging) {
     // TODO(student): add logging here
@@ -105,6 +107,14 @@ void TransactionManager::Abort(Transaction *txn) {
   global_txn_latch_.RUnlock();
 }
 
+void TransactionManager::RunCompletionCallbacks(Transaction *txn, bool committed) {
+  auto callbacks = std::move(*txn->GetCompletionCallbacks());
+  txn->GetCompletionCallbacks()->clear();
+  for (auto &callback : callbacks) {
+    callback(committed);
+  }
+}
+
 void TransactionManager::BlockAllTransactions() { global_txn_latch_.WLock(); }
 
 void TransactionManager::ResumeTransactions() { global_txn_latch_.WUnlock(); }
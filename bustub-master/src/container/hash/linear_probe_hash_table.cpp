@@ -10,6 +10,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <utility>
@@ -33,6 +35,8 @@ HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager
         slot_num_per_page_ = block_page->SlotNum();
         header_page_->AddBlockPageId(hash_table_first_bucket);
         size_ = slot_num_per_page_;
+        buffer_pool_manager_->UnpinPage(hash_table_first_bucket, true);
+        buffer_pool_manager_->UnpinPage(header_page_id_, true);
         Resize(num_buckets);
     }
 
@@ -84,12 +88,22 @@ bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-    if (resize_thread_id_ != std::this_thread::get_id() || is_resizing_ == false) {
-        table_latch_.WLock();
+    table_latch_.WLock();
+    bool full;
+    bool ret = InsertNoLock(key, value, &full);
+    // Probing ran off the end of the table: grow it until the pair fits.
+    while (full && Grow(size_ * 2)) {
+        ret = InsertNoLock(key, value, &full);
     }
-    is_inserting_ = true;
-    int64_t hash_val = hash_fn_.GetHash(key) % size_;   // get hash value
-    page_id_t bucket_id = hash_val / slot_num_per_page_;  // get page id
+    table_latch_.WUnlock();
+    return ret;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::InsertNoLock(const KeyType &key, const ValueType &value, bool *full) {
+    *full = false;
+    size_t hash_val = hash_fn_.GetHash(key) % size_;   // get hash value
+    size_t bucket_id = hash_val / slot_num_per_page_;  // get page id
     int slot_idx = hash_val % slot_num_per_page_;   // get slot_idx'th slot in the page
 
     // get header page
@@ -98,61 +112,38 @@ bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const
     // get bucket page
     auto bucket_page = reinterpret_cast<HashTableBlockPage<KeyType, ValueType, KeyComparator>*>(buffer_pool_manager_->FetchPage(bucket_page_id)->GetData());
 
-    bool is_duplicated = false;
-    bool header_page_modified = false;
-    // get the slot to insert
-    while (bucket_page->IsReadable(slot_idx)) {
+    bool ret = false;
+    // take the first free slot or tombstone
+    while (true) {
+        if (!bucket_page->IsReadable(slot_idx)) {
+            ret = bucket_page->Insert(slot_idx, key, value);
+            break;
+        }
         // not allow duplicated item in hash table
         if (comparator_(bucket_page->KeyAt(slot_idx), key) == 0 && bucket_page->ValueAt(slot_idx) == value) {
-            is_duplicated = true;
             break;
         }
 
         slot_idx++;
         hash_val++;
-        // resize
-        if (hash_val >= (int)size_) {
-            Resize(size_ * 2);
+        if (hash_val >= size_) {
+            *full = true;
+            break;
         }
 
         // to the end of current page, get next page
         if (slot_idx >= slot_num_per_page_) {
             buffer_pool_manager_->UnpinPage(bucket_page_id, false);
-            bucket_id++;  //　换页
-            // current page is the last page in this hash table, return false
-            if (bucket_id >= 4080) {
-                LOG_INFO("Insert failed\n");
-                buffer_pool_manager_->UnpinPage(header_page_id_, header_page_modified);
-                if (resize_thread_id_ != std::this_thread::get_id() || is_resizing_ == false)
-                    table_latch_.WUnlock();
-                is_inserting_ = false;
-                return false;
-            }
+            bucket_id++;
             bucket_page_id = header_page->GetBlockPageId(bucket_id);
             bucket_page = reinterpret_cast<HashTableBlockPage<KeyType, ValueType, KeyComparator>*>(buffer_pool_manager_->FetchPage(bucket_page_id)->GetData());
             slot_idx = 0;
         }
     }
 
-    if (is_duplicated) {
-        buffer_pool_manager_->UnpinPage(bucket_id, false);
-        buffer_pool_manager_->UnpinPage(header_page_id_, header_page_modified);
-        if (resize_thread_id_ != std::this_thread::get_id() || is_resizing_ == false)
-            table_latch_.WUnlock();
-        is_inserting_ = false;
-        return false;
-    }
-    else {
-        bool ret = false;
-        ret = bucket_page->Insert(slot_idx, key, value);
-        buffer_pool_manager_->UnpinPage(bucket_id, true);
-        buffer_pool_manager_->UnpinPage(header_page_id_, header_page_modified);
-        if (resize_thread_id_ != std::this_thread::get_id() || is_resizing_ == false)
-            table_latch_.WUnlock();
-        is_inserting_ = false;
-        return ret;
-    }
-
+    buffer_pool_manager_->UnpinPage(bucket_page_id, ret);
+    buffer_pool_manager_->UnpinPage(header_page_id_, false);
+    return ret;
 }
 
 /*****************************************************************************
@@ -160,8 +151,7 @@ bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
-    if (resize_thread_id_ != std::this_thread::get_id() || is_resizing_ == false)
-        table_latch_.WLock();
+    table_latch_.WLock();
     int64_t hash_val = hash_fn_.GetHash(key) % size_;   // get hash value
     page_id_t bucket_id = hash_val / slot_num_per_page_;  // get page id
     int slot_idx = hash_val % slot_num_per_page_;   // get slot_idx'th slot in the page
@@ -197,8 +187,7 @@ bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const
     }
     buffer_pool_manager_->UnpinPage(bucket_page_id, false);
     buffer_pool_manager_->UnpinPage(header_page_id_, false);
-    if (resize_thread_id_ != std::this_thread::get_id() || is_resizing_ == false)
-        table_latch_.WUnlock();
+    table_latch_.WUnlock();
     return ret;
 }
 
@@ -207,57 +196,85 @@ bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::Resize(size_t initial_size) {
-    if (is_inserting_ == false)
-        table_latch_.WLock();
-    resize_thread_id_ =  std::this_thread::get_id();
-    is_resizing_ = true;
-    int new_page_num = initial_size / slot_num_per_page_;  //　一共需要new_page_num个page
-    if (initial_size % slot_num_per_page_ != 0)
-        new_page_num++;
+    table_latch_.WLock();
+    if (initial_size > size_) {
+        Grow(initial_size);
+    }
+    table_latch_.WUnlock();
+}
 
-    int new_page_id;
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::Grow(size_t new_size) {
     auto header_page = reinterpret_cast<HashTableHeaderPage*>(buffer_pool_manager_->FetchPage(header_page_id_)->GetData());
-    int i;
-    // LOG_INFO("new pages\n");
-    for (i = header_page->GetSize(); i < (int)new_page_num; i++) {
-        if (buffer_pool_manager_->NewPage(&new_page_id)) {
-            header_page->AddBlockPageId(new_page_id);
-        }
-        else{
-            // page用尽
+
+    // Add blocks until the new size fits, as far as the header page and the buffer pool allow. This comes first, so
+    // that a table that cannot grow keeps its pairs where they are.
+    size_t num_blocks = std::min((new_size - 1) / slot_num_per_page_ + 1, MAX_BLOCKS);
+    while (header_page->NumBlocks() < num_blocks) {
+        page_id_t page_id;
+        if (buffer_pool_manager_->NewPage(&page_id) == nullptr) {
             LOG_INFO("page out of usage\n");
-            buffer_pool_manager_->UnpinPage(header_page_id_, true);
-            if (is_inserting_ == false)
-                table_latch_.WUnlock();
-            return;
+            break;
         }
+        header_page->AddBlockPageId(page_id);
+        buffer_pool_manager_->UnpinPage(page_id, true);
+    }
+    size_t max_size = header_page->NumBlocks() * slot_num_per_page_;
+    size_t old_size = size_;
+    if (std::min(new_size, max_size) <= old_size) {
+        buffer_pool_manager_->UnpinPage(header_page_id_, true);
+        return false;
     }
 
-    // LOG_INFO("rehash\n");
-    int old_size = size_;
-    size_ = initial_size; // 更新size
-    for (i = 0; i < (int)old_size; i++) {
-        int old_page_idx = i / slot_num_per_page_;  // 对应page在header page中的idx
-        int old_slot_idx = i % slot_num_per_page_;
-        int old_page_id =  header_page->GetBlockPageId(old_page_idx); // 对应page的page_id_t
-        // 对应的block_page
-        auto block_page = reinterpret_cast<HashTableBlockPage<KeyType, ValueType, KeyComparator>*>(buffer_pool_manager_->FetchPage(old_page_id));
+    // Take every pair out; every key moves once the size changes.
+    std::vector<std::pair<KeyType, ValueType>> pairs;
+    for (size_t i = 0; i < header_page->NumBlocks(); i++) {
+        page_id_t page_id = header_page->GetBlockPageId(i);
+        Page *page = buffer_pool_manager_->FetchPage(page_id);
+        auto block_page = reinterpret_cast<HashTableBlockPage<KeyType, ValueType, KeyComparator>*>(page->GetData());
+        for (int slot_idx = 0; slot_idx < slot_num_per_page_; slot_idx++) {
+            if (block_page->IsReadable(slot_idx)) {
+                pairs.emplace_back(block_page->KeyAt(slot_idx), block_page->ValueAt(slot_idx));
+            }
+        }
+        buffer_pool_manager_->UnpinPage(page_id, false);
+    }
+    buffer_pool_manager_->UnpinPage(header_page_id_, true);
 
-        if (block_page->IsReadable(old_slot_idx)) {
-            block_page->Remove(old_slot_idx);  // 先删除再插入
-            auto key = block_page->KeyAt(old_slot_idx);
-            auto val = block_page->ValueAt(old_slot_idx);
-            Insert(nullptr, key, val);
+    // A pair may still run off the end of the new size; double it while the blocks allow. If no size fits, go back to
+    // the old one, which holds every pair whatever order they are inserted in.
+    for (size_t size = std::min(new_size, max_size);; size = std::min(size * 2, max_size)) {
+        if (Rehash(pairs, size)) {
+            return true;
+        }
+        if (size == max_size) {
+            break;
         }
+    }
+    Rehash(pairs, old_size);
+    return false;
+}
 
-        buffer_pool_manager_->UnpinPage(header_page->GetBlockPageId(old_page_id), true);
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::Rehash(const std::vector<std::pair<KeyType, ValueType>> &pairs, size_t size) {
+    Page *page = buffer_pool_manager_->FetchPage(header_page_id_);
+    auto header_page = reinterpret_cast<HashTableHeaderPage*>(page->GetData());
+    for (size_t i = 0; i < header_page->NumBlocks(); i++) {
+        page_id_t page_id = header_page->GetBlockPageId(i);
+        memset(buffer_pool_manager_->FetchPage(page_id)->GetData(), 0, PAGE_SIZE);
+        buffer_pool_manager_->UnpinPage(page_id, true);
     }
+    buffer_pool_manager_->UnpinPage(header_page_id_, false);
 
-    buffer_pool_manager_->UnpinPage(header_page_id_, true);
-    size_ = initial_size;
-    is_resizing_ = false;
-    if (is_inserting_ == false)
-        table_latch_.WUnlock();
+    size_ = size;
+    for (const auto &pair : pairs) {
+        bool full;
+        InsertNoLock(pair.first, pair.second, &full);
+        if (full) {
+            return false;
+        }
+    }
+    return true;
 }
 
 /*****************************************************************************
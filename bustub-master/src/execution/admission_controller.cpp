@@ -0,0 +1,207 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// admission_controller.cpp
+//
+// Identification: src/execution/admission_controller.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/admission_controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/distinct_plan.h"
+#include "execution/plans/hash_join_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/insert_plan.h"
+#include "execution/plans/late_materialize_plan.h"
+#include "execution/plans/limit_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/plans/topn_plan.h"
+#include "execution/plans/view_scan_plan.h"
+#include "optimizer/join_order_optimizer.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return the bytes that rows tuples of the output of plan hold in memory */
+size_t TupleBytes(const AbstractPlanNode *plan, double rows) {
+  return static_cast<size_t>(rows * (plan->OutputSchema()->GetLength() + AdmissionController::TUPLE_OVERHEAD));
+}
+
+}  // namespace
+
+AdmissionTicket::~AdmissionTicket() {
+  if (controller_ != nullptr) {
+    controller_->Release(memory_, threads_);
+  }
+}
+
+QueryEstimate AdmissionController::Estimate(const AbstractPlanNode *plan, SimpleCatalog *catalog,
+                                            size_t memory_budget) {
+  QueryEstimate estimate;
+  switch (plan->GetType()) {
+    case PlanType::SeqScan: {
+      const auto *scan_plan = dynamic_cast<const SeqScanPlanNode *>(plan);
+      const TableStats *stats = catalog->GetTableStats(scan_plan->GetTableOid());
+      double table_rows = stats == nullptr ? JoinOrderOptimizer::DEFAULT_CARDINALITY : stats->num_rows_;
+      double selectivity = 1;
+      if (scan_plan->GetPredicate() != nullptr) {
+        selectivity = stats == nullptr ? JoinOrderOptimizer::DEFAULT_SELECTIVITY
+                                       : JoinOrderOptimizer::EstimateSelectivity(scan_plan->GetPredicate(), *stats);
+      }
+      estimate.cpu_cost_ = table_rows;
+      estimate.rows_ = table_rows * selectivity;
+      break;
+    }
+    case PlanType::IndexScan: {
+      // Every key is assumed to find a single tuple.
+      const auto *index_plan = dynamic_cast<const IndexScanPlanNode *>(plan);
+      estimate.rows_ = static_cast<double>(index_plan->GetKeys().size());
+      estimate.cpu_cost_ = estimate.rows_;
+      break;
+    }
+    case PlanType::ViewScan: {
+      const auto *view_plan = dynamic_cast<const ViewScanPlanNode *>(plan);
+      estimate.rows_ = static_cast<double>(catalog->GetMaterializedView(view_plan->GetViewOid())->GetNumGroups());
+      estimate.cpu_cost_ = estimate.rows_;
+      break;
+    }
+    case PlanType::Insert: {
+      const auto *insert_plan = dynamic_cast<const InsertPlanNode *>(plan);
+      if (insert_plan->IsRawInsert()) {
+        estimate.rows_ = static_cast<double>(insert_plan->RawValues().size());
+      } else {
+        estimate = Estimate(insert_plan->GetChildPlan(), catalog, memory_budget);
+      }
+      estimate.cpu_cost_ += estimate.rows_;
+      break;
+    }
+    case PlanType::HashJoin: {
+      // The join cannot spill, so the build side counts in full. The join is assumed to follow a foreign key.
+      const auto *join_plan = dynamic_cast<const HashJoinPlanNode *>(plan);
+      QueryEstimate left = Estimate(join_plan->GetLeftPlan(), catalog, memory_budget);
+      QueryEstimate right = Estimate(join_plan->GetRightPlan(), catalog, memory_budget);
+      estimate.rows_ = std::max(left.rows_, right.rows_);
+      estimate.cpu_cost_ = left.cpu_cost_ + right.cpu_cost_ + left.rows_ + right.rows_;
+      estimate.memory_ = left.memory_ + right.memory_ + TupleBytes(join_plan->GetLeftPlan(), left.rows_);
+      break;
+    }
+    case PlanType::Aggregation: {
+      // Every input row may start a group, unless there are no group-bys.
+      const auto *agg_plan = dynamic_cast<const AggregationPlanNode *>(plan);
+      estimate = Estimate(agg_plan->GetChildPlan(), catalog, memory_budget);
+      double groups = agg_plan->GetGroupBys().empty() ? 1 : estimate.rows_;
+      estimate.cpu_cost_ += estimate.rows_;
+      estimate.memory_ += std::min(TupleBytes(plan, groups), memory_budget);
+      estimate.rows_ = agg_plan->GetHaving() == nullptr ? groups : groups * JoinOrderOptimizer::DEFAULT_SELECTIVITY;
+      break;
+    }
+    case PlanType::Sort: {
+      estimate = Estimate(plan->GetChildAt(0), catalog, memory_budget);
+      estimate.cpu_cost_ += estimate.rows_ * std::log2(estimate.rows_ + 2);
+      estimate.memory_ += std::min(TupleBytes(plan, estimate.rows_), memory_budget);
+      break;
+    }
+    case PlanType::TopN: {
+      const auto *topn_plan = dynamic_cast<const TopNPlanNode *>(plan);
+      estimate = Estimate(topn_plan->GetChildPlan(), catalog, memory_budget);
+      estimate.cpu_cost_ += estimate.rows_;
+      estimate.rows_ = std::min(estimate.rows_, static_cast<double>(topn_plan->GetN()));
+      estimate.memory_ += TupleBytes(plan, estimate.rows_);
+      break;
+    }
+    case PlanType::Limit: {
+      const auto *limit_plan = dynamic_cast<const LimitPlanNode *>(plan);
+      estimate = Estimate(limit_plan->GetChildPlan(), catalog, memory_budget);
+      estimate.rows_ = std::min(estimate.rows_, static_cast<double>(limit_plan->GetLimit()));
+      break;
+    }
+    case PlanType::Distinct: {
+      estimate = Estimate(plan->GetChildAt(0), catalog, memory_budget);
+      estimate.cpu_cost_ += estimate.rows_;
+      estimate.memory_ += std::min(TupleBytes(plan, estimate.rows_), memory_budget);
+      break;
+    }
+    case PlanType::LateMaterialize: {
+      estimate = Estimate(plan->GetChildAt(0), catalog, memory_budget);
+      estimate.cpu_cost_ += estimate.rows_;
+      break;
+    }
+  }
+  return estimate;
+}
+
+std::unique_ptr<AdmissionTicket> AdmissionController::Admit(const QueryEstimate &estimate, QueryPriority priority) {
+  auto start = Clock::now();
+  std::unique_lock<std::mutex> lock(latch_);
+  if (IsPointQuery(estimate)) {
+    stats_.admitted_++;
+    stats_.point_queries_++;
+    return std::unique_ptr<AdmissionTicket>(new AdmissionTicket(nullptr, 0, 0, std::chrono::microseconds(0)));
+  }
+
+  Request request{std::min(estimate.memory_, memory_limit_), std::min(estimate.threads_, thread_limit_)};
+  auto &queue = queues_[static_cast<int>(priority)];
+  queue.push_back(&request);
+  bool waited = !CanAdmit(&request);
+  if (waited) {
+    stats_.waiting_++;
+    cv_.wait(lock, [this, &request] { return CanAdmit(&request); });
+    stats_.waiting_--;
+  }
+  queue.pop_front();
+  running_memory_ += request.memory_;
+  running_threads_ += request.threads_;
+  running_queries_++;
+
+  auto wait = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+  stats_.admitted_++;
+  if (waited) {
+    int p = static_cast<int>(priority);
+    stats_.queued_[p]++;
+    stats_.queue_wait_[p] += wait;
+    stats_.max_queue_wait_[p] = std::max(stats_.max_queue_wait_[p], wait);
+    // The next query in line may fit as well.
+    cv_.notify_all();
+  }
+  return std::unique_ptr<AdmissionTicket>(new AdmissionTicket(this, request.memory_, request.threads_, wait));
+}
+
+AdmissionStats AdmissionController::GetStats() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return stats_;
+}
+
+bool AdmissionController::CanAdmit(const Request *request) const {
+  for (const auto &queue : queues_) {
+    if (!queue.empty()) {
+      if (queue.front() != request) {
+        return false;
+      }
+      break;
+    }
+  }
+  return running_queries_ == 0 ||
+         (running_memory_ + request->memory_ <= memory_limit_ && running_threads_ + request->threads_ <= thread_limit_);
+}
+
+void AdmissionController::Release(size_t memory, uint32_t threads) {
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    running_memory_ -= memory;
+    running_threads_ -= threads;
+    running_queries_--;
+  }
+  cv_.notify_all();
+}
+
+}  // namespace bustub
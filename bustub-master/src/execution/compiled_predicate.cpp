@@ -0,0 +1,412 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compiled_predicate.cpp
+//
+// Identification: src/execution/compiled_predicate.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/compiled_predicate.h"
+
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "type/limits.h"
+
+namespace bustub {
+
+namespace {
+
+bool IsIntegral(TypeId type) {
+  return type == TypeId::TINYINT || type == TypeId::SMALLINT || type == TypeId::INTEGER || type == TypeId::BIGINT;
+}
+
+/** Reads a fixed-width column of the given type and widens it to int64_t. @return false if the column is NULL */
+inline bool LoadInteger(TypeId type, const char *ptr, int64_t *out) {
+  switch (type) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT: {
+      int8_t raw;
+      memcpy(&raw, ptr, sizeof(raw));
+      *out = raw;
+      return raw != BUSTUB_INT8_NULL;
+    }
+    case TypeId::SMALLINT: {
+      int16_t raw;
+      memcpy(&raw, ptr, sizeof(raw));
+      *out = raw;
+      return raw != BUSTUB_INT16_NULL;
+    }
+    case TypeId::INTEGER: {
+      int32_t raw;
+      memcpy(&raw, ptr, sizeof(raw));
+      *out = raw;
+      return raw != BUSTUB_INT32_NULL;
+    }
+    case TypeId::BIGINT: {
+      int64_t raw;
+      memcpy(&raw, ptr, sizeof(raw));
+      *out = raw;
+      return raw != BUSTUB_INT64_NULL;
+    }
+    default:
+      UNREACHABLE("Not an integral column.");
+  }
+}
+
+/** Reads a numeric column and widens it to double. @return false if the column is NULL */
+inline bool LoadDecimal(TypeId type, const char *ptr, double *out) {
+  if (type == TypeId::DECIMAL) {
+    memcpy(out, ptr, sizeof(double));
+    return *out != BUSTUB_DECIMAL_NULL;
+  }
+  int64_t raw;
+  bool not_null = LoadInteger(type, ptr, &raw);
+  *out = static_cast<double>(raw);
+  return not_null;
+}
+
+template <typename T>
+inline bool Compare(ComparisonType comp_type, T lhs, T rhs) {
+  switch (comp_type) {
+    case ComparisonType::Equal:
+      return lhs == rhs;
+    case ComparisonType::NotEqual:
+      return lhs != rhs;
+    case ComparisonType::LessThan:
+      return lhs < rhs;
+    case ComparisonType::LessThanOrEqual:
+      return lhs <= rhs;
+    case ComparisonType::GreaterThan:
+      return lhs > rhs;
+    case ComparisonType::GreaterThanOrEqual:
+      return lhs >= rhs;
+  }
+  return false;
+}
+
+inline bool RunCompare(const PredicateInstruction &ins, const char *const *data) {
+  const PredicateOperand &lhs = ins.lhs_;
+  const PredicateOperand &rhs = ins.rhs_;
+  switch (ins.domain_) {
+    case CompareDomain::Integer: {
+      int64_t l = lhs.constant_.integer_;
+      int64_t r = rhs.constant_.integer_;
+      if (!lhs.is_constant_ && !LoadInteger(lhs.type_, data[lhs.tuple_idx_] + lhs.offset_, &l)) {
+        return false;
+      }
+      if (!rhs.is_constant_ && !LoadInteger(rhs.type_, data[rhs.tuple_idx_] + rhs.offset_, &r)) {
+        return false;
+      }
+      return Compare(ins.comp_type_, l, r);
+    }
+    case CompareDomain::Decimal: {
+      double l = lhs.constant_.decimal_;
+      double r = rhs.constant_.decimal_;
+      if (!lhs.is_constant_ && !LoadDecimal(lhs.type_, data[lhs.tuple_idx_] + lhs.offset_, &l)) {
+        return false;
+      }
+      if (!rhs.is_constant_ && !LoadDecimal(rhs.type_, data[rhs.tuple_idx_] + rhs.offset_, &r)) {
+        return false;
+      }
+      return Compare(ins.comp_type_, l, r);
+    }
+    case CompareDomain::Timestamp: {
+      uint64_t l = lhs.constant_.timestamp_;
+      uint64_t r = rhs.constant_.timestamp_;
+      if (!lhs.is_constant_) {
+        memcpy(&l, data[lhs.tuple_idx_] + lhs.offset_, sizeof(l));
+      }
+      if (!rhs.is_constant_) {
+        memcpy(&r, data[rhs.tuple_idx_] + rhs.offset_, sizeof(r));
+      }
+      if (l == BUSTUB_TIMESTAMP_NULL || r == BUSTUB_TIMESTAMP_NULL) {
+        return false;
+      }
+      return Compare(ins.comp_type_, l, r);
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+/**
+ * PredicateCompiler lowers an expression tree into a CompiledPredicate.
+ * It first builds a small tree of folded nodes, then emits it as a flat program with short-circuit jumps.
+ */
+class PredicateCompiler {
+ public:
+  explicit PredicateCompiler(CompiledPredicate *target) : target_{target} {}
+
+  void Compile(const AbstractExpression *expr) {
+    auto root = Build(expr);
+    Emit(*root);
+  }
+
+ private:
+  enum class NodeKind { True, False, Leaf, And, Or };
+
+  struct Node {
+    NodeKind kind_;
+    PredicateInstruction leaf_{PredicateOpCode::Interpret};
+    std::unique_ptr<Node> left_;
+    std::unique_ptr<Node> right_;
+  };
+
+  static std::unique_ptr<Node> MakeConstant(bool value) {
+    auto node = std::make_unique<Node>();
+    node->kind_ = value ? NodeKind::True : NodeKind::False;
+    return node;
+  }
+
+  static std::unique_ptr<Node> MakeInterpret(const AbstractExpression *expr) {
+    auto node = std::make_unique<Node>();
+    node->kind_ = NodeKind::Leaf;
+    node->leaf_.op_ = PredicateOpCode::Interpret;
+    node->leaf_.expr_ = expr;
+    return node;
+  }
+
+  std::unique_ptr<Node> Build(const AbstractExpression *expr) {
+    if (const auto *logic = dynamic_cast<const LogicExpression *>(expr); logic != nullptr) {
+      return BuildLogic(logic);
+    }
+    if (const auto *cmp = dynamic_cast<const ComparisonExpression *>(expr); cmp != nullptr) {
+      return BuildComparison(cmp);
+    }
+    if (const auto *constant = dynamic_cast<const ConstantValueExpression *>(expr); constant != nullptr) {
+      const Value &val = constant->GetValue();
+      if (val.GetTypeId() == TypeId::BOOLEAN) {
+        return MakeConstant(!val.IsNull() && val.GetAs<int8_t>() != 0);
+      }
+    }
+    return MakeInterpret(expr);
+  }
+
+  std::unique_ptr<Node> BuildLogic(const LogicExpression *logic) {
+    auto left = Build(logic->GetChildAt(0));
+    auto right = Build(logic->GetChildAt(1));
+    // The absorbing element decides the result; the identity element disappears.
+    NodeKind absorbing = logic->GetLogicType() == LogicType::And ? NodeKind::False : NodeKind::True;
+    NodeKind identity = logic->GetLogicType() == LogicType::And ? NodeKind::True : NodeKind::False;
+    if (left->kind_ == absorbing || right->kind_ == absorbing) {
+      return MakeConstant(absorbing == NodeKind::True);
+    }
+    if (left->kind_ == identity) {
+      return right;
+    }
+    if (right->kind_ == identity) {
+      return left;
+    }
+    auto node = std::make_unique<Node>();
+    node->kind_ = logic->GetLogicType() == LogicType::And ? NodeKind::And : NodeKind::Or;
+    node->left_ = std::move(left);
+    node->right_ = std::move(right);
+    return node;
+  }
+
+  std::unique_ptr<Node> BuildComparison(const ComparisonExpression *cmp) {
+    PredicateOperand lhs;
+    PredicateOperand rhs;
+    Value lhs_val;
+    Value rhs_val;
+    if (!MakeOperand(cmp->GetChildAt(0), &lhs, &lhs_val) || !MakeOperand(cmp->GetChildAt(1), &rhs, &rhs_val)) {
+      return MakeInterpret(cmp);
+    }
+    if (lhs.is_constant_ && rhs.is_constant_) {
+      // Fold by running the interpreter once; NULL folds to false under filter semantics.
+      Value result = cmp->Evaluate(nullptr, nullptr);
+      return MakeConstant(!result.IsNull() && result.GetAs<int8_t>() != 0);
+    }
+    CompareDomain domain;
+    if (!PickDomain(lhs.type_, rhs.type_, &domain)) {
+      return MakeInterpret(cmp);
+    }
+    if ((lhs.is_constant_ && lhs.is_null_) || (rhs.is_constant_ && rhs.is_null_)) {
+      return MakeConstant(false);
+    }
+    Widen(domain, lhs_val, &lhs);
+    Widen(domain, rhs_val, &rhs);
+
+    auto node = std::make_unique<Node>();
+    node->kind_ = NodeKind::Leaf;
+    node->leaf_.op_ = PredicateOpCode::Compare;
+    node->leaf_.comp_type_ = cmp->GetComparisonType();
+    node->leaf_.domain_ = domain;
+    node->leaf_.lhs_ = lhs;
+    node->leaf_.rhs_ = rhs;
+    return node;
+  }
+
+  /** Resolves a comparison child to a column offset or a constant. @return false if it must be interpreted */
+  bool MakeOperand(const AbstractExpression *expr, PredicateOperand *operand, Value *constant) {
+    if (const auto *col = dynamic_cast<const ColumnValueExpression *>(expr); col != nullptr) {
+      uint32_t tuple_idx = target_->is_join_ ? col->GetTupleIdx() : 0;
+      const Schema *schema = tuple_idx == 0 ? target_->left_schema_ : target_->right_schema_;
+      if (schema == nullptr || col->GetColIdx() >= schema->GetColumnCount()) {
+        return false;
+      }
+      const Column &column = schema->GetColumn(col->GetColIdx());
+      if (!column.IsInlined()) {
+        return false;
+      }
+      operand->is_constant_ = false;
+      operand->tuple_idx_ = tuple_idx;
+      operand->offset_ = column.GetOffset();
+      operand->type_ = column.GetType();
+      return true;
+    }
+    if (const auto *con = dynamic_cast<const ConstantValueExpression *>(expr); con != nullptr) {
+      *constant = con->GetValue();
+      operand->is_constant_ = true;
+      operand->type_ = constant->GetTypeId();
+      operand->is_null_ = constant->IsNull();
+      return true;
+    }
+    return false;
+  }
+
+  /** Picks the machine type both operands are compared in, mirroring the promotion rules of Type::Compare*. */
+  static bool PickDomain(TypeId lhs, TypeId rhs, CompareDomain *domain) {
+    if ((IsIntegral(lhs) && IsIntegral(rhs)) || (lhs == TypeId::BOOLEAN && rhs == TypeId::BOOLEAN)) {
+      *domain = CompareDomain::Integer;
+      return true;
+    }
+    bool lhs_numeric = IsIntegral(lhs) || lhs == TypeId::DECIMAL;
+    bool rhs_numeric = IsIntegral(rhs) || rhs == TypeId::DECIMAL;
+    if (lhs_numeric && rhs_numeric) {
+      *domain = CompareDomain::Decimal;
+      return true;
+    }
+    if (lhs == TypeId::TIMESTAMP && rhs == TypeId::TIMESTAMP) {
+      *domain = CompareDomain::Timestamp;
+      return true;
+    }
+    return false;
+  }
+
+  static void Widen(CompareDomain domain, const Value &val, PredicateOperand *operand) {
+    if (!operand->is_constant_) {
+      return;
+    }
+    switch (domain) {
+      case CompareDomain::Integer:
+        operand->constant_.integer_ =
+            val.GetTypeId() == TypeId::BOOLEAN ? val.GetAs<int8_t>() : val.CastAs(TypeId::BIGINT).GetAs<int64_t>();
+        break;
+      case CompareDomain::Decimal:
+        operand->constant_.decimal_ = val.CastAs(TypeId::DECIMAL).GetAs<double>();
+        break;
+      case CompareDomain::Timestamp:
+        operand->constant_.timestamp_ = val.GetAs<uint64_t>();
+        break;
+    }
+  }
+
+  void Emit(const Node &node) {
+    auto &program = target_->program_;
+    switch (node.kind_) {
+      case NodeKind::True:
+        program.push_back(PredicateInstruction{PredicateOpCode::LoadTrue});
+        break;
+      case NodeKind::False:
+        program.push_back(PredicateInstruction{PredicateOpCode::LoadFalse});
+        break;
+      case NodeKind::Leaf:
+        program.push_back(node.leaf_);
+        break;
+      case NodeKind::And:
+      case NodeKind::Or: {
+        // The accumulator already holds the result of the left operand when the jump is taken.
+        Emit(*node.left_);
+        size_t jump = program.size();
+        program.push_back(PredicateInstruction{node.kind_ == NodeKind::And ? PredicateOpCode::JumpIfFalse
+                                                                           : PredicateOpCode::JumpIfTrue});
+        Emit(*node.right_);
+        program[jump].jump_target_ = static_cast<uint32_t>(program.size());
+        break;
+      }
+    }
+  }
+
+  CompiledPredicate *target_;
+};
+
+std::unique_ptr<CompiledPredicate> CompiledPredicate::Compile(const AbstractExpression *expr, const Schema *schema) {
+  BUSTUB_ASSERT(expr != nullptr, "Cannot compile an empty predicate.");
+  std::unique_ptr<CompiledPredicate> predicate{new CompiledPredicate(false, schema, nullptr)};
+  PredicateCompiler{predicate.get()}.Compile(expr);
+  return predicate;
+}
+
+std::unique_ptr<CompiledPredicate> CompiledPredicate::CompileJoin(const AbstractExpression *expr,
+                                                                  const Schema *left_schema,
+                                                                  const Schema *right_schema) {
+  BUSTUB_ASSERT(expr != nullptr, "Cannot compile an empty predicate.");
+  std::unique_ptr<CompiledPredicate> predicate{new CompiledPredicate(true, left_schema, right_schema)};
+  PredicateCompiler{predicate.get()}.Compile(expr);
+  return predicate;
+}
+
+bool CompiledPredicate::IsFullyCompiled() const {
+  for (const auto &ins : program_) {
+    if (ins.op_ == PredicateOpCode::Interpret) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CompiledPredicate::Run(const Tuple *left_tuple, const Tuple *right_tuple) const {
+  const char *data[2] = {left_tuple->GetData(), right_tuple->GetData()};
+  const auto size = static_cast<uint32_t>(program_.size());
+  bool acc = false;
+  uint32_t pc = 0;
+  while (pc < size) {
+    const PredicateInstruction &ins = program_[pc];
+    switch (ins.op_) {
+      case PredicateOpCode::LoadTrue:
+        acc = true;
+        pc++;
+        break;
+      case PredicateOpCode::LoadFalse:
+        acc = false;
+        pc++;
+        break;
+      case PredicateOpCode::Compare:
+        acc = RunCompare(ins, data);
+        pc++;
+        break;
+      case PredicateOpCode::JumpIfFalse:
+        pc = acc ? pc + 1 : ins.jump_target_;
+        break;
+      case PredicateOpCode::JumpIfTrue:
+        pc = acc ? ins.jump_target_ : pc + 1;
+        break;
+      case PredicateOpCode::Interpret:
+        acc = Interpret(ins.expr_, left_tuple, right_tuple);
+        pc++;
+        break;
+    }
+  }
+  return acc;
+}
+
+bool CompiledPredicate::Interpret(const AbstractExpression *expr, const Tuple *left_tuple,
+                                  const Tuple *right_tuple) const {
+  Value result = is_join_ ? expr->EvaluateJoin(left_tuple, left_schema_, right_tuple, right_schema_)
+                          : expr->Evaluate(left_tuple, left_schema_);
+  return !result.IsNull() && result.GetAs<int8_t>() != 0;
+}
+
+}  // namespace bustub
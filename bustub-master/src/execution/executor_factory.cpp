@@ -12,24 +12,91 @@
 
 #include "execution/executor_factory.h"
 
+#include <algorithm>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "execution/executors/abstract_executor.h"
 #include "execution/executors/aggregation_executor.h"
+#include "execution/executors/distinct_executor.h"
 #include "execution/executors/hash_join_executor.h"
+#include "execution/executors/index_scan_executor.h"
 #include "execution/executors/insert_executor.h"
+#include "execution/executors/late_materialize_executor.h"
+#include "execution/executors/limit_executor.h"
+#include "execution/executors/profiling_executor.h"
 #include "execution/executors/seq_scan_executor.h"
+#include "execution/executors/sort_executor.h"
+#include "execution/executors/stream_aggregation_executor.h"
+#include "execution/executors/topn_executor.h"
+#include "execution/executors/view_scan_executor.h"
+#include "execution/expressions/column_value_expression.h"
 
 namespace bustub {
-std::unique_ptr<AbstractExecutor> ExecutorFactory::CreateExecutor(ExecutorContext *exec_ctx,
-                                                                  const AbstractPlanNode *plan) {
+
+namespace {
+
+/** @return true if the child of the aggregation produces its tuples ordered on all the group-by columns */
+bool IsGroupedInput(const AggregationPlanNode *agg_plan) {
+  const auto &group_bys = agg_plan->GetGroupBys();
+  const auto &ordering = agg_plan->GetChildPlan()->GetOutputOrdering();
+  if (group_bys.empty() || group_bys.size() > ordering.size()) {
+    return false;
+  }
+  // The group-by columns must be exactly the leading ordering columns, in any order.
+  std::vector<uint32_t> leading(ordering.begin(), ordering.begin() + group_bys.size());
+  for (const auto *expr : group_bys) {
+    const auto *col_expr = dynamic_cast<const ColumnValueExpression *>(expr);
+    if (col_expr == nullptr || std::find(leading.begin(), leading.end(), col_expr->GetColIdx()) == leading.end()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/** @return the name of the executor created for a plan node, as shown in a QueryProfile */
+const char *GetExecutorName(const AbstractPlanNode *plan, const AbstractExecutor *executor) {
+  switch (plan->GetType()) {
+    case PlanType::SeqScan:
+      return "SeqScan";
+    case PlanType::IndexScan:
+      return "IndexScan";
+    case PlanType::Insert:
+      return "Insert";
+    case PlanType::HashJoin:
+      return "HashJoin";
+    case PlanType::Aggregation:
+      return dynamic_cast<const StreamAggregationExecutor *>(executor) != nullptr ? "StreamAggregation" : "Aggregation";
+    case PlanType::Sort:
+      return "Sort";
+    case PlanType::TopN:
+      return "TopN";
+    case PlanType::Limit:
+      return "Limit";
+    case PlanType::Distinct:
+      return "Distinct";
+    case PlanType::LateMaterialize:
+      return "LateMaterialize";
+    case PlanType::ViewScan:
+      return "ViewScan";
+  }
+  return "Unknown";
+}
+
+/** @return the executor for a plan node, whose children are created through ExecutorFactory */
+std::unique_ptr<AbstractExecutor> CreatePlanExecutor(ExecutorContext *exec_ctx, const AbstractPlanNode *plan) {
   switch (plan->GetType()) {
     // Create a new sequential scan executor.
     case PlanType::SeqScan: {
       return std::make_unique<SeqScanExecutor>(exec_ctx, dynamic_cast<const SeqScanPlanNode *>(plan));
     }
 
+    // Create a new index scan executor.
+    case PlanType::IndexScan: {
+      return std::make_unique<IndexScanExecutor>(exec_ctx, dynamic_cast<const IndexScanPlanNode *>(plan));
+    }
+
     // Create a new insert executor.
     case PlanType::Insert: {
       auto insert_plan = dynamic_cast<const InsertPlanNode *>(plan);
@@ -47,16 +114,80 @@ std::unique_ptr<AbstractExecutor> ExecutorFactory::CreateExecutor(ExecutorContex
                                                 std::move(right_executor));
     }
 
-    // Create a new aggregation executor.
+    // Create a new aggregation executor, streaming if the input already arrives grouped.
     case PlanType::Aggregation: {
       auto agg_plan = dynamic_cast<const AggregationPlanNode *>(plan);
       auto child_executor = ExecutorFactory::CreateExecutor(exec_ctx, agg_plan->GetChildPlan());
+      if (IsGroupedInput(agg_plan)) {
+        return std::make_unique<StreamAggregationExecutor>(exec_ctx, agg_plan, std::move(child_executor));
+      }
       return std::make_unique<AggregationExecutor>(exec_ctx, agg_plan, std::move(child_executor));
     }
 
+    // Create a new sort executor.
+    case PlanType::Sort: {
+      auto sort_plan = dynamic_cast<const SortPlanNode *>(plan);
+      auto child_executor = ExecutorFactory::CreateExecutor(exec_ctx, sort_plan->GetChildPlan());
+      return std::make_unique<SortExecutor>(exec_ctx, sort_plan, std::move(child_executor));
+    }
+
+    // Create a new top-n executor.
+    case PlanType::TopN: {
+      auto topn_plan = dynamic_cast<const TopNPlanNode *>(plan);
+      auto child_executor = ExecutorFactory::CreateExecutor(exec_ctx, topn_plan->GetChildPlan());
+      return std::make_unique<TopNExecutor>(exec_ctx, topn_plan, std::move(child_executor));
+    }
+
+    // Create a new limit executor.
+    case PlanType::Limit: {
+      auto limit_plan = dynamic_cast<const LimitPlanNode *>(plan);
+      auto child_executor = ExecutorFactory::CreateExecutor(exec_ctx, limit_plan->GetChildPlan());
+      return std::make_unique<LimitExecutor>(exec_ctx, limit_plan, std::move(child_executor));
+    }
+
+    // Create a new distinct executor.
+    case PlanType::Distinct: {
+      auto distinct_plan = dynamic_cast<const DistinctPlanNode *>(plan);
+      auto child_executor = ExecutorFactory::CreateExecutor(exec_ctx, distinct_plan->GetChildPlan());
+      return std::make_unique<DistinctExecutor>(exec_ctx, distinct_plan, std::move(child_executor));
+    }
+
+    // Create a new late materialization executor.
+    case PlanType::LateMaterialize: {
+      auto late_plan = dynamic_cast<const LateMaterializePlanNode *>(plan);
+      auto child_executor = ExecutorFactory::CreateExecutor(exec_ctx, late_plan->GetChildPlan());
+      return std::make_unique<LateMaterializeExecutor>(exec_ctx, late_plan, std::move(child_executor));
+    }
+
+    // Create a new materialized view scan executor.
+    case PlanType::ViewScan: {
+      auto view_plan = dynamic_cast<const ViewScanPlanNode *>(plan);
+      return std::make_unique<ViewScanExecutor>(exec_ctx, view_plan);
+    }
+
     default: {
       BUSTUB_ASSERT(false, "Unsupported plan type.");
     }
   }
 }
+
+}  // namespace
+
+std::unique_ptr<AbstractExecutor> ExecutorFactory::CreateExecutor(ExecutorContext *exec_ctx,
+                                                                  const AbstractPlanNode *plan) {
+  AdmissionController *admission = exec_ctx->GetAdmissionController();
+  if (admission != nullptr && exec_ctx->GetAdmissionTicket() == nullptr) {
+    // The first executor created is that of the root plan, so the whole query waits here.
+    QueryEstimate estimate = AdmissionController::Estimate(plan, exec_ctx->GetCatalog(), exec_ctx->GetMemoryBudget());
+    estimate.threads_ = exec_ctx->GetNumThreads();
+    exec_ctx->SetAdmissionTicket(admission->Admit(estimate, exec_ctx->GetQueryPriority()));
+  }
+  auto executor = CreatePlanExecutor(exec_ctx, plan);
+  QueryProfile *profile = exec_ctx->GetProfile();
+  if (profile == nullptr) {
+    return executor;
+  }
+  OperatorProfile *op_profile = profile->AddOperator(plan, GetExecutorName(plan, executor.get()));
+  return std::make_unique<ProfilingExecutor>(exec_ctx, std::move(executor), op_profile);
+}
 }  // namespace bustub
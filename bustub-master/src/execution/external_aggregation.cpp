@@ -0,0 +1,163 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_aggregation.cpp
+//
+// Identification: src/execution/external_aggregation.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/external_aggregation.h"
+
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
+#include "storage/page/tmp_tuple_page.h"
+
+namespace bustub {
+
+ExternalAggregation::~ExternalAggregation() {
+  memory_tracker_->SetUsage(0, "Aggregation");
+  if (page_ != nullptr) {
+    // The merge of a partition threw; the page is deleted with the rest of the partition.
+    bpm_->UnpinPage(page_->GetPageId(), false);
+  }
+  for (auto *partitions : {&partitions_, &pending_}) {
+    for (const auto &partition : *partitions) {
+      for (page_id_t page_id : partition.pages_) {
+        bpm_->DeletePage(page_id);
+      }
+    }
+  }
+}
+
+void ExternalAggregation::Insert(const Tuple &tuple) {
+  table_->InsertCombine(tuple);
+  size_t memory_usage = table_->GetMemoryUsage();
+  if (memory_usage > memory_budget_ || !memory_tracker_->TrySetUsage(memory_usage)) {
+    SpillTable(&partitions_, 0);
+  }
+}
+
+void ExternalAggregation::Finish() {
+  group_idx_ = 0;
+  if (partitions_.empty()) {
+    return;
+  }
+  // Part of the input is on disk, so the groups still in memory may be partial: spill them as well.
+  SpillTable(&partitions_, 0);
+  for (auto &partition : partitions_) {
+    if (!partition.pages_.empty()) {
+      pending_.emplace_back(std::move(partition));
+    }
+  }
+  partitions_.clear();
+}
+
+bool ExternalAggregation::Next(std::vector<Value> *group_bys, std::vector<Value> *aggregates) {
+  while (group_idx_ >= table_->Size()) {
+    if (pending_.empty()) {
+      return false;
+    }
+    LoadNextPartition();
+  }
+  table_->GetGroup(group_idx_++, group_bys, aggregates);
+  return true;
+}
+
+void ExternalAggregation::SpillTable(std::vector<Partition> *partitions, uint32_t level) {
+  if (partitions->empty()) {
+    partitions->resize(FANOUT, Partition{level, {}});
+  }
+
+  // Bucket the groups by partition so that each partition is written one page at a time.
+  std::vector<std::vector<uint32_t>> groups(FANOUT);
+  for (uint32_t i = 0; i < table_->Size(); i++) {
+    groups[GetPartition(table_->GetRowHash(i), level)].push_back(i);
+  }
+
+  for (uint32_t p = 0; p < FANOUT; p++) {
+    if (groups[p].empty()) {
+      continue;
+    }
+    Partition &partition = (*partitions)[p];
+    TmpTuplePage *page = nullptr;
+    if (!partition.pages_.empty()) {
+      page = reinterpret_cast<TmpTuplePage *>(bpm_->FetchPage(partition.pages_.back()));
+    }
+    for (uint32_t group_idx : groups[p]) {
+      TmpTuple out(INVALID_PAGE_ID, 0);
+      if (page != nullptr && page->Insert(table_->GetRowData(group_idx), table_->GetRowWidth(), &out)) {
+        continue;
+      }
+      if (page != nullptr) {
+        bpm_->UnpinPage(page->GetPageId(), true);
+      }
+      page_id_t page_id;
+      page = reinterpret_cast<TmpTuplePage *>(bpm_->NewPage(&page_id));
+      if (page == nullptr) {
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "Aggregation could not allocate a temporary page.");
+      }
+      page->Init(page_id, PAGE_SIZE);
+      partition.pages_.push_back(page_id);
+      num_spilled_pages_++;
+      bool inserted = page->Insert(table_->GetRowData(group_idx), table_->GetRowWidth(), &out);
+      BUSTUB_ASSERT(inserted, "A row must fit in an empty page.");
+      (void)inserted;
+    }
+    bpm_->UnpinPage(page->GetPageId(), true);
+  }
+  table_->Release();
+  memory_tracker_->SetUsage(table_->GetMemoryUsage(), "Aggregation");
+}
+
+void ExternalAggregation::LoadNextPartition() {
+  // The partition stays in pending_ until its pages are consumed, and its children are spilled to partitions_ (empty
+  // after Finish()), so that the destructor deletes every page that is left if the merge throws.
+  Partition &partition = pending_.back();
+  const uint32_t child_level = partition.level_ + 1;
+  table_->Release();
+  memory_tracker_->SetUsage(table_->GetMemoryUsage(), "Aggregation");
+  group_idx_ = 0;
+
+  bool can_split = child_level < MAX_LEVEL;
+  while (!partition.pages_.empty()) {
+    page_id_t page_id = partition.pages_.back();
+    page_ = reinterpret_cast<TmpTuplePage *>(bpm_->FetchPage(page_id));
+    if (page_ == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "Aggregation could not fetch a temporary page.");
+    }
+    for (uint32_t offset = page_->GetFreeSpacePointer(); offset < static_cast<uint32_t>(PAGE_SIZE);) {
+      TupleView row = page_->Get(offset);
+      table_->MergeRow(row.GetData());
+      offset += sizeof(uint32_t) + row.GetLength();
+      size_t memory_usage = table_->GetMemoryUsage();
+      if (!can_split) {
+        memory_tracker_->SetUsage(memory_usage, "Aggregation partition");
+      } else if (memory_usage > memory_budget_ || !memory_tracker_->TrySetUsage(memory_usage)) {
+        SpillTable(&partitions_, child_level);
+      }
+    }
+    bpm_->UnpinPage(page_id, false);
+    page_ = nullptr;
+    partition.pages_.pop_back();
+    bpm_->DeletePage(page_id);
+  }
+  pending_.pop_back();
+
+  if (!partitions_.empty()) {
+    SpillTable(&partitions_, child_level);
+    for (auto &child : partitions_) {
+      if (!child.pages_.empty()) {
+        pending_.emplace_back(std::move(child));
+      }
+    }
+    partitions_.clear();
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,247 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_distinct.cpp
+//
+// Identification: src/execution/external_distinct.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/external_distinct.h"
+
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+ExternalDistinct::ExternalDistinct(BufferPoolManager *bpm, size_t memory_budget, MemoryTracker *memory_tracker)
+    : bpm_(bpm), memory_budget_(memory_budget), memory_tracker_(memory_tracker) {
+  for (uint32_t i = 0; i < FANOUT; i++) {
+    sets_.emplace_back(std::make_unique<PackedKeySet>());
+    memory_usage_ += sets_.back()->GetMemoryUsage();
+  }
+  partitions_.resize(FANOUT, Partition{0, {}, {}});
+  memory_tracker_->SetUsage(memory_usage_, "Distinct");
+}
+
+ExternalDistinct::~ExternalDistinct() {
+  memory_tracker_->SetUsage(0, "Distinct");
+  if (page_ != nullptr) {
+    bpm_->UnpinPage(page_->GetPageId(), false);
+    bpm_->DeletePage(page_->GetPageId());
+  }
+  DeletePages(unread_pages_);
+  for (auto *partitions : {&partitions_, &pending_}) {
+    for (const auto &partition : *partitions) {
+      DeletePages(partition.seen_.pages_);
+      DeletePages(partition.unseen_.pages_);
+    }
+  }
+}
+
+bool ExternalDistinct::Insert(const char *key, uint32_t size, bool seen) {
+  hash_t hash = PackedKeySet::Hash(key, size);
+  uint32_t p = GetPartition(hash, level_);
+  PackedKeySet *set = sets_[p].get();
+  if (set == nullptr) {
+    Append(seen ? &partitions_[p].seen_ : &partitions_[p].unseen_, key, size);
+    return false;
+  }
+  size_t before = set->GetMemoryUsage();
+  if (!set->Insert(key, size, hash)) {
+    return false;
+  }
+  memory_usage_ += set->GetMemoryUsage() - before;
+  if (level_ + 1 >= MAX_LEVEL) {
+    memory_tracker_->SetUsage(memory_usage_, "Distinct partition");
+  } else if (memory_usage_ > memory_budget_ || !memory_tracker_->TrySetUsage(memory_usage_)) {
+    // The key is in its set, so if that set spills the key lands on the seen pages: it is reported now either way.
+    SpillSets();
+  }
+  return !seen;
+}
+
+void ExternalDistinct::SpillSets() {
+  while (memory_usage_ > memory_budget_ || !memory_tracker_->TrySetUsage(memory_usage_)) {
+    uint32_t largest = FANOUT;
+    for (uint32_t p = 0; p < FANOUT; p++) {
+      if (sets_[p] != nullptr && (largest == FANOUT || sets_[p]->GetMemoryUsage() > sets_[largest]->GetMemoryUsage())) {
+        largest = p;
+      }
+    }
+    if (largest == FANOUT) {
+      // Only buffers are left.
+      for (auto &partition : partitions_) {
+        Flush(&partition.seen_);
+        Flush(&partition.unseen_);
+      }
+      break;
+    }
+    PackedKeySet *set = sets_[largest].get();
+    for (uint32_t i = 0; i < set->Size(); i++) {
+      uint32_t size;
+      const char *key = set->GetKey(i, &size);
+      Append(&partitions_[largest].seen_, key, size);
+    }
+    memory_usage_ -= set->GetMemoryUsage();
+    sets_[largest].reset();
+  }
+  memory_tracker_->SetUsage(memory_usage_, "Distinct");
+}
+
+void ExternalDistinct::Append(SpillList *list, const char *key, uint32_t size) {
+  size_t offset = list->buffer_.size();
+  list->buffer_.resize(offset + sizeof(uint32_t) + size);
+  memcpy(list->buffer_.data() + offset, &size, sizeof(uint32_t));
+  memcpy(list->buffer_.data() + offset + sizeof(uint32_t), key, size);
+  memory_usage_ += sizeof(uint32_t) + size;
+  if (list->buffer_.size() >= static_cast<size_t>(PAGE_SIZE)) {
+    Flush(list);
+  }
+}
+
+void ExternalDistinct::Flush(SpillList *list) {
+  if (list->buffer_.empty()) {
+    return;
+  }
+  TmpTuplePage *page = nullptr;
+  if (!list->pages_.empty()) {
+    page = reinterpret_cast<TmpTuplePage *>(bpm_->FetchPage(list->pages_.back()));
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "Distinct could not fetch a temporary page.");
+    }
+  }
+  for (size_t offset = 0; offset < list->buffer_.size();) {
+    uint32_t size;
+    memcpy(&size, list->buffer_.data() + offset, sizeof(uint32_t));
+    const char *key = list->buffer_.data() + offset + sizeof(uint32_t);
+    offset += sizeof(uint32_t) + size;
+    TmpTuple out(INVALID_PAGE_ID, 0);
+    if (page != nullptr && page->Insert(key, size, &out)) {
+      continue;
+    }
+    if (page != nullptr) {
+      bpm_->UnpinPage(page->GetPageId(), true);
+    }
+    page_id_t page_id;
+    page = reinterpret_cast<TmpTuplePage *>(bpm_->NewPage(&page_id));
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "Distinct could not allocate a temporary page.");
+    }
+    page->Init(page_id, PAGE_SIZE);
+    list->pages_.push_back(page_id);
+    num_spilled_pages_++;
+    bool inserted = page->Insert(key, size, &out);
+    BUSTUB_ASSERT(inserted, "A key must fit in an empty page.");
+    (void)inserted;
+  }
+  bpm_->UnpinPage(page->GetPageId(), true);
+  memory_usage_ -= list->buffer_.size();
+  list->buffer_.clear();
+}
+
+void ExternalDistinct::Finish() { FinishPass(); }
+
+bool ExternalDistinct::Next(const char **key, uint32_t *size) {
+  while (true) {
+    if (page_ != nullptr && offset_ < static_cast<uint32_t>(PAGE_SIZE)) {
+      TupleView row = page_->Get(offset_);
+      offset_ += sizeof(uint32_t) + row.GetLength();
+      if (Insert(row.GetData(), row.GetLength(), false)) {
+        *key = row.GetData();
+        *size = row.GetLength();
+        return true;
+      }
+      continue;
+    }
+    if (page_ != nullptr) {
+      page_id_t page_id = page_->GetPageId();
+      bpm_->UnpinPage(page_id, false);
+      bpm_->DeletePage(page_id);
+      page_ = nullptr;
+    }
+    if (!unread_pages_.empty()) {
+      // The page leaves unread_pages_ only once it is pinned in page_, so that the destructor deletes it either way.
+      page_ = reinterpret_cast<TmpTuplePage *>(bpm_->FetchPage(unread_pages_.front()));
+      if (page_ == nullptr) {
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "Distinct could not fetch a temporary page.");
+      }
+      unread_pages_.erase(unread_pages_.begin());
+      offset_ = page_->GetFreeSpacePointer();
+      continue;
+    }
+    // The pass is over; start one over the next spilled partition.
+    FinishPass();
+    if (pending_.empty()) {
+      return false;
+    }
+    StartPass();
+  }
+}
+
+void ExternalDistinct::StartPass() {
+  // The partition stays in pending_ until its pages are handed over, so that the destructor deletes every page that
+  // is left if loading the seen keys throws. Insert() never touches pending_.
+  Partition &partition = pending_.back();
+  level_ = partition.level_ + 1;
+  for (auto &set : sets_) {
+    set = std::make_unique<PackedKeySet>();
+    memory_usage_ += set->GetMemoryUsage();
+  }
+  partitions_.assign(FANOUT, Partition{level_, {}, {}});
+  memory_tracker_->SetUsage(memory_usage_, "Distinct");
+
+  std::vector<page_id_t> &seen_pages = partition.seen_.pages_;
+  while (!seen_pages.empty()) {
+    page_ = reinterpret_cast<TmpTuplePage *>(bpm_->FetchPage(seen_pages.back()));
+    if (page_ == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "Distinct could not fetch a temporary page.");
+    }
+    seen_pages.pop_back();
+    for (uint32_t offset = page_->GetFreeSpacePointer(); offset < static_cast<uint32_t>(PAGE_SIZE);) {
+      TupleView row = page_->Get(offset);
+      Insert(row.GetData(), row.GetLength(), true);
+      offset += sizeof(uint32_t) + row.GetLength();
+    }
+    page_id_t page_id = page_->GetPageId();
+    bpm_->UnpinPage(page_id, false);
+    bpm_->DeletePage(page_id);
+    page_ = nullptr;
+  }
+  unread_pages_ = std::move(partition.unseen_.pages_);
+  pending_.pop_back();
+}
+
+void ExternalDistinct::FinishPass() {
+  for (auto &set : sets_) {
+    set.reset();
+  }
+  for (auto &partition : partitions_) {
+    Flush(&partition.unseen_);
+    if (!partition.unseen_.pages_.empty()) {
+      Flush(&partition.seen_);
+      pending_.emplace_back(std::move(partition));
+    } else {
+      // Every key of the partition was reported already.
+      DeletePages(partition.seen_.pages_);
+    }
+  }
+  partitions_.clear();
+  memory_usage_ = 0;
+  memory_tracker_->SetUsage(0, "Distinct");
+}
+
+void ExternalDistinct::DeletePages(const std::vector<page_id_t> &pages) {
+  for (page_id_t page_id : pages) {
+    bpm_->DeletePage(page_id);
+  }
+}
+
+}  // namespace bustub
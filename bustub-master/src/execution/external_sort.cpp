@@ -0,0 +1,341 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sort.cpp
+//
+// Identification: src/execution/external_sort.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/external_sort.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
+#include "storage/page/tmp_tuple_page.h"
+
+namespace bustub {
+
+namespace {
+
+/** Number of buffer pool frames left for everything but the runs being merged. */
+constexpr size_t RESERVED_FRAMES = 4;
+
+/** Appends records to a new run, one pinned page at a time. */
+class RunWriter {
+ public:
+  RunWriter(BufferPoolManager *bpm, std::vector<page_id_t> *pages) : bpm_(bpm), pages_(pages) {}
+
+  ~RunWriter() {
+    if (page_ != nullptr) {
+      bpm_->UnpinPage(page_->GetPageId(), true);
+    }
+  }
+
+  DISALLOW_COPY_AND_MOVE(RunWriter);
+
+  /** Append a record: | PayloadSize (4) | Payload |. */
+  void Append(const char *record) {
+    uint32_t size;
+    memcpy(&size, record, sizeof(uint32_t));
+    TmpTuple out(INVALID_PAGE_ID, 0);
+    if (page_ != nullptr && page_->Insert(record + sizeof(uint32_t), size, &out)) {
+      return;
+    }
+    if (page_ != nullptr) {
+      bpm_->UnpinPage(page_->GetPageId(), true);
+    }
+    page_id_t page_id;
+    page_ = reinterpret_cast<TmpTuplePage *>(bpm_->NewPage(&page_id));
+    if (page_ == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "Sort could not allocate a temporary page.");
+    }
+    page_->Init(page_id, PAGE_SIZE);
+    pages_->push_back(page_id);
+    if (!page_->Insert(record + sizeof(uint32_t), size, &out)) {
+      throw Exception(ExceptionType::OUT_OF_RANGE, "Tuple too large to sort.");
+    }
+  }
+
+ private:
+  BufferPoolManager *bpm_;
+  std::vector<page_id_t> *pages_;
+  TmpTuplePage *page_{nullptr};
+};
+
+}  // namespace
+
+/** Reads the records of a run in order, deleting its pages as they are consumed. */
+class ExternalSort::RunReader {
+ public:
+  RunReader(BufferPoolManager *bpm, Run pages) : bpm_(bpm), pages_(std::move(pages)) {
+    next_page_ = FetchAhead(0);
+    OpenPage(0);
+  }
+
+  ~RunReader() {
+    for (auto *page : {page_, next_page_}) {
+      if (page != nullptr) {
+        bpm_->UnpinPage(page->GetPageId(), false);
+      }
+    }
+    for (size_t i = page_idx_; i < pages_.size(); i++) {
+      bpm_->DeletePage(pages_[i]);
+    }
+  }
+
+  DISALLOW_COPY_AND_MOVE(RunReader);
+
+  /** @return the current record, nullptr once the run is exhausted */
+  const char *Current() const { return page_ == nullptr ? nullptr : page_->GetData() + offsets_[pos_]; }
+
+  /** Move to the next record. */
+  void Advance() {
+    if (pos_ > 0) {
+      pos_--;
+      return;
+    }
+    bpm_->UnpinPage(page_->GetPageId(), false);
+    bpm_->DeletePage(pages_[page_idx_]);
+    page_ = nullptr;
+    OpenPage(page_idx_ + 1);
+  }
+
+ private:
+  /** Pin the page after which page_idx is read, so that it is resident by the time it is needed. */
+  TmpTuplePage *FetchAhead(size_t page_idx) {
+    if (page_idx >= pages_.size()) {
+      return nullptr;
+    }
+    auto *page = reinterpret_cast<TmpTuplePage *>(bpm_->FetchPage(pages_[page_idx]));
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "Sort could not fetch a temporary page.");
+    }
+    return page;
+  }
+
+  /** Make the prefetched page current and prefetch the one after it. */
+  void OpenPage(size_t page_idx) {
+    page_idx_ = page_idx;
+    page_ = next_page_;
+    next_page_ = nullptr;
+    if (page_ == nullptr) {
+      return;
+    }
+    next_page_ = FetchAhead(page_idx + 1);
+    // Records are stacked from the end of the page towards its header, so walk them once and read them backwards.
+    offsets_.clear();
+    for (uint32_t offset = page_->GetFreeSpacePointer(); offset < static_cast<uint32_t>(PAGE_SIZE);) {
+      offsets_.push_back(offset);
+      offset += sizeof(uint32_t) + page_->Get(offset).GetLength();
+    }
+    pos_ = offsets_.size() - 1;
+  }
+
+  BufferPoolManager *bpm_;
+  Run pages_;
+  size_t page_idx_{0};
+  TmpTuplePage *page_{nullptr};
+  TmpTuplePage *next_page_{nullptr};
+  /** The offsets of the records of the current page, last record first. */
+  std::vector<uint32_t> offsets_;
+  size_t pos_{0};
+};
+
+/**
+ * A tree of losers over k sources: every inner node holds the source that lost the comparison there, and node 0
+ * holds the overall winner. After the winner advances, only the log(k) nodes on its path are replayed.
+ */
+class ExternalSort::LoserTree {
+ public:
+  /**
+   * @param k the number of sources
+   * @param less less(a, b) is true if the current element of source a must come before that of source b
+   */
+  LoserTree(uint32_t k, std::function<bool(uint32_t, uint32_t)> less) : k_(k), less_(std::move(less)), tree_(k, k) {
+    // Start from a tree full of the sentinel k, which beats everything, and push every source up to its place.
+    for (uint32_t leaf = k; leaf-- > 0;) {
+      Replay(leaf);
+    }
+  }
+
+  /** @return the source whose element comes first */
+  uint32_t Winner() const { return tree_[0]; }
+
+  /** Restore the tree after the current element of a source, usually the winner, changed. */
+  void Replay(uint32_t leaf) {
+    uint32_t winner = leaf;
+    for (uint32_t node = (leaf + k_) / 2; node > 0; node /= 2) {
+      if (Beats(tree_[node], winner)) {
+        std::swap(tree_[node], winner);
+      }
+    }
+    tree_[0] = winner;
+  }
+
+ private:
+  bool Beats(uint32_t a, uint32_t b) const {
+    if (a == k_ || b == k_) {
+      return a == k_;
+    }
+    return less_(a, b);
+  }
+
+  uint32_t k_;
+  std::function<bool(uint32_t, uint32_t)> less_;
+  std::vector<uint32_t> tree_;
+};
+
+ExternalSort::ExternalSort(const Schema *schema, const std::vector<OrderBy> &order_bys, BufferPoolManager *bpm,
+                           size_t memory_budget, MemoryTracker *memory_tracker)
+    : encoder_(schema, order_bys),
+      bpm_(bpm),
+      memory_budget_(memory_budget),
+      memory_tracker_(memory_tracker),
+      key_width_(encoder_.GetKeyWidth()) {}
+
+ExternalSort::~ExternalSort() {
+  memory_tracker_->SetUsage(0, "Sort");
+  // Readers delete the rest of their runs.
+  readers_.clear();
+  for (const auto &run : runs_) {
+    for (page_id_t page_id : run) {
+      bpm_->DeletePage(page_id);
+    }
+  }
+}
+
+void ExternalSort::Insert(const Tuple &tuple) {
+  uint32_t tuple_size = tuple.GetLength();
+  uint32_t payload_size = key_width_ + sizeof(uint32_t) + tuple_size;
+  char *record = arena_.Allocate(sizeof(uint32_t) + payload_size, alignof(uint32_t));
+  memcpy(record, &payload_size, sizeof(uint32_t));
+  encoder_.Encode(tuple, record + sizeof(uint32_t));
+  memcpy(record + sizeof(uint32_t) + key_width_, &tuple_size, sizeof(uint32_t));
+  memcpy(record + 2 * sizeof(uint32_t) + key_width_, tuple.GetData(), tuple_size);
+  records_.push_back(record);
+
+  size_t memory_usage = arena_.GetBytesAllocated() + records_.size() * sizeof(const char *);
+  if (memory_usage > memory_budget_ || !memory_tracker_->TrySetUsage(memory_usage)) {
+    SpillRun();
+  }
+}
+
+void ExternalSort::Finish() {
+  record_idx_ = 0;
+  if (runs_.empty()) {
+    std::stable_sort(records_.begin(), records_.end(), [this](const char *a, const char *b) { return Less(a, b); });
+    return;
+  }
+  if (!records_.empty()) {
+    SpillRun();
+  }
+
+  // Every open run pins two pages, so merge adjacent groups of runs until the rest fit into the buffer pool.
+  // Merging adjacent runs keeps tuples with equal keys in input order.
+  size_t pool_size = bpm_->GetPoolSize();
+  size_t fan_in = std::max<size_t>(2, pool_size > RESERVED_FRAMES ? (pool_size - RESERVED_FRAMES) / 2 : 0);
+  while (runs_.size() > fan_in) {
+    std::vector<Run> merged;
+    for (size_t i = 0; i < runs_.size(); i += fan_in) {
+      size_t end = std::min(runs_.size(), i + fan_in);
+      std::vector<Run> group(std::make_move_iterator(runs_.begin() + i), std::make_move_iterator(runs_.begin() + end));
+      merged.emplace_back(group.size() == 1 ? std::move(group[0]) : MergeRuns(std::move(group)));
+    }
+    runs_ = std::move(merged);
+  }
+
+  for (auto &run : runs_) {
+    readers_.emplace_back(std::make_unique<RunReader>(bpm_, std::move(run)));
+  }
+  runs_.clear();
+  tree_ = std::make_unique<LoserTree>(readers_.size(),
+                                      [this](uint32_t a, uint32_t b) { return RunLess(readers_, a, b); });
+}
+
+bool ExternalSort::Next(Tuple *tuple) {
+  if (tree_ == nullptr) {
+    if (record_idx_ == records_.size()) {
+      return false;
+    }
+    tuple->DeserializeFrom(records_[record_idx_++] + sizeof(uint32_t) + key_width_);
+    return true;
+  }
+  uint32_t winner = tree_->Winner();
+  const char *record = readers_[winner]->Current();
+  if (record == nullptr) {
+    return false;
+  }
+  tuple->DeserializeFrom(record + sizeof(uint32_t) + key_width_);
+  readers_[winner]->Advance();
+  tree_->Replay(winner);
+  return true;
+}
+
+void ExternalSort::SpillRun() {
+  std::stable_sort(records_.begin(), records_.end(), [this](const char *a, const char *b) { return Less(a, b); });
+  Run run;
+  {
+    RunWriter writer(bpm_, &run);
+    for (const char *record : records_) {
+      writer.Append(record);
+    }
+  }
+  runs_.emplace_back(std::move(run));
+  num_runs_++;
+  records_.clear();
+  arena_.Reset();
+  memory_tracker_->SetUsage(0, "Sort");
+}
+
+ExternalSort::Run ExternalSort::MergeRuns(std::vector<Run> runs) {
+  std::vector<std::unique_ptr<RunReader>> readers;
+  for (auto &run : runs) {
+    readers.emplace_back(std::make_unique<RunReader>(bpm_, std::move(run)));
+  }
+  LoserTree tree(readers.size(), [this, &readers](uint32_t a, uint32_t b) { return RunLess(readers, a, b); });
+
+  Run merged;
+  RunWriter writer(bpm_, &merged);
+  for (uint32_t winner = tree.Winner(); readers[winner]->Current() != nullptr; winner = tree.Winner()) {
+    writer.Append(readers[winner]->Current());
+    readers[winner]->Advance();
+    tree.Replay(winner);
+  }
+  num_runs_++;
+  return merged;
+}
+
+bool ExternalSort::Less(const char *a, const char *b) const {
+  int cmp = encoder_.CompareKeys(a + sizeof(uint32_t), b + sizeof(uint32_t));
+  if (cmp == 0 && encoder_.IsTruncating()) {
+    cmp = encoder_.CompareValues(GetRecordTuple(a), GetRecordTuple(b));
+  }
+  return cmp < 0;
+}
+
+bool ExternalSort::RunLess(const std::vector<std::unique_ptr<RunReader>> &readers, uint32_t a, uint32_t b) const {
+  const char *rec_a = readers[a]->Current();
+  const char *rec_b = readers[b]->Current();
+  if (rec_a == nullptr || rec_b == nullptr) {
+    return rec_b == nullptr && rec_a != nullptr;
+  }
+  // Runs hold consecutive parts of the input, so ties go to the earlier run.
+  return Less(rec_a, rec_b) || (!Less(rec_b, rec_a) && a < b);
+}
+
+Tuple ExternalSort::GetRecordTuple(const char *record) const {
+  const char *tuple_data = record + sizeof(uint32_t) + key_width_;
+  uint32_t tuple_size;
+  memcpy(&tuple_size, tuple_data, sizeof(uint32_t));
+  return Tuple(TupleView(tuple_data + sizeof(uint32_t), tuple_size, RID()));
+}
+
+}  // namespace bustub
@@ -0,0 +1,593 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// packed_aggregation_hash_table.cpp
+//
+// Identification: src/execution/packed_aggregation_hash_table.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/packed_aggregation_hash_table.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "common/exception.h"
+#include "common/hyperloglog.h"
+#include "execution/approximate_aggregate.h"
+#include "execution/expressions/column_value_expression.h"
+#include "murmur3/MurmurHash3.h"
+#include "type/limits.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+bool IsIntegral(TypeId type) {
+  return type == TypeId::TINYINT || type == TypeId::SMALLINT || type == TypeId::INTEGER || type == TypeId::BIGINT;
+}
+
+uint32_t AlignUp(uint32_t n, uint32_t align) { return (n + align - 1) / align * align; }
+
+/** Reads an integral column and widens it to int64_t. @return false if the column is NULL */
+inline bool LoadInteger(TypeId type, const char *ptr, int64_t *out) {
+  switch (type) {
+    case TypeId::TINYINT: {
+      int8_t raw;
+      memcpy(&raw, ptr, sizeof(raw));
+      *out = raw;
+      return raw != BUSTUB_INT8_NULL;
+    }
+    case TypeId::SMALLINT: {
+      int16_t raw;
+      memcpy(&raw, ptr, sizeof(raw));
+      *out = raw;
+      return raw != BUSTUB_INT16_NULL;
+    }
+    case TypeId::INTEGER: {
+      int32_t raw;
+      memcpy(&raw, ptr, sizeof(raw));
+      *out = raw;
+      return raw != BUSTUB_INT32_NULL;
+    }
+    case TypeId::BIGINT: {
+      memcpy(out, ptr, sizeof(int64_t));
+      return *out != BUSTUB_INT64_NULL;
+    }
+    default:
+      UNREACHABLE("Not an integral column.");
+  }
+}
+
+/** Reads a numeric column as a double. @return false if the column is NULL */
+inline bool LoadDecimal(TypeId type, const char *ptr, double *out) {
+  if (IsIntegral(type)) {
+    int64_t raw;
+    bool not_null = LoadInteger(type, ptr, &raw);
+    *out = static_cast<double>(raw);
+    return not_null;
+  }
+  memcpy(out, ptr, sizeof(double));
+  return *out != BUSTUB_DECIMAL_NULL;
+}
+
+/** Hashes a column like HashUtil::HashValue() hashes its value. @return false if the column is NULL */
+inline bool HashColumn(TypeId type, const char *ptr, hash_t *out) {
+  if (IsIntegral(type)) {
+    int64_t raw;
+    if (!LoadInteger(type, ptr, &raw)) {
+      return false;
+    }
+    *out = HashUtil::Hash<int64_t>(&raw);
+    return true;
+  }
+  if (type == TypeId::DECIMAL) {
+    double raw;
+    memcpy(&raw, ptr, sizeof(raw));
+    *out = HashUtil::Hash<double>(&raw);
+    return raw != BUSTUB_DECIMAL_NULL;
+  }
+  uint64_t raw;
+  memcpy(&raw, ptr, sizeof(raw));
+  *out = HashUtil::Hash<uint64_t>(&raw);
+  return raw != BUSTUB_TIMESTAMP_NULL;
+}
+
+/** @return the column a plain column reference points to, nullptr if expr is anything else */
+const Column *GetInlinedColumn(const Schema *schema, const AbstractExpression *expr) {
+  const auto *col_expr = dynamic_cast<const ColumnValueExpression *>(expr);
+  if (col_expr == nullptr || col_expr->GetColIdx() >= schema->GetColumnCount()) {
+    return nullptr;
+  }
+  const Column &col = schema->GetColumn(col_expr->GetColIdx());
+  return col.IsInlined() ? &col : nullptr;
+}
+
+/** @return the typed update for an aggregate over a column of the given type, false if there is none */
+bool PickAccumulatorOp(AggregationType agg_type, TypeId input_type, AccumulatorOp *op) {
+  bool integral = IsIntegral(input_type);
+  bool decimal = input_type == TypeId::DECIMAL;
+  bool timestamp = input_type == TypeId::TIMESTAMP;
+  switch (agg_type) {
+    case AggregationType::CountAggregate:
+      *op = AccumulatorOp::Count;
+      return true;
+    case AggregationType::SumAggregate:
+      *op = integral ? AccumulatorOp::SumInteger : AccumulatorOp::SumDecimal;
+      return integral || decimal;
+    case AggregationType::MinAggregate:
+      *op = integral ? AccumulatorOp::MinInteger : decimal ? AccumulatorOp::MinDecimal : AccumulatorOp::MinTimestamp;
+      return integral || decimal || timestamp;
+    case AggregationType::MaxAggregate:
+      *op = integral ? AccumulatorOp::MaxInteger : decimal ? AccumulatorOp::MaxDecimal : AccumulatorOp::MaxTimestamp;
+      return integral || decimal || timestamp;
+    case AggregationType::ApproxCountDistinctAggregate:
+      *op = AccumulatorOp::ApproxCountDistinct;
+      return integral || decimal || timestamp;
+    case AggregationType::AvgAggregate:
+      *op = AccumulatorOp::Avg;
+      return integral || decimal;
+    case AggregationType::SumErrorAggregate:
+      *op = AccumulatorOp::SumError;
+      return integral || decimal;
+    case AggregationType::AvgErrorAggregate:
+      *op = AccumulatorOp::AvgError;
+      return integral || decimal;
+  }
+  return false;
+}
+
+/** @return an integral value of the given type */
+Value MakeIntegerValue(TypeId type, int64_t val) {
+  switch (type) {
+    case TypeId::TINYINT:
+      return ValueFactory::GetTinyIntValue(static_cast<int8_t>(val));
+    case TypeId::SMALLINT:
+      return ValueFactory::GetSmallIntValue(static_cast<int16_t>(val));
+    case TypeId::INTEGER:
+      if (val > BUSTUB_INT32_MAX || val < BUSTUB_INT32_MIN) {
+        throw Exception(ExceptionType::OUT_OF_RANGE, "Numeric value out of range.");
+      }
+      return ValueFactory::GetIntegerValue(static_cast<int32_t>(val));
+    case TypeId::BIGINT:
+      return ValueFactory::GetBigIntValue(val);
+    default:
+      UNREACHABLE("Not an integral type.");
+  }
+}
+
+}  // namespace
+
+bool PackedAggregationHashTable::CanHandle(const Schema *input_schema,
+                                           const std::vector<const AbstractExpression *> &group_bys,
+                                           const std::vector<const AbstractExpression *> &aggregates,
+                                           const std::vector<AggregationType> &agg_types) {
+  if (input_schema == nullptr || aggregates.size() != agg_types.size()) {
+    return false;
+  }
+  uint32_t key_width = 0;
+  for (const auto *expr : group_bys) {
+    const Column *col = GetInlinedColumn(input_schema, expr);
+    if (col == nullptr) {
+      return false;
+    }
+    key_width += col->GetFixedLength();
+  }
+  auto num_flags = static_cast<uint32_t>(aggregates.size());
+  uint32_t row_width = AlignUp(key_width, sizeof(int64_t)) + AlignUp(num_flags, sizeof(int64_t));
+  for (uint32_t i = 0; i < aggregates.size(); i++) {
+    const Column *col = GetInlinedColumn(input_schema, aggregates[i]);
+    AccumulatorOp op;
+    if (col == nullptr || !PickAccumulatorOp(agg_types[i], col->GetType(), &op)) {
+      return false;
+    }
+    row_width += GetStateWidth(op);
+  }
+  return row_width <= MAX_ROW_WIDTH;
+}
+
+uint32_t PackedAggregationHashTable::GetStateWidth(AccumulatorOp op) {
+  switch (op) {
+    case AccumulatorOp::ApproxCountDistinct:
+      return 1U << ApproximateAggregate::APPROX_DISTINCT_PRECISION;
+    case AccumulatorOp::Avg:
+    case AccumulatorOp::SumError:
+    case AccumulatorOp::AvgError:
+      return sizeof(SampleMoments);
+    default:
+      return sizeof(int64_t);
+  }
+}
+
+PackedAggregationHashTable::PackedAggregationHashTable(const Schema *input_schema,
+                                                       const std::vector<const AbstractExpression *> &group_bys,
+                                                       const std::vector<const AbstractExpression *> &aggregates,
+                                                       const std::vector<AggregationType> &agg_types,
+                                                       double sample_rate)
+    : sample_rate_(sample_rate) {
+  BUSTUB_ASSERT(CanHandle(input_schema, group_bys, aggregates, agg_types), "Unsupported aggregation.");
+  for (const auto *expr : group_bys) {
+    const Column *col = GetInlinedColumn(input_schema, expr);
+    keys_.push_back({col->GetOffset(), key_width_, col->GetFixedLength(), col->GetType()});
+    key_width_ += col->GetFixedLength();
+  }
+  state_offset_ = AlignUp(key_width_, sizeof(int64_t));
+  null_offset_ = state_offset_;
+  for (uint32_t i = 0; i < aggregates.size(); i++) {
+    const Column *col = GetInlinedColumn(input_schema, aggregates[i]);
+    Accumulator acc{AccumulatorOp::Count, col->GetOffset(), col->GetType(), null_offset_};
+    PickAccumulatorOp(agg_types[i], col->GetType(), &acc.op_);
+    accumulators_.push_back(acc);
+    null_offset_ += GetStateWidth(acc.op_);
+  }
+  row_width_ = AlignUp(null_offset_ + static_cast<uint32_t>(accumulators_.size()), sizeof(int64_t));
+  row_width_ = std::max<uint32_t>(row_width_, sizeof(int64_t));
+  key_buffer_.resize(std::max<uint32_t>(key_width_, 1));
+  slots_.assign(INITIAL_SLOTS, Slot{0, EMPTY_SLOT});
+}
+
+void PackedAggregationHashTable::InsertCombine(const Tuple &tuple) {
+  const char *data = tuple.GetData();
+  for (const auto &key : keys_) {
+    memcpy(key_buffer_.data() + key.key_offset_, data + key.tuple_offset_, key.size_);
+  }
+  Accumulate(FindOrCreateGroup(HashKey(key_buffer_.data())), data);
+}
+
+void PackedAggregationHashTable::Combine(uint32_t group_idx, const Tuple &tuple) {
+  Accumulate(GetRow(group_idx), tuple.GetData());
+}
+
+bool PackedAggregationHashTable::KeyEquals(uint32_t group_idx, const Tuple &tuple) const {
+  const char *row = GetRow(group_idx);
+  const char *data = tuple.GetData();
+  for (const auto &key : keys_) {
+    if (memcmp(row + key.key_offset_, data + key.tuple_offset_, key.size_) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void PackedAggregationHashTable::Accumulate(char *row, const char *data) {
+  for (uint32_t i = 0; i < accumulators_.size(); i++) {
+    const Accumulator &acc = accumulators_[i];
+    char *state = row + acc.state_offset_;
+    char *is_null = row + null_offset_ + i;
+    const char *input = data + acc.tuple_offset_;
+    switch (acc.op_) {
+      case AccumulatorOp::Count: {
+        int64_t count;
+        memcpy(&count, state, sizeof(count));
+        count++;
+        memcpy(state, &count, sizeof(count));
+        break;
+      }
+      case AccumulatorOp::SumInteger:
+      case AccumulatorOp::MinInteger:
+      case AccumulatorOp::MaxInteger: {
+        int64_t val;
+        if (!LoadInteger(acc.input_type_, input, &val)) {
+          *is_null = 1;
+          break;
+        }
+        int64_t cur;
+        memcpy(&cur, state, sizeof(cur));
+        cur = acc.op_ == AccumulatorOp::SumInteger ? cur + val
+                                                   : acc.op_ == AccumulatorOp::MinInteger ? std::min(cur, val)
+                                                                                          : std::max(cur, val);
+        memcpy(state, &cur, sizeof(cur));
+        break;
+      }
+      case AccumulatorOp::SumDecimal:
+      case AccumulatorOp::MinDecimal:
+      case AccumulatorOp::MaxDecimal: {
+        double val;
+        if (!LoadDecimal(acc.input_type_, input, &val)) {
+          *is_null = 1;
+          break;
+        }
+        double cur;
+        memcpy(&cur, state, sizeof(cur));
+        cur = acc.op_ == AccumulatorOp::SumDecimal ? cur + val
+                                                   : acc.op_ == AccumulatorOp::MinDecimal ? std::min(cur, val)
+                                                                                          : std::max(cur, val);
+        memcpy(state, &cur, sizeof(cur));
+        break;
+      }
+      case AccumulatorOp::MinTimestamp:
+      case AccumulatorOp::MaxTimestamp: {
+        uint64_t val;
+        memcpy(&val, input, sizeof(val));
+        if (val == BUSTUB_TIMESTAMP_NULL) {
+          *is_null = 1;
+          break;
+        }
+        uint64_t cur;
+        memcpy(&cur, state, sizeof(cur));
+        cur = acc.op_ == AccumulatorOp::MinTimestamp ? std::min(cur, val) : std::max(cur, val);
+        memcpy(state, &cur, sizeof(cur));
+        break;
+      }
+      case AccumulatorOp::ApproxCountDistinct: {
+        // NULLs are not counted.
+        hash_t hash;
+        if (HashColumn(acc.input_type_, input, &hash)) {
+          HyperLogLog::AddHash(reinterpret_cast<uint8_t *>(state), ApproximateAggregate::APPROX_DISTINCT_PRECISION,
+                               hash);
+        }
+        break;
+      }
+      case AccumulatorOp::Avg:
+      case AccumulatorOp::SumError:
+      case AccumulatorOp::AvgError: {
+        // NULLs are skipped.
+        double val;
+        if (LoadDecimal(acc.input_type_, input, &val)) {
+          SampleMoments moments;
+          memcpy(&moments, state, sizeof(moments));
+          moments.Add(val);
+          memcpy(state, &moments, sizeof(moments));
+        }
+        break;
+      }
+    }
+  }
+}
+
+void PackedAggregationHashTable::MergeRow(const char *input_row) {
+  memcpy(key_buffer_.data(), input_row, key_width_);
+  char *row = FindOrCreateGroup(HashKey(key_buffer_.data()));
+
+  for (uint32_t i = 0; i < accumulators_.size(); i++) {
+    char *state = row + accumulators_[i].state_offset_;
+    const char *input = input_row + accumulators_[i].state_offset_;
+    row[null_offset_ + i] |= input_row[null_offset_ + i];
+    switch (accumulators_[i].op_) {
+      case AccumulatorOp::Count:
+      case AccumulatorOp::SumInteger:
+      case AccumulatorOp::MinInteger:
+      case AccumulatorOp::MaxInteger: {
+        int64_t cur;
+        int64_t val;
+        memcpy(&cur, state, sizeof(cur));
+        memcpy(&val, input, sizeof(val));
+        AccumulatorOp op = accumulators_[i].op_;
+        cur = op == AccumulatorOp::MinInteger ? std::min(cur, val)
+                                              : op == AccumulatorOp::MaxInteger ? std::max(cur, val) : cur + val;
+        memcpy(state, &cur, sizeof(cur));
+        break;
+      }
+      case AccumulatorOp::SumDecimal:
+      case AccumulatorOp::MinDecimal:
+      case AccumulatorOp::MaxDecimal: {
+        double cur;
+        double val;
+        memcpy(&cur, state, sizeof(cur));
+        memcpy(&val, input, sizeof(val));
+        AccumulatorOp op = accumulators_[i].op_;
+        cur = op == AccumulatorOp::MinDecimal ? std::min(cur, val)
+                                              : op == AccumulatorOp::MaxDecimal ? std::max(cur, val) : cur + val;
+        memcpy(state, &cur, sizeof(cur));
+        break;
+      }
+      case AccumulatorOp::MinTimestamp:
+      case AccumulatorOp::MaxTimestamp: {
+        uint64_t cur;
+        uint64_t val;
+        memcpy(&cur, state, sizeof(cur));
+        memcpy(&val, input, sizeof(val));
+        cur = accumulators_[i].op_ == AccumulatorOp::MinTimestamp ? std::min(cur, val) : std::max(cur, val);
+        memcpy(state, &cur, sizeof(cur));
+        break;
+      }
+      case AccumulatorOp::ApproxCountDistinct:
+        HyperLogLog::Merge(reinterpret_cast<uint8_t *>(state), reinterpret_cast<const uint8_t *>(input),
+                           ApproximateAggregate::APPROX_DISTINCT_PRECISION);
+        break;
+      case AccumulatorOp::Avg:
+      case AccumulatorOp::SumError:
+      case AccumulatorOp::AvgError: {
+        SampleMoments cur;
+        SampleMoments val;
+        memcpy(&cur, state, sizeof(cur));
+        memcpy(&val, input, sizeof(val));
+        cur.Merge(val);
+        memcpy(state, &cur, sizeof(cur));
+        break;
+      }
+    }
+  }
+}
+
+hash_t PackedAggregationHashTable::GetRowHash(uint32_t group_idx) const { return HashKey(GetRow(group_idx)); }
+
+hash_t PackedAggregationHashTable::HashKey(const char *key) const {
+  uint64_t hash[2] = {0, 0};
+  murmur3::MurmurHash3_x64_128(key, static_cast<int>(key_width_), 0, hash);
+  return hash[0];
+}
+
+char *PackedAggregationHashTable::FindOrCreateGroup(hash_t hash) {
+  size_t mask = slots_.size() - 1;
+  for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+    Slot &slot = slots_[pos];
+    if (slot.group_ == EMPTY_SLOT) {
+      // New group: append a row with the key and the initial state of every aggregate.
+      uint32_t group_idx = num_groups_++;
+      rows_.resize(static_cast<size_t>(num_groups_) * row_width_);
+      char *row = GetRow(group_idx);
+      memset(row, 0, row_width_);
+      memcpy(row, key_buffer_.data(), key_width_);
+      for (const Accumulator &acc : accumulators_) {
+        char *state = row + acc.state_offset_;
+        switch (acc.op_) {
+          case AccumulatorOp::MinInteger: {
+            int64_t init = std::numeric_limits<int64_t>::max();
+            memcpy(state, &init, sizeof(init));
+            break;
+          }
+          case AccumulatorOp::MaxInteger: {
+            int64_t init = std::numeric_limits<int64_t>::min();
+            memcpy(state, &init, sizeof(init));
+            break;
+          }
+          case AccumulatorOp::MinDecimal: {
+            double init = std::numeric_limits<double>::infinity();
+            memcpy(state, &init, sizeof(init));
+            break;
+          }
+          case AccumulatorOp::MaxDecimal: {
+            double init = -std::numeric_limits<double>::infinity();
+            memcpy(state, &init, sizeof(init));
+            break;
+          }
+          case AccumulatorOp::MinTimestamp: {
+            uint64_t init = std::numeric_limits<uint64_t>::max();
+            memcpy(state, &init, sizeof(init));
+            break;
+          }
+          default:
+            // Counts, sums, MaxTimestamp, moments and sketches start at zero.
+            break;
+        }
+      }
+      slot.hash_ = hash;
+      slot.group_ = group_idx;
+      if (static_cast<size_t>(num_groups_) * 2 > slots_.size()) {
+        Grow();
+        return GetRow(group_idx);
+      }
+      return row;
+    }
+    if (slot.hash_ == hash && memcmp(GetRow(slot.group_), key_buffer_.data(), key_width_) == 0) {
+      return GetRow(slot.group_);
+    }
+  }
+}
+
+void PackedAggregationHashTable::Grow() {
+  std::vector<Slot> slots(slots_.size() * 2, Slot{0, EMPTY_SLOT});
+  size_t mask = slots.size() - 1;
+  for (const Slot &slot : slots_) {
+    if (slot.group_ == EMPTY_SLOT) {
+      continue;
+    }
+    size_t pos = slot.hash_ & mask;
+    while (slots[pos].group_ != EMPTY_SLOT) {
+      pos = (pos + 1) & mask;
+    }
+    slots[pos] = slot;
+  }
+  slots_ = std::move(slots);
+}
+
+void PackedAggregationHashTable::GetGroup(uint32_t group_idx, std::vector<Value> *group_bys,
+                                          std::vector<Value> *aggregates) const {
+  const char *row = GetRow(group_idx);
+  group_bys->clear();
+  for (const auto &key : keys_) {
+    group_bys->emplace_back(Value::DeserializeFrom(row + key.key_offset_, key.type_));
+  }
+  aggregates->clear();
+  for (uint32_t i = 0; i < accumulators_.size(); i++) {
+    const Accumulator &acc = accumulators_[i];
+    const char *state = row + acc.state_offset_;
+    bool is_null = row[null_offset_ + i] != 0;
+    // COUNT and SUM of a sample are scaled up to the whole input.
+    bool scale = sample_rate_ < 1 && (acc.op_ == AccumulatorOp::Count || acc.op_ == AccumulatorOp::SumInteger ||
+                                      acc.op_ == AccumulatorOp::SumDecimal);
+    switch (acc.op_) {
+      case AccumulatorOp::Count: {
+        int64_t count;
+        memcpy(&count, state, sizeof(count));
+        if (scale) {
+          count = std::llround(static_cast<double>(count) / sample_rate_);
+        }
+        aggregates->emplace_back(MakeIntegerValue(TypeId::INTEGER, count));
+        break;
+      }
+      case AccumulatorOp::SumInteger:
+      case AccumulatorOp::MinInteger:
+      case AccumulatorOp::MaxInteger: {
+        // SUM is computed as INTEGER + input, so it is at least an INTEGER; MIN and MAX keep the input type.
+        TypeId type = acc.input_type_;
+        if (acc.op_ == AccumulatorOp::SumInteger && type != TypeId::BIGINT) {
+          type = TypeId::INTEGER;
+        }
+        int64_t val;
+        memcpy(&val, state, sizeof(val));
+        if (scale) {
+          val = std::llround(static_cast<double>(val) / sample_rate_);
+        }
+        aggregates->emplace_back(is_null ? ValueFactory::GetNullValueByType(type) : MakeIntegerValue(type, val));
+        break;
+      }
+      case AccumulatorOp::SumDecimal:
+      case AccumulatorOp::MinDecimal:
+      case AccumulatorOp::MaxDecimal: {
+        double val;
+        memcpy(&val, state, sizeof(val));
+        if (scale) {
+          val /= sample_rate_;
+        }
+        aggregates->emplace_back(is_null ? ValueFactory::GetNullValueByType(TypeId::DECIMAL)
+                                         : ValueFactory::GetDecimalValue(val));
+        break;
+      }
+      case AccumulatorOp::MinTimestamp:
+      case AccumulatorOp::MaxTimestamp: {
+        uint64_t val;
+        memcpy(&val, state, sizeof(val));
+        aggregates->emplace_back(is_null ? ValueFactory::GetNullValueByType(TypeId::TIMESTAMP)
+                                         : ValueFactory::GetTimestampValue(val));
+        break;
+      }
+      case AccumulatorOp::ApproxCountDistinct: {
+        double estimate = HyperLogLog::Estimate(reinterpret_cast<const uint8_t *>(state),
+                                                ApproximateAggregate::APPROX_DISTINCT_PRECISION);
+        aggregates->emplace_back(MakeIntegerValue(TypeId::INTEGER, std::llround(estimate)));
+        break;
+      }
+      case AccumulatorOp::Avg:
+      case AccumulatorOp::SumError:
+      case AccumulatorOp::AvgError: {
+        SampleMoments m;
+        memcpy(&m, state, sizeof(m));
+        if (acc.op_ == AccumulatorOp::Avg) {
+          aggregates->emplace_back(m.count_ == 0 ? ValueFactory::GetNullValueByType(TypeId::DECIMAL)
+                                                 : ValueFactory::GetDecimalValue(m.sum_ / m.count_));
+        } else if (acc.op_ == AccumulatorOp::SumError) {
+          aggregates->emplace_back(
+              ValueFactory::GetDecimalValue(ApproximateAggregate::SumErrorBound(m.sum_squares_, sample_rate_)));
+        } else {
+          aggregates->emplace_back(ValueFactory::GetDecimalValue(
+              ApproximateAggregate::AvgErrorBound(m.count_, m.sum_, m.sum_squares_, sample_rate_)));
+        }
+        break;
+      }
+    }
+  }
+}
+
+void PackedAggregationHashTable::Clear() {
+  rows_.clear();
+  num_groups_ = 0;
+  slots_.assign(INITIAL_SLOTS, Slot{0, EMPTY_SLOT});
+}
+
+void PackedAggregationHashTable::Release() {
+  // Hand the memory back instead of keeping the capacity, GetMemoryUsage() no longer counts it.
+  std::vector<char>().swap(rows_);
+  num_groups_ = 0;
+  std::vector<Slot>(INITIAL_SLOTS, Slot{0, EMPTY_SLOT}).swap(slots_);
+}
+
+}  // namespace bustub
@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// packed_key_set.cpp
+//
+// Identification: src/execution/packed_key_set.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/packed_key_set.h"
+
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "murmur3/MurmurHash3.h"
+
+namespace bustub {
+
+hash_t PackedKeySet::Hash(const char *key, uint32_t size) {
+  uint64_t hash[2] = {0, 0};
+  murmur3::MurmurHash3_x64_128(key, static_cast<int>(size), 0, hash);
+  return hash[0];
+}
+
+bool PackedKeySet::Insert(const char *key, uint32_t size, hash_t hash) {
+  auto tag = static_cast<uint32_t>(hash);
+  size_t mask = slots_.size() - 1;
+  for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+    Slot &slot = slots_[pos];
+    if (slot.entry_ == EMPTY_SLOT) {
+      slot.tag_ = tag;
+      slot.entry_ = static_cast<uint32_t>(entries_.size());
+      entries_.push_back(Entry{static_cast<uint32_t>(keys_.size()), size});
+      keys_.insert(keys_.end(), key, key + size);
+      if (entries_.size() * 2 > slots_.size()) {
+        Grow();
+      }
+      return true;
+    }
+    if (slot.tag_ == tag) {
+      const Entry &entry = entries_[slot.entry_];
+      if (entry.size_ == size && memcmp(keys_.data() + entry.offset_, key, size) == 0) {
+        return false;
+      }
+    }
+  }
+}
+
+void PackedKeySet::Grow() {
+  std::vector<Slot> slots(slots_.size() * 2, Slot{0, EMPTY_SLOT});
+  size_t mask = slots.size() - 1;
+  for (const Slot &slot : slots_) {
+    if (slot.entry_ == EMPTY_SLOT) {
+      continue;
+    }
+    // The tag holds all the bits the mask can take.
+    size_t pos = slot.tag_ & mask;
+    while (slots[pos].entry_ != EMPTY_SLOT) {
+      pos = (pos + 1) & mask;
+    }
+    slots[pos] = slot;
+  }
+  slots_ = std::move(slots);
+}
+
+void PackedKeySet::Clear() {
+  // Hand the memory back instead of keeping the capacity, GetMemoryUsage() no longer counts it.
+  std::vector<char>().swap(keys_);
+  std::vector<Entry>().swap(entries_);
+  std::vector<Slot>(INITIAL_SLOTS, Slot{0, EMPTY_SLOT}).swap(slots_);
+}
+
+}  // namespace bustub
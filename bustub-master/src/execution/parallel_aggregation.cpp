@@ -0,0 +1,175 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_aggregation.cpp
+//
+// Identification: src/execution/parallel_aggregation.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/parallel_aggregation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "common/exception.h"
+#include "common/task_pool.h"
+
+namespace bustub {
+
+ParallelAggregation::ParallelAggregation(const Schema *input_schema,
+                                         const std::vector<const AbstractExpression *> &group_bys,
+                                         const std::vector<const AbstractExpression *> &aggregates,
+                                         const std::vector<AggregationType> &agg_types, uint32_t num_threads,
+                                         MemoryTracker *memory_tracker, double sample_rate)
+    : input_schema_(input_schema),
+      group_bys_(group_bys),
+      aggregates_(aggregates),
+      agg_types_(agg_types),
+      num_threads_(std::max<uint32_t>(num_threads, 1)),
+      memory_tracker_(memory_tracker),
+      sample_rate_(sample_rate) {}
+
+bool ParallelAggregation::Run(uint32_t num_morsels, const MorselScan &scan) {
+  local_tables_.clear();
+  partition_tables_.clear();
+  memory_tracker_->Release(charged_);
+  charged_ = 0;
+  for (uint32_t i = 0; i < num_threads_; i++) {
+    local_tables_.emplace_back(MakeTable());
+  }
+  for (uint32_t i = 0; i < NUM_PARTITIONS; i++) {
+    partition_tables_.emplace_back(MakeTable());
+  }
+
+  // Phase 1: pre-aggregate morsels into the private table of the worker, then partition its groups.
+  std::atomic<uint32_t> next_morsel{0};
+  std::atomic<bool> out_of_memory{false};
+  std::atomic<bool> failed{false};
+  std::vector<size_t> local_charged(num_threads_, 0);
+  std::vector<std::vector<std::vector<uint32_t>>> partitions(num_threads_);
+  RunWorkers([&](uint32_t worker_idx) {
+    PackedAggregationHashTable *table = local_tables_[worker_idx].get();
+    Sink sink = [table](const Tuple &tuple) { table->InsertCombine(tuple); };
+    for (uint32_t morsel = next_morsel++; morsel < num_morsels && !out_of_memory && !failed;
+         morsel = next_morsel++) {
+      if (!scan(morsel, sink)) {
+        failed = true;
+      }
+      if (!Charge(table, &local_charged[worker_idx])) {
+        out_of_memory = true;
+      }
+    }
+    if (failed) {
+      return;
+    }
+    auto &groups = partitions[worker_idx];
+    groups.resize(NUM_PARTITIONS);
+    for (uint32_t i = 0; i < table->Size(); i++) {
+      groups[table->GetRowHash(i) >> (sizeof(hash_t) * 8 - PARTITION_BITS)].push_back(i);
+    }
+  });
+
+  size_t local_total = 0;
+  for (size_t charged : local_charged) {
+    local_total += charged;
+  }
+  charged_ = local_total;
+  if (failed) {
+    Discard();
+    return false;
+  }
+  if (out_of_memory) {
+    FailOutOfMemory();
+  }
+
+  // Phase 2: merge the partial groups of each partition across all local tables.
+  std::atomic<uint32_t> next_partition{0};
+  std::vector<size_t> partition_charged(NUM_PARTITIONS, 0);
+  RunWorkers([&](uint32_t worker_idx) {
+    for (uint32_t p = next_partition++; p < NUM_PARTITIONS && !out_of_memory; p = next_partition++) {
+      PackedAggregationHashTable *merged = partition_tables_[p].get();
+      for (uint32_t w = 0; w < num_threads_; w++) {
+        for (uint32_t group_idx : partitions[w][p]) {
+          merged->MergeRow(local_tables_[w]->GetRowData(group_idx));
+        }
+      }
+      if (!Charge(merged, &partition_charged[p])) {
+        out_of_memory = true;
+      }
+    }
+  });
+  for (size_t charged : partition_charged) {
+    charged_ += charged;
+  }
+  if (out_of_memory) {
+    FailOutOfMemory();
+  }
+  local_tables_.clear();
+  memory_tracker_->Release(local_total);
+  charged_ -= local_total;
+
+  partition_idx_ = 0;
+  group_idx_ = 0;
+  return true;
+}
+
+bool ParallelAggregation::Next(std::vector<Value> *group_bys, std::vector<Value> *aggregates) {
+  while (partition_idx_ < partition_tables_.size()) {
+    if (group_idx_ < partition_tables_[partition_idx_]->Size()) {
+      partition_tables_[partition_idx_]->GetGroup(group_idx_++, group_bys, aggregates);
+      return true;
+    }
+    partition_idx_++;
+    group_idx_ = 0;
+  }
+  return false;
+}
+
+uint32_t ParallelAggregation::Size() const {
+  uint32_t size = 0;
+  for (const auto &table : partition_tables_) {
+    size += table->Size();
+  }
+  return size;
+}
+
+bool ParallelAggregation::Charge(const PackedAggregationHashTable *table, size_t *charged) const {
+  size_t memory_usage = table->GetMemoryUsage();
+  if (memory_usage > *charged && !memory_tracker_->TryConsume(memory_usage - *charged)) {
+    return false;
+  }
+  *charged = std::max(*charged, memory_usage);
+  return true;
+}
+
+void ParallelAggregation::Discard() {
+  local_tables_.clear();
+  partition_tables_.clear();
+  memory_tracker_->Release(charged_);
+  charged_ = 0;
+}
+
+void ParallelAggregation::FailOutOfMemory() {
+  Discard();
+  throw Exception(ExceptionType::OUT_OF_MEMORY, "Parallel aggregation exceeds the memory limit of the query.");
+}
+
+std::unique_ptr<PackedAggregationHashTable> ParallelAggregation::MakeTable() const {
+  return std::make_unique<PackedAggregationHashTable>(input_schema_, group_bys_, aggregates_, agg_types_,
+                                                      sample_rate_);
+}
+
+void ParallelAggregation::RunWorkers(const std::function<void(uint32_t worker_idx)> &fn) const {
+  if (num_threads_ == 1) {
+    fn(0);
+    return;
+  }
+  TaskPool::GetShared()->ParallelFor(num_threads_, [&fn](size_t worker_idx) { fn(worker_idx); });
+}
+
+}  // namespace bustub
@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// query_profile.cpp
+//
+// Identification: src/execution/query_profile.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/query_profile.h"
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace bustub {
+
+namespace {
+
+/** @return the name of a plan type, for plan nodes without a profile */
+const char *PlanTypeName(PlanType type) {
+  switch (type) {
+    case PlanType::SeqScan:
+      return "SeqScan";
+    case PlanType::IndexScan:
+      return "IndexScan";
+    case PlanType::HashJoin:
+      return "HashJoin";
+    case PlanType::Insert:
+      return "Insert";
+    case PlanType::Aggregation:
+      return "Aggregation";
+    case PlanType::Sort:
+      return "Sort";
+    case PlanType::TopN:
+      return "TopN";
+    case PlanType::Limit:
+      return "Limit";
+    case PlanType::Distinct:
+      return "Distinct";
+    case PlanType::LateMaterialize:
+      return "LateMaterialize";
+    case PlanType::ViewScan:
+      return "ViewScan";
+  }
+  return "Unknown";
+}
+
+/** @return a - b, or 0 if the estimated time of the children exceeds that of their parent */
+uint64_t Subtract(uint64_t a, uint64_t b) { return a > b ? a - b : 0; }
+
+}  // namespace
+
+std::string QueryProfile::ToString(const AbstractPlanNode *plan) const {
+  uint64_t ticks = Now() - start_ticks_;
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time_).count();
+  std::string out;
+  Render(plan, 0, ticks == 0 ? 0 : ms / static_cast<double>(ticks), &out);
+  return out;
+}
+
+void QueryProfile::Render(const AbstractPlanNode *plan, uint32_t depth, double ms_per_tick, std::string *out) const {
+  out->append(2 * depth, ' ');
+  const OperatorProfile *op = GetOperator(plan);
+  if (op == nullptr) {
+    out->append(PlanTypeName(plan->GetType())).append(" (not profiled)\n");
+  } else {
+    uint64_t child_ticks = 0;
+    for (const auto *child : plan->GetChildren()) {
+      if (const OperatorProfile *child_op = GetOperator(child)) {
+        child_ticks += child_op->GetTotalTicks();
+      }
+    }
+    const BufferPoolStats &buffer_pool = op->buffer_pool_;
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(3) << op->name_ << " (rows=" << op->rows_
+         << ", init=" << ms_per_tick * static_cast<double>(op->init_ticks_)
+         << "ms, next=" << ms_per_tick * static_cast<double>(op->GetNextTicks())
+         << "ms, self=" << ms_per_tick * static_cast<double>(Subtract(op->GetTotalTicks(), child_ticks))
+         << "ms, fetches=" << buffer_pool.fetches_ << ", hits=" << buffer_pool.fetches_ - buffer_pool.misses_
+         << ", misses=" << buffer_pool.misses_
+         << ", peak_memory=" << op->peak_memory_ << "B)\n";
+    out->append(line.str());
+  }
+  for (const auto *child : plan->GetChildren()) {
+    Render(child, depth + 1, ms_per_tick, out);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,362 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// result_cache.cpp
+//
+// Identification: src/execution/result_cache.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/result_cache.h"
+
+#include <cstring>
+#include <iterator>
+#include <typeinfo>
+
+#include "execution/executor_factory.h"
+#include "execution/expressions/aggregate_value_expression.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "execution/expressions/row_id_expression.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/hash_join_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/insert_plan.h"
+#include "execution/plans/late_materialize_plan.h"
+#include "execution/plans/limit_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/plans/topn_plan.h"
+#include "execution/plans/view_scan_plan.h"
+
+namespace bustub {
+
+namespace {
+
+/** Append the placeholder of a constant to a fingerprint and the constant to the parameters. */
+void AppendParam(const Value &value, std::string *out, std::vector<Value> *params) {
+  *out += "?" + std::to_string(static_cast<int>(value.GetTypeId()));
+  params->push_back(value);
+}
+
+/** Append a double exactly, as its bits. */
+void AppendDouble(double value, std::string *out) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  *out += std::to_string(bits);
+}
+
+void AppendExpression(const AbstractExpression *expr, std::string *out, std::vector<Value> *params) {
+  if (expr == nullptr) {
+    *out += "-";
+    return;
+  }
+  if (const auto *constant = dynamic_cast<const ConstantValueExpression *>(expr)) {
+    AppendParam(constant->GetValue(), out, params);
+    return;
+  }
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr)) {
+    *out += "col" + std::to_string(column->GetTupleIdx()) + "." + std::to_string(column->GetColIdx());
+  } else if (const auto *comparison = dynamic_cast<const ComparisonExpression *>(expr)) {
+    *out += "cmp" + std::to_string(static_cast<int>(comparison->GetComparisonType()));
+  } else if (const auto *logic = dynamic_cast<const LogicExpression *>(expr)) {
+    *out += "logic" + std::to_string(static_cast<int>(logic->GetLogicType()));
+  } else if (const auto *aggregate = dynamic_cast<const AggregateValueExpression *>(expr)) {
+    *out += (aggregate->IsGroupByTerm() ? "group" : "agg") + std::to_string(aggregate->GetTermIdx());
+  } else if (dynamic_cast<const RowIdExpression *>(expr) != nullptr) {
+    *out += "rid";
+  } else {
+    *out += typeid(*expr).name();
+  }
+  *out += ":" + std::to_string(static_cast<int>(expr->GetReturnType())) + "(";
+  for (const auto *child : expr->GetChildren()) {
+    AppendExpression(child, out, params);
+    *out += ",";
+  }
+  *out += ")";
+}
+
+void AppendExpressions(const std::vector<const AbstractExpression *> &exprs, std::string *out,
+                       std::vector<Value> *params) {
+  *out += "[";
+  for (const auto *expr : exprs) {
+    AppendExpression(expr, out, params);
+    *out += ",";
+  }
+  *out += "]";
+}
+
+void AppendOrderBys(const std::vector<OrderBy> &order_bys, std::string *out, std::vector<Value> *params) {
+  *out += "[";
+  for (const auto &order_by : order_bys) {
+    AppendExpression(order_by.first, out, params);
+    *out += order_by.second == OrderByType::Asc ? " asc," : " desc,";
+  }
+  *out += "]";
+}
+
+void AppendPlan(const AbstractPlanNode *plan, std::string *out, std::vector<Value> *params) {
+  switch (plan->GetType()) {
+    case PlanType::SeqScan: {
+      const auto *scan_plan = dynamic_cast<const SeqScanPlanNode *>(plan);
+      *out += "SeqScan t" + std::to_string(scan_plan->GetTableOid()) + " ";
+      AppendExpression(scan_plan->GetPredicate(), out, params);
+      break;
+    }
+    case PlanType::IndexScan: {
+      const auto *index_plan = dynamic_cast<const IndexScanPlanNode *>(plan);
+      *out += "IndexScan t" + std::to_string(index_plan->GetTableOid()) + " i" +
+              std::to_string(index_plan->GetIndexOid()) + " [";
+      for (const auto &key : index_plan->GetKeys()) {
+        for (const auto &value : key) {
+          AppendParam(value, out, params);
+        }
+        *out += ",";
+      }
+      *out += "] ";
+      AppendExpression(index_plan->GetPredicate(), out, params);
+      break;
+    }
+    case PlanType::HashJoin: {
+      const auto *join_plan = dynamic_cast<const HashJoinPlanNode *>(plan);
+      *out += "HashJoin ";
+      AppendExpression(join_plan->Predicate(), out, params);
+      AppendExpressions(join_plan->GetLeftKeys(), out, params);
+      AppendExpressions(join_plan->GetRightKeys(), out, params);
+      break;
+    }
+    case PlanType::Insert: {
+      const auto *insert_plan = dynamic_cast<const InsertPlanNode *>(plan);
+      *out += "Insert t" + std::to_string(insert_plan->TableOid()) + " [";
+      if (insert_plan->IsRawInsert()) {
+        for (const auto &row : insert_plan->RawValues()) {
+          for (const auto &value : row) {
+            AppendParam(value, out, params);
+          }
+          *out += ",";
+        }
+      }
+      *out += "]";
+      break;
+    }
+    case PlanType::Aggregation: {
+      const auto *agg_plan = dynamic_cast<const AggregationPlanNode *>(plan);
+      *out += "Aggregation ";
+      AppendExpressions(agg_plan->GetGroupBys(), out, params);
+      AppendExpressions(agg_plan->GetAggregates(), out, params);
+      *out += "[";
+      for (const auto &agg_type : agg_plan->GetAggregateTypes()) {
+        *out += std::to_string(static_cast<int>(agg_type)) + ",";
+      }
+      *out += "] ";
+      AppendExpression(agg_plan->GetHaving(), out, params);
+      *out += " ";
+      AppendDouble(agg_plan->GetSampleRate(), out);
+      *out += " " + std::to_string(agg_plan->GetSampleSeed());
+      break;
+    }
+    case PlanType::Sort: {
+      *out += "Sort ";
+      AppendOrderBys(dynamic_cast<const SortPlanNode *>(plan)->GetOrderBys(), out, params);
+      break;
+    }
+    case PlanType::TopN: {
+      const auto *topn_plan = dynamic_cast<const TopNPlanNode *>(plan);
+      *out += "TopN " + std::to_string(topn_plan->GetN()) + " ";
+      AppendOrderBys(topn_plan->GetOrderBys(), out, params);
+      break;
+    }
+    case PlanType::Limit: {
+      *out += "Limit " + std::to_string(dynamic_cast<const LimitPlanNode *>(plan)->GetLimit());
+      break;
+    }
+    case PlanType::Distinct: {
+      *out += "Distinct";
+      break;
+    }
+    case PlanType::LateMaterialize: {
+      const auto *late_plan = dynamic_cast<const LateMaterializePlanNode *>(plan);
+      *out += "LateMaterialize t" + std::to_string(late_plan->GetTableOid()) + " r" +
+              std::to_string(late_plan->GetRidColumn());
+      break;
+    }
+    case PlanType::ViewScan: {
+      *out += "ViewScan v" + std::to_string(dynamic_cast<const ViewScanPlanNode *>(plan)->GetViewOid());
+      break;
+    }
+  }
+
+  *out += " {";
+  if (plan->OutputSchema() != nullptr) {
+    for (const auto &column : plan->OutputSchema()->GetColumns()) {
+      *out += column.GetName() + ":" + std::to_string(static_cast<int>(column.GetType())) + "=";
+      AppendExpression(column.GetExpr(), out, params);
+      *out += ",";
+    }
+  }
+  *out += "} <";
+  for (uint32_t col_idx : plan->GetOutputOrdering()) {
+    *out += std::to_string(col_idx) + ",";
+  }
+  *out += "> (";
+  for (const auto *child : plan->GetChildren()) {
+    AppendPlan(child, out, params);
+    *out += ",";
+  }
+  *out += ")";
+}
+
+/** Run a plan and collect its output, copied out of the pages and the arena of the query. */
+void Run(ExecutorContext *exec_ctx, const AbstractPlanNode *plan, std::vector<Tuple> *result) {
+  auto executor = ExecutorFactory::CreateExecutor(exec_ctx, plan);
+  executor->Init();
+  const Schema *schema = plan->OutputSchema();
+  if (schema == nullptr) {
+    // A plan without output, i.e. an insert, does all its work in one call.
+    executor->Next(nullptr);
+    return;
+  }
+  std::vector<Value> values;
+  Tuple tuple;
+  while (executor->Next(&tuple)) {
+    if (tuple.IsAllocated()) {
+      result->push_back(tuple);
+      continue;
+    }
+    values.clear();
+    for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+      values.push_back(tuple.GetValue(schema, i));
+    }
+    result->emplace_back(values, schema);
+  }
+}
+
+}  // namespace
+
+bool ResultCache::IsCacheable(const AbstractPlanNode *plan) {
+  if (plan->GetType() == PlanType::Insert) {
+    return false;
+  }
+  for (const auto *child : plan->GetChildren()) {
+    if (!IsCacheable(child)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string ResultCache::Fingerprint(const AbstractPlanNode *plan, std::vector<Value> *params) {
+  std::string fingerprint;
+  AppendPlan(plan, &fingerprint, params);
+  return fingerprint;
+}
+
+bool ResultCache::Execute(ExecutorContext *exec_ctx, const AbstractPlanNode *plan, std::vector<Tuple> *result) {
+  result->clear();
+  if (!IsCacheable(plan)) {
+    {
+      std::lock_guard<std::mutex> guard(latch_);
+      stats_.uncacheable_++;
+    }
+    Run(exec_ctx, plan, result);
+    return false;
+  }
+
+  ResultCacheKey key;
+  key.fingerprint_ = Fingerprint(plan, &key.params_);
+  // The counts are taken before the plan runs, so that a write made while it runs makes the entry stale.
+  TableVersions versions;
+  CollectVersions(plan, exec_ctx->GetCatalog(), &versions);
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      if (it->second->versions_ == versions) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        *result = it->second->tuples_;
+        stats_.hits_++;
+        return true;
+      }
+      Remove(it->second);
+      stats_.invalidations_++;
+    }
+    stats_.misses_++;
+  }
+
+  Run(exec_ctx, plan, result);
+  size_t size = sizeof(Entry) + key.fingerprint_.size() + key.params_.size() * sizeof(Value) +
+                versions.size() * sizeof(versions[0]);
+  for (const auto &tuple : *result) {
+    size += sizeof(Tuple) + tuple.GetLength();
+  }
+  if (size > capacity_) {
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  // Another query may have cached the same result meanwhile.
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    Remove(it->second);
+  }
+  lru_.push_front(Entry{key, std::move(versions), *result, size});
+  entries_.emplace(std::move(key), lru_.begin());
+  stats_.memory_ += size;
+  while (stats_.memory_ > capacity_) {
+    Remove(std::prev(lru_.end()));
+    stats_.evictions_++;
+  }
+  return false;
+}
+
+void ResultCache::Clear() {
+  std::lock_guard<std::mutex> guard(latch_);
+  entries_.clear();
+  lru_.clear();
+  stats_.memory_ = 0;
+}
+
+ResultCacheStats ResultCache::GetStats() {
+  std::lock_guard<std::mutex> guard(latch_);
+  ResultCacheStats stats = stats_;
+  stats.entries_ = entries_.size();
+  return stats;
+}
+
+void ResultCache::CollectVersions(const AbstractPlanNode *plan, SimpleCatalog *catalog, TableVersions *versions) {
+  TableHeap *table = nullptr;
+  switch (plan->GetType()) {
+    case PlanType::SeqScan:
+      table = catalog->GetTable(dynamic_cast<const SeqScanPlanNode *>(plan)->GetTableOid())->table_.get();
+      break;
+    case PlanType::IndexScan:
+      table = catalog->GetTable(dynamic_cast<const IndexScanPlanNode *>(plan)->GetTableOid())->table_.get();
+      break;
+    case PlanType::LateMaterialize:
+      table = catalog->GetTable(dynamic_cast<const LateMaterializePlanNode *>(plan)->GetTableOid())->table_.get();
+      break;
+    case PlanType::ViewScan:
+      table = catalog->GetMaterializedView(dynamic_cast<const ViewScanPlanNode *>(plan)->GetViewOid())->GetStorage();
+      break;
+    default:
+      break;
+  }
+  if (table != nullptr) {
+    versions->emplace_back(table, table->GetModificationCount());
+  }
+  for (const auto *child : plan->GetChildren()) {
+    CollectVersions(child, catalog, versions);
+  }
+}
+
+void ResultCache::Remove(std::list<Entry>::iterator entry) {
+  stats_.memory_ -= entry->size_;
+  entries_.erase(entry->key_);
+  lru_.erase(entry);
+}
+
+}  // namespace bustub
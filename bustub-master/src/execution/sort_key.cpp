@@ -0,0 +1,142 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_key.cpp
+//
+// Identification: src/execution/sort_key.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/sort_key.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return the number of bytes the value of a type takes in the normalized key, without the NULL flag */
+uint32_t GetEncodedWidth(TypeId type) {
+  switch (type) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return 1;
+    case TypeId::SMALLINT:
+      return 2;
+    case TypeId::INTEGER:
+      return 4;
+    case TypeId::BIGINT:
+    case TypeId::DECIMAL:
+    case TypeId::TIMESTAMP:
+      return 8;
+    case TypeId::VARCHAR:
+      return SortKeyEncoder::VARCHAR_PREFIX;
+    default:
+      throw NotImplementedException("Cannot sort on this type.");
+  }
+}
+
+/** Store the low width bytes of val big-endian, so that memcmp orders like the unsigned value. */
+inline void StoreBigEndian(uint64_t val, uint32_t width, char *out) {
+  for (uint32_t i = 0; i < width; i++) {
+    out[i] = static_cast<char>(val >> (8 * (width - 1 - i)));
+  }
+}
+
+}  // namespace
+
+SortKeyEncoder::SortKeyEncoder(const Schema *schema, const std::vector<OrderBy> &order_bys)
+    : schema_(schema), order_bys_(order_bys) {
+  for (const auto &order_by : order_bys_) {
+    TypeId type = order_by.first->GetReturnType();
+    key_offsets_.push_back(key_width_);
+    key_width_ += 1 + GetEncodedWidth(type);
+    has_varchar_ = has_varchar_ || type == TypeId::VARCHAR;
+  }
+}
+
+void SortKeyEncoder::Encode(const Tuple &tuple, char *key) const {
+  for (uint32_t i = 0; i < order_bys_.size(); i++) {
+    const auto &order_by = order_bys_[i];
+    TypeId type = order_by.first->GetReturnType();
+    uint32_t width = GetEncodedWidth(type);
+    char *out = key + key_offsets_[i];
+    Value val = order_by.first->Evaluate(&tuple, schema_);
+    memset(out, 0, 1 + width);
+    if (!val.IsNull()) {
+      // The NULL flag is 0 for NULL and 1 otherwise, so NULLs come first.
+      out[0] = 1;
+      switch (type) {
+        case TypeId::BOOLEAN:
+        case TypeId::TINYINT:
+          StoreBigEndian(static_cast<uint8_t>(val.GetAs<int8_t>()) ^ 0x80U, width, out + 1);
+          break;
+        case TypeId::SMALLINT:
+          StoreBigEndian(static_cast<uint16_t>(val.GetAs<int16_t>()) ^ 0x8000U, width, out + 1);
+          break;
+        case TypeId::INTEGER:
+          StoreBigEndian(static_cast<uint32_t>(val.GetAs<int32_t>()) ^ 0x80000000U, width, out + 1);
+          break;
+        case TypeId::BIGINT:
+          StoreBigEndian(static_cast<uint64_t>(val.GetAs<int64_t>()) ^ (1ULL << 63), width, out + 1);
+          break;
+        case TypeId::DECIMAL: {
+          // Flip the sign bit of positive numbers and all bits of negative ones; -0.0 and 0.0 are the same key.
+          double d = val.GetAs<double>();
+          d = d == 0 ? 0 : d;
+          uint64_t bits;
+          memcpy(&bits, &d, sizeof(bits));
+          bits = (bits >> 63) != 0 ? ~bits : bits ^ (1ULL << 63);
+          StoreBigEndian(bits, width, out + 1);
+          break;
+        }
+        case TypeId::TIMESTAMP:
+          StoreBigEndian(val.GetAs<uint64_t>(), width, out + 1);
+          break;
+        case TypeId::VARCHAR: {
+          // The length includes the terminating zero; shorter strings are zero-padded so prefixes sort first.
+          uint32_t len = std::min<uint32_t>(static_cast<uint32_t>(strnlen(val.GetData(), val.GetLength())), width);
+          memcpy(out + 1, val.GetData(), len);
+          break;
+        }
+        default:
+          UNREACHABLE("Cannot sort on this type.");
+      }
+    }
+    if (order_by.second == OrderByType::Desc) {
+      for (uint32_t j = 0; j < 1 + width; j++) {
+        out[j] = static_cast<char>(~out[j]);
+      }
+    }
+  }
+}
+
+int SortKeyEncoder::CompareValues(const Tuple &a, const Tuple &b) const {
+  for (const auto &order_by : order_bys_) {
+    Value val_a = order_by.first->Evaluate(&a, schema_);
+    Value val_b = order_by.first->Evaluate(&b, schema_);
+    if (val_a.IsNull() || val_b.IsNull()) {
+      // Equal normalized keys have the same NULL flags.
+      continue;
+    }
+    int cmp = 0;
+    if (val_a.CompareLessThan(val_b) == CmpBool::CmpTrue) {
+      cmp = -1;
+    } else if (val_a.CompareGreaterThan(val_b) == CmpBool::CmpTrue) {
+      cmp = 1;
+    }
+    if (cmp != 0) {
+      return order_by.second == OrderByType::Desc ? -cmp : cmp;
+    }
+  }
+  return 0;
+}
+
+}  // namespace bustub
@@ -12,17 +12,54 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <future>  // NOLINT
 #include <list>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "buffer/clock_replacer.h"
+#include "common/macros.h"
+#include "common/task_pool.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
 
 namespace bustub {
 
+/** Counters of the buffer pool traffic of some unit of work, see BufferPoolManager::SetThreadStats(). */
+struct BufferPoolStats {
+  /** The number of FetchPage calls. */
+  uint64_t fetches_{0};
+  /** The number of FetchPage calls that had to read the page from disk. */
+  uint64_t misses_{0};
+};
+
+/**
+ * BufferRing is a ring-buffer access strategy for bulk reads that touch each page once, like the page samples of
+ * ANALYZE. The pages such a read brings into the buffer pool cycle through a few frames of their own instead of
+ * evicting the working set of everyone else: once the ring is full, the frame a slot filled one round earlier is
+ * recycled, provided nobody has it pinned and it still holds the page the ring put there. Pages that were already
+ * resident are used in place and never enter the ring.
+ */
+class BufferRing {
+ public:
+  /** @param size the number of frames of the ring, well below the size of the buffer pool */
+  explicit BufferRing(size_t size) : frames_(size, -1), page_ids_(size, INVALID_PAGE_ID) {}
+
+ private:
+  friend class BufferPoolManager;
+
+  /** The frame every slot filled last, -1 if none, and the page it put there. */
+  std::vector<frame_id_t> frames_;
+  std::vector<page_id_t> page_ids_;
+  /** The slot to fill next. */
+  size_t next_{0};
+};
+
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
@@ -91,12 +128,57 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Write dirty unpinned pages back periodically in the background, on the shared TaskPool, so that evictions rarely
+   * have to write a page before they can reuse its frame. The writer runs until StopBackgroundWriter() or until the
+   * buffer pool is destroyed.
+   * @param interval the time between two passes over the buffer pool
+   */
+  void StartBackgroundWriter(std::chrono::milliseconds interval);
+
+  /** Stop the background writer, waiting for a pass in progress. */
+  void StopBackgroundWriter();
+
+  /** @return the number of pages the background writer wrote back */
+  size_t GetNumBackgroundWrites() const { return num_background_writes_; }
+
+  /**
+   * Fetch a page for a bulk read, see BufferRing.
+   * @param page_id id of page to be fetched
+   * @param ring the ring whose frames a page read from disk goes into, nullptr to fetch like FetchPage()
+   * @return the requested page, nullptr if every frame is pinned
+   */
+  Page *FetchPageWithRing(page_id_t page_id, BufferRing *ring) { return FetchPageImpl(page_id, ring); }
+
+  /**
+   * Fetch a page without waiting for it to be read from disk. A page that is not resident gets a frame and is pinned
+   * as usual, but it is read on the I/O threads of the disk manager (DiskManager::ReadPageAsync). The caller must wait
+   * for *ready before it touches the page, and must not unpin it before; FetchPage() calls for the page meanwhile wait
+   * for the read, and FetchPageAsync() calls get the same future.
+   * @param page_id id of page to be fetched
+   * @param[out] ready the read of the page, or an invalid future if the page can be used right away
+   * @return the requested page, nullptr if every frame is pinned
+   */
+  Page *FetchPageAsync(page_id_t page_id, std::shared_future<void> *ready) {
+    return FetchPageImpl(page_id, nullptr, ready);
+  }
+
   /** @return pointer to all the pages in the buffer pool */
   Page *GetPages() { return pages_; }
 
   /** @return size of the buffer pool */
   size_t GetPoolSize() { return pool_size_; }
 
+  /**
+   * Count the FetchPage calls of the calling thread into stats from now on, e.g. to attribute them to an operator.
+   * @param stats the counters to charge, nullptr to stop counting
+   * @return the counters charged until now, to restore when the unit of work is done
+   */
+  static BufferPoolStats *SetThreadStats(BufferPoolStats *stats) {
+    std::swap(stats, thread_stats_);
+    return stats;
+  }
+
  private:
   /**
    * Grading function. Do not modify!
@@ -114,9 +196,11 @@ class BufferPoolManager {
   /**
    * Fetch the requested page from the buffer pool.
    * @param page_id id of page to be fetched
+   * @param ring the ring whose frames a page read from disk goes into, nullptr if there is none
+   * @param[out] ready nullptr to wait for the page to be read, see FetchPageAsync() otherwise
    * @return the requested page
    */
-  Page *FetchPageImpl(page_id_t page_id);
+  Page *FetchPageImpl(page_id_t page_id, BufferRing *ring = nullptr, std::shared_future<void> *ready = nullptr);
 
   /**
    * Unpin the target page from the buffer pool.
@@ -152,6 +236,34 @@ class BufferPoolManager {
    */
   void FlushAllPagesImpl();
 
+  /**
+   * Find a frame for a new resident page, from the free list first and then from the replacer. A dirty victim is
+   * written back and its page table entry removed. The latch must be held.
+   * @param[out] frame_id the frame
+   * @return false if every frame is pinned
+   */
+  bool GetFreeFrame(frame_id_t *frame_id);
+
+  /**
+   * Recycle the frame the next slot of a ring filled one round earlier for page_id, and advance the ring.
+   * The latch must be held.
+   * @param[out] frame_id the frame
+   * @return false if the slot is empty or its frame is pinned or holds another page by now
+   */
+  bool GetRingFrame(BufferRing *ring, page_id_t page_id, frame_id_t *frame_id);
+
+  /** Wait for the read of a frame that is being recycled, if one was issued. The latch must be held. */
+  void FinishRead(frame_id_t frame_id);
+
+  /** Write the page in frame_id back to disk, after the log records it depends on. The latch must be held. */
+  void WriteBack(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Write back the pages that are dirty and unpinned; the background writer runs this. Every page is pinned and read
+   * latched while it is written, outside of the latch, so fetches go on meanwhile.
+   */
+  void WriteBackUnpinned();
+
   /** Number of pages in the buffer pool. */
   size_t pool_size_;
   /** Array of buffer pool pages. */
@@ -166,7 +278,31 @@ class BufferPoolManager {
   Replacer *replacer_;
   /** List of free pages. */
   std::list<frame_id_t> free_list_;
+  /** The reads issued by FetchPageAsync(), by frame, until a later fetch or a recycling of the frame sees them done. */
+  std::unordered_map<frame_id_t, std::shared_future<void>> reads_;
+  /** The periodic task of the background writer, see StartBackgroundWriter(). */
+  periodic_task_id_t background_writer_{TaskPool::NO_PERIODIC_TASK};
+  std::atomic<size_t> num_background_writes_{0};
   /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
   std::mutex latch_;
+  /** The counters that the FetchPage calls of this thread are charged to, nullptr if there are none. */
+  static thread_local BufferPoolStats *thread_stats_;
+};
+
+/**
+ * ThreadStatsScope charges the FetchPage calls of the calling thread to stats for as long as it lives, see
+ * BufferPoolManager::SetThreadStats(). The counters charged before are restored however the scope is left, so they
+ * never point into a profile that was destroyed after an exception.
+ */
+class ThreadStatsScope {
+ public:
+  explicit ThreadStatsScope(BufferPoolStats *stats) : outer_(BufferPoolManager::SetThreadStats(stats)) {}
+
+  ~ThreadStatsScope() { BufferPoolManager::SetThreadStats(outer_); }
+
+  DISALLOW_COPY_AND_MOVE(ThreadStatsScope);
+
+ private:
+  BufferPoolStats *outer_;
 };
 }  // namespace bustub
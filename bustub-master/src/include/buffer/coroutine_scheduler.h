@@ -0,0 +1,227 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// coroutine_scheduler.h
+//
+// Identification: src/include/buffer/coroutine_scheduler.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#ifdef BUSTUB_COROUTINES
+
+#include <chrono>     // NOLINT
+#include <coroutine>  // NOLINT
+#include <deque>
+#include <exception>
+#include <future>  // NOLINT
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+namespace detail {
+
+/** The promise parts that do not depend on the result type of a Task. */
+struct TaskPromiseBase {
+  /** Resume the coroutine that awaits the task when it finishes; there is none for the tasks a scheduler runs. */
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+      std::coroutine_handle<> continuation = handle.promise().continuation_;
+      return continuation ? continuation : std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+  };
+
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  FinalAwaiter final_suspend() noexcept { return {}; }
+  void unhandled_exception() { exception_ = std::current_exception(); }
+
+  /** Rethrow the exception the task ended with, if any. */
+  void Rethrow() const {
+    if (exception_ != nullptr) {
+      std::rethrow_exception(exception_);
+    }
+  }
+
+  std::coroutine_handle<> continuation_;
+  std::exception_ptr exception_;
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+  void return_value(T value) { value_ = std::move(value); }
+  T Result() {
+    Rethrow();
+    return std::move(*value_);
+  }
+  std::optional<T> value_;
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+  void return_void() {}
+  void Result() { Rethrow(); }
+};
+
+}  // namespace detail
+
+/**
+ * Task is a lazily started coroutine that produces a T. A coroutine awaits a task with co_await, which runs it until it
+ * finishes and resumes the awaiting coroutine right away, without going through the scheduler; the top-level tasks are
+ * run by a CoroutineScheduler.
+ */
+template <typename T>
+class Task {
+ public:
+  struct promise_type : detail::TaskPromise<T> {
+    Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+  };
+
+  Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+  Task &operator=(Task &&other) noexcept {
+    std::swap(handle_, other.handle_);
+    return *this;
+  }
+  ~Task() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+    handle_.promise().continuation_ = awaiting;
+    return handle_;
+  }
+  T await_resume() { return handle_.promise().Result(); }
+
+ private:
+  friend class CoroutineScheduler;
+
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+/**
+ * CoroutineScheduler interleaves coroutines on the calling thread so that their page reads overlap.
+ *
+ * A coroutine fetches pages with co_await FetchPage(), which returns a resident page right away and otherwise issues
+ * the read on the I/O threads of the disk manager (BufferPoolManager::FetchPageAsync) and suspends. Run() resumes the
+ * runnable coroutines one after the other and, once none is left, the ones whose reads completed, so one thread keeps
+ * many reads in flight instead of stalling on each. At most max_active tasks are started at once; as every task
+ * usually pins a page, that bounds the frames they hold.
+ */
+class CoroutineScheduler {
+ public:
+  /** Awaits a page fetch, see FetchPage(). */
+  class PageAwaiter {
+   public:
+    bool await_ready() {
+      page_ = scheduler_->bpm_->FetchPageAsync(page_id_, &ready_);
+      return page_ == nullptr || !ready_.valid() ||
+             ready_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+    void await_suspend(std::coroutine_handle<> handle) { scheduler_->waiting_.emplace_back(ready_, handle); }
+    Page *await_resume() const { return page_; }
+
+   private:
+    friend class CoroutineScheduler;
+    PageAwaiter(CoroutineScheduler *scheduler, page_id_t page_id) : scheduler_(scheduler), page_id_(page_id) {}
+
+    CoroutineScheduler *scheduler_;
+    page_id_t page_id_;
+    Page *page_{nullptr};
+    std::shared_future<void> ready_;
+  };
+
+  /**
+   * @param bpm the buffer pool the pages are fetched from
+   * @param max_active the number of tasks that may run at once
+   */
+  CoroutineScheduler(BufferPoolManager *bpm, size_t max_active) : bpm_(bpm), max_active_(max_active) {
+    BUSTUB_ASSERT(max_active > 0, "At least one task must be able to run.");
+  }
+
+  DISALLOW_COPY_AND_MOVE(CoroutineScheduler);
+
+  /**
+   * Fetch a page from a coroutine run by this scheduler; it must be unpinned with UnpinPage() as usual.
+   * @return an awaitable that produces the pinned page, nullptr if every frame is pinned
+   */
+  PageAwaiter FetchPage(page_id_t page_id) { return PageAwaiter(this, page_id); }
+
+  /** Add a task to run by the next Run(). */
+  void Spawn(Task<void> task) { tasks_.emplace_back(std::move(task)); }
+
+  /** Run the spawned tasks until all of them finish, then rethrow the first exception a task ended with, if any. */
+  void Run() {
+    size_t next = 0;
+    std::vector<size_t> active;
+    while (true) {
+      // Start tasks in spawn order as others finish.
+      for (size_t i = 0; i < active.size();) {
+        if (tasks_[active[i]].handle_.done()) {
+          active[i] = active.back();
+          active.pop_back();
+        } else {
+          i++;
+        }
+      }
+      while (active.size() < max_active_ && next < tasks_.size()) {
+        ready_.push_back(tasks_[next].handle_);
+        active.push_back(next++);
+      }
+      if (ready_.empty()) {
+        if (waiting_.empty()) {
+          break;
+        }
+        // Nothing can run: resume every coroutine whose read completed, waiting for the oldest read if none did.
+        waiting_.front().first.wait();
+        for (size_t i = 0; i < waiting_.size();) {
+          if (waiting_[i].first.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            ready_.push_back(waiting_[i].second);
+            waiting_.erase(waiting_.begin() + i);
+          } else {
+            i++;
+          }
+        }
+      }
+      while (!ready_.empty()) {
+        std::coroutine_handle<> handle = ready_.front();
+        ready_.pop_front();
+        handle.resume();
+      }
+    }
+    std::vector<Task<void>> tasks(std::move(tasks_));
+    tasks_.clear();
+    for (auto &task : tasks) {
+      task.handle_.promise().Result();
+    }
+  }
+
+ private:
+  BufferPoolManager *bpm_;
+  size_t max_active_;
+  /** The tasks of the next Run(). */
+  std::vector<Task<void>> tasks_;
+  /** The coroutines that can be resumed. */
+  std::deque<std::coroutine_handle<>> ready_;
+  /** The coroutines suspended on a page read, oldest first. */
+  std::deque<std::pair<std::shared_future<void>, std::coroutine_handle<>>> waiting_;
+};
+
+}  // namespace bustub
+
+#endif  // BUSTUB_COROUTINES
@@ -0,0 +1,218 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// materialized_view.h
+//
+// Identification: src/include/catalog/materialized_view.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "concurrency/transaction.h"
+#include "execution/plans/aggregation_plan.h"
+#include "storage/table/table_heap.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * MaterializedView keeps the result of an aggregation over one table up to date as the table changes.
+ *
+ * The view is defined by an AggregationPlanNode whose child is a sequential scan of the base table, and it supports
+ * the distributive aggregates COUNT, SUM, MIN and MAX. Every group is stored as one row of a table: the group-by
+ * values, the aggregate states and the number of base rows in the group. An in-memory map from the group-by values
+ * to the RID of the row makes reading a group a point lookup, and reading the whole view costs O(groups) instead of
+ * a pass over the base table.
+ *
+ * The writers of the base table report the rows they insert, delete and update. The view folds them into per
+ * transaction deltas of every group and applies those when the transaction commits, so readers never see the changes
+ * of transactions that are running or aborted. The state of a SUM, MIN or MAX is the aggregate of its non-NULL inputs
+ * and the number of its NULL inputs, as a NULL input makes the result NULL like in AggregationExecutor. COUNT, SUM
+ * and the NULL counts take the delta as it is. MIN and MAX take the extreme of the inserted values, and the groups
+ * whose current extreme may have been deleted are recomputed with one pass over the base table per commit. A group
+ * is removed when its last row is deleted.
+ *
+ * The recomputation reads the base table as it is, so like the rest of the executors it sees the writes of the
+ * transactions that are still running. The plan and its expressions must outlive the view.
+ *
+ * If a stored row cannot be read or written, e.g. because the buffer pool has no free frame, the view is stale: it
+ * stops applying deltas and is rebuilt from the base table as soon as no transaction has deltas pending, since the
+ * base table then holds exactly the committed rows. Reading a stale view fails.
+ */
+class MaterializedView {
+ public:
+  /** A group of the view, see Snapshot(). */
+  struct Group {
+    std::vector<Value> group_bys_;
+    std::vector<Value> aggregates_;
+  };
+
+  /** The length of the VARCHAR group-by columns of the stored rows. */
+  static constexpr uint32_t VARCHAR_LENGTH = 128;
+
+  /**
+   * Create a view and fill it from the current contents of the base table.
+   * @param plan the aggregation that defines the view, see CheckPlan()
+   * @param base the base table
+   * @param base_schema the schema of the base table
+   * @param storage the empty table the view is stored in, with the schema of StorageSchema()
+   * @param txn the transaction in which the base table is read
+   */
+  MaterializedView(const AggregationPlanNode *plan, TableHeap *base, const Schema *base_schema, TableHeap *storage,
+                   Transaction *txn);
+
+  /**
+   * Check that an aggregation can define a view, throwing NOT_IMPLEMENTED if it cannot: the child must be a
+   * sequential scan, every aggregate COUNT, SUM, MIN or MAX, and all rows must be aggregated.
+   * @return the oid of the base table
+   */
+  static uint32_t CheckPlan(const AggregationPlanNode *plan);
+
+  /**
+   * @return the schema of the rows a view of the plan is stored as: the group-bys, the aggregate states, the NULL
+   * counts of the aggregates, then the row count
+   */
+  static Schema StorageSchema(const AggregationPlanNode *plan);
+
+  /** @return the aggregation that defines the view */
+  const AggregationPlanNode *GetPlan() const { return plan_; }
+
+  /** @return the table the view is stored in */
+  TableHeap *GetStorage() const { return storage_; }
+
+  /** @return the schema of the stored rows */
+  const Schema *GetStorageSchema() const { return &storage_schema_; }
+
+  /** @return the number of groups of the view, which is only an estimate while the view is stale */
+  size_t GetNumGroups();
+
+  /**
+   * Read a group of the view as of the last commit.
+   * @param group_bys the group-by values
+   * @param[out] aggregates the aggregate values of the group
+   * @return true if the group exists
+   * @throw Exception if the view is stale or its row cannot be read
+   */
+  bool Lookup(const std::vector<Value> &group_bys, std::vector<Value> *aggregates);
+
+  /**
+   * Read all groups of the view as of the last commit. The view is latched while they are read, so a commit never
+   * shows up halfway.
+   * @param txn the transaction that reads the view
+   * @param[out] groups the groups, in the order they are stored
+   * @return false if the view is stale or the stored rows could not be read, in which case txn is aborted
+   */
+  bool Snapshot(Transaction *txn, std::vector<Group> *groups);
+
+  /**
+   * Split a stored row into its group-by and aggregate values.
+   * @param row a row of the storage table
+   * @param[out] group_bys the group-by values
+   * @param[out] aggregates the aggregate values
+   */
+  void SplitRow(const Tuple &row, std::vector<Value> *group_bys, std::vector<Value> *aggregates) const;
+
+  /** Report that a transaction inserted a row, in the schema of the base table, into the base table. */
+  void Insert(const Tuple &row, Transaction *txn) { Record(row, 1, txn); }
+
+  /** Report that a transaction deleted a row from the base table. */
+  void Delete(const Tuple &row, Transaction *txn) { Record(row, -1, txn); }
+
+  /** Report that a transaction updated a row of the base table from old_row to new_row. */
+  void Update(const Tuple &old_row, const Tuple &new_row, Transaction *txn) {
+    Record(old_row, -1, txn);
+    Record(new_row, 1, txn);
+  }
+
+ private:
+  /** The aggregation state of a group, or the net change of a group in a transaction. */
+  struct GroupState {
+    /** The number of rows of the group. */
+    int32_t count_{0};
+    /** Per aggregate: the COUNT, or the SUM, MIN or MAX of the non-NULL inputs; a delta has the change of a COUNT or
+     * SUM and the extreme of the inserted inputs of a MIN or MAX. */
+    std::vector<Value> values_;
+    /** Per aggregate: the number of NULL inputs of a SUM, MIN or MAX, whose result they make NULL. */
+    std::vector<int32_t> nulls_;
+    /** Per aggregate of a delta: the extreme of the deleted non-NULL inputs of a MIN or MAX, NULL if there is none. */
+    std::vector<Value> removed_;
+  };
+
+  using Deltas = std::unordered_map<AggregateKey, GroupState>;
+
+  /**
+   * Evaluate the group-bys and the aggregate inputs of a base row.
+   * @return false if the row does not pass the predicate of the scan
+   */
+  bool Evaluate(const Tuple &row, AggregateKey *key, std::vector<Value> *inputs) const;
+
+  /** @return the state of a group without rows */
+  GroupState InitialState() const;
+
+  /** Fold the aggregate inputs of a row that was inserted (sign 1) or deleted (sign -1) into the delta of a group. */
+  void Combine(Deltas *deltas, const AggregateKey &key, const std::vector<Value> &inputs, int32_t sign) const;
+
+  /** Fold a row that a transaction inserted or deleted into the deltas of the transaction. */
+  void Record(const Tuple &row, int32_t sign, Transaction *txn);
+
+  /** Apply the deltas of a transaction that ended, or drop them if it aborted. */
+  void Complete(txn_id_t txn_id, bool committed);
+
+  /** Apply the deltas of a committed transaction to the stored rows; latch_ must be held. */
+  void Apply(const Deltas &deltas);
+
+  /** Recompute the MIN and MAX aggregates of some groups from the base table; latch_ must be held. */
+  void Recompute(const std::vector<AggregateKey> &keys);
+
+  /** Rebuild a stale view if no transaction has deltas pending; latch_ must be held. @return false if it is stale */
+  bool Refresh();
+
+  /** Replace the stored rows of a stale view by the groups of the base table; latch_ must be held. */
+  void Rebuild();
+
+  /** Parse a stored row into its group-by values, if group_bys is not nullptr, and its state. */
+  void ParseRow(const Tuple &row, std::vector<Value> *group_bys, GroupState *state) const;
+
+  /** Turn the state of a group into its aggregate values. */
+  void Finalize(const GroupState &state, std::vector<Value> *aggregates) const;
+
+  /** Read the state of a stored group; latch_ must be held. @return false if the row could not be read */
+  bool ReadGroup(const RID &rid, GroupState *state);
+
+  /** Store a group, replacing its row if it has one; latch_ must be held. @return false if it could not be written */
+  bool WriteGroup(const AggregateKey &key, const GroupState &state);
+
+  /** Remove the row of a group; latch_ must be held. @return false if it could not be deleted */
+  bool RemoveGroup(std::unordered_map<AggregateKey, RID>::iterator group);
+
+  const AggregationPlanNode *plan_;
+  TableHeap *base_;
+  const Schema *base_schema_;
+  TableHeap *storage_;
+  Schema storage_schema_;
+
+  /** Protects the members below and the stored rows. */
+  std::mutex latch_;
+  /** The RID of the stored row of every group. */
+  std::unordered_map<AggregateKey, RID> groups_;
+  /** The deltas of the running transactions that changed the base table. */
+  std::unordered_map<txn_id_t, std::unique_ptr<Deltas>> pending_;
+  /** The transaction the stored rows are written in, which is never committed; its write set is dropped. */
+  Transaction storage_txn_{INVALID_TXN_ID};
+  /** True if the stored rows may no longer match the base table, as reading or writing one of them failed. */
+  bool stale_{false};
+};
+
+}  // namespace bustub
@@ -1,14 +1,19 @@
 #pragma once
 
 #include <memory>
+#include <random>
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 #include <exception>
 
 #include "buffer/buffer_pool_manager.h"
+#include "catalog/materialized_view.h"
 #include "catalog/schema.h"
+#include "catalog/table_stats.h"
 #include "storage/index/index.h"
+#include "storage/index/linear_probe_hash_table_index.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
@@ -18,6 +23,7 @@ namespace bustub {
  */
 using table_oid_t = uint32_t;
 using column_oid_t = uint32_t;
+using index_oid_t = uint32_t;
 
 /**
  * Metadata about a table.
@@ -31,6 +37,26 @@ struct TableMetadata {
   table_oid_t oid_;
 };
 
+/**
+ * Metadata about an index.
+ */
+struct IndexInfo {
+  IndexInfo(Schema key_schema, std::string name, std::unique_ptr<Index> &&index, index_oid_t index_oid,
+            std::string table_name, size_t key_size)
+      : key_schema_(std::move(key_schema)),
+        name_(std::move(name)),
+        index_(std::move(index)),
+        index_oid_(index_oid),
+        table_name_(std::move(table_name)),
+        key_size_(key_size) {}
+  Schema key_schema_;
+  std::string name_;
+  std::unique_ptr<Index> index_;
+  index_oid_t index_oid_;
+  std::string table_name_;
+  const size_t key_size_;
+};
+
 /**
  * SimpleCatalog is a non-persistent catalog that is designed for the executor to use.
  * It handles table creation and table lookup.
@@ -78,7 +104,146 @@ class SimpleCatalog {
     return tables_[table_oid].get();
   }
 
+  /**
+   * Create a new hash index on a table, fill it with the tuples already in the table and return its metadata.
+   * Tuples inserted through InsertExecutor afterwards are added to the index as well.
+   * @param txn the transaction in which the index is being created
+   * @param index_name the name of the new index, unique among the indexes of the table
+   * @param table_name the name of the indexed table
+   * @param schema the schema of the table
+   * @param key_schema the schema of the key, i.e. the key_attrs columns of schema
+   * @param key_attrs the indexed columns of the table
+   * @param key_size the size of KeyType
+   * @return a pointer to the metadata of the new index
+   */
+  template <class KeyType, class ValueType, class KeyComparator>
+  IndexInfo *CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
+                         const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
+                         size_t key_size) {
+    BUSTUB_ASSERT(index_names_[table_name].count(index_name) == 0, "Index names should be unique per table!");
+    auto *metadata = new IndexMetadata(index_name, table_name, &schema, key_attrs);
+    auto index = std::make_unique<LinearProbeHashTableIndex<KeyType, ValueType, KeyComparator>>(
+        metadata, bpm_, INDEX_NUM_BUCKETS, HashFunction<KeyType>());
+    TableHeap *table = GetTable(table_name)->table_.get();
+    for (auto it = table->Begin(txn); it != table->End(); ++it) {
+      if (!index->InsertEntry(it->KeyFromTuple(schema, key_schema, key_attrs), it->GetRid(), txn)) {
+        // An index that misses tuples of its table would make index scans return incomplete results.
+        txn->SetState(TransactionState::ABORTED);
+        throw TransactionAbortException(txn->GetTransactionId());
+      }
+    }
+    index_oid_t index_oid = next_index_oid_++;
+    index_names_[table_name][index_name] = index_oid;
+    indexes_[index_oid] = std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name,
+                                                      key_size);
+    return indexes_[index_oid].get();
+  }
+
+  /** @return index metadata by index name and table name */
+  IndexInfo *GetIndex(const std::string &index_name, const std::string &table_name) {
+    auto table_indexes = index_names_.find(table_name);
+    if (table_indexes == index_names_.end() || table_indexes->second.count(index_name) == 0) {
+      throw std::out_of_range("");
+    }
+    return indexes_[table_indexes->second[index_name]].get();
+  }
+
+  /** @return index metadata by oid */
+  IndexInfo *GetIndex(index_oid_t index_oid) {
+    if (indexes_.count(index_oid) == 0) {
+      throw std::out_of_range("");
+    }
+    return indexes_[index_oid].get();
+  }
+
+  /** @return all the indexes of a table, empty if it has none */
+  std::vector<IndexInfo *> GetTableIndexes(const std::string &table_name) {
+    std::vector<IndexInfo *> result;
+    auto table_indexes = index_names_.find(table_name);
+    if (table_indexes != index_names_.end()) {
+      for (const auto &entry : table_indexes->second) {
+        result.push_back(indexes_[entry.second].get());
+      }
+    }
+    return result;
+  }
+
+  /**
+   * Gather the statistics of a table in a full pass over it (ANALYZE), replacing those gathered before.
+   * @param txn the transaction in which the table is read
+   * @param table_name the name of the table
+   * @return the new statistics of the table
+   */
+  TableStats *AnalyzeTable(Transaction *txn, const std::string &table_name) {
+    TableMetadata *table = GetTable(table_name);
+    stats_[table->oid_] = TableStats::Analyze(table->table_.get(), table->schema_, txn);
+    return stats_[table->oid_].get();
+  }
+
+  /**
+   * Estimate the statistics of a table from a sample of its pages (sampling ANALYZE), replacing those gathered before.
+   * See TableStats::AnalyzeSample().
+   * @param txn the transaction in which the table is read
+   * @param table_name the name of the table
+   * @param sample_pages the number of pages to read
+   * @param sample_rows the number of rows to build the histograms from
+   * @return the new statistics of the table
+   */
+  TableStats *AnalyzeTable(Transaction *txn, const std::string &table_name, size_t sample_pages,
+                           size_t sample_rows = TableStats::DEFAULT_SAMPLE_ROWS) {
+    TableMetadata *table = GetTable(table_name);
+    stats_[table->oid_] = TableStats::AnalyzeSample(table->table_.get(), table->schema_, txn, sample_pages, sample_rows,
+                                                    std::random_device{}());
+    return stats_[table->oid_].get();
+  }
+
+  /** @return the statistics of a table by oid, nullptr if the table was never analyzed */
+  const TableStats *GetTableStats(table_oid_t table_oid) const {
+    auto it = stats_.find(table_oid);
+    return it == stats_.end() ? nullptr : it->second.get();
+  }
+
+  /**
+   * Create a materialized view of an aggregation over one table, see MaterializedView.
+   * @param txn the transaction in which the base table is read and the storage table is created
+   * @param view_name the name of the view, which is also the name of the table the view is stored in
+   * @param plan the aggregation that defines the view; it and its expressions must outlive the catalog
+   * @return the view; its oid is the oid of its storage table
+   */
+  MaterializedView *CreateMaterializedView(Transaction *txn, const std::string &view_name,
+                                           const AggregationPlanNode *plan) {
+    TableMetadata *base = GetTable(MaterializedView::CheckPlan(plan));
+    TableMetadata *storage = CreateTable(txn, view_name, MaterializedView::StorageSchema(plan));
+    views_[storage->oid_] =
+        std::make_unique<MaterializedView>(plan, base->table_.get(), &base->schema_, storage->table_.get(), txn);
+    view_names_[base->name_].push_back(storage->oid_);
+    return views_[storage->oid_].get();
+  }
+
+  /** @return a materialized view by the oid of its storage table */
+  MaterializedView *GetMaterializedView(table_oid_t view_oid) {
+    if (views_.count(view_oid) == 0) {
+      throw std::out_of_range("");
+    }
+    return views_[view_oid].get();
+  }
+
+  /** @return the materialized views over a table, empty if it has none */
+  std::vector<MaterializedView *> GetTableViews(const std::string &table_name) {
+    std::vector<MaterializedView *> result;
+    auto table_views = view_names_.find(table_name);
+    if (table_views != view_names_.end()) {
+      for (const auto &view_oid : table_views->second) {
+        result.push_back(views_[view_oid].get());
+      }
+    }
+    return result;
+  }
+
  private:
+  /** The number of buckets a new index starts with; the hash table doubles when it runs out. */
+  static constexpr size_t INDEX_NUM_BUCKETS = 1024;
+
   [[maybe_unused]] BufferPoolManager *bpm_;
   [[maybe_unused]] LockManager *lock_manager_;
   [[maybe_unused]] LogManager *log_manager_;
@@ -89,5 +254,20 @@ class SimpleCatalog {
   std::unordered_map<std::string, table_oid_t> names_;
   /** The next table identifier to be used. */
   std::atomic<table_oid_t> next_table_oid_{0};
+
+  /** indexes_: index identifiers -> index metadata. Note that indexes_ owns all index metadata. */
+  std::unordered_map<index_oid_t, std::unique_ptr<IndexInfo>> indexes_;
+  /** index_names_: table name -> index names -> index identifiers */
+  std::unordered_map<std::string, std::unordered_map<std::string, index_oid_t>> index_names_;
+  /** The next index identifier to be used. */
+  std::atomic<index_oid_t> next_index_oid_{0};
+
+  /** stats_: table identifiers -> statistics of the last ANALYZE of the table */
+  std::unordered_map<table_oid_t, std::unique_ptr<TableStats>> stats_;
+
+  /** views_: storage table identifiers -> materialized views. Note that views_ owns all materialized views. */
+  std::unordered_map<table_oid_t, std::unique_ptr<MaterializedView>> views_;
+  /** view_names_: base table name -> storage table identifiers of the views over the table */
+  std::unordered_map<std::string, std::vector<table_oid_t>> view_names_;
 };
 }  // namespace bustub
@@ -0,0 +1,159 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_stats.h
+//
+// Identification: src/include/catalog/table_stats.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "concurrency/transaction.h"
+#include "storage/table/table_heap.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * Histogram is an equi-depth histogram over the non-null values of a column. Every bucket holds about the same number
+ * of values and is described by its largest value, so frequent values get narrow buckets and skew costs less accuracy
+ * than with equi-width buckets. A value frequent enough to fill several buckets is the upper bound of all of them.
+ */
+class Histogram {
+ public:
+  /** The most buckets a histogram has. */
+  static constexpr uint32_t MAX_BUCKETS = 64;
+
+  /** Creates an empty histogram. */
+  Histogram() = default;
+
+  /**
+   * Creates a histogram over a column.
+   * @param sorted_values the non-null values of the column in ascending order
+   */
+  explicit Histogram(const std::vector<Value> &sorted_values);
+
+  /**
+   * @param value the value to compare with, of a type comparable to the column
+   * @param inclusive true to count the values equal to value as well
+   * @return the estimated fraction of the values that are less than (or equal to) value
+   */
+  double EstimateLessThan(const Value &value, bool inclusive) const;
+
+  /** @return the estimated fraction of the values that equal value, 0 if the histogram only knows it is rare */
+  double EstimateFrequentValue(const Value &value) const;
+
+  /** @return the number of buckets, 0 if the column had no values */
+  uint32_t GetNumBuckets() const { return static_cast<uint32_t>(upper_bounds_.size()); }
+
+  /** @return the smallest value of the column; only valid if there are buckets */
+  const Value &GetMin() const { return min_; }
+
+  /** @return the largest value of bucket i */
+  const Value &GetUpperBound(uint32_t i) const { return upper_bounds_[i]; }
+
+  /** @return the number of values in buckets 0 to i */
+  size_t GetCumulativeCount(uint32_t i) const { return cumulative_counts_[i]; }
+
+ private:
+  Value min_;
+  std::vector<Value> upper_bounds_;
+  std::vector<size_t> cumulative_counts_;
+};
+
+/** The statistics of one column of a table. */
+struct ColumnStats {
+  /**
+   * Computes the statistics of a column from its values.
+   * @param[in,out] values the non-null values of the column, sorted in place
+   * @param num_nulls the number of NULLs in the column
+   * @return the statistics
+   */
+  static ColumnStats FromValues(std::vector<Value> *values, size_t num_nulls);
+
+  /** @return the fraction of the rows that are NULL */
+  double GetNullFraction() const {
+    size_t num_rows = num_values_ + num_nulls_;
+    return num_rows == 0 ? 0 : static_cast<double>(num_nulls_) / static_cast<double>(num_rows);
+  }
+
+  /**
+   * @param value a non-null value
+   * @return the estimated fraction of the rows whose value in the column equals value
+   */
+  double EstimateEqual(const Value &value) const;
+
+  /**
+   * @param value a non-null value
+   * @param inclusive true to count the rows whose value equals value as well
+   * @return the estimated fraction of the rows whose value in the column is less than (or equal to) value
+   */
+  double EstimateLessThan(const Value &value, bool inclusive) const {
+    return (1 - GetNullFraction()) * histogram_.EstimateLessThan(value, inclusive);
+  }
+
+  /** The number of non-null values. */
+  size_t num_values_{0};
+  size_t num_nulls_{0};
+  /** The number of distinct non-null values. */
+  size_t num_distinct_{0};
+  Histogram histogram_;
+};
+
+/**
+ * TableStats holds the statistics of a table that the optimizer estimates cardinalities from: the number of rows, and
+ * per column the NULL count, the number of distinct values and an equi-depth histogram.
+ */
+struct TableStats {
+  /** The rows a sampling ANALYZE builds the histograms from by default. */
+  static constexpr size_t DEFAULT_SAMPLE_ROWS = 30000;
+  /** The frames of the BufferRing a sampling ANALYZE reads its pages through. */
+  static constexpr size_t SAMPLE_RING_SIZE = 8;
+
+  /**
+   * Gathers the statistics of a table in a full pass over its heap (ANALYZE).
+   * @param table the table heap
+   * @param schema the schema of the table
+   * @param txn the transaction to read the table in
+   * @return the statistics
+   */
+  static std::unique_ptr<TableStats> Analyze(TableHeap *table, const Schema &schema, Transaction *txn);
+
+  /**
+   * Estimates the statistics of a table from a sample of its pages, so the cost depends on the sample size rather than
+   * on the size of the table.
+   *
+   * Random pages are picked from the page directory of the heap and read in table order through a BufferRing, so the
+   * sample does not flush the buffer pool. Every row on them passes through a HyperLogLog sketch per column and a
+   * reservoir sample of sample_rows rows, which the histograms are built from. The row and NULL counts are scaled up
+   * from the pages read. The number of distinct values is the larger of the sketch estimate, which only knows the
+   * values on the pages read, and the Duj1 estimator over the reservoir, which extrapolates from how many values the
+   * reservoir saw only once. If the sample covers every page, the sketch estimate is used alone.
+   *
+   * @param table the table heap
+   * @param schema the schema of the table
+   * @param txn the transaction to read the table in
+   * @param sample_pages the number of pages to read
+   * @param sample_rows the number of rows to build the histograms from
+   * @param seed the seed of the random choices
+   * @return the statistics
+   */
+  static std::unique_ptr<TableStats> AnalyzeSample(TableHeap *table, const Schema &schema, Transaction *txn,
+                                                   size_t sample_pages, size_t sample_rows, uint64_t seed);
+
+  size_t num_rows_{0};
+  /** The number of rows the histograms were built from, num_rows_ after a full pass. */
+  size_t num_sampled_rows_{0};
+  /** The statistics of every column, in the order of the schema. */
+  std::vector<ColumnStats> columns_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arena.h
+//
+// Identification: src/include/common/arena.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * Arena is a bump allocator for memory that lives exactly as long as a query.
+ *
+ * Allocations are carved out of large blocks and are never freed individually; everything is released at once when
+ * the arena is destroyed or Reset(). Objects placed in the arena must therefore be trivially destructible (tuple
+ * bytes, varlen payloads, hash table nodes, ...).
+ */
+class Arena {
+ public:
+  /** The size of a regular block. Requests larger than a quarter of this get a block of their own. */
+  static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+  Arena() = default;
+
+  ~Arena() = default;
+
+  DISALLOW_COPY_AND_MOVE(Arena);
+
+  /**
+   * Allocate uninitialized memory.
+   * @param size number of bytes to allocate
+   * @param align required alignment, must be a power of two
+   * @return pointer to the memory, valid until the arena is reset or destroyed
+   */
+  char *Allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+    auto cur = reinterpret_cast<uintptr_t>(cur_);
+    size_t padding = (align - (cur & (align - 1))) & (align - 1);
+    if (cur_ == nullptr || padding + size > static_cast<size_t>(end_ - cur_)) {
+      return AllocateSlow(size, align);
+    }
+    char *result = cur_ + padding;
+    cur_ = result + size;
+    bytes_allocated_ += size;
+    return result;
+  }
+
+  /**
+   * Copy a byte range into the arena.
+   * @return the copy, valid until the arena is reset or destroyed
+   */
+  char *Copy(const char *data, size_t size) {
+    char *result = Allocate(size, 1);
+    memcpy(result, data, size);
+    return result;
+  }
+
+  /**
+   * Construct a trivially destructible object in the arena.
+   * @return the new object, valid until the arena is reset or destroyed
+   */
+  template <typename T, typename... Args>
+  T *New(Args &&... args) {
+    static_assert(std::is_trivially_destructible<T>::value, "The arena never runs destructors.");
+    return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+  }
+
+  /** Release all memory handed out so far. */
+  void Reset() {
+    blocks_.clear();
+    cur_ = nullptr;
+    end_ = nullptr;
+    bytes_allocated_ = 0;
+    bytes_reserved_ = 0;
+  }
+
+  /** @return the number of bytes handed out since the last reset */
+  size_t GetBytesAllocated() const { return bytes_allocated_; }
+
+  /** @return the number of bytes obtained from the system since the last reset */
+  size_t GetBytesReserved() const { return bytes_reserved_; }
+
+ private:
+  char *AllocateSlow(size_t size, size_t align) {
+    if (size + align > BLOCK_SIZE / 4) {
+      // Large request: give it a dedicated block and keep bumping in the current one.
+      char *block = NewBlock(size + align);
+      auto addr = reinterpret_cast<uintptr_t>(block);
+      bytes_allocated_ += size;
+      return block + ((align - (addr & (align - 1))) & (align - 1));
+    }
+    cur_ = NewBlock(BLOCK_SIZE);
+    end_ = cur_ + BLOCK_SIZE;
+    return Allocate(size, align);
+  }
+
+  char *NewBlock(size_t size) {
+    blocks_.emplace_back(new char[size]);
+    bytes_reserved_ += size;
+    return blocks_.back().get();
+  }
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char *cur_{nullptr};
+  char *end_{nullptr};
+  size_t bytes_allocated_{0};
+  size_t bytes_reserved_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,127 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hyperloglog.h
+//
+// Identification: src/include/common/hyperloglog.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "common/macros.h"
+#include "common/util/hash_util.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * HyperLogLog estimates the number of distinct values in a stream in a fixed amount of memory: 2^precision registers
+ * of a byte each, with a standard error of about 1.04 / sqrt(2^precision), i.e. 1.6% with 4KB at the default
+ * precision. Every value is hashed; the leading bits of the hash pick a register, which keeps the longest run of
+ * leading zeros seen in the remaining bits. Sketches of the same precision merge by taking the maximum of every
+ * register, so partial sketches of disjoint parts of the input add up to the sketch of all of it.
+ */
+class HyperLogLog {
+ public:
+  /** The precision that a sketch has by default. */
+  static constexpr uint32_t DEFAULT_PRECISION = 12;
+
+  /** @param precision the number of hash bits that pick a register, between 4 and 18 */
+  explicit HyperLogLog(uint32_t precision = DEFAULT_PRECISION)
+      : precision_(precision), registers_(size_t{1} << precision, 0) {
+    BUSTUB_ASSERT(precision >= 4 && precision <= 18, "The precision of a sketch must be between 4 and 18.");
+  }
+
+  /** Add a value; NULLs are not counted. */
+  void Add(const Value &value) {
+    if (!value.IsNull()) {
+      AddHash(HashUtil::HashValue(&value));
+    }
+  }
+
+  /** Add the hash of a value. The hash is mixed again, so hashes with weak high bits are fine. */
+  void AddHash(hash_t hash) { AddHash(registers_.data(), precision_, hash); }
+
+  /** Fold another sketch of the same precision into this one. */
+  void Merge(const HyperLogLog &other) {
+    BUSTUB_ASSERT(precision_ == other.precision_, "Only sketches of the same precision can be merged.");
+    Merge(registers_.data(), other.registers_.data(), precision_);
+  }
+
+  /** @return the estimated number of distinct values added */
+  double Estimate() const { return Estimate(registers_.data(), precision_); }
+
+  /** Forget all values added. */
+  void Clear() { std::fill(registers_.begin(), registers_.end(), 0); }
+
+  /** @return the bytes of the registers */
+  size_t GetMemoryUsage() const { return registers_.size(); }
+
+  /** @return the number of hash bits that pick a register */
+  uint32_t GetPrecision() const { return precision_; }
+
+  /**
+   * The operations below work on 2^precision registers stored elsewhere, e.g. inline in the row of a group, so that a
+   * sketch can live in memory it does not own. Zeroed registers are an empty sketch.
+   */
+
+  /** Add a hash to the registers of a sketch. */
+  static void AddHash(uint8_t *registers, uint32_t precision, hash_t hash) {
+    // The finalizer of MurmurHash3 spreads every input bit over all output bits.
+    uint64_t x = hash;
+    x = (x ^ (x >> 33)) * 0xFF51AFD7ED558CCDULL;
+    x = (x ^ (x >> 33)) * 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    size_t idx = x >> (64 - precision);
+    // The guard bit bounds the rank when all remaining bits are zero.
+    uint64_t rest = (x << precision) | (uint64_t{1} << (precision - 1));
+    // The rank is the position of the first set bit; half of the hashes stop at the first bit, so the loop is short.
+    uint8_t rank = 1;
+    for (uint64_t bit = uint64_t{1} << 63; (rest & bit) == 0; bit >>= 1) {
+      rank++;
+    }
+    registers[idx] = std::max(registers[idx], rank);
+  }
+
+  /** Fold the registers of one sketch into those of another of the same precision. */
+  static void Merge(uint8_t *registers, const uint8_t *other, uint32_t precision) {
+    for (size_t i = 0; i < (size_t{1} << precision); i++) {
+      registers[i] = std::max(registers[i], other[i]);
+    }
+  }
+
+  /** @return the estimated number of distinct values added to the registers of a sketch */
+  static double Estimate(const uint8_t *registers, uint32_t precision) {
+    size_t num_registers = size_t{1} << precision;
+    auto m = static_cast<double>(num_registers);
+    double sum = 0;
+    size_t zeros = 0;
+    for (size_t i = 0; i < num_registers; i++) {
+      sum += std::ldexp(1.0, -registers[i]);
+      zeros += registers[i] == 0 ? 1 : 0;
+    }
+    double alpha = 0.7213 / (1 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+    // Small cardinalities leave registers empty; counting those (linear counting) is more accurate then. With 64-bit
+    // hashes collisions are too rare to need a correction at the top end.
+    if (estimate <= 2.5 * m && zeros > 0) {
+      estimate = m * std::log(m / static_cast<double>(zeros));
+    }
+    return estimate;
+  }
+
+ private:
+  uint32_t precision_;
+  std::vector<uint8_t> registers_;
+};
+
+}  // namespace bustub
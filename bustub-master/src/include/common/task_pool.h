@@ -0,0 +1,211 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// task_pool.h
+//
+// Identification: src/include/common/task_pool.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <future>  // NOLINT
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <set>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/** The priority of a task: workers run every runnable foreground task before any background task. */
+enum class TaskPriority { FOREGROUND = 0, BACKGROUND = 1 };
+
+using periodic_task_id_t = uint64_t;
+
+/** The counters of a task pool, see TaskPool::GetStats(). */
+struct TaskPoolStats {
+  /** The number of foreground and of background tasks that started, periodic runs included. */
+  uint64_t foreground_tasks_{0};
+  uint64_t background_tasks_{0};
+  /** The number of tasks a worker took from the deque of another worker. */
+  uint64_t steals_{0};
+  /** The number of runs of periodic tasks. */
+  uint64_t periodic_runs_{0};
+  /** The number of tasks waiting to run. */
+  uint64_t queued_{0};
+};
+
+/**
+ * TaskPool runs the background and query work of the system on a fixed set of worker threads.
+ *
+ * Every worker has a deque per priority. A task submitted by a worker goes to its own deque and the worker takes the
+ * newest task of its deques first, which keeps the data of nested tasks in its cache; an idle worker steals the
+ * oldest task of another worker. Tasks posted from outside the pool are spread round robin into a separate inbox of
+ * every worker, which is taken oldest first: they are independent requests, so they run in the order they came in
+ * rather than the newest one first. Foreground tasks (query work) run ahead of background tasks (log flushes, page
+ * write back, checkpoints): a worker only takes a background task when no foreground task can be found. Periodic
+ * tasks are run by the workers as well, which wait for the next deadline when they are idle.
+ *
+ * Tasks must not block on work that only a queued task can do; ParallelFor() avoids this by running the iterations
+ * that no worker has started on the calling thread.
+ */
+class TaskPool {
+ public:
+  /** The id that no periodic task has. */
+  static constexpr periodic_task_id_t NO_PERIODIC_TASK = 0;
+
+  /** @param num_workers the number of worker threads, at least one */
+  explicit TaskPool(size_t num_workers);
+
+  /** Run the tasks that are queued, drop the periodic tasks and join the workers. */
+  ~TaskPool();
+
+  DISALLOW_COPY_AND_MOVE(TaskPool);
+
+  /** @return the pool shared by the whole process, with a worker per hardware thread and at least two */
+  static TaskPool *GetShared();
+
+  /** @return the number of worker threads */
+  size_t GetNumWorkers() const { return workers_.size(); }
+
+  /** @return a snapshot of the counters of the pool */
+  TaskPoolStats GetStats() const;
+
+  /**
+   * Queue a task.
+   * @param task the task, which must not throw; see Submit() for tasks that may
+   * @param priority the priority of the task
+   */
+  void Post(std::function<void()> task, TaskPriority priority = TaskPriority::FOREGROUND);
+
+  /**
+   * Queue a task whose result is needed.
+   * @return the future of the result or of the exception of the task
+   */
+  template <typename F>
+  auto Submit(F &&fn, TaskPriority priority = TaskPriority::FOREGROUND) -> std::future<decltype(fn())> {
+    auto task = std::make_shared<std::packaged_task<decltype(fn())()>>(std::forward<F>(fn));
+    std::future<decltype(fn())> result = task->get_future();
+    Post([task] { (*task)(); }, priority);
+    return result;
+  }
+
+  /**
+   * Call fn(0), ..., fn(n - 1) on the workers and on the calling thread, and return once all calls finish. The calling
+   * thread runs every call that no worker has started yet, so a task may call ParallelFor() as well.
+   * @param n the number of calls
+   * @param fn the function, which must be safe to call concurrently
+   * @param priority the priority of the calls that run on the workers
+   * @throw the first exception a call threw, once all calls finished
+   */
+  void ParallelFor(size_t n, const std::function<void(size_t)> &fn, TaskPriority priority = TaskPriority::FOREGROUND);
+
+  /**
+   * Run a task periodically on the workers, for the first time one interval from now. Runs of the same task never
+   * overlap: the next deadline is set when a run ends.
+   * @param interval the time from the end of a run to the start of the next
+   * @param task the task, which must not throw
+   * @param priority the priority of the runs
+   * @return the id to cancel the task with
+   */
+  periodic_task_id_t SchedulePeriodic(std::chrono::milliseconds interval, std::function<void()> task,
+                                      TaskPriority priority = TaskPriority::BACKGROUND);
+
+  /**
+   * Stop running a periodic task, waiting for a run in progress to finish; the task must not cancel itself.
+   * @param id the id SchedulePeriodic() returned; NO_PERIODIC_TASK and cancelled ids are ignored
+   */
+  void CancelPeriodic(periodic_task_id_t id);
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  /** The task deques of a worker, one per priority. */
+  struct Worker {
+    std::mutex latch_;
+    /** The tasks the worker posted itself, taken newest first by the worker and oldest first by thieves. */
+    std::deque<std::function<void()>> queues_[2];
+    /** The tasks posted from outside the pool, taken oldest first. */
+    std::deque<std::function<void()>> inbox_[2];
+  };
+
+  /** A task that runs periodically. */
+  struct PeriodicTask {
+    std::chrono::milliseconds interval_;
+    std::function<void()> task_;
+    TaskPriority priority_;
+    /** The deadline of the next run, unless the task is running. */
+    Clock::time_point deadline_;
+    /** True from the time a run is queued until it finishes. */
+    bool running_{false};
+    bool cancelled_{false};
+  };
+
+  /** The loop of worker worker_idx. */
+  void Run(size_t worker_idx);
+
+  /**
+   * Take the next task for a worker: its newest foreground task, the oldest foreground task of its inbox, the oldest
+   * foreground task of another worker or of its inbox, then the same for background tasks.
+   * @param worker_idx the worker
+   * @param[out] task the task
+   * @param[out] priority the priority of the task
+   * @return false if there is no task
+   */
+  bool TakeTask(size_t worker_idx, std::function<void()> *task, TaskPriority *priority);
+
+  /** Run a task that was taken from the deques. */
+  void RunTask(const std::function<void()> &task, TaskPriority priority);
+
+  /** Queue the runs of the periodic tasks whose deadline passed. */
+  void QueueDuePeriodicTasks();
+
+  /** Run a periodic task once and set its next deadline. */
+  void RunPeriodic(periodic_task_id_t id);
+
+  /** Publish the earliest deadline of a periodic task to the workers; sleep_latch_ must be held. */
+  void UpdateNextDeadline();
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+  /** The worker the next task posted from outside the pool goes to. */
+  std::atomic<size_t> next_worker_{0};
+
+  /** Protects the members below; the workers sleep on sleep_cv_ when there is nothing to run. */
+  std::mutex sleep_latch_;
+  std::condition_variable sleep_cv_;
+  /** Notified when a periodic task finishes a run, for CancelPeriodic(). */
+  std::condition_variable periodic_cv_;
+  bool shutdown_{false};
+  /** The periodic tasks by id, and their ids in the order of their deadlines. */
+  std::map<periodic_task_id_t, PeriodicTask> periodic_tasks_;
+  std::set<std::pair<Clock::time_point, periodic_task_id_t>> deadlines_;
+  periodic_task_id_t next_periodic_id_{NO_PERIODIC_TASK + 1};
+  /** The earliest deadline of a periodic task in clock ticks, so that busy workers check it without the latch. */
+  std::atomic<Clock::rep> next_deadline_{Clock::time_point::max().time_since_epoch().count()};
+
+  /**
+   * The number of queued tasks and of sleeping workers. A worker counts itself as sleeping before it checks for queued
+   * tasks, and a task is counted as queued before its poster checks for sleeping workers to wake up.
+   */
+  std::atomic<uint64_t> num_queued_{0};
+  std::atomic<size_t> num_sleeping_{0};
+  std::atomic<uint64_t> num_tasks_[2]{};
+  std::atomic<uint64_t> num_steals_{0};
+  std::atomic<uint64_t> num_periodic_runs_{0};
+};
+
+}  // namespace bustub
@@ -30,10 +30,11 @@ class HashUtil {
 
  public:
   static inline hash_t HashBytes(const char *bytes, size_t length) {
-    // https://github.com/greenplum-db/gpos/blob/b53c1acd6285de94044ff91fbee91589543feba1/libgpos/src/utils.cpp#L126
-    hash_t hash = length;
+    // 64-bit FNV-1a. The shift-and-xor hash of gpos was written for 32-bit words; on 64 bits every byte is shifted in
+    // by only 5 bits, so e.g. one million consecutive integers collided into 2^17 distinct hashes.
+    hash_t hash = 0xCBF29CE484222325ULL ^ length;
     for (size_t i = 0; i < length; ++i) {
-      hash = ((hash << 5) ^ (hash >> 27)) ^ bytes[i];
+      hash = (hash ^ static_cast<unsigned char>(bytes[i])) * 0x100000001B3ULL;
     }
     return hash;
   }
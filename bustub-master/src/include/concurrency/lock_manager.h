@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "common/rid.h"
+#include "common/task_pool.h"
 #include "concurrency/transaction.h"
 
 namespace bustub {
@@ -64,20 +65,20 @@ class LockManager {
    */
   explicit LockManager(TwoPLMode two_pl_mode, DeadlockMode deadlock_mode = DeadlockMode::PREVENTION)
       : two_pl_mode_(two_pl_mode), deadlock_mode_(deadlock_mode) {
-    // If Detection() is enabled, we should launch a background cycle detection thread.
+    // If Detection() is enabled, we should run cycle detection periodically in the background.
     if (Detection()) {
       enable_cycle_detection_ = true;
-      cycle_detection_thread_ = new std::thread(&LockManager::RunCycleDetection, this);
-      LOG_INFO("Cycle detection thread launched");
+      cycle_detection_task_ = TaskPool::GetShared()->SchedulePeriodic(cycle_detection_interval,
+                                                                      [this] { RunCycleDetection(); });
+      LOG_INFO("Cycle detection task scheduled");
     }
   }
 
   ~LockManager() {
     if (Detection()) {
       enable_cycle_detection_ = false;
-      cycle_detection_thread_->join();
-      delete cycle_detection_thread_;
-      LOG_INFO("Cycle detection thread stopped");
+      TaskPool::GetShared()->CancelPeriodic(cycle_detection_task_);
+      LOG_INFO("Cycle detection task cancelled");
     }
   }
 
@@ -142,7 +143,7 @@ class LockManager {
   /** @return the set of all edges in the graph, used for testing only! */
   std::vector<std::pair<txn_id_t, txn_id_t>> GetEdgeList();
 
-  /** Runs cycle detection in the background. */
+  /** Runs one pass of cycle detection; a periodic task of the shared TaskPool runs it in the background. */
   void RunCycleDetection();
 
  private:
@@ -154,7 +155,7 @@ class LockManager {
 
   std::mutex latch_;
   std::atomic<bool> enable_cycle_detection_;
-  std::thread *cycle_detection_thread_;
+  periodic_task_id_t cycle_detection_task_{TaskPool::NO_PERIODIC_TASK};
 
   /** Lock table for lock requests. */
   std::unordered_map<RID, LockRequestQueue> lock_table_;
@@ -14,9 +14,13 @@
 
 #include <atomic>
 #include <deque>
+#include <exception>
+#include <functional>
 #include <memory>
 #include <thread>  // NOLINT
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "common/logger.h"
@@ -138,6 +142,18 @@ class Transaction {
    */
   inline void SetPrevLSN(lsn_t prev_lsn) { prev_lsn_ = prev_lsn; }
 
+  /**
+   * Register a function that the transaction manager calls once the transaction ends, after the deletes of a commit
+   * are applied or the writes of an abort are rolled back.
+   * @param callback the function, called with true if the transaction committed
+   */
+  inline void AddCompletionCallback(std::function<void(bool)> callback) {
+    completion_callbacks_.emplace_back(std::move(callback));
+  }
+
+  /** @return the functions to call once the transaction ends */
+  inline std::vector<std::function<void(bool)>> *GetCompletionCallbacks() { return &completion_callbacks_; }
+
  private:
   /** The current transaction state. */
   TransactionState state_;
@@ -160,6 +176,26 @@ class Transaction {
   std::shared_ptr<std::unordered_set<RID>> shared_lock_set_;
   /** LockManager: the set of exclusive-locked tuples held by this transaction. */
   std::shared_ptr<std::unordered_set<RID>> exclusive_lock_set_;
+
+  /** The functions to call once the transaction ends, e.g. to apply the deltas of materialized views on commit. */
+  std::vector<std::function<void(bool)>> completion_callbacks_;
+};
+
+/**
+ * TransactionAbortException is thrown by the executors when the transaction they run in was aborted, e.g. because a
+ * page could not be fetched or a lock could not be taken. The transaction is in the ABORTED state by then.
+ */
+class TransactionAbortException : public std::exception {
+ public:
+  explicit TransactionAbortException(txn_id_t txn_id) : txn_id_(txn_id) {}
+
+  /** @return the id of the aborted transaction */
+  txn_id_t GetTransactionId() const { return txn_id_; }
+
+  const char *what() const noexcept override { return "Transaction aborted."; }
+
+ private:
+  txn_id_t txn_id_;
 };
 
 }  // namespace bustub
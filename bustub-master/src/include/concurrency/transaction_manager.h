@@ -79,6 +79,13 @@ class TransactionManager {
   void ResumeTransactions();
 
  private:
+  /**
+   * Call the completion callbacks of a transaction, see Transaction::AddCompletionCallback().
+   * @param txn the transaction that ended
+   * @param committed true if it committed
+   */
+  void RunCompletionCallbacks(Transaction *txn, bool committed);
+
   /**
    * Releases all the locks held by the given transaction.
    * @param txn the transaction whose locks should be released
@@ -14,6 +14,7 @@
 
 #include <queue>
 #include <string>
+#include <utility>
 #include <vector>
 #include <thread>
 
@@ -87,6 +88,30 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
    */
   size_t GetSize();
 
+ private:
+  /** The number of block page ids that fit into the header page. */
+  static constexpr size_t MAX_BLOCKS = (PAGE_SIZE - 32) / sizeof(page_id_t);
+
+  /**
+   * Insert a pair without taking the table latch.
+   * @param[out] full set if probing reached the end of the table without finding a free slot
+   * @return true if the pair was inserted
+   */
+  bool InsertNoLock(const KeyType &key, const ValueType &value, bool *full);
+
+  /**
+   * Grow the table to new_size slots and rehash all pairs, without taking the table latch. The table may end up larger
+   * if a pair runs off the end of new_size slots.
+   * @return false if the table could not grow, in which case it still holds all its pairs
+   */
+  bool Grow(size_t new_size);
+
+  /**
+   * Empty the blocks and insert the pairs into a table of the given size.
+   * @return false if a pair ran off the end of the table, leaving the pairs after it out
+   */
+  bool Rehash(const std::vector<std::pair<KeyType, ValueType>> &pairs, size_t size);
+
  private:
   // member variable
   page_id_t header_page_id_;
@@ -102,9 +127,6 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
   // HashTableHeaderPage *header_page_;
   size_t size_;
   int slot_num_per_page_;
-  bool is_resizing_ = false;
-  bool is_inserting_ = false;
-  std::thread::id resize_thread_id_;
 };
 
 }  // namespace bustub
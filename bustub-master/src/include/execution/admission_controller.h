@@ -0,0 +1,176 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// admission_controller.h
+//
+// Identification: src/include/execution/admission_controller.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
+
+#include "catalog/simple_catalog.h"
+#include "common/macros.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/** The priority class of a query that waits for admission; queries of a higher class are admitted first. */
+enum class QueryPriority { HIGH = 0, NORMAL = 1, LOW = 2 };
+
+/** The resources a query is estimated to need, see AdmissionController::Estimate(). */
+struct QueryEstimate {
+  /** The estimated rows of the output of the plan. */
+  double rows_{0};
+  /** The estimated rows that the operators of the plan process, which stands for its CPU time. */
+  double cpu_cost_{0};
+  /** The estimated bytes that the operators of the plan hold in memory at once. */
+  size_t memory_{0};
+  /** The threads the query runs on. */
+  uint32_t threads_{1};
+};
+
+/** The counters of an admission controller, see AdmissionController::GetStats(). */
+struct AdmissionStats {
+  /** The number of queries admitted, point queries included. */
+  uint64_t admitted_{0};
+  /** The number of point queries, which were admitted without a check. */
+  uint64_t point_queries_{0};
+  /** Per priority class: the number of queries that had to wait, their total and their longest wait. */
+  uint64_t queued_[3]{};
+  std::chrono::microseconds queue_wait_[3]{};
+  std::chrono::microseconds max_queue_wait_[3]{};
+  /** The number of queries waiting now. */
+  uint64_t waiting_{0};
+};
+
+class AdmissionController;
+
+/** AdmissionTicket holds the resources of an admitted query and hands them back when it is destroyed. */
+class AdmissionTicket {
+ public:
+  ~AdmissionTicket();
+
+  DISALLOW_COPY_AND_MOVE(AdmissionTicket);
+
+  /** @return the time the query waited for admission */
+  std::chrono::microseconds GetQueueWait() const { return queue_wait_; }
+
+ private:
+  friend class AdmissionController;
+
+  AdmissionTicket(AdmissionController *controller, size_t memory, uint32_t threads,
+                  std::chrono::microseconds queue_wait)
+      : controller_(controller), memory_(memory), threads_(threads), queue_wait_(queue_wait) {}
+
+  AdmissionController *controller_;
+  size_t memory_;
+  uint32_t threads_;
+  std::chrono::microseconds queue_wait_;
+};
+
+/**
+ * AdmissionController decides when a query may start, so that a burst of heavy queries runs a few at a time instead of
+ * thrashing the buffer pool and exhausting memory together.
+ *
+ * Every query is estimated from the shape of its plan and the statistics of its tables (see Estimate()). A point
+ * query, whose CPU cost is at most the point query cost, starts at once and is not counted: it is done before a queue
+ * would help. Any other query is admitted while the memory and the threads of the running queries, its own included,
+ * stay within the limits. Otherwise it waits in the FIFO queue of its priority class. Only the oldest query of the
+ * highest class that has waiting queries may be admitted, so a large query is never overtaken forever; a query that
+ * exceeds a limit on its own is admitted once nothing else runs.
+ *
+ * To put the queries of an ExecutorContext under admission control, set the controller with
+ * ExecutorContext::SetAdmissionControl(): ExecutorFactory::CreateExecutor() then waits for the admission of the root
+ * plan, and the query holds its resources until the context is destroyed or ExecutorContext::ReleaseAdmission().
+ */
+class AdmissionController {
+ public:
+  /** The number of priority classes. */
+  static constexpr uint32_t NUM_PRIORITIES = 3;
+  /** The CPU cost up to which a query is a point query by default. */
+  static constexpr double DEFAULT_POINT_QUERY_COST = 100;
+  /** The bytes a tuple held in memory is assumed to need besides its data. */
+  static constexpr size_t TUPLE_OVERHEAD = 32;
+
+  /**
+   * Creates an admission controller.
+   * @param memory_limit the most bytes the admitted queries may be estimated to hold at once
+   * @param thread_limit the most threads the admitted queries may run on at once
+   * @param point_query_cost the CPU cost up to which a query is a point query
+   */
+  AdmissionController(size_t memory_limit, uint32_t thread_limit, double point_query_cost = DEFAULT_POINT_QUERY_COST)
+      : memory_limit_(memory_limit), thread_limit_(thread_limit), point_query_cost_(point_query_cost) {}
+
+  DISALLOW_COPY_AND_MOVE(AdmissionController);
+
+  /**
+   * Estimate the resources of a plan. The rows of a scan come from the statistics of its table, and from
+   * JoinOrderOptimizer::DEFAULT_CARDINALITY for tables that were never analyzed. The CPU cost adds up the rows every
+   * operator reads, n log n for a sort. The memory adds up what the materializing operators hold, each capped at
+   * memory_budget if it spills past it: the build side of a hash join, the groups of an aggregation, the keys of a
+   * distinct and the input of a sort or of a top-n.
+   * @param plan the root of the plan
+   * @param catalog the catalog the tables, their statistics and the materialized views are looked up in
+   * @param memory_budget the bytes an operator may hold before it spills, see ExecutorContext::GetMemoryBudget()
+   * @return the estimate, for a query on one thread
+   */
+  static QueryEstimate Estimate(const AbstractPlanNode *plan, SimpleCatalog *catalog, size_t memory_budget);
+
+  /** @return true if a query with the estimate is a point query, which is admitted at once */
+  bool IsPointQuery(const QueryEstimate &estimate) const { return estimate.cpu_cost_ <= point_query_cost_; }
+
+  /**
+   * Wait until a query may start.
+   * @param estimate the estimate of the query
+   * @param priority the priority class of the query
+   * @return the ticket that holds the resources of the query until it is destroyed
+   */
+  std::unique_ptr<AdmissionTicket> Admit(const QueryEstimate &estimate, QueryPriority priority);
+
+  /** @return a snapshot of the counters */
+  AdmissionStats GetStats();
+
+ private:
+  friend class AdmissionTicket;
+  using Clock = std::chrono::steady_clock;
+
+  /** The resources a waiting query asks for. */
+  struct Request {
+    size_t memory_;
+    uint32_t threads_;
+  };
+
+  /** @return true if request is the next to admit and fits; latch_ must be held */
+  bool CanAdmit(const Request *request) const;
+
+  /** Hand back the resources of a query that finished. */
+  void Release(size_t memory, uint32_t threads);
+
+  const size_t memory_limit_;
+  const uint32_t thread_limit_;
+  const double point_query_cost_;
+
+  /** Protects the members below; waiting queries sleep on cv_. */
+  std::mutex latch_;
+  std::condition_variable cv_;
+  /** The waiting queries of every priority class, oldest first. */
+  std::deque<const Request *> queues_[NUM_PRIORITIES];
+  /** The resources of the admitted queries that are not point queries. */
+  size_t running_memory_{0};
+  uint32_t running_threads_{0};
+  uint32_t running_queries_{0};
+  AdmissionStats stats_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// approximate_aggregate.h
+//
+// Identification: src/include/execution/approximate_aggregate.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include "common/util/hash_util.h"
+
+namespace bustub {
+
+/**
+ * The state of the approximate aggregates that is shared by the aggregation tables.
+ *
+ * APPROX_COUNT_DISTINCT keeps a HyperLogLog sketch of APPROX_DISTINCT_PRECISION per group. Sketches merge by the
+ * maximum of every register, so partial groups from parallel workers and spilled partitions combine exactly.
+ *
+ * A sampled aggregation (AggregationPlanNode::GetSampleRate() below 1) only aggregates a Bernoulli sample of its
+ * input, every row kept independently with probability p. COUNT and SUM are scaled up by 1 / p (Horvitz-Thompson),
+ * AVG is the mean of the sample, and the error aggregates give the half-width of a 95% confidence interval of SUM and
+ * AVG. MIN, MAX and APPROX_COUNT_DISTINCT see only the sample and are not corrected.
+ */
+class ApproximateAggregate {
+ public:
+  /** The precision of an APPROX_COUNT_DISTINCT sketch: 2KB per group, a standard error of 2.3%. */
+  static constexpr uint32_t APPROX_DISTINCT_PRECISION = 11;
+  /** The z-score of the confidence interval the error aggregates give the half-width of. */
+  static constexpr double CONFIDENCE_Z = 1.96;
+
+  /** @return the 95% error bound of a SUM scaled up from a sample at rate, given the sum of squares of the sample */
+  static double SumErrorBound(double sum_squares, double rate) {
+    return CONFIDENCE_Z * std::sqrt((1 - rate) * sum_squares) / rate;
+  }
+
+  /**
+   * @return the 95% error bound of the mean of a sample at rate of count rows with the given sum and sum of squares,
+   * by the variance of a ratio estimator
+   */
+  static double AvgErrorBound(double count, double sum, double sum_squares, double rate) {
+    if (count == 0) {
+      return 0;
+    }
+    double deviations = std::max(0.0, sum_squares - sum * sum / count);
+    return CONFIDENCE_Z * std::sqrt((1 - rate) * deviations) / count;
+  }
+};
+
+/** SampleMoments is the running count, sum and sum of squares of the non-NULL inputs of an AVG or error aggregate. */
+struct SampleMoments {
+  double count_{0};
+  double sum_{0};
+  double sum_squares_{0};
+
+  void Add(double x) {
+    count_ += 1;
+    sum_ += x;
+    sum_squares_ += x * x;
+  }
+
+  void Merge(const SampleMoments &other) {
+    count_ += other.count_;
+    sum_ += other.sum_;
+    sum_squares_ += other.sum_squares_;
+  }
+};
+
+/** RowSampler decides which rows a sampled aggregation keeps, each with probability rate. */
+class RowSampler {
+ public:
+  /**
+   * @param rate the probability of keeping a row, 1 keeps all of them
+   * @param seed the seed of the decisions
+   * @param stream separates the decisions of samplers with the same seed, e.g. one per morsel
+   */
+  explicit RowSampler(double rate, uint64_t seed = 0, uint64_t stream = 0)
+      : rate_(rate), rng_(HashUtil::CombineHashes(seed, stream)), keep_(std::min(1.0, std::max(0.0, rate))) {}
+
+  /** @return true if the next row is kept */
+  bool Sample() { return rate_ >= 1 || keep_(rng_); }
+
+ private:
+  double rate_;
+  std::mt19937_64 rng_;
+  std::bernoulli_distribution keep_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,179 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bloom_filter.h
+//
+// Identification: src/include/execution/bloom_filter.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/util/hash_util.h"
+#include "execution/expressions/abstract_expression.h"
+#include "storage/table/table_heap.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * Hashes the join key of a tuple, combining the hashes of the non-null values of the key expressions.
+ * Both sides of a hash join and the scans that apply its Bloom filter must hash keys this way.
+ * @param tuple the tuple to hash
+ * @param schema the schema to evaluate the key expressions against
+ * @param exprs the key expressions
+ * @return the hash of the key
+ */
+inline hash_t HashJoinKey(const Tuple *tuple, const Schema *schema,
+                          const std::vector<const AbstractExpression *> &exprs) {
+  hash_t curr_hash = 0;
+  for (const auto &expr : exprs) {
+    Value val = expr->Evaluate(tuple, schema);
+    if (!val.IsNull()) {
+      curr_hash = HashUtil::CombineHashes(curr_hash, HashUtil::HashValue(&val));
+    }
+  }
+  return curr_hash;
+}
+
+/**
+ * BloomFilter is a register-blocked Bloom filter over key hashes: every key sets BITS_PER_KEY bits within a single
+ * 64-bit word, so a lookup costs one memory access and one mask comparison. With WORD_BITS_PER_KEY bits of filter per
+ * key the false positive rate stays around one percent. A filter never rejects a hash that was inserted.
+ */
+class BloomFilter {
+ public:
+  /** @param num_keys the number of keys that will be inserted */
+  explicit BloomFilter(size_t num_keys) {
+    size_t num_words = 1;
+    while (num_words * 64 < num_keys * WORD_BITS_PER_KEY) {
+      num_words *= 2;
+      word_shift_--;
+    }
+    words_.assign(num_words, 0);
+  }
+
+  /** Add a key hash. */
+  void Insert(hash_t h) {
+    uint64_t x = Mix(h);
+    words_[WordIdx(x)] |= Mask(x);
+  }
+
+  /** @return false if the key hash was certainly never inserted */
+  bool MayContain(hash_t h) const {
+    uint64_t x = Mix(h);
+    uint64_t mask = Mask(x);
+    return (words_[WordIdx(x)] & mask) == mask;
+  }
+
+  /** @return the size of the filter in bytes */
+  size_t GetMemoryUsage() const { return words_.size() * sizeof(uint64_t); }
+
+ private:
+  /** The number of bits a key sets in its word. */
+  static constexpr uint32_t BITS_PER_KEY = 4;
+  /** The number of filter bits to reserve per key. */
+  static constexpr size_t WORD_BITS_PER_KEY = 16;
+
+  /** Join hashes are not well mixed, so scramble them once with the finalizer of MurmurHash3. */
+  static uint64_t Mix(hash_t h) {
+    auto x = static_cast<uint64_t>(h);
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return x;
+  }
+
+  /** The word is picked with the high bits of the mix, the bits within it with the low bits. */
+  size_t WordIdx(uint64_t x) const { return word_shift_ == 64 ? 0 : static_cast<size_t>(x >> word_shift_); }
+
+  static uint64_t Mask(uint64_t x) {
+    uint64_t mask = 0;
+    for (uint32_t i = 0; i < BITS_PER_KEY; i++) {
+      mask |= uint64_t{1} << ((x >> (6 * i)) & 63);
+    }
+    return mask;
+  }
+
+  std::vector<uint64_t> words_;
+  /** 64 - log2 of the number of words, 64 for a single word. */
+  uint32_t word_shift_{64};
+};
+
+/**
+ * ScanBloomFilter applies the Bloom filters pushed down into a scan (see AbstractExecutor::PushDownBloomFilter) to the
+ * raw table tuples, so the tuples they rule out are dropped before they are copied out of the page. A scan below
+ * several joins may receive a filter from each; a tuple is kept only if every filter may contain its key.
+ */
+class ScanBloomFilter {
+ public:
+  /**
+   * Apply a filter on the given output columns from now on, in addition to the filters set before.
+   * @param filter the filter over the keys hashed with HashJoinKey
+   * @param key_cols the output columns of the scan that make up the key
+   * @param output_schema the output schema of the scan, whose column expressions are evaluated against table_schema
+   * @param table_schema the schema of the table
+   * @return false if a key column has no expression, in which case nothing changes
+   */
+  bool Set(const BloomFilter *filter, const std::vector<uint32_t> &key_cols, const Schema *output_schema,
+           const Schema *table_schema) {
+    std::vector<const AbstractExpression *> key_exprs;
+    for (uint32_t col : key_cols) {
+      const AbstractExpression *expr = output_schema->GetColumn(col).GetExpr();
+      if (expr == nullptr) {
+        return false;
+      }
+      key_exprs.push_back(expr);
+    }
+    filters_.push_back({filter, std::move(key_exprs)});
+    if (!row_filter_) {
+      row_filter_ = [this, table_schema](const Tuple &tuple) {
+        for (const auto &pushed : filters_) {
+          if (!pushed.filter_->MayContain(HashJoinKey(&tuple, table_schema, pushed.key_exprs_))) {
+            num_filtered_++;
+            return false;
+          }
+        }
+        return true;
+      };
+    }
+    return true;
+  }
+
+  /** Stop filtering, e.g. when the scan restarts. */
+  void Clear() {
+    filters_.clear();
+    row_filter_ = nullptr;
+    num_filtered_ = 0;
+  }
+
+  /** @return the row filter to scan with, nullptr if no filter was pushed down */
+  const TableHeap::RowFilter *GetRowFilter() const { return row_filter_ ? &row_filter_ : nullptr; }
+
+  /** @return the number of tuples the filters dropped */
+  size_t GetNumFiltered() const { return num_filtered_; }
+
+ private:
+  /** A pushed-down filter and the expressions of its key over the table. */
+  struct PushedFilter {
+    const BloomFilter *filter_;
+    std::vector<const AbstractExpression *> key_exprs_;
+  };
+
+  std::vector<PushedFilter> filters_;
+  /** Tests every filter in filters_, unset while there are none. */
+  TableHeap::RowFilter row_filter_;
+  size_t num_filtered_{0};
+};
+
+}  // namespace bustub
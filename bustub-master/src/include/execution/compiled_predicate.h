@@ -0,0 +1,138 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compiled_predicate.h
+//
+// Identification: src/include/execution/compiled_predicate.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/** PredicateOpCode enumerates the instructions of a compiled predicate program. */
+enum class PredicateOpCode : uint8_t { LoadTrue, LoadFalse, Compare, JumpIfFalse, JumpIfTrue, Interpret };
+
+/** CompareDomain is the machine type that both operands of a compiled comparison are widened to. */
+enum class CompareDomain : uint8_t { Integer, Decimal, Timestamp };
+
+/**
+ * PredicateOperand is one side of a compiled comparison.
+ * It is either a column read straight from the tuple bytes at a fixed offset, or a constant folded at compile time.
+ */
+struct PredicateOperand {
+  /** True if this operand is a constant, false if it is a column. */
+  bool is_constant_{false};
+  /** For columns, 0 = left (or only) tuple, 1 = right tuple of a join. */
+  uint32_t tuple_idx_{0};
+  /** For columns, the byte offset of the column inside the tuple. */
+  uint32_t offset_{0};
+  /** The storage type of the column or constant. */
+  TypeId type_{TypeId::INVALID};
+  /** True if the constant is NULL. */
+  bool is_null_{false};
+  /** The constant, widened to the comparison domain. */
+  union {
+    int64_t integer_;
+    double decimal_;
+    uint64_t timestamp_;
+  } constant_{0};
+};
+
+/** PredicateInstruction is a single step of a compiled predicate program. */
+struct PredicateInstruction {
+  PredicateOpCode op_;
+  /** Compare: the comparison to perform. */
+  ComparisonType comp_type_{ComparisonType::Equal};
+  /** Compare: the domain both operands are widened to. */
+  CompareDomain domain_{CompareDomain::Integer};
+  /** Compare: the operands. */
+  PredicateOperand lhs_{};
+  PredicateOperand rhs_{};
+  /** JumpIfFalse / JumpIfTrue: the program counter to continue at. */
+  uint32_t jump_target_{0};
+  /** Interpret: the expression subtree that could not be compiled. */
+  const AbstractExpression *expr_{nullptr};
+};
+
+/**
+ * CompiledPredicate is a boolean expression tree flattened into a register program over raw tuple bytes.
+ *
+ * Comparisons between fixed-width columns and constants become typed Compare instructions that read the column
+ * straight out of Tuple::GetData() without constructing any Value. AND/OR become conditional jumps over a single
+ * boolean accumulator, so the right operand is skipped whenever the left one decides the result. Constant
+ * subexpressions are folded at compile time. Anything the compiler does not understand (e.g. VARCHAR comparisons)
+ * is kept as an Interpret instruction that calls back into AbstractExpression::Evaluate, so every predicate compiles.
+ *
+ * The program implements filter semantics: a NULL result is reported as false. This is exact for the operators we
+ * have (comparisons, AND, OR), as none of them can turn an unknown into a true.
+ */
+class CompiledPredicate {
+ public:
+  /**
+   * Compiles a predicate over tuples of a single schema.
+   * @param expr the predicate, must not be nullptr
+   * @param schema the schema of the tuples the predicate is evaluated against
+   * @return the compiled predicate
+   */
+  static std::unique_ptr<CompiledPredicate> Compile(const AbstractExpression *expr, const Schema *schema);
+
+  /**
+   * Compiles a join predicate over pairs of tuples.
+   * @param expr the join predicate, must not be nullptr
+   * @param left_schema the schema of the left tuple
+   * @param right_schema the schema of the right tuple
+   * @return the compiled predicate
+   */
+  static std::unique_ptr<CompiledPredicate> CompileJoin(const AbstractExpression *expr, const Schema *left_schema,
+                                                        const Schema *right_schema);
+
+  /** @return true if the predicate holds for the tuple */
+  bool Evaluate(const Tuple *tuple) const { return Run(tuple, tuple); }
+
+  /** @return true if the join predicate holds for the pair of tuples */
+  bool EvaluateJoin(const Tuple *left_tuple, const Tuple *right_tuple) const { return Run(left_tuple, right_tuple); }
+
+  /** @return true if the predicate folded to a constant */
+  bool IsConstant() const {
+    return program_.size() == 1 &&
+           (program_[0].op_ == PredicateOpCode::LoadTrue || program_[0].op_ == PredicateOpCode::LoadFalse);
+  }
+
+  /** @return true if every instruction runs on raw bytes, i.e. nothing falls back to the expression interpreter */
+  bool IsFullyCompiled() const;
+
+  /** @return the compiled program, for inspection and testing */
+  const std::vector<PredicateInstruction> &GetProgram() const { return program_; }
+
+ private:
+  CompiledPredicate(bool is_join, const Schema *left_schema, const Schema *right_schema)
+      : is_join_{is_join}, left_schema_{left_schema}, right_schema_{right_schema} {}
+
+  bool Run(const Tuple *left_tuple, const Tuple *right_tuple) const;
+
+  bool Interpret(const AbstractExpression *expr, const Tuple *left_tuple, const Tuple *right_tuple) const;
+
+  /** The flattened program. Execution starts at 0 and the accumulator holds the result when it falls off the end. */
+  std::vector<PredicateInstruction> program_;
+  /** True if this predicate was compiled for EvaluateJoin. */
+  bool is_join_;
+  const Schema *left_schema_;
+  const Schema *right_schema_;
+
+  friend class PredicateCompiler;
+};
+
+}  // namespace bustub
@@ -12,12 +12,17 @@
 
 #pragma once
 
+#include <memory>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "catalog/simple_catalog.h"
+#include "common/arena.h"
 #include "concurrency/transaction.h"
+#include "execution/admission_controller.h"
+#include "execution/memory_tracker.h"
+#include "execution/query_profile.h"
 #include "storage/page/tmp_tuple_page.h"
 
 namespace bustub {
@@ -26,6 +31,9 @@ namespace bustub {
  */
 class ExecutorContext {
  public:
+  /** The default memory budget of an operator. */
+  static constexpr size_t DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+
   /**
    * Creates an ExecutorContext for the transaction that is executing the query.
    * @param transaction the transaction executing the query
@@ -48,6 +56,72 @@ class ExecutorContext {
   /** @return the buffer pool manager */
   BufferPoolManager *GetBufferPoolManager() { return bpm_; }
 
+  /** @return the arena for memory that executors materialize, released in bulk when the query finishes */
+  Arena *GetArena() { return &arena_; }
+
+  /** @return the number of bytes an operator may hold in memory before it spills to temporary pages */
+  size_t GetMemoryBudget() const { return memory_budget_; }
+
+  /** Set the number of bytes an operator may hold in memory before it spills to temporary pages. */
+  void SetMemoryBudget(size_t memory_budget) { memory_budget_ = memory_budget; }
+
+  /** @return the tracker that the operators of the query charge their memory to */
+  MemoryTracker *GetMemoryTracker() { return &memory_tracker_; }
+
+  /**
+   * Set the most bytes the operators of the query may hold in memory at once. Past it operators spill if they can and
+   * fail the query otherwise.
+   */
+  void SetMemoryLimit(size_t memory_limit) { memory_tracker_.SetLimit(memory_limit); }
+
+  /** @return the number of threads an operator may use */
+  uint32_t GetNumThreads() const { return num_threads_; }
+
+  /** Set the number of threads an operator may use. */
+  void SetNumThreads(uint32_t num_threads) { num_threads_ = num_threads; }
+
+  /** @return the number of page reads an operator may keep in flight in the coroutine execution mode, 0 if it is off */
+  uint32_t GetMaxInFlightReads() const { return max_in_flight_reads_; }
+
+  /**
+   * Set the number of page reads an operator may keep in flight at once by running its page fetches as coroutines
+   * (see CoroutineScheduler); 0, the default, reads pages synchronously. Only builds with the BUSTUB_COROUTINES option
+   * have the coroutine execution mode; other builds ignore the setting.
+   */
+  void SetMaxInFlightReads(uint32_t max_in_flight_reads) { max_in_flight_reads_ = max_in_flight_reads; }
+
+  /** Collect a QueryProfile for the executors that ExecutorFactory creates from now on. */
+  void EnableProfiling() { profile_ = std::make_unique<QueryProfile>(); }
+
+  /** @return the profile of the query, nullptr if profiling is off */
+  QueryProfile *GetProfile() { return profile_.get(); }
+
+  /**
+   * Put the query under admission control: ExecutorFactory::CreateExecutor() waits for the admission of the root plan
+   * before it creates its executor. The controller must outlive the context.
+   * @param controller the admission controller, nullptr to admit the query without a check
+   * @param priority the priority class the query waits in
+   */
+  void SetAdmissionControl(AdmissionController *controller, QueryPriority priority = QueryPriority::NORMAL) {
+    admission_controller_ = controller;
+    query_priority_ = priority;
+  }
+
+  /** @return the admission controller of the query, nullptr if there is none */
+  AdmissionController *GetAdmissionController() { return admission_controller_; }
+
+  /** @return the priority class of the query */
+  QueryPriority GetQueryPriority() const { return query_priority_; }
+
+  /** @return the ticket of the admitted query, nullptr before its admission */
+  AdmissionTicket *GetAdmissionTicket() { return admission_ticket_.get(); }
+
+  /** Hold the resources of the admitted query until the context is destroyed or ReleaseAdmission() is called. */
+  void SetAdmissionTicket(std::unique_ptr<AdmissionTicket> ticket) { admission_ticket_ = std::move(ticket); }
+
+  /** Hand the resources of the query back to the admission controller once its executors are done. */
+  void ReleaseAdmission() { admission_ticket_.reset(); }
+
   /** @return the log manager - don't worry about it for now */
   LogManager *GetLogManager() { return nullptr; }
 
@@ -58,6 +132,15 @@ class ExecutorContext {
   Transaction *transaction_;
   SimpleCatalog *catalog_;
   BufferPoolManager *bpm_;
+  Arena arena_;
+  size_t memory_budget_{DEFAULT_MEMORY_BUDGET};
+  MemoryTracker memory_tracker_;
+  uint32_t num_threads_{1};
+  uint32_t max_in_flight_reads_{0};
+  std::unique_ptr<QueryProfile> profile_;
+  AdmissionController *admission_controller_{nullptr};
+  QueryPriority query_priority_{QueryPriority::NORMAL};
+  std::unique_ptr<AdmissionTicket> admission_ticket_;
 };
 
 }  // namespace bustub
@@ -12,10 +12,15 @@
 
 #pragma once
 
+#include <vector>
+
+#include "concurrency/transaction.h"
 #include "execution/executor_context.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
+class BloomFilter;
+
 /**
  * AbstractExecutor implements the Volcano tuple-at-a-time iterator model.
  */
@@ -46,10 +51,38 @@ class AbstractExecutor {
   /** @return the schema of the tuples that this executor produces */
   virtual const Schema *GetOutputSchema() = 0;
 
+  /**
+   * Offers a Bloom filter on some output columns, built by a hash join above this executor once its build side is
+   * complete. An executor that accepts the filter drops the tuples it rules out before producing them; executors that
+   * only pass tuples through may forward it to a child. Called after Init(), before the first Next().
+   * @param filter the filter over the keys hashed with HashJoinKey, must stay valid while this executor runs
+   * @param key_cols the output columns that make up the key, in key order
+   * @return true if the filter is applied by this executor or one of its children
+   */
+  virtual bool PushDownBloomFilter(const BloomFilter * /*filter*/, const std::vector<uint32_t> & /*key_cols*/) {
+    return false;
+  }
+
+  /**
+   * @return the most bytes this executor held in memory at once since Init(), not counting its children, for
+   * executors that materialize tuples; 0 for executors that stream
+   */
+  virtual size_t GetPeakMemoryUsage() { return 0; }
+
   /** @return the executor context in which this executor runs */
   ExecutorContext *GetExecutorContext() { return exec_ctx_; }
 
  protected:
+  /**
+   * Abort the transaction of this executor, if it is not aborted yet, e.g. because the storage failed under it.
+   * @throws TransactionAbortException always
+   */
+  [[noreturn]] void AbortQuery() {
+    Transaction *txn = exec_ctx_->GetTransaction();
+    txn->SetState(TransactionState::ABORTED);
+    throw TransactionAbortException(txn->GetTransactionId());
+  }
+
   ExecutorContext *exec_ctx_;
 };
 }  // namespace bustub
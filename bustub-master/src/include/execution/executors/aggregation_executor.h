@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <cmath>
 #include <memory>
 #include <unordered_map>
 #include <utility>
@@ -19,16 +20,27 @@
 
 #include "common/util/hash_util.h"
 #include "container/hash/hash_function.h"
+#include "common/hyperloglog.h"
+#include "execution/approximate_aggregate.h"
+#include "execution/compiled_predicate.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/expressions/abstract_expression.h"
+#include "execution/external_aggregation.h"
+#include "execution/memory_tracker.h"
+#include "execution/packed_aggregation_hash_table.h"
+#include "execution/parallel_aggregation.h"
 #include "execution/plans/aggregation_plan.h"
+#include "execution/plans/seq_scan_plan.h"
 #include "storage/table/tuple.h"
 #include "type/value_factory.h"
 
 namespace bustub {
 /**
  * A simplified hash table that has all the necessary functionality for aggregations.
+ *
+ * The aggregate values it holds are running states; FinalizeAggregateValue() turns them into the results, estimating
+ * the approximate aggregates and scaling up those of a sampled aggregation (see ApproximateAggregate).
  */
 class SimpleAggregationHashTable {
  public:
@@ -36,10 +48,17 @@ class SimpleAggregationHashTable {
    * Create a new simplified aggregation hash table.
    * @param agg_exprs the aggregation expressions
    * @param agg_types the types of aggregations
+   * @param sample_rate the fraction of the input rows the aggregation sees
    */
   SimpleAggregationHashTable(const std::vector<const AbstractExpression *> &agg_exprs,
-                             const std::vector<AggregationType> &agg_types)
-      : agg_exprs_{agg_exprs}, agg_types_{agg_types} {}
+                             const std::vector<AggregationType> &agg_types, double sample_rate = 1)
+      : agg_exprs_{agg_exprs}, agg_types_{agg_types}, sample_rate_{sample_rate} {
+    for (const auto &agg_type : agg_types_) {
+      num_sketches_ += agg_type == AggregationType::ApproxCountDistinctAggregate ? 1 : 0;
+      has_moments_ = has_moments_ || agg_type == AggregationType::AvgAggregate ||
+                     agg_type == AggregationType::SumErrorAggregate || agg_type == AggregationType::AvgErrorAggregate;
+    }
+  }
 
   /** @return the initial aggregrate value for this aggregation executor */
   AggregateValue GenerateInitialAggregateValue() {
@@ -62,13 +81,23 @@ class SimpleAggregationHashTable {
           // Max starts at INT_MIN.
           values.emplace_back(ValueFactory::GetIntegerValue(BUSTUB_INT32_MIN));
           break;
+        default:
+          // The others keep their state in moments_ or sketches_ until they are finalized.
+          values.emplace_back(ValueFactory::GetIntegerValue(0));
+          break;
       }
     }
-    return {values};
+    AggregateValue result{values, {}, {}};
+    if (has_moments_) {
+      result.moments_.resize(agg_types_.size());
+    }
+    result.sketches_.assign(num_sketches_, HyperLogLog(ApproximateAggregate::APPROX_DISTINCT_PRECISION));
+    return result;
   }
 
   /** Combines the input into the aggregation result. */
   void CombineAggregateValues(AggregateValue *result, const AggregateValue &input) {
+    uint32_t sketch_idx = 0;
     for (uint32_t i = 0; i < agg_exprs_.size(); i++) {
       switch (agg_types_[i]) {
         case AggregationType::CountAggregate:
@@ -87,6 +116,62 @@ class SimpleAggregationHashTable {
           // Max is just the max.
           result->aggregates_[i] = result->aggregates_[i].Max(input.aggregates_[i]);
           break;
+        case AggregationType::ApproxCountDistinctAggregate:
+          // The sketch skips NULLs.
+          result->sketches_[sketch_idx++].Add(input.aggregates_[i]);
+          break;
+        case AggregationType::AvgAggregate:
+        case AggregationType::SumErrorAggregate:
+        case AggregationType::AvgErrorAggregate:
+          // AVG and the error bounds skip NULLs.
+          if (!input.aggregates_[i].IsNull()) {
+            result->moments_[i].Add(ValueFactory::CastAsDecimal(input.aggregates_[i]).GetAs<double>());
+          }
+          break;
+      }
+    }
+  }
+
+  /**
+   * Turn the running state of a group into its aggregate results.
+   * @param val the running state
+   * @param[out] aggregates the results
+   */
+  void FinalizeAggregateValue(const AggregateValue &val, std::vector<Value> *aggregates) const {
+    aggregates->clear();
+    uint32_t sketch_idx = 0;
+    for (uint32_t i = 0; i < agg_types_.size(); i++) {
+      const Value &state = val.aggregates_[i];
+      switch (agg_types_[i]) {
+        case AggregationType::CountAggregate:
+        case AggregationType::SumAggregate:
+          aggregates->emplace_back(sample_rate_ < 1 && !state.IsNull() ? ScaleUp(state) : state);
+          break;
+        case AggregationType::MinAggregate:
+        case AggregationType::MaxAggregate:
+          aggregates->emplace_back(state);
+          break;
+        case AggregationType::ApproxCountDistinctAggregate: {
+          double estimate = val.sketches_[sketch_idx++].Estimate();
+          aggregates->emplace_back(ValueFactory::GetIntegerValue(static_cast<int32_t>(std::llround(estimate))));
+          break;
+        }
+        case AggregationType::AvgAggregate: {
+          const SampleMoments &m = val.moments_[i];
+          aggregates->emplace_back(m.count_ == 0 ? ValueFactory::GetNullValueByType(TypeId::DECIMAL)
+                                                 : ValueFactory::GetDecimalValue(m.sum_ / m.count_));
+          break;
+        }
+        case AggregationType::SumErrorAggregate:
+          aggregates->emplace_back(ValueFactory::GetDecimalValue(
+              ApproximateAggregate::SumErrorBound(val.moments_[i].sum_squares_, sample_rate_)));
+          break;
+        case AggregationType::AvgErrorAggregate: {
+          const SampleMoments &m = val.moments_[i];
+          aggregates->emplace_back(ValueFactory::GetDecimalValue(
+              ApproximateAggregate::AvgErrorBound(m.count_, m.sum_, m.sum_squares_, sample_rate_)));
+          break;
+        }
       }
     }
   }
@@ -134,6 +219,21 @@ class SimpleAggregationHashTable {
     std::unordered_map<AggregateKey, AggregateValue>::const_iterator iter_;
   };
 
+  /** @return an estimate of the bytes held by the groups of the table */
+  size_t GetMemoryUsage() const {
+    if (ht.empty()) {
+      return 0;
+    }
+    const auto &group = *ht.begin();
+    size_t values = group.first.group_bys_.size() + group.second.aggregates_.size();
+    size_t state = group.second.moments_.size() * sizeof(SampleMoments);
+    for (const auto &sketch : group.second.sketches_) {
+      state += sizeof(sketch) + sketch.GetMemoryUsage();
+    }
+    return ht.bucket_count() * sizeof(void *) +
+           ht.size() * (sizeof(group) + sizeof(void *) + values * sizeof(Value) + state);
+  }
+
   /** @return iterator to the start of the hash table */
   Iterator Begin() { return Iterator{ht.cbegin()}; }
 
@@ -141,16 +241,43 @@ class SimpleAggregationHashTable {
   Iterator End() { return Iterator{ht.cend()}; }
 
  private:
+  /** @return a COUNT or SUM of the sample scaled up to the whole input, keeping its type */
+  Value ScaleUp(const Value &value) const {
+    double scaled = ValueFactory::CastAsDecimal(value).GetAs<double>() / sample_rate_;
+    if (value.GetTypeId() == TypeId::DECIMAL) {
+      return ValueFactory::GetDecimalValue(scaled);
+    }
+    return ValueFactory::GetDecimalValue(std::round(scaled)).CastAs(value.GetTypeId());
+  }
+
   /** The hash table is just a map from aggregate keys to aggregate values. */
   std::unordered_map<AggregateKey, AggregateValue> ht{};
   /** The aggregate expressions that we have. */
   const std::vector<const AbstractExpression *> &agg_exprs_;
   /** The types of aggregations that we have. */
   const std::vector<AggregationType> &agg_types_;
+  /** The fraction of the input rows the aggregation sees. */
+  double sample_rate_;
+  /** The number of APPROX_COUNT_DISTINCT aggregates. */
+  uint32_t num_sketches_{0};
+  /** True if any aggregate keeps moments. */
+  bool has_moments_{false};
 };
 
 /**
  * AggregationExecutor executes an aggregation operation (e.g. COUNT, SUM, MIN, MAX) on the tuples of a child executor.
+ *
+ * Aggregations whose group-bys and inputs are plain fixed-width columns of the child run on a
+ * PackedAggregationHashTable, which spills partitions to temporary pages once it outgrows the memory budget of the
+ * executor context or the memory limit of the query (see ExternalAggregation). Everything else runs in memory on the
+ * SimpleAggregationHashTable, which fails the query once it exceeds the memory limit.
+ *
+ * If the executor context allows more than one thread and the child is a sequential scan, a packed aggregation scans
+ * the table pages itself and aggregates them on that many threads (see ParallelAggregation). The parallel path keeps
+ * its partial tables in memory and does not spill either.
+ *
+ * A plan with a sample rate below 1 aggregates a Bernoulli sample of the child tuples on every path (see
+ * ApproximateAggregate for how the results are corrected).
  */
 class AggregationExecutor : public AbstractExecutor {
  public:
@@ -162,11 +289,19 @@ class AggregationExecutor : public AbstractExecutor {
    */
   AggregationExecutor(ExecutorContext *exec_ctx, const AggregationPlanNode *plan,
                       std::unique_ptr<AbstractExecutor> &&child)
-      : AbstractExecutor(exec_ctx), 
+      : AbstractExecutor(exec_ctx),
         plan_(plan),
         child_(std::move(child)),
-        aht_(plan->GetAggregates(), plan->GetAggregateTypes()),
-        aht_iterator_(aht_.Begin()) {}
+        aht_(plan->GetAggregates(), plan->GetAggregateTypes(), plan->GetSampleRate()),
+        aht_iterator_(aht_.Begin()),
+        memory_tracker_(exec_ctx->GetMemoryTracker()) {
+    if (PackedAggregationHashTable::CanHandle(child_->GetOutputSchema(), plan_->GetGroupBys(),
+                                              plan_->GetAggregates(), plan_->GetAggregateTypes())) {
+      packed_aht_ = std::make_unique<PackedAggregationHashTable>(child_->GetOutputSchema(), plan_->GetGroupBys(),
+                                                                 plan_->GetAggregates(), plan_->GetAggregateTypes(),
+                                                                 plan_->GetSampleRate());
+    }
+  }
 
   /** Do not use or remove this function, otherwise you will get zero points. */
   const AbstractExecutor *GetChildExecutor() const { return child_.get(); }
@@ -174,49 +309,71 @@ class AggregationExecutor : public AbstractExecutor {
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
 
   void Init() override {
-    child_->Init();
+    parallel_aht_.reset();
+    if (packed_aht_ != nullptr && exec_ctx_->GetNumThreads() > 1 && !enable_logging &&
+        plan_->GetChildPlan()->GetType() == PlanType::SeqScan) {
+      RunParallel();
+      return;
+    }
 
+    child_->Init();
     Tuple cur_tuple;
-    while (child_->Next(&cur_tuple)) {
-      // if (plan_->GetHaving() && plan_->GetHaving()->Evaluate(&cur_tuple, child_->GetOutputSchema()).GetAs<bool>()) {
-        aht_.InsertCombine(MakeKey(&cur_tuple), MakeVal(&cur_tuple));
-      // }
+    RowSampler sampler(plan_->GetSampleRate(), plan_->GetSampleSeed());
+    if (packed_aht_ != nullptr) {
+      external_aht_.reset();
+      packed_aht_->Release();
+      external_aht_ = std::make_unique<ExternalAggregation>(
+          packed_aht_.get(), exec_ctx_->GetBufferPoolManager(), exec_ctx_->GetMemoryBudget(), &memory_tracker_);
+      while (child_->Next(&cur_tuple)) {
+        if (sampler.Sample()) {
+          external_aht_->Insert(cur_tuple);
+        }
+      }
+      external_aht_->Finish();
+      return;
     }
 
+    while (child_->Next(&cur_tuple)) {
+      if (!sampler.Sample()) {
+        continue;
+      }
+      aht_.InsertCombine(MakeKey(&cur_tuple), MakeVal(&cur_tuple));
+      memory_tracker_.SetUsage(aht_.GetMemoryUsage(), "Aggregation");
+    }
     aht_iterator_ = aht_.Begin();
   }
 
   bool Next(Tuple *tuple) override {
-    bool ret = false;
-    std::vector<Value> values;
-    const Schema *output_schema = GetOutputSchema();
-
-    while (aht_iterator_ != aht_.End()) {
-      if (plan_->GetHaving() == nullptr) {
-        ret = true;
-        break;
+    if (parallel_aht_ != nullptr) {
+      while (parallel_aht_->Next(&group_bys_, &aggregates_)) {
+        if (EmitGroup(group_bys_, aggregates_, tuple)) {
+          return true;
+        }
       }
-      else {
-        if (plan_->GetHaving()->EvaluateAggregate(aht_iterator_.Key().group_bys_, aht_iterator_.Val().aggregates_).GetAs<bool>()) {
-          ret = true;
-          break;
+      return false;
+    }
+    if (packed_aht_ != nullptr) {
+      while (external_aht_->Next(&group_bys_, &aggregates_)) {
+        if (EmitGroup(group_bys_, aggregates_, tuple)) {
+          return true;
         }
       }
-      
-      ++aht_iterator_;
+      return false;
     }
 
-    if (ret) {
-      for (unsigned int i = 0; i < output_schema->GetColumnCount(); i++) {
-        values.push_back(output_schema->GetColumn(i).GetExpr()->EvaluateAggregate(aht_iterator_.Key().group_bys_, aht_iterator_.Val().aggregates_));
-      }
-      *tuple = Tuple(values, GetOutputSchema());
+    while (aht_iterator_ != aht_.End()) {
+      const AggregateKey &key = aht_iterator_.Key();
+      aht_.FinalizeAggregateValue(aht_iterator_.Val(), &aggregates_);
       ++aht_iterator_;
+      if (EmitGroup(key.group_bys_, aggregates_, tuple)) {
+        return true;
+      }
     }
-    
-    return ret;
+    return false;
   }
 
+  size_t GetPeakMemoryUsage() override { return memory_tracker_.GetPeakUsage(); }
+
   /** @return the tuple as an AggregateKey */
   AggregateKey MakeKey(const Tuple *tuple) {
     std::vector<Value> keys;
@@ -232,18 +389,84 @@ class AggregationExecutor : public AbstractExecutor {
     for (const auto &expr : plan_->GetAggregates()) {
       vals.emplace_back(expr->Evaluate(tuple, child_->GetOutputSchema()));
     }
-    return {vals};
+    return {vals, {}, {}};
   }
 
  private:
+  /** Aggregate the table of the child sequential scan page by page on several threads. */
+  void RunParallel() {
+    const auto *scan_plan = static_cast<const SeqScanPlanNode *>(plan_->GetChildPlan());
+    TableMetadata *table_info = exec_ctx_->GetCatalog()->GetTable(scan_plan->GetTableOid());
+    std::unique_ptr<CompiledPredicate> predicate;
+    if (scan_plan->GetPredicate() != nullptr) {
+      predicate = CompiledPredicate::Compile(scan_plan->GetPredicate(), &table_info->schema_);
+    }
+    Transaction *txn = exec_ctx_->GetTransaction();
+    std::vector<page_id_t> page_ids = table_info->table_->GetPageIds(txn);
+    if (txn->GetState() == TransactionState::ABORTED) {
+      // The page directory could not be read.
+      AbortQuery();
+    }
+
+    parallel_aht_ = std::make_unique<ParallelAggregation>(
+        child_->GetOutputSchema(), plan_->GetGroupBys(), plan_->GetAggregates(), plan_->GetAggregateTypes(),
+        exec_ctx_->GetNumThreads(), &memory_tracker_, plan_->GetSampleRate());
+    auto scan_morsel = [&](uint32_t morsel_idx, const ParallelAggregation::Sink &sink) {
+      // Every morsel samples its rows on its own, so the sample does not depend on which worker scans it.
+      RowSampler sampler(plan_->GetSampleRate(), plan_->GetSampleSeed(), morsel_idx);
+      auto sample = [&sink, &sampler](Tuple *t) {
+        if (sampler.Sample()) {
+          sink(*t);
+        }
+        return true;
+      };
+      // The workers share the transaction, so they take no locks (the parallel path runs without logging) and leave
+      // aborting it to this thread. sample never stops the scan, so false means the page could not be read.
+      page_id_t next_page_id;
+      return table_info->table_->ScanPage(page_ids[morsel_idx], &table_info->schema_, predicate.get(),
+                                          scan_plan->OutputSchema(), sample, nullptr, &next_page_id);
+    };
+    if (!parallel_aht_->Run(page_ids.size(), scan_morsel)) {
+      AbortQuery();
+    }
+  }
+
+  /**
+   * Apply the HAVING clause to a group and build its output tuple.
+   * @return true if the group passed the HAVING clause and tuple was set
+   */
+  bool EmitGroup(const std::vector<Value> &group_bys, const std::vector<Value> &aggregates, Tuple *tuple) {
+    if (plan_->GetHaving() != nullptr && !plan_->GetHaving()->EvaluateAggregate(group_bys, aggregates).GetAs<bool>()) {
+      return false;
+    }
+    const Schema *output_schema = GetOutputSchema();
+    std::vector<Value> values;
+    values.reserve(output_schema->GetColumnCount());
+    for (const auto &col : output_schema->GetColumns()) {
+      values.push_back(col.GetExpr()->EvaluateAggregate(group_bys, aggregates));
+    }
+    *tuple = Tuple(values, output_schema);
+    return true;
+  }
+
   /** The aggregation plan node. */
   const AggregationPlanNode *plan_;
   /** The child executor whose tuples we are aggregating. */
   std::unique_ptr<AbstractExecutor> child_;
-  bool has_init;
   /** Simple aggregation hash table. */
   SimpleAggregationHashTable aht_;
   /** Simple aggregation hash table iterator. */
   SimpleAggregationHashTable::Iterator aht_iterator_;
+  /** Charges the tables to the query; declared before them so that it outlives them. */
+  MemoryTracker memory_tracker_;
+  /** Packed aggregation hash table, nullptr if the aggregation does not fit it. */
+  std::unique_ptr<PackedAggregationHashTable> packed_aht_;
+  /** Runs the packed table under the memory budget, spilling it if needed. */
+  std::unique_ptr<ExternalAggregation> external_aht_;
+  /** Runs the packed aggregation on several threads, nullptr unless the parallel path was taken. */
+  std::unique_ptr<ParallelAggregation> parallel_aht_;
+  /** Scratch space for the group being emitted. */
+  std::vector<Value> group_bys_;
+  std::vector<Value> aggregates_;
 };
 }  // namespace bustub
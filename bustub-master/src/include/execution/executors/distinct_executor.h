@@ -0,0 +1,154 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// distinct_executor.h
+//
+// Identification: src/include/execution/executors/distinct_executor.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/external_distinct.h"
+#include "execution/memory_tracker.h"
+#include "execution/plans/distinct_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * DistinctExecutor executes SELECT DISTINCT with a hash set of packed keys (see ExternalDistinct).
+ *
+ * The key of a tuple is its bytes if all columns are fixed-width, and the serialized values otherwise, so keys
+ * compare byte for byte and no aggregate state is kept. Every tuple is passed on the moment it is found to be new,
+ * so the executor does not block; only the tuples of partitions spilled under the memory budget come out after the
+ * child is exhausted.
+ */
+class DistinctExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new distinct executor.
+   * @param exec_ctx the context that the distinct should be performed in
+   * @param plan the distinct plan node
+   * @param child the child executor whose duplicates are removed
+   */
+  DistinctExecutor(ExecutorContext *exec_ctx, const DistinctPlanNode *plan, std::unique_ptr<AbstractExecutor> &&child)
+      : AbstractExecutor(exec_ctx),
+        plan_(plan),
+        child_(std::move(child)),
+        memory_tracker_(exec_ctx->GetMemoryTracker()) {
+    const Schema *schema = child_->GetOutputSchema();
+    fixed_width_ = schema->GetUnlinedColumns().empty();
+  }
+
+  /** @return the child executor */
+  const AbstractExecutor *GetChildExecutor() const { return child_.get(); }
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  void Init() override {
+    child_->Init();
+    distinct_.reset();
+    distinct_ = std::make_unique<ExternalDistinct>(exec_ctx_->GetBufferPoolManager(), exec_ctx_->GetMemoryBudget(),
+                                                   &memory_tracker_);
+    child_done_ = false;
+  }
+
+  bool Next(Tuple *tuple) override {
+    while (!child_done_) {
+      if (!child_->Next(tuple)) {
+        child_done_ = true;
+        distinct_->Finish();
+        break;
+      }
+      const char *key = tuple->GetData();
+      uint32_t size = tuple->GetLength();
+      if (!fixed_width_) {
+        EncodeKey(*tuple);
+        key = key_.data();
+        size = static_cast<uint32_t>(key_.size());
+      }
+      if (distinct_->Insert(key, size)) {
+        return true;
+      }
+    }
+
+    const char *key;
+    uint32_t size;
+    if (!distinct_->Next(&key, &size)) {
+      return false;
+    }
+    DecodeKey(key, size, tuple);
+    return true;
+  }
+
+  size_t GetPeakMemoryUsage() override { return memory_tracker_.GetPeakUsage(); }
+
+  /** @return the number of temporary pages the spilled partitions took */
+  uint32_t GetNumSpilledPages() const { return distinct_ == nullptr ? 0 : distinct_->GetNumSpilledPages(); }
+
+ private:
+  /** Serialize the values of a tuple with variable-length columns into key_. */
+  void EncodeKey(const Tuple &tuple) {
+    const Schema *schema = child_->GetOutputSchema();
+    key_.clear();
+    for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+      const Column &col = schema->GetColumn(i);
+      Value value = tuple.GetValue(schema, i);
+      size_t offset = key_.size();
+      key_.resize(offset + GetSerializedLength(col, value));
+      value.SerializeTo(key_.data() + offset);
+    }
+  }
+
+  /** Rebuild a tuple from its key. */
+  void DecodeKey(const char *key, uint32_t size, Tuple *tuple) const {
+    const Schema *schema = child_->GetOutputSchema();
+    if (fixed_width_) {
+      // Copy the bytes out of the temporary page.
+      Tuple view(TupleView(key, size, RID()));
+      *tuple = view;
+      return;
+    }
+    std::vector<Value> values;
+    values.reserve(schema->GetColumnCount());
+    for (const Column &col : schema->GetColumns()) {
+      values.emplace_back(Value::DeserializeFrom(key, col.GetType()));
+      key += GetSerializedLength(col, values.back());
+    }
+    *tuple = Tuple(values, schema);
+  }
+
+  /** @return the bytes a value of a column takes in a key */
+  static uint32_t GetSerializedLength(const Column &col, const Value &value) {
+    if (col.IsInlined()) {
+      return col.GetFixedLength();
+    }
+    return sizeof(uint32_t) + (value.IsNull() ? 0 : value.GetLength());
+  }
+
+  /** The distinct plan node. */
+  const DistinctPlanNode *plan_;
+  /** The child executor whose duplicates are removed. */
+  std::unique_ptr<AbstractExecutor> child_;
+  /** Charges the key sets to the query; declared before them so that it outlives them. */
+  MemoryTracker memory_tracker_;
+  /** The keys seen so far. */
+  std::unique_ptr<ExternalDistinct> distinct_;
+  /** True if all columns are fixed-width, so that the bytes of a tuple are its key. */
+  bool fixed_width_;
+  /** True once the child is exhausted and the spilled partitions are being read. */
+  bool child_done_{false};
+  /** Scratch space for the key of a tuple with variable-length columns. */
+  std::vector<char> key_;
+};
+}  // namespace bustub
@@ -12,22 +12,24 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
-#include <string>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "common/arena.h"
 #include "common/util/hash_util.h"
 #include "container/hash/hash_function.h"
-#include "container/hash/linear_probe_hash_table.h"
+#include "execution/bloom_filter.h"
+#include "execution/compiled_predicate.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/expressions/abstract_expression.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/memory_tracker.h"
 #include "execution/plans/hash_join_plan.h"
-#include "storage/index/hash_comparator.h"
-#include "storage/table/tmp_tuple.h"
 #include "storage/table/tuple.h"
+#include "storage/table/tuple_view.h"
 
 namespace bustub {
 /**
@@ -45,46 +47,114 @@ class IdentityHashFunction : public HashFunction<hash_t> {
 
 /**
  * A simple hash table that supports hash joins.
+ * Chain entries live in an arena next to the build tuples they point to, so building the table costs no allocation
+ * per tuple; the table itself only owns its bucket array.
  */
 class SimpleHashJoinHashTable {
  public:
-  /** Creates a new simple hash join hash table. */
-  SimpleHashJoinHashTable(const std::string &name, BufferPoolManager *bpm, HashComparator cmp, uint32_t buckets,
-                          const IdentityHashFunction &hash_fn) {}
+  /** An entry in a bucket chain. */
+  struct Entry {
+    hash_t hash_;
+    TupleView tuple_;
+    Entry *next_;
+  };
+
+  /**
+   * Creates a new simple hash join hash table.
+   * @param arena the arena that holds the entries
+   * @param buckets the initial number of buckets, must be a power of two
+   */
+  SimpleHashJoinHashTable(Arena *arena, uint32_t buckets) : arena_(arena), buckets_(buckets, nullptr) {}
 
   /**
    * Inserts a (hash key, tuple) pair into the hash table.
    * @param txn the transaction that we execute in
    * @param h the hash key
-   * @param t the tuple to associate with the key
+   * @param t the tuple to associate with the key, must stay valid as long as the table
    * @return true if the insert succeeded
    */
-  bool Insert(Transaction *txn, hash_t h, const Tuple &t) {
-    hash_table_[h].emplace_back(t);
+  bool Insert(Transaction *txn, hash_t h, const TupleView &t) {
+    if (size_ >= buckets_.size()) {
+      Grow();
+    }
+    Entry *&head = buckets_[h & (buckets_.size() - 1)];
+    head = arena_->New<Entry>(Entry{h, t, head});
+    size_++;
     return true;
   }
 
   /**
-   * Gets the values in the hash table that match the given hash key.
    * @param txn the transaction that we execute in
    * @param h the hash key
-   * @param[out] t the list of tuples that matched the key
+   * @return the first entry with the given hash key, nullptr if there is none
    */
-  void GetValue(Transaction *txn, hash_t h, std::vector<Tuple> *t) { *t = hash_table_[h]; }
+  const Entry *GetValue(Transaction *txn, hash_t h) const { return Match(buckets_[h & (buckets_.size() - 1)], h); }
+
+  /** @return the entry after e with the same hash key, nullptr if there is none */
+  const Entry *GetNextValue(const Entry *e) const { return Match(e->next_, e->hash_); }
+
+  /** @return the number of tuples in the table */
+  size_t Size() const { return size_; }
+
+  /** @return the bytes held by the bucket array; the entries are allocated in the arena */
+  size_t GetMemoryUsage() const { return buckets_.size() * sizeof(Entry *); }
+
+  /** Call fn with the hash key of every entry. */
+  template <typename F>
+  void ForEachHash(F &&fn) const {
+    for (const Entry *e : buckets_) {
+      for (; e != nullptr; e = e->next_) {
+        fn(e->hash_);
+      }
+    }
+  }
+
+  /** Remove all entries. Their memory is reclaimed with the arena. */
+  void Clear() {
+    std::fill(buckets_.begin(), buckets_.end(), nullptr);
+    size_ = 0;
+  }
 
  private:
-  std::unordered_map<hash_t, std::vector<Tuple>> hash_table_;
+  static const Entry *Match(const Entry *e, hash_t h) {
+    while (e != nullptr && e->hash_ != h) {
+      e = e->next_;
+    }
+    return e;
+  }
+
+  void Grow() {
+    std::vector<Entry *> buckets(buckets_.size() * 2, nullptr);
+    for (Entry *e : buckets_) {
+      while (e != nullptr) {
+        Entry *next = e->next_;
+        Entry *&head = buckets[e->hash_ & (buckets.size() - 1)];
+        e->next_ = head;
+        head = e;
+        e = next;
+      }
+    }
+    buckets_ = std::move(buckets);
+  }
+
+  Arena *arena_;
+  std::vector<Entry *> buckets_;
+  size_t size_{0};
 };
 
-// TODO(student): when you are ready to attempt task 3, replace the using declaration!
 using HT = SimpleHashJoinHashTable;
 
-// using HashJoinKeyType = ???;
-// using HashJoinValType = ???;
-// using HT = LinearProbeHashTable<HashJoinKeyType, HashJoinValType, HashComparator>;
-
 /**
  * HashJoinExecutor executes hash join operations.
+ *
+ * The left child is drained into the hash table during Init(). Its tuples are copied once into an arena of the join
+ * and referenced by TupleView from then on; Init() resets the arena, so building the table again frees the previous
+ * build. Next() streams the right child and probes the table, comparing the keys of the candidates that share the hash
+ * when there is no predicate. The table and the build tuples are charged to the memory tracker of the query as they
+ * grow; the join cannot spill, so a build side that does not fit fails the query.
+ *
+ * If the right keys are plain columns, Init() also builds a Bloom filter over the hashes in the table and pushes it
+ * into the right child, so the scans below the probe side drop tuples without a match before materializing them.
  */
 class HashJoinExecutor : public AbstractExecutor {
  public:
@@ -97,80 +167,91 @@ class HashJoinExecutor : public AbstractExecutor {
    */
   HashJoinExecutor(ExecutorContext *exec_ctx, const HashJoinPlanNode *plan, std::unique_ptr<AbstractExecutor> &&left,
                    std::unique_ptr<AbstractExecutor> &&right)
-      : AbstractExecutor(exec_ctx), 
+      : AbstractExecutor(exec_ctx),
         plan_(plan),
         left_executor_(std::move(left)),
-        right_executor_(std::move(right))  {}
+        right_executor_(std::move(right)),
+        jht_(&arena_, jht_num_buckets_),
+        memory_tracker_(exec_ctx->GetMemoryTracker()) {}
 
   /** @return the JHT in use. Do not modify this function, otherwise you will get a zero. */
-  // Uncomment me! const HT *GetJHT() const { return &jht_; }
+  const HT *GetJHT() const { return &jht_; }
 
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
 
   void Init() override {
     left_executor_->Init();
     right_executor_->Init();
-    Tuple cur_tuple;
-    left_idx = 0;
-    right_idx = 0;
-
-    while (left_executor_->Next(&cur_tuple)) {
-      left_tuples.push_back(cur_tuple);
+    const Schema *left_schema = left_executor_->GetOutputSchema();
+    const Schema *right_schema = right_executor_->GetOutputSchema();
+    if (plan_->Predicate() != nullptr) {
+      predicate_ = CompiledPredicate::CompileJoin(plan_->Predicate(), left_schema, right_schema);
     }
 
-    while (right_executor_->Next(&cur_tuple)) {
-      right_tuples.push_back(cur_tuple);
+    // Build phase.
+    jht_.Clear();
+    arena_.Reset();
+    bloom_filter_.reset();
+    memory_tracker_.SetUsage(GetMemoryUsage(), "Hash join");
+    Tuple tuple;
+    while (left_executor_->Next(&tuple)) {
+      hash_t h = HashValues(&tuple, left_schema, plan_->GetLeftKeys());
+      jht_.Insert(exec_ctx_->GetTransaction(), h, tuple.GetView().CopyTo(&arena_));
+      memory_tracker_.SetUsage(GetMemoryUsage(), "Hash join build");
     }
+    match_ = nullptr;
 
-    left_schema = left_executor_->GetOutputSchema();
-    right_schema = right_executor_->GetOutputSchema();
-    output_schema = plan_->OutputSchema();
-    std::vector<Column> output_cols = output_schema->GetColumns();
-    std::vector<Column> left_cols = left_schema->GetColumns();
-    std::vector<Column> right_cols = right_schema->GetColumns();
-
-    for (unsigned int i = 0; i < output_cols.size(); i++) {
-    for (unsigned int j = 0; j < left_cols.size(); j++) {
-      if (output_cols[i].GetName() == left_cols[j].GetName()) {
-        output_order.push_back({0, j});
-      }
+    std::vector<uint32_t> key_cols;
+    if (GetRightColumns(plan_->GetRightKeys(), &key_cols, false)) {
+      bloom_filter_ = std::make_unique<BloomFilter>(jht_.Size());
+      memory_tracker_.SetUsage(GetMemoryUsage(), "Hash join Bloom filter");
+      jht_.ForEachHash([this](hash_t h) { bloom_filter_->Insert(h); });
+      right_executor_->PushDownBloomFilter(bloom_filter_.get(), key_cols);
     }
+  }
 
-    for (unsigned int j = 0; j < right_cols.size(); j++) {
-      if (output_cols[i].GetName() == right_cols[j].GetName()) {
-        output_order.push_back({1, j});
+  bool Next(Tuple *tuple) override {
+    const Schema *left_schema = left_executor_->GetOutputSchema();
+    const Schema *right_schema = right_executor_->GetOutputSchema();
+    while (true) {
+      // Continue the chain of the current probe tuple; the hash only narrows the candidates down.
+      for (; match_ != nullptr; match_ = jht_.GetNextValue(match_)) {
+        Tuple left_tuple(match_->tuple_);
+        if (predicate_ == nullptr ? KeysMatch(&left_tuple, left_schema)
+                                  : predicate_->EvaluateJoin(&left_tuple, &right_tuple_)) {
+          values_.clear();
+          for (const auto &col : GetOutputSchema()->GetColumns()) {
+            values_.emplace_back(col.GetExpr()->EvaluateJoin(&left_tuple, left_schema, &right_tuple_, right_schema));
+          }
+          *tuple = Tuple(values_, GetOutputSchema());
+          match_ = jht_.GetNextValue(match_);
+          return true;
+        }
+      }
+      if (!right_executor_->Next(&right_tuple_)) {
+        return false;
+      }
+      hash_t h = HashValues(&right_tuple_, right_schema, plan_->GetRightKeys());
+      match_ = jht_.GetValue(exec_ctx_->GetTransaction(), h);
+      if (predicate_ == nullptr && match_ != nullptr) {
+        right_keys_.clear();
+        for (const auto *expr : plan_->GetRightKeys()) {
+          right_keys_.emplace_back(expr->Evaluate(&right_tuple_, right_schema));
+        }
       }
     }
-    }
-
-    left_tuples_size = left_tuples.size();
-    right_tuples_size = right_tuples.size();
-    total_size = left_tuples_size * right_tuples_size;
-    idx = 0;
   }
 
-  bool Next(Tuple *tuple) override { 
-    Tuple cur_tuple;
+  size_t GetPeakMemoryUsage() override { return memory_tracker_.GetPeakUsage(); }
 
-    for (; idx < total_size; idx++) {
-        int left_idx = idx / right_tuples_size;
-        int right_idx = idx % right_tuples_size;
-        if (plan_->Predicate()->EvaluateJoin(&left_tuples[left_idx], left_schema, &right_tuples[right_idx], right_schema).GetAs<bool>()) {
-          std::vector<Value> values;
-
-          for (const auto &order : output_order) {
-            if (order.first == 1)
-              values.push_back(left_tuples[left_idx].GetValue(left_schema, order.second));
-            else 
-              values.push_back(right_tuples[right_idx].GetValue(right_schema, order.second));
-          }
-          *tuple = Tuple(values, output_schema);
-          idx++;
-          
-          return true;
-      }
+  /** Output columns that come straight from the right child are filtered there; the left child is already drained. */
+  bool PushDownBloomFilter(const BloomFilter *filter, const std::vector<uint32_t> &key_cols) override {
+    std::vector<const AbstractExpression *> exprs;
+    for (uint32_t col : key_cols) {
+      exprs.push_back(GetOutputSchema()->GetColumn(col).GetExpr());
     }
-    return false;
+    std::vector<uint32_t> right_cols;
+    return GetRightColumns(exprs, &right_cols, true) && right_executor_->PushDownBloomFilter(filter, right_cols);
   }
 
   /**
@@ -181,46 +262,68 @@ class HashJoinExecutor : public AbstractExecutor {
    * @return the hashed tuple
    */
   hash_t HashValues(const Tuple *tuple, const Schema *schema, const std::vector<const AbstractExpression *> &exprs) {
-    hash_t curr_hash = 0;
-    // For every expression,
-    for (const auto &expr : exprs) {
-      // We evaluate the tuple on the expression and schema.
-      Value val = expr->Evaluate(tuple, schema);
-      // If this produces a value,
-      if (!val.IsNull()) {
-        // We combine the hash of that value into our current hash.
-        curr_hash = HashUtil::CombineHashes(curr_hash, HashUtil::HashValue(&val));
+    return HashJoinKey(tuple, schema, exprs);
+  }
+
+ private:
+  /** @return the bytes held by the hash table, the arena allocations of the join and the Bloom filter */
+  size_t GetMemoryUsage() const {
+    return jht_.GetMemoryUsage() + arena_.GetBytesAllocated() +
+           (bloom_filter_ == nullptr ? 0 : bloom_filter_->GetMemoryUsage());
+  }
+
+  /** @return true if the keys of a build tuple equal right_keys_; like in the predicate, NULL equals nothing */
+  bool KeysMatch(const Tuple *left_tuple, const Schema *left_schema) const {
+    const auto &left_keys = plan_->GetLeftKeys();
+    for (uint32_t i = 0; i < left_keys.size(); i++) {
+      if (left_keys[i]->Evaluate(left_tuple, left_schema).CompareEquals(right_keys_[i]) != CmpBool::CmpTrue) {
+        return false;
       }
     }
-    return curr_hash;
+    return true;
+  }
+
+  /**
+   * @param exprs the expressions to map to columns of the right child
+   * @param[out] cols the column indexes of the expressions
+   * @param join_output true if the expressions are evaluated on both sides of the join, false if on the right only
+   * @return false if some expression is not a plain column of the right child
+   */
+  static bool GetRightColumns(const std::vector<const AbstractExpression *> &exprs, std::vector<uint32_t> *cols,
+                              bool join_output) {
+    for (const auto *expr : exprs) {
+      const auto *col_expr = dynamic_cast<const ColumnValueExpression *>(expr);
+      if (col_expr == nullptr || (join_output && col_expr->GetTupleIdx() != 1)) {
+        return false;
+      }
+      cols->push_back(col_expr->GetColIdx());
+    }
+    return true;
   }
 
- private:
   /** The hash join plan node. */
   const HashJoinPlanNode *plan_;
-  /** The comparator is used to compare hashes. */
-  [[maybe_unused]] HashComparator jht_comp_{};
-  /** The identity hash function. */
-  IdentityHashFunction jht_hash_fn_{};
-
-  /** The hash table that we are using. */
-  // Uncomment me! HT jht_;
-  /** The number of buckets in the hash table. */
-  static constexpr uint32_t jht_num_buckets_ = 2;
-
-  std::vector<Tuple> left_tuples, right_tuples;
-  std::vector<std::pair<int, int> > output_order;
-  int left_tuples_size;
-  int right_tuples_size;
-  int total_size;
-  int left_idx;
-  int right_idx;
-  int idx;
-  const Schema *left_schema;
-  const Schema *right_schema;
-  const Schema *output_schema;
   std::unique_ptr<AbstractExecutor> left_executor_;
   std::unique_ptr<AbstractExecutor> right_executor_;
-  
+  /** Holds the build tuples and the entries of jht_ of the current build. */
+  Arena arena_;
+  /** The hash table that we are using. */
+  HT jht_;
+  /** The Bloom filter over the hashes in jht_ that the right child applies, nullptr if it was not built. */
+  std::unique_ptr<BloomFilter> bloom_filter_;
+  /** Charges the memory of the build side to the query. */
+  MemoryTracker memory_tracker_;
+  /** The initial number of buckets in the hash table. */
+  static constexpr uint32_t jht_num_buckets_ = 1024;
+  /** The join predicate compiled against the child schemas, nullptr if there is none. */
+  std::unique_ptr<CompiledPredicate> predicate_;
+  /** The current probe tuple from the right child. */
+  Tuple right_tuple_;
+  /** The right keys of right_tuple_ when there is no predicate to compare the candidates with. */
+  std::vector<Value> right_keys_;
+  /** The next candidate build tuple for right_tuple_. */
+  const HT::Entry *match_{nullptr};
+  /** Scratch space for the output values. */
+  std::vector<Value> values_;
 };
 }  // namespace bustub
@@ -0,0 +1,186 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_scan_executor.h
+//
+// Identification: src/include/execution/executors/index_scan_executor.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/bloom_filter.h"
+#include "execution/compiled_predicate.h"
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/index_scan_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * IndexScanExecutor reads the tuples of a table whose keys are found in an index.
+ *
+ * Init() looks up all the keys first and sorts the RIDs they produce by page and slot, like a bitmap heap scan: every
+ * heap page is then pinned and latched once, however many of its tuples qualify, and pages are read in page id order.
+ * In the coroutine execution mode (see ExecutorContext::SetMaxInFlightReads) several of those reads are in flight at
+ * once, so a cold probe of many keys does not stall on every page.
+ */
+class IndexScanExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new index scan executor.
+   * @param exec_ctx the executor context
+   * @param plan the index scan plan to be executed
+   */
+  IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
+      : AbstractExecutor(exec_ctx), plan_(plan) {}
+
+  void Init() override {
+    auto *catalog = exec_ctx_->GetCatalog();
+    table_info_ = catalog->GetTable(plan_->GetTableOid());
+    IndexInfo *index_info = catalog->GetIndex(plan_->GetIndexOid());
+    if (plan_->GetPredicate() != nullptr) {
+      predicate_ = CompiledPredicate::Compile(plan_->GetPredicate(), &table_info_->schema_);
+    }
+
+    std::vector<RID> rids;
+    for (const auto &key : plan_->GetKeys()) {
+      index_info->index_->ScanKey(Tuple(key, &index_info->key_schema_), &rids, exec_ctx_->GetTransaction());
+    }
+    std::sort(rids.begin(), rids.end(), [](const RID &a, const RID &b) {
+      return a.GetPageId() < b.GetPageId() || (a.GetPageId() == b.GetPageId() && a.GetSlotNum() < b.GetSlotNum());
+    });
+    rids.erase(std::unique(rids.begin(), rids.end()), rids.end());
+    pages_.clear();
+    for (const RID &rid : rids) {
+      if (pages_.empty() || pages_.back().first != rid.GetPageId()) {
+        pages_.emplace_back(rid.GetPageId(), std::vector<uint32_t>());
+      }
+      pages_.back().second.push_back(rid.GetSlotNum());
+    }
+    page_pos_ = 0;
+    page_tuples_.clear();
+    page_idx_ = 0;
+    bloom_filter_.Clear();
+  }
+
+  bool Next(Tuple *tuple) override {
+    while (page_idx_ == page_tuples_.size()) {
+      if (page_pos_ == pages_.size()) {
+        return false;
+      }
+      ReadPages();
+    }
+    *tuple = std::move(page_tuples_[page_idx_++]);
+    return true;
+  }
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  bool PushDownBloomFilter(const BloomFilter *filter, const std::vector<uint32_t> &key_cols) override {
+    return bloom_filter_.Set(filter, key_cols, GetOutputSchema(), &table_info_->schema_);
+  }
+
+  /** @return the number of tuples dropped by a pushed-down Bloom filter */
+  size_t GetNumFiltered() const { return bloom_filter_.GetNumFiltered(); }
+
+  /** @return the number of heap pages the last Init() found qualifying tuples on */
+  size_t GetNumPages() const { return pages_.size(); }
+
+ private:
+  /**
+   * Read the qualifying tuples of the next page into page_tuples_. All the slots of a page are read at once; the
+   * predicate and projection run on the raw page bytes. In the coroutine execution mode the next pages are read
+   * together instead, with up to GetMaxInFlightReads() page reads in flight, and their tuples kept in page order.
+   */
+  void ReadPages() {
+    page_tuples_.clear();
+    page_idx_ = 0;
+#ifdef BUSTUB_COROUTINES
+    if (exec_ctx_->GetMaxInFlightReads() > 0) {
+      size_t max_in_flight = exec_ctx_->GetMaxInFlightReads();
+      size_t end = std::min(pages_.size(), page_pos_ + max_in_flight * PAGES_PER_READER);
+      std::vector<std::vector<Tuple>> tuples(end - page_pos_);
+      std::vector<char> succeeded(end - page_pos_, 0);
+      CoroutineScheduler scheduler(exec_ctx_->GetBufferPoolManager(), max_in_flight);
+      for (size_t i = page_pos_; i < end; i++) {
+        scheduler.Spawn(ReadPage(&scheduler, i, &tuples[i - page_pos_], &succeeded[i - page_pos_]));
+      }
+      scheduler.Run();
+      page_pos_ = end;
+      for (size_t i = 0; i < tuples.size(); i++) {
+        if (succeeded[i] == 0) {
+          FailScan();
+        }
+        std::move(tuples[i].begin(), tuples[i].end(), std::back_inserter(page_tuples_));
+      }
+      return;
+    }
+#endif
+    auto collect = [this](Tuple *t) {
+      page_tuples_.emplace_back(std::move(*t));
+      return true;
+    };
+    const auto &page = pages_[page_pos_++];
+    if (!table_info_->table_->FetchSlots(page.first, page.second, &table_info_->schema_, predicate_.get(),
+                                         GetOutputSchema(), collect, exec_ctx_->GetTransaction(),
+                                         bloom_filter_.GetRowFilter())) {
+      FailScan();
+    }
+  }
+
+  /**
+   * Give up on the scan after a page could not be read; collect never stops it, so that is the only way FetchSlots
+   * fails. The tuples read so far are dropped rather than returned as a partial result.
+   * @throws TransactionAbortException always
+   */
+  [[noreturn]] void FailScan() {
+    page_pos_ = pages_.size();
+    page_tuples_.clear();
+    page_idx_ = 0;
+    AbortQuery();
+  }
+
+#ifdef BUSTUB_COROUTINES
+  /** The number of pages ReadPages() reads per page read it may keep in flight. */
+  static constexpr size_t PAGES_PER_READER = 4;
+
+  /** Read the qualifying tuples of pages_[pos] into tuples, and set succeeded unless the read failed. */
+  Task<void> ReadPage(CoroutineScheduler *scheduler, size_t pos, std::vector<Tuple> *tuples, char *succeeded) {
+    auto collect = [tuples](Tuple *t) {
+      tuples->emplace_back(std::move(*t));
+      return true;
+    };
+    const auto &page = pages_[pos];
+    *succeeded = static_cast<char>(co_await table_info_->table_->FetchSlotsAsync(
+        scheduler, page.first, page.second, &table_info_->schema_, predicate_.get(), GetOutputSchema(), collect,
+        exec_ctx_->GetTransaction(), bloom_filter_.GetRowFilter()));
+  }
+#endif
+
+  /** The index scan plan node to be executed. */
+  const IndexScanPlanNode *plan_;
+  /** The table being scanned. */
+  TableMetadata *table_info_{nullptr};
+  /** The predicate compiled against the table schema, nullptr if there is none. */
+  std::unique_ptr<CompiledPredicate> predicate_;
+  /** The Bloom filter pushed down by a hash join above, if any. */
+  ScanBloomFilter bloom_filter_;
+  /** The heap pages to read, in page id order, with the sorted slots found on each. */
+  std::vector<std::pair<page_id_t, std::vector<uint32_t>>> pages_;
+  size_t page_pos_{0};
+  /** The qualifying, projected tuples of the last read page. */
+  std::vector<Tuple> page_tuples_;
+  size_t page_idx_{0};
+};
+}  // namespace bustub
@@ -14,6 +14,7 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
@@ -42,16 +43,17 @@ class InsertExecutor : public AbstractExecutor {
   void Init() override {
     table_meta_ = exec_ctx_->GetCatalog()->GetTable(plan_->TableOid());
     table_ = exec_ctx_->GetCatalog()->GetTable(plan_->TableOid())->table_.get();
+    indexes_ = exec_ctx_->GetCatalog()->GetTableIndexes(table_meta_->name_);
+    views_ = exec_ctx_->GetCatalog()->GetTableViews(table_meta_->name_);
   }
 
   // Note that Insert does not make use of the tuple pointer being passed in.
   // We return false if the insert failed for any reason, and return true if all inserts succeeded.
   bool Next([[maybe_unused]] Tuple *tuple) override {
-    RID rid;
     if (plan_->IsRawInsert()) {
       std::vector<std::vector<Value>> raw_values = plan_->RawValues();
       for (unsigned int i = 0; i < raw_values.size(); i++) {
-      if (table_->InsertTuple(Tuple(raw_values[i], &table_meta_->schema_), &rid, exec_ctx_->GetTransaction()) == false) 
+      if (InsertTuple(Tuple(raw_values[i], &table_meta_->schema_)) == false) 
         return false;
       }
     }
@@ -60,7 +62,7 @@ class InsertExecutor : public AbstractExecutor {
       auto child_executor = ExecutorFactory::CreateExecutor(exec_ctx_, plan_->GetChildPlan());
       child_executor->Init();
       while (child_executor->Next(&child_tuple)) {
-        if (table_->InsertTuple(child_tuple, &rid, exec_ctx_->GetTransaction()) == false)
+        if (InsertTuple(child_tuple) == false)
           return false;
       }
     }
@@ -69,9 +71,37 @@ class InsertExecutor : public AbstractExecutor {
   }
 
  private:
+  /** Insert a tuple into the table and all of its indexes, and report it to the materialized views of the table. */
+  bool InsertTuple(const Tuple &tuple) {
+    RID rid;
+    if (!table_->InsertTuple(tuple, &rid, exec_ctx_->GetTransaction())) {
+      return false;
+    }
+    for (auto *index_info : indexes_) {
+      Index *index = index_info->index_.get();
+      if (!index->InsertEntry(tuple.KeyFromTuple(table_meta_->schema_, index_info->key_schema_, index->GetKeyAttrs()),
+                              rid, exec_ctx_->GetTransaction())) {
+        // The index is full: going on would leave the tuple out of it, and index scans would miss it.
+        AbortQuery();
+      }
+    }
+    if (!indexes_.empty()) {
+      // Readers through an index may have seen the heap change but not the index one.
+      table_->MarkModified();
+    }
+    for (auto *view : views_) {
+      view->Insert(tuple, exec_ctx_->GetTransaction());
+    }
+    return true;
+  }
+
   /** The insert plan node to be executed. */
   const InsertPlanNode *plan_;
   TableHeap *table_;
   TableMetadata *table_meta_;
+  /** The indexes of the table, which are kept up to date with the inserted tuples. */
+  std::vector<IndexInfo *> indexes_;
+  /** The materialized views over the table, which apply the inserted tuples when the transaction commits. */
+  std::vector<MaterializedView *> views_;
 };
 }  // namespace bustub
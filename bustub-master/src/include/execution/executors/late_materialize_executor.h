@@ -0,0 +1,193 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// late_materialize_executor.h
+//
+// Identification: src/include/execution/executors/late_materialize_executor.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/rid.h"
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/late_materialize_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * LateMaterializeExecutor fetches the columns of the rows its child identifies by RID.
+ *
+ * The child tuples are read in batches of BATCH_SIZE. The RIDs of a batch are sorted by page and slot, like in
+ * IndexScanExecutor, so every heap page is pinned and latched once per batch however many of its rows the batch
+ * holds; the output then follows the order of the child. In the coroutine execution mode (see
+ * ExecutorContext::SetMaxInFlightReads) the pages of a batch are fetched concurrently, which suits the random reads
+ * of the rows that survive a join.
+ */
+class LateMaterializeExecutor : public AbstractExecutor {
+ public:
+  /** The number of child tuples whose rows are fetched together. */
+  static constexpr size_t BATCH_SIZE = 1024;
+
+  /**
+   * Creates a new late materialization executor.
+   * @param exec_ctx the executor context
+   * @param plan the late materialization plan node
+   * @param child the child executor that produces the RIDs
+   */
+  LateMaterializeExecutor(ExecutorContext *exec_ctx, const LateMaterializePlanNode *plan,
+                          std::unique_ptr<AbstractExecutor> &&child)
+      : AbstractExecutor(exec_ctx), plan_(plan), child_(std::move(child)) {}
+
+  /** @return the child executor */
+  const AbstractExecutor *GetChildExecutor() const { return child_.get(); }
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  void Init() override {
+    child_->Init();
+    table_info_ = exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid());
+    child_done_ = false;
+    batch_.clear();
+    batch_idx_ = 0;
+    num_fetched_pages_ = 0;
+  }
+
+  bool Next(Tuple *tuple) override {
+    while (batch_idx_ == batch_.size()) {
+      if (child_done_) {
+        return false;
+      }
+      FillBatch();
+    }
+    *tuple = std::move(batch_[batch_idx_++]);
+    return true;
+  }
+
+  /** @return the number of heap page reads the fetches took so far */
+  size_t GetNumFetchedPages() const { return num_fetched_pages_; }
+
+ private:
+  /** Read the next batch of child tuples and materialize their output tuples into batch_. */
+  void FillBatch() {
+    batch_.clear();
+    batch_idx_ = 0;
+    const Schema *child_schema = child_->GetOutputSchema();
+    std::vector<Tuple> inputs;
+    std::vector<RID> rids;
+    Tuple input;
+    while (inputs.size() < BATCH_SIZE) {
+      if (!child_->Next(&input)) {
+        child_done_ = true;
+        break;
+      }
+      rids.emplace_back(input.GetValue(child_schema, plan_->GetRidColumn()).GetAs<int64_t>());
+      inputs.emplace_back(std::move(input));
+    }
+
+    std::vector<RID> sorted(rids);
+    std::sort(sorted.begin(), sorted.end(), [](const RID &a, const RID &b) {
+      return a.GetPageId() < b.GetPageId() || (a.GetPageId() == b.GetPageId() && a.GetSlotNum() < b.GetSlotNum());
+    });
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    rows_.clear();
+    auto collect = [this](Tuple *t) {
+      rows_.emplace(t->GetRid(), std::move(*t));
+      return true;
+    };
+    std::vector<std::pair<page_id_t, std::vector<uint32_t>>> pages;
+    for (const RID &rid : sorted) {
+      if (pages.empty() || pages.back().first != rid.GetPageId()) {
+        pages.emplace_back(rid.GetPageId(), std::vector<uint32_t>());
+      }
+      pages.back().second.push_back(rid.GetSlotNum());
+    }
+    num_fetched_pages_ += pages.size();
+#ifdef BUSTUB_COROUTINES
+    if (exec_ctx_->GetMaxInFlightReads() > 0) {
+      // Fetch the pages of the batch as coroutines, with up to GetMaxInFlightReads() page reads in flight.
+      CoroutineScheduler scheduler(exec_ctx_->GetBufferPoolManager(), exec_ctx_->GetMaxInFlightReads());
+      bool succeeded = true;
+      for (const auto &page : pages) {
+        scheduler.Spawn(FetchPage(&scheduler, &page, collect, &succeeded));
+      }
+      scheduler.Run();
+      if (!succeeded) {
+        FailFetch();
+      }
+      pages.clear();
+    }
+#endif
+    for (const auto &page : pages) {
+      if (!table_info_->table_->FetchSlots(page.first, page.second, &table_info_->schema_, nullptr, nullptr, collect,
+                                           exec_ctx_->GetTransaction())) {
+        FailFetch();
+      }
+    }
+
+    std::vector<Value> values;
+    for (size_t i = 0; i < inputs.size(); i++) {
+      auto row = rows_.find(rids[i]);
+      if (row == rows_.end()) {
+        continue;
+      }
+      values.clear();
+      for (const auto &col : GetOutputSchema()->GetColumns()) {
+        values.emplace_back(
+            col.GetExpr()->EvaluateJoin(&inputs[i], child_schema, &row->second, &table_info_->schema_));
+      }
+      batch_.emplace_back(values, GetOutputSchema());
+    }
+  }
+
+  /**
+   * Give up after a page of the batch could not be read; collect never stops FetchSlots, so that is the only way it
+   * fails. The batch is dropped rather than returned with rows missing.
+   * @throws TransactionAbortException always
+   */
+  [[noreturn]] void FailFetch() {
+    child_done_ = true;
+    rows_.clear();
+    AbortQuery();
+  }
+
+#ifdef BUSTUB_COROUTINES
+  /** Fetch the rows on a page into rows_ with collect, and clear succeeded if the read fails. */
+  Task<void> FetchPage(CoroutineScheduler *scheduler, const std::pair<page_id_t, std::vector<uint32_t>> *page,
+                       TableHeap::ScanCallback collect, bool *succeeded) {
+    if (!co_await table_info_->table_->FetchSlotsAsync(scheduler, page->first, page->second, &table_info_->schema_,
+                                                       nullptr, nullptr, std::move(collect),
+                                                       exec_ctx_->GetTransaction())) {
+      *succeeded = false;
+    }
+  }
+#endif
+
+  /** The late materialization plan node. */
+  const LateMaterializePlanNode *plan_;
+  /** The child executor that produces the RIDs. */
+  std::unique_ptr<AbstractExecutor> child_;
+  /** The table the rows are fetched from. */
+  TableMetadata *table_info_{nullptr};
+  /** True once the child is exhausted. */
+  bool child_done_{false};
+  /** The rows of the current batch by RID. */
+  std::unordered_map<RID, Tuple> rows_;
+  /** The output tuples of the current batch. */
+  std::vector<Tuple> batch_;
+  size_t batch_idx_{0};
+  size_t num_fetched_pages_{0};
+};
+}  // namespace bustub
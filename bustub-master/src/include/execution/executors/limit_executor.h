@@ -0,0 +1,66 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// limit_executor.h
+//
+// Identification: src/include/execution/executors/limit_executor.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <utility>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/limit_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * LimitExecutor executes LIMIT. It stops pulling from its child as soon as the limit is reached, so the child does no
+ * work for tuples that would be thrown away.
+ */
+class LimitExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new limit executor.
+   * @param exec_ctx the context that the limit should be performed in
+   * @param plan the limit plan node
+   * @param child the child executor whose tuples are limited
+   */
+  LimitExecutor(ExecutorContext *exec_ctx, const LimitPlanNode *plan, std::unique_ptr<AbstractExecutor> &&child)
+      : AbstractExecutor(exec_ctx), plan_(plan), child_(std::move(child)) {}
+
+  /** @return the child executor */
+  const AbstractExecutor *GetChildExecutor() const { return child_.get(); }
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  void Init() override {
+    child_->Init();
+    num_emitted_ = 0;
+  }
+
+  bool Next(Tuple *tuple) override {
+    if (num_emitted_ == plan_->GetLimit() || !child_->Next(tuple)) {
+      return false;
+    }
+    num_emitted_++;
+    return true;
+  }
+
+ private:
+  /** The limit plan node. */
+  const LimitPlanNode *plan_;
+  /** The child executor whose tuples are limited. */
+  std::unique_ptr<AbstractExecutor> child_;
+  /** The number of tuples returned since Init(). */
+  size_t num_emitted_{0};
+};
+}  // namespace bustub
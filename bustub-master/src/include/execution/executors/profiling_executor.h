@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// profiling_executor.h
+//
+// Identification: src/include/execution/executors/profiling_executor.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/query_profile.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * ProfilingExecutor wraps the executor of one operator when the query is profiled, and records the time, rows, buffer
+ * pool traffic and peak memory of its Init() and Next() calls into the OperatorProfile of the operator. Everything
+ * else is forwarded to the wrapped executor.
+ *
+ * Reading the clock costs about as much as producing a tuple in a simple operator, so only the first EXACT_CALLS calls
+ * to Next() and a random one in SAMPLE_INTERVAL calls after them are timed (see OperatorProfile), and the rest is
+ * extrapolated from the latter. Buffer pool fetches are charged to the operator whose call is running on the thread,
+ * see ThreadStatsScope.
+ */
+class ProfilingExecutor : public AbstractExecutor {
+ public:
+  /**
+   * @param exec_ctx the executor context
+   * @param executor the executor to profile
+   * @param profile the profile of the operator the executor runs
+   */
+  ProfilingExecutor(ExecutorContext *exec_ctx, std::unique_ptr<AbstractExecutor> &&executor, OperatorProfile *profile)
+      : AbstractExecutor(exec_ctx), executor_(std::move(executor)), profile_(profile) {}
+
+  /** @return the wrapped executor */
+  AbstractExecutor *GetExecutor() const { return executor_.get(); }
+
+  const Schema *GetOutputSchema() override { return executor_->GetOutputSchema(); }
+
+  void Init() override {
+    {
+      ThreadStatsScope stats_scope(&profile_->buffer_pool_);
+      uint64_t start = QueryProfile::Now();
+      executor_->Init();
+      profile_->init_ticks_ += QueryProfile::Now() - start;
+    }
+    SamplePeakMemory();
+  }
+
+  bool Next(Tuple *tuple) override {
+    uint64_t call = profile_->next_calls_++;
+    bool has_next;
+    {
+      ThreadStatsScope stats_scope(&profile_->buffer_pool_);
+      if (call < OperatorProfile::EXACT_CALLS) {
+        uint64_t start = QueryProfile::Now();
+        has_next = executor_->Next(tuple);
+        profile_->exact_next_ticks_ += QueryProfile::Now() - start;
+        SamplePeakMemory();
+      } else if (call == profile_->next_sample_call_) {
+        uint64_t start = QueryProfile::Now();
+        has_next = executor_->Next(tuple);
+        profile_->sampled_next_ticks_ += QueryProfile::Now() - start;
+        profile_->sampled_next_calls_++;
+        profile_->ScheduleSample();
+        SamplePeakMemory();
+      } else {
+        has_next = executor_->Next(tuple);
+      }
+    }
+    if (!has_next) {
+      SamplePeakMemory();
+      return false;
+    }
+    profile_->rows_++;
+    return true;
+  }
+
+  bool PushDownBloomFilter(const BloomFilter *filter, const std::vector<uint32_t> &key_cols) override {
+    return executor_->PushDownBloomFilter(filter, key_cols);
+  }
+
+  size_t GetPeakMemoryUsage() override { return executor_->GetPeakMemoryUsage(); }
+
+ private:
+  void SamplePeakMemory() {
+    profile_->peak_memory_ = std::max(profile_->peak_memory_, executor_->GetPeakMemoryUsage());
+  }
+
+  std::unique_ptr<AbstractExecutor> executor_;
+  OperatorProfile *profile_;
+};
+}  // namespace bustub
@@ -12,8 +12,12 @@
 
 #pragma once
 
+#include <memory>
+#include <utility>
 #include <vector>
 
+#include "execution/bloom_filter.h"
+#include "execution/compiled_predicate.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/seq_scan_plan.h"
@@ -23,6 +27,11 @@ namespace bustub {
 
 /**
  * SeqScanExecutor executes a sequential scan over a table.
+ *
+ * Scans share their page reads (see TableHeap::StartSharedScan): a scan that starts while another one is running on
+ * a large table begins at the page that one is reading and wraps around to the pages it missed, so the tuples come in
+ * table order only when no other scan of the table is in progress. A plan that declares an output ordering (the table
+ * was loaded in that order) relies on table order, so its scan always starts at the first page.
  */
 class SeqScanExecutor : public AbstractExecutor {
  public:
@@ -34,39 +43,92 @@ class SeqScanExecutor : public AbstractExecutor {
   SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan) : 
     AbstractExecutor(exec_ctx), 
     plan_(plan) {}
-    
 
+  ~SeqScanExecutor() override { EndScan(); }
 
   void Init() override {
-    iter_ = exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid())->table_->Begin(exec_ctx_->GetTransaction());
-    end_iter_ = exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid())->table_->End();
+    EndScan();
+    table_info_ = exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid());
+    if (plan_->GetPredicate() != nullptr) {
+      predicate_ = CompiledPredicate::Compile(plan_->GetPredicate(), &table_info_->schema_);
+    }
+    start_page_id_ =
+        table_info_->table_->StartSharedScan(exec_ctx_->GetTransaction(), !plan_->GetOutputOrdering().empty());
+    scanning_ = true;
+    next_page_id_ = start_page_id_;
+    wrapped_ = false;
+    page_tuples_.clear();
+    page_idx_ = 0;
+    bloom_filter_.Clear();
   }
 
-  bool Next(Tuple *tuple) override { 
-    while (iter_ != end_iter_) {
-      *tuple = *iter_;
-      if (plan_->GetPredicate()) {
-        if (plan_->GetPredicate()->Evaluate(tuple, GetOutputSchema()).GetAs<bool>()) {
-          iter_++;
-          return true;
-        }
+  bool Next(Tuple *tuple) override {
+    // Refill from the next page; the predicate and projection run inside TableHeap on the raw page bytes.
+    while (page_idx_ == page_tuples_.size()) {
+      TableHeap *table = table_info_->table_.get();
+      if (next_page_id_ == INVALID_PAGE_ID && !wrapped_ && start_page_id_ != table->GetFirstPageId()) {
+        // Wrap around to the pages before the one the scan attached at.
+        next_page_id_ = table->GetFirstPageId();
+        wrapped_ = true;
       }
-      else {
-        iter_++;
+      if (next_page_id_ == INVALID_PAGE_ID || (wrapped_ && next_page_id_ == start_page_id_)) {
+        EndScan();
+        return false;
+      }
+      table->ReportScanPosition(next_page_id_);
+      page_tuples_.clear();
+      page_idx_ = 0;
+      auto collect = [this](Tuple *t) {
+        page_tuples_.emplace_back(std::move(*t));
         return true;
+      };
+      if (!table->ScanPage(next_page_id_, &table_info_->schema_, predicate_.get(), GetOutputSchema(), collect,
+                           exec_ctx_->GetTransaction(), &next_page_id_, bloom_filter_.GetRowFilter())) {
+        // collect never stops the scan, so the page could not be read or a tuple could not be locked.
+        EndScan();
+        AbortQuery();
       }
-      iter_++;
-   }
-   return false;
+    }
+    *tuple = std::move(page_tuples_[page_idx_++]);
+    return true;
   }
 
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
 
+  bool PushDownBloomFilter(const BloomFilter *filter, const std::vector<uint32_t> &key_cols) override {
+    return bloom_filter_.Set(filter, key_cols, GetOutputSchema(), &table_info_->schema_);
+  }
+
+  /** @return the number of tuples dropped by a pushed-down Bloom filter */
+  size_t GetNumFiltered() const { return bloom_filter_.GetNumFiltered(); }
+
  private:
+  /** Unregister the shared scan, once the table is exhausted or the executor goes away before. */
+  void EndScan() {
+    if (scanning_) {
+      table_info_->table_->EndSharedScan();
+      scanning_ = false;
+    }
+  }
+
   /** The sequential scan plan node to be executed. */
   const SeqScanPlanNode *plan_;
-  TableIterator iter_;
-  TableIterator end_iter_;
-  int init_times = 0;
+  /** The table being scanned. */
+  TableMetadata *table_info_{nullptr};
+  /** The scan predicate compiled against the table schema, nullptr if there is none. */
+  std::unique_ptr<CompiledPredicate> predicate_;
+  /** The Bloom filter pushed down by a hash join above, if any. */
+  ScanBloomFilter bloom_filter_;
+  /** The page the scan started at, where it stops after wrapping around. */
+  page_id_t start_page_id_{INVALID_PAGE_ID};
+  /** The next page to scan, INVALID_PAGE_ID at the end of the table. */
+  page_id_t next_page_id_{INVALID_PAGE_ID};
+  /** True once the scan went past the last page of the table back to the first one. */
+  bool wrapped_{false};
+  /** True while the scan is registered with the table heap. */
+  bool scanning_{false};
+  /** The qualifying, projected tuples of the last scanned page. */
+  std::vector<Tuple> page_tuples_;
+  size_t page_idx_{0};
 };
 }  // namespace bustub
@@ -0,0 +1,81 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_executor.h
+//
+// Identification: src/include/execution/executors/sort_executor.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <utility>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/external_sort.h"
+#include "execution/memory_tracker.h"
+#include "execution/plans/sort_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * SortExecutor executes ORDER BY. Init() drains the child into an ExternalSort, which spills sorted runs to temporary
+ * pages once the tuples exceed the memory budget of the executor context or the memory limit of the query; Next()
+ * returns the merged output.
+ */
+class SortExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new sort executor.
+   * @param exec_ctx the context that the sort should be performed in
+   * @param plan the sort plan node
+   * @param child the child executor whose tuples are sorted
+   */
+  SortExecutor(ExecutorContext *exec_ctx, const SortPlanNode *plan, std::unique_ptr<AbstractExecutor> &&child)
+      : AbstractExecutor(exec_ctx),
+        plan_(plan),
+        child_(std::move(child)),
+        memory_tracker_(exec_ctx->GetMemoryTracker()) {}
+
+  /** @return the child executor */
+  const AbstractExecutor *GetChildExecutor() const { return child_.get(); }
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  void Init() override {
+    child_->Init();
+    sort_.reset();
+    sort_ = std::make_unique<ExternalSort>(child_->GetOutputSchema(), plan_->GetOrderBys(),
+                                           exec_ctx_->GetBufferPoolManager(), exec_ctx_->GetMemoryBudget(),
+                                           &memory_tracker_);
+    Tuple tuple;
+    while (child_->Next(&tuple)) {
+      sort_->Insert(tuple);
+    }
+    sort_->Finish();
+  }
+
+  bool Next(Tuple *tuple) override { return sort_->Next(tuple); }
+
+  size_t GetPeakMemoryUsage() override { return memory_tracker_.GetPeakUsage(); }
+
+  /** @return the number of runs the last Init() spilled, 0 if it sorted in memory */
+  uint32_t GetNumRuns() const { return sort_ == nullptr ? 0 : sort_->GetNumRuns(); }
+
+ private:
+  /** The sort plan node. */
+  const SortPlanNode *plan_;
+  /** The child executor whose tuples are sorted. */
+  std::unique_ptr<AbstractExecutor> child_;
+  /** Charges the records buffered by the sort to the query; declared first so that it outlives the sort. */
+  MemoryTracker memory_tracker_;
+  /** The sort of the tuples of the child. */
+  std::unique_ptr<ExternalSort> sort_;
+};
+}  // namespace bustub
@@ -0,0 +1,181 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// stream_aggregation_executor.h
+//
+// Identification: src/include/execution/executors/stream_aggregation_executor.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/approximate_aggregate.h"
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/executors/aggregation_executor.h"
+#include "execution/packed_aggregation_hash_table.h"
+#include "execution/plans/aggregation_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * StreamAggregationExecutor executes an aggregation over a child whose tuples arrive grouped, i.e. ordered on the
+ * group-by keys. It folds tuples into a single running group and emits the group as soon as the key changes, so it
+ * needs no hash table and keeps only the current group in memory.
+ *
+ * If the aggregation fits a PackedAggregationHashTable, that table holds the running group: keys are compared byte
+ * for byte and aggregates are folded in without creating Values. Otherwise the aggregates are computed like in
+ * SimpleAggregationHashTable. Either way NULL group-by keys form a single group. A sampled plan folds in a Bernoulli
+ * sample of the child tuples, like AggregationExecutor.
+ */
+class StreamAggregationExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new stream aggregation executor.
+   * @param exec_ctx the context that the aggregation should be performed in
+   * @param plan the aggregation plan node
+   * @param child the child executor, which must produce its tuples grouped on the group-by keys
+   */
+  StreamAggregationExecutor(ExecutorContext *exec_ctx, const AggregationPlanNode *plan,
+                            std::unique_ptr<AbstractExecutor> &&child)
+      : AbstractExecutor(exec_ctx),
+        plan_(plan),
+        child_(std::move(child)),
+        combiner_(plan->GetAggregates(), plan->GetAggregateTypes(), plan->GetSampleRate()),
+        sampler_(plan->GetSampleRate(), plan->GetSampleSeed()) {
+    if (PackedAggregationHashTable::CanHandle(child_->GetOutputSchema(), plan_->GetGroupBys(),
+                                              plan_->GetAggregates(), plan_->GetAggregateTypes())) {
+      group_ = std::make_unique<PackedAggregationHashTable>(child_->GetOutputSchema(), plan_->GetGroupBys(),
+                                                            plan_->GetAggregates(), plan_->GetAggregateTypes(),
+                                                            plan_->GetSampleRate());
+    }
+  }
+
+  /** @return the child executor */
+  const AbstractExecutor *GetChildExecutor() const { return child_.get(); }
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  void Init() override {
+    child_->Init();
+    sampler_ = RowSampler(plan_->GetSampleRate(), plan_->GetSampleSeed());
+    has_next_ = NextInput(&next_tuple_);
+  }
+
+  bool Next(Tuple *tuple) override {
+    while (has_next_) {
+      // next_tuple_ starts a new group; fold in tuples until the key changes.
+      if (group_ != nullptr) {
+        NextPackedGroup();
+      } else {
+        NextGroup();
+      }
+      if (plan_->GetHaving() != nullptr &&
+          !plan_->GetHaving()->EvaluateAggregate(key_.group_bys_, aggregates_).GetAs<bool>()) {
+        continue;
+      }
+      const Schema *output_schema = GetOutputSchema();
+      std::vector<Value> values;
+      values.reserve(output_schema->GetColumnCount());
+      for (const auto &col : output_schema->GetColumns()) {
+        values.push_back(col.GetExpr()->EvaluateAggregate(key_.group_bys_, aggregates_));
+      }
+      *tuple = Tuple(values, output_schema);
+      return true;
+    }
+    return false;
+  }
+
+ private:
+  /** @return false if the child is exhausted, otherwise the next child tuple of the sample is in tuple */
+  bool NextInput(Tuple *tuple) {
+    while (child_->Next(tuple)) {
+      if (sampler_.Sample()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /** Fold the group starting at next_tuple_ into key_ and aggregates_, on the packed table. */
+  void NextPackedGroup() {
+    group_->Clear();
+    group_->InsertCombine(next_tuple_);
+    while ((has_next_ = NextInput(&next_tuple_)) && group_->KeyEquals(0, next_tuple_)) {
+      group_->Combine(0, next_tuple_);
+    }
+    group_->GetGroup(0, &key_.group_bys_, &aggregates_);
+  }
+
+  /** Fold the group starting at next_tuple_ into key_ and aggregates_, on Values. */
+  void NextGroup() {
+    FillValues(&next_tuple_, plan_->GetGroupBys(), &key_.group_bys_);
+    val_ = combiner_.GenerateInitialAggregateValue();
+    FillValues(&next_tuple_, plan_->GetAggregates(), &input_.aggregates_);
+    combiner_.CombineAggregateValues(&val_, input_);
+    while ((has_next_ = NextInput(&next_tuple_))) {
+      FillValues(&next_tuple_, plan_->GetGroupBys(), &next_key_.group_bys_);
+      if (!IsSameGroup(key_, next_key_)) {
+        break;
+      }
+      FillValues(&next_tuple_, plan_->GetAggregates(), &input_.aggregates_);
+      combiner_.CombineAggregateValues(&val_, input_);
+    }
+    combiner_.FinalizeAggregateValue(val_, &aggregates_);
+  }
+
+  /** Evaluate exprs on the tuple into values, reusing its storage. */
+  void FillValues(const Tuple *tuple, const std::vector<const AbstractExpression *> &exprs,
+                  std::vector<Value> *values) {
+    values->clear();
+    for (const auto &expr : exprs) {
+      values->emplace_back(expr->Evaluate(tuple, child_->GetOutputSchema()));
+    }
+  }
+
+  /** @return true if both keys belong to the same group, where NULL matches NULL */
+  static bool IsSameGroup(const AggregateKey &a, const AggregateKey &b) {
+    for (uint32_t i = 0; i < a.group_bys_.size(); i++) {
+      const Value &lhs = a.group_bys_[i];
+      const Value &rhs = b.group_bys_[i];
+      if (lhs.IsNull() || rhs.IsNull()) {
+        if (lhs.IsNull() != rhs.IsNull()) {
+          return false;
+        }
+      } else if (lhs.CompareEquals(rhs) != CmpBool::CmpTrue) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /** The aggregation plan node. */
+  const AggregationPlanNode *plan_;
+  /** The child executor whose tuples we are aggregating. */
+  std::unique_ptr<AbstractExecutor> child_;
+  /** Provides the initial, combine and finalize steps of the aggregates; its hash table is never used. */
+  SimpleAggregationHashTable combiner_;
+  /** Picks the child tuples a sampled plan folds in. */
+  RowSampler sampler_;
+  /** Holds the running group if the aggregation fits the packed layout, nullptr otherwise. */
+  std::unique_ptr<PackedAggregationHashTable> group_;
+  /** The first tuple of the next group, valid if has_next_. */
+  Tuple next_tuple_;
+  bool has_next_{false};
+  /** The key, the running aggregates and the aggregate results of the current group. */
+  AggregateKey key_;
+  AggregateValue val_;
+  std::vector<Value> aggregates_;
+  /** Scratch space for the key and the aggregate inputs of the tuple being folded in. */
+  AggregateKey next_key_;
+  AggregateValue input_;
+};
+}  // namespace bustub
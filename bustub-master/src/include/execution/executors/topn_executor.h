@@ -0,0 +1,147 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// topn_executor.h
+//
+// Identification: src/include/execution/executors/topn_executor.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/memory_tracker.h"
+#include "execution/plans/topn_plan.h"
+#include "execution/sort_key.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * TopNExecutor executes ORDER BY ... LIMIT n with a bounded max-heap of the best n tuples seen so far. The normalized
+ * key of every incoming tuple is compared against the heap top first, and only tuples that beat it are copied into
+ * the heap, so once the heap has settled most tuples cost one key encoding and one memcmp. Tuples with equal keys keep
+ * the order of the child, like in SortExecutor. The heap is charged to the memory tracker of the query as it fills, and
+ * fails the query if n tuples do not fit the memory limit.
+ */
+class TopNExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new top-n executor.
+   * @param exec_ctx the context that the top-n should be performed in
+   * @param plan the top-n plan node
+   * @param child the child executor whose tuples are sorted
+   */
+  TopNExecutor(ExecutorContext *exec_ctx, const TopNPlanNode *plan, std::unique_ptr<AbstractExecutor> &&child)
+      : AbstractExecutor(exec_ctx),
+        plan_(plan),
+        child_(std::move(child)),
+        encoder_(child_->GetOutputSchema(), plan_->GetOrderBys()),
+        key_(encoder_.GetKeyWidth()),
+        memory_tracker_(exec_ctx->GetMemoryTracker()) {}
+
+  /** @return the child executor */
+  const AbstractExecutor *GetChildExecutor() const { return child_.get(); }
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  void Init() override {
+    child_->Init();
+    keys_.clear();
+    tuples_.clear();
+    seqs_.clear();
+    heap_.clear();
+    num_pruned_ = 0;
+    memory_usage_ = 0;
+    memory_tracker_.SetUsage(0, "Top-N");
+
+    const size_t n = plan_->GetN();
+    const uint32_t key_width = encoder_.GetKeyWidth();
+    auto worse = [this, key_width](uint32_t a, uint32_t b) {
+      return Before(&keys_[a * key_width], tuples_[a], seqs_[a], b);
+    };
+    Tuple tuple;
+    for (uint64_t seq = 0; n > 0 && child_->Next(&tuple); seq++) {
+      encoder_.Encode(tuple, key_.data());
+      uint32_t slot;
+      if (heap_.size() < n) {
+        slot = heap_.size();
+        keys_.resize(keys_.size() + key_width);
+        tuples_.emplace_back();
+        seqs_.emplace_back();
+        memory_usage_ += key_width + sizeof(Tuple) + sizeof(uint64_t) + sizeof(uint32_t);
+      } else {
+        // The heap top is the worst of the best n; a tuple that does not come before it cannot make the cut.
+        if (!Before(key_.data(), tuple, seq, heap_.front())) {
+          num_pruned_++;
+          continue;
+        }
+        std::pop_heap(heap_.begin(), heap_.end(), worse);
+        slot = heap_.back();
+        heap_.pop_back();
+      }
+      memcpy(&keys_[slot * key_width], key_.data(), key_width);
+      memory_usage_ = memory_usage_ - tuples_[slot].GetLength() + tuple.GetLength();
+      tuples_[slot] = tuple;
+      seqs_[slot] = seq;
+      heap_.push_back(slot);
+      std::push_heap(heap_.begin(), heap_.end(), worse);
+      memory_tracker_.SetUsage(memory_usage_, "Top-N heap");
+    }
+    std::sort_heap(heap_.begin(), heap_.end(), worse);
+    next_idx_ = 0;
+  }
+
+  bool Next(Tuple *tuple) override {
+    if (next_idx_ == heap_.size()) {
+      return false;
+    }
+    *tuple = tuples_[heap_[next_idx_++]];
+    return true;
+  }
+
+  size_t GetPeakMemoryUsage() override { return memory_tracker_.GetPeakUsage(); }
+
+  /** @return the number of child tuples the last Init() rejected against the heap top without copying them */
+  size_t GetNumPruned() const { return num_pruned_; }
+
+ private:
+  /** @return true if the tuple with the given key and sequence number sorts before the tuple in slot */
+  bool Before(const char *key, const Tuple &tuple, uint64_t seq, uint32_t slot) const {
+    int cmp = encoder_.CompareKeys(key, &keys_[slot * encoder_.GetKeyWidth()]);
+    if (cmp == 0 && encoder_.IsTruncating()) {
+      cmp = encoder_.CompareValues(tuple, tuples_[slot]);
+    }
+    return cmp < 0 || (cmp == 0 && seq < seqs_[slot]);
+  }
+
+  /** The top-n plan node. */
+  const TopNPlanNode *plan_;
+  /** The child executor whose tuples are sorted. */
+  std::unique_ptr<AbstractExecutor> child_;
+  SortKeyEncoder encoder_;
+  /** Scratch space for the key of the incoming tuple. */
+  std::vector<char> key_;
+  /** The heap entries by slot: normalized keys back to back, tuples, and their positions in the child output. */
+  std::vector<char> keys_;
+  std::vector<Tuple> tuples_;
+  std::vector<uint64_t> seqs_;
+  /** Slots ordered as a max-heap during Init(), sorted afterwards. */
+  std::vector<uint32_t> heap_;
+  size_t next_idx_{0};
+  size_t num_pruned_{0};
+  /** The bytes held by the heap entries, charged to memory_tracker_. */
+  size_t memory_usage_{0};
+  MemoryTracker memory_tracker_;
+};
+}  // namespace bustub
@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// view_scan_executor.h
+//
+// Identification: src/include/execution/executors/view_scan_executor.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "catalog/materialized_view.h"
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/view_scan_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * ViewScanExecutor reads the stored groups of a materialized view, which costs one pass over the groups instead of
+ * one over the base table. Init() takes a snapshot of the groups (see MaterializedView::Snapshot()), so the scan sees
+ * the view as of the last commit before it, even if another commit changes the view while the scan runs.
+ */
+class ViewScanExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new view scan executor.
+   * @param exec_ctx the executor context
+   * @param plan the view scan plan node
+   */
+  ViewScanExecutor(ExecutorContext *exec_ctx, const ViewScanPlanNode *plan) : AbstractExecutor(exec_ctx), plan_(plan) {}
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  void Init() override {
+    view_ = exec_ctx_->GetCatalog()->GetMaterializedView(plan_->GetViewOid());
+    group_idx_ = 0;
+    if (!view_->Snapshot(exec_ctx_->GetTransaction(), &groups_)) {
+      groups_.clear();
+      AbortQuery();
+    }
+  }
+
+  bool Next(Tuple *tuple) override {
+    const AbstractExpression *having = view_->GetPlan()->GetHaving();
+    while (group_idx_ < groups_.size()) {
+      const MaterializedView::Group &group = groups_[group_idx_++];
+      if (having != nullptr && !having->EvaluateAggregate(group.group_bys_, group.aggregates_).GetAs<bool>()) {
+        continue;
+      }
+      const Schema *output_schema = GetOutputSchema();
+      std::vector<Value> values;
+      values.reserve(output_schema->GetColumnCount());
+      for (const auto &col : output_schema->GetColumns()) {
+        values.push_back(col.GetExpr()->EvaluateAggregate(group.group_bys_, group.aggregates_));
+      }
+      *tuple = Tuple(values, output_schema);
+      return true;
+    }
+    return false;
+  }
+
+ private:
+  /** The view scan plan node to be executed. */
+  const ViewScanPlanNode *plan_;
+  /** The view being scanned. */
+  MaterializedView *view_{nullptr};
+  /** The groups of the view when the scan started, and the next one to produce. */
+  std::vector<MaterializedView::Group> groups_;
+  size_t group_idx_{0};
+};
+}  // namespace bustub
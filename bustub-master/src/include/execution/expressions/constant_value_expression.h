@@ -36,6 +36,9 @@ class ConstantValueExpression : public AbstractExpression {
     return val_;
   }
 
+  /** @return the constant value wrapped by this expression */
+  const Value &GetValue() const { return val_; }
+
  private:
   Value val_;
 };
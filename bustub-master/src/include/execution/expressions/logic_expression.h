@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// logic_expression.h
+//
+// Identification: src/include/execution/expressions/logic_expression.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "catalog/schema.h"
+#include "execution/expressions/abstract_expression.h"
+#include "storage/table/tuple.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+/** LogicType represents the type of logical connective that we want to perform. */
+enum class LogicType { And, Or };
+
+/**
+ * LogicExpression represents two boolean expressions combined with AND or OR.
+ * Evaluation follows SQL three-valued logic and short-circuits on the left child.
+ */
+class LogicExpression : public AbstractExpression {
+ public:
+  /** Creates a new logic expression representing (left logic_type right). */
+  LogicExpression(const AbstractExpression *left, const AbstractExpression *right, LogicType logic_type)
+      : AbstractExpression({left, right}, TypeId::BOOLEAN), logic_type_{logic_type} {}
+
+  Value Evaluate(const Tuple *tuple, const Schema *schema) const override {
+    CmpBool lhs = ToCmpBool(GetChildAt(0)->Evaluate(tuple, schema));
+    if (IsShortCircuit(lhs)) {
+      return ValueFactory::GetBooleanValue(lhs);
+    }
+    CmpBool rhs = ToCmpBool(GetChildAt(1)->Evaluate(tuple, schema));
+    return ValueFactory::GetBooleanValue(Combine(lhs, rhs));
+  }
+
+  Value EvaluateJoin(const Tuple *left_tuple, const Schema *left_schema, const Tuple *right_tuple,
+                     const Schema *right_schema) const override {
+    CmpBool lhs = ToCmpBool(GetChildAt(0)->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema));
+    if (IsShortCircuit(lhs)) {
+      return ValueFactory::GetBooleanValue(lhs);
+    }
+    CmpBool rhs = ToCmpBool(GetChildAt(1)->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema));
+    return ValueFactory::GetBooleanValue(Combine(lhs, rhs));
+  }
+
+  Value EvaluateAggregate(const std::vector<Value> &group_bys, const std::vector<Value> &aggregates) const override {
+    CmpBool lhs = ToCmpBool(GetChildAt(0)->EvaluateAggregate(group_bys, aggregates));
+    if (IsShortCircuit(lhs)) {
+      return ValueFactory::GetBooleanValue(lhs);
+    }
+    CmpBool rhs = ToCmpBool(GetChildAt(1)->EvaluateAggregate(group_bys, aggregates));
+    return ValueFactory::GetBooleanValue(Combine(lhs, rhs));
+  }
+
+  /** @return the logical connective of this expression */
+  LogicType GetLogicType() const { return logic_type_; }
+
+ private:
+  static CmpBool ToCmpBool(const Value &val) {
+    if (val.IsNull()) {
+      return CmpBool::CmpNull;
+    }
+    return val.GetAs<int8_t>() != 0 ? CmpBool::CmpTrue : CmpBool::CmpFalse;
+  }
+
+  /** @return true if the left operand alone decides the result */
+  bool IsShortCircuit(CmpBool lhs) const {
+    return (logic_type_ == LogicType::And && lhs == CmpBool::CmpFalse) ||
+           (logic_type_ == LogicType::Or && lhs == CmpBool::CmpTrue);
+  }
+
+  CmpBool Combine(CmpBool lhs, CmpBool rhs) const {
+    if (logic_type_ == LogicType::And) {
+      if (rhs == CmpBool::CmpFalse) {
+        return CmpBool::CmpFalse;
+      }
+      return (lhs == CmpBool::CmpNull || rhs == CmpBool::CmpNull) ? CmpBool::CmpNull : CmpBool::CmpTrue;
+    }
+    if (rhs == CmpBool::CmpTrue) {
+      return CmpBool::CmpTrue;
+    }
+    return (lhs == CmpBool::CmpNull || rhs == CmpBool::CmpNull) ? CmpBool::CmpNull : CmpBool::CmpFalse;
+  }
+
+  LogicType logic_type_;
+};
+}  // namespace bustub
@@ -0,0 +1,44 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// row_id_expression.h
+//
+// Identification: src/include/execution/expressions/row_id_expression.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "catalog/schema.h"
+#include "execution/expressions/abstract_expression.h"
+#include "storage/table/tuple.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+/**
+ * RowIdExpression evaluates to the RID of a table tuple as a BIGINT (see RID::Get()). A scan projects it as a column
+ * so that the operators above can carry the row instead of its columns, see LateMaterializePlanNode.
+ */
+class RowIdExpression : public AbstractExpression {
+ public:
+  RowIdExpression() : AbstractExpression({}, TypeId::BIGINT) {}
+
+  Value Evaluate(const Tuple *tuple, const Schema *schema) const override {
+    return ValueFactory::GetBigIntValue(tuple->GetRid().Get());
+  }
+
+  Value EvaluateJoin(const Tuple *left_tuple, const Schema *left_schema, const Tuple *right_tuple,
+                     const Schema *right_schema) const override {
+    BUSTUB_ASSERT(false, "Only the scan of a table knows the RIDs of its tuples.");
+  }
+
+  Value EvaluateAggregate(const std::vector<Value> &group_bys, const std::vector<Value> &aggregates) const override {
+    BUSTUB_ASSERT(false, "Only the scan of a table knows the RIDs of its tuples.");
+  }
+};
+}  // namespace bustub
@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_aggregation.h
+//
+// Identification: src/include/execution/external_aggregation.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/macros.h"
+#include "execution/memory_tracker.h"
+#include "execution/packed_aggregation_hash_table.h"
+#include "storage/page/tmp_tuple_page.h"
+
+namespace bustub {
+
+/**
+ * ExternalAggregation runs a PackedAggregationHashTable under a memory budget.
+ *
+ * Tuples are aggregated in memory until the table grows past the budget, or until the MemoryTracker it is charged to
+ * refuses to take more. The partially aggregated groups are then
+ * hash-partitioned into FANOUT partitions of temporary pages (TmpTuplePage) obtained from the buffer pool, and the
+ * table starts over empty. Once the input is exhausted, the partitions are re-aggregated one at a time by merging
+ * their partial rows; as every group of a partition hashes to it, each group is complete after its partition. A
+ * partition that still does not fit is partitioned again on the next hash bits, up to MAX_LEVEL times; past that a
+ * partition that exceeds the memory limit fails the query.
+ *
+ * If the input never exceeds the budget, nothing is spilled and the groups come straight out of the table.
+ */
+class ExternalAggregation {
+ public:
+  /** Number of hash bits each partitioning pass consumes. */
+  static constexpr uint32_t FANOUT_BITS = 4;
+  /** Number of partitions a spill writes. */
+  static constexpr uint32_t FANOUT = 1U << FANOUT_BITS;
+  /** Number of partitioning passes after which a partition is aggregated in memory regardless of the budget. */
+  static constexpr uint32_t MAX_LEVEL = 8;
+
+  /**
+   * @param table the table to aggregate in, which must be empty
+   * @param bpm the buffer pool the temporary pages are allocated from
+   * @param memory_budget the number of bytes the table may hold before it is spilled
+   * @param memory_tracker the tracker the table is charged to
+   */
+  ExternalAggregation(PackedAggregationHashTable *table, BufferPoolManager *bpm, size_t memory_budget,
+                      MemoryTracker *memory_tracker)
+      : table_(table), bpm_(bpm), memory_budget_(memory_budget), memory_tracker_(memory_tracker) {}
+
+  /** Delete the temporary pages that have not been consumed and release the charge of the table. */
+  ~ExternalAggregation();
+
+  DISALLOW_COPY_AND_MOVE(ExternalAggregation);
+
+  /** Fold an input tuple into its group, spilling the table if it grows past the budget. */
+  void Insert(const Tuple &tuple);
+
+  /** Signal the end of the input. */
+  void Finish();
+
+  /**
+   * Produce the next group. Only valid after Finish().
+   * @param[out] group_bys the group-by values
+   * @param[out] aggregates the aggregate values
+   * @return false if there are no more groups
+   */
+  bool Next(std::vector<Value> *group_bys, std::vector<Value> *aggregates);
+
+  /** @return the number of temporary pages written so far */
+  uint32_t GetNumSpilledPages() const { return num_spilled_pages_; }
+
+ private:
+  /** A partition of spilled rows whose hashes agree on the first level * FANOUT_BITS partitioning bits. */
+  struct Partition {
+    uint32_t level_;
+    std::vector<page_id_t> pages_;
+  };
+
+  /** @return the partition of the given level a hash belongs to */
+  static uint32_t GetPartition(hash_t hash, uint32_t level) {
+    // Use the high bits; the table probes with the low ones.
+    return static_cast<uint32_t>(hash >> (sizeof(hash_t) * 8 - FANOUT_BITS * (level + 1))) & (FANOUT - 1);
+  }
+
+  /** Write every group of the table to the given partitions and clear the table. */
+  void SpillTable(std::vector<Partition> *partitions, uint32_t level);
+
+  /** Re-aggregate the next pending partition into the table, re-partitioning it if it does not fit. */
+  void LoadNextPartition();
+
+  PackedAggregationHashTable *table_;
+  BufferPoolManager *bpm_;
+  size_t memory_budget_;
+  MemoryTracker *memory_tracker_;
+  /** The first-level partitions, empty until the first spill; after Finish(), the children of a partition. */
+  std::vector<Partition> partitions_;
+  /** Partitions waiting to be re-aggregated. */
+  std::vector<Partition> pending_;
+  /** The page of a pending partition being merged, pinned. */
+  TmpTuplePage *page_{nullptr};
+  /** The next group of the table to produce. */
+  uint32_t group_idx_{0};
+  uint32_t num_spilled_pages_{0};
+};
+
+}  // namespace bustub
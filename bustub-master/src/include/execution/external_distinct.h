@@ -0,0 +1,150 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_distinct.h
+//
+// Identification: src/include/execution/external_distinct.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/macros.h"
+#include "execution/memory_tracker.h"
+#include "execution/packed_key_set.h"
+#include "storage/page/tmp_tuple_page.h"
+
+namespace bustub {
+
+/**
+ * ExternalDistinct removes duplicate keys from a stream under a memory budget, reporting every key the moment it is
+ * first seen whenever it can.
+ *
+ * Keys are hash-partitioned into FANOUT PackedKeySets. While all of them fit in the budget, Insert() tells right away
+ * whether a key is new. Once they grow past the budget, or past what the MemoryTracker will take, the largest set is
+ * spilled: its keys, all of them reported already, are written to the "seen" pages of its partition and the set is
+ * dropped. Keys that arrive later for a spilled partition cannot be decided yet and go to its "unseen" pages. Spilled
+ * keys are staged in a page-sized buffer per list, so that a page is pinned once per page of keys rather than per key.
+ *
+ * After Finish(), Next() produces the new keys of the spilled partitions one partition at a time: the seen keys are
+ * loaded first and the unseen keys are then streamed against them, partitioned on the next hash bits, so a partition
+ * that still does not fit spills again. Past MAX_LEVEL partitioning passes a partition that exceeds the memory limit
+ * fails the query. The temporary pages (TmpTuplePage) come from the buffer pool and are deleted once read.
+ */
+class ExternalDistinct {
+ public:
+  /** Number of hash bits each partitioning pass consumes. */
+  static constexpr uint32_t FANOUT_BITS = 4;
+  /** Number of partitions of a pass. */
+  static constexpr uint32_t FANOUT = 1U << FANOUT_BITS;
+  /** Number of partitioning passes after which a partition is kept in memory regardless of the budget. */
+  static constexpr uint32_t MAX_LEVEL = 8;
+
+  /**
+   * @param bpm the buffer pool the temporary pages are allocated from
+   * @param memory_budget the number of bytes the key sets may hold before one is spilled
+   * @param memory_tracker the tracker the key sets are charged to
+   */
+  ExternalDistinct(BufferPoolManager *bpm, size_t memory_budget, MemoryTracker *memory_tracker);
+
+  /** Delete the temporary pages that have not been consumed and release the charge of the key sets. */
+  ~ExternalDistinct();
+
+  DISALLOW_COPY_AND_MOVE(ExternalDistinct);
+
+  /**
+   * Add a key of the input.
+   * @return true if the key is new; false if it is a duplicate, or if it was spilled to be decided by Next()
+   */
+  bool Insert(const char *key, uint32_t size) { return Insert(key, size, false); }
+
+  /** Signal the end of the input. */
+  void Finish();
+
+  /**
+   * Produce the next new key of the spilled partitions. Only valid after Finish().
+   * @param[out] key the key, valid until the next call
+   * @param[out] size the length of the key
+   * @return false if there are no more new keys
+   */
+  bool Next(const char **key, uint32_t *size);
+
+  /** @return the number of temporary pages written so far */
+  uint32_t GetNumSpilledPages() const { return num_spilled_pages_; }
+
+ private:
+  /** Keys written to temporary pages. */
+  struct SpillList {
+    std::vector<page_id_t> pages_;
+    /** The records (length, then bytes) not written to the pages yet. */
+    std::vector<char> buffer_;
+  };
+
+  /** A spilled partition, whose keys agree on the partitioning bits of every pass up to level. */
+  struct Partition {
+    uint32_t level_;
+    /** Keys reported already. */
+    SpillList seen_;
+    /** Keys not decided yet, possibly duplicates of each other or of the seen keys. */
+    SpillList unseen_;
+  };
+
+  /** @return the partition of the given pass a hash belongs to */
+  static uint32_t GetPartition(hash_t hash, uint32_t level) {
+    // Use the high bits; the key sets probe with the low ones.
+    return static_cast<uint32_t>(hash >> (sizeof(hash_t) * 8 - FANOUT_BITS * (level + 1))) & (FANOUT - 1);
+  }
+
+  /**
+   * Add a key to the current pass.
+   * @param seen true if the key was reported already
+   * @return true if the key is new and was not reported yet
+   */
+  bool Insert(const char *key, uint32_t size, bool seen);
+
+  /** Spill the largest key sets of the current pass until the rest fit. */
+  void SpillSets();
+
+  /** Append a key to a list, writing its buffer out once it holds a page of keys. */
+  void Append(SpillList *list, const char *key, uint32_t size);
+
+  /** Write the buffer of a list to its pages. */
+  void Flush(SpillList *list);
+
+  /** Start a pass over the last pending partition: load its seen keys, queue its unseen ones and drop it. */
+  void StartPass();
+
+  /** End the current pass: drop its key sets and queue its spilled partitions. */
+  void FinishPass();
+
+  /** Delete the pages of a list. */
+  void DeletePages(const std::vector<page_id_t> &pages);
+
+  BufferPoolManager *bpm_;
+  size_t memory_budget_;
+  MemoryTracker *memory_tracker_;
+  /** The partitioning pass the key sets belong to, 0 for the input. */
+  uint32_t level_{0};
+  /** The key set of every partition of the current pass, nullptr once spilled. */
+  std::vector<std::unique_ptr<PackedKeySet>> sets_;
+  /** The bytes held by sets_ and by the buffers of partitions_. */
+  size_t memory_usage_{0};
+  /** The partitions of the current pass. */
+  std::vector<Partition> partitions_;
+  /** Partitions waiting for a pass. */
+  std::vector<Partition> pending_;
+  /** The unseen pages of the current pass not read yet, and the page being read (seen or unseen), pinned. */
+  std::vector<page_id_t> unread_pages_;
+  TmpTuplePage *page_{nullptr};
+  uint32_t offset_{0};
+  uint32_t num_spilled_pages_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sort.h
+//
+// Identification: src/include/execution/external_sort.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/schema.h"
+#include "common/arena.h"
+#include "common/macros.h"
+#include "execution/memory_tracker.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/sort_key.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * ExternalSort sorts tuples on a list of order-by keys under a memory budget.
+ *
+ * Every tuple is stored as a record holding its normalized sort key (see SortKeyEncoder) followed by the tuple bytes,
+ * so records are ordered with memcmp; only keys with truncated varchars need their values compared in full.
+ *
+ * Records are collected in memory, charged to a MemoryTracker, until they exceed the budget or the tracker refuses to
+ * take more; then they are stably sorted and written out as a run of
+ * temporary pages. At the end the runs are merged with a loser tree; if there are more runs than the buffer pool can
+ * keep open, groups of adjacent runs are merged into longer runs first. Each open run keeps its current page pinned and
+ * fetches the next one ahead of time. If nothing was spilled, the records are sorted and read back in memory.
+ */
+class ExternalSort {
+ public:
+  /**
+   * @param schema the schema of the tuples to sort
+   * @param order_bys the order-by keys, evaluated against schema
+   * @param bpm the buffer pool the temporary pages are allocated from
+   * @param memory_budget the number of bytes of records to hold in memory before a run is spilled
+   * @param memory_tracker the tracker the buffered records are charged to
+   */
+  ExternalSort(const Schema *schema, const std::vector<OrderBy> &order_bys, BufferPoolManager *bpm,
+               size_t memory_budget, MemoryTracker *memory_tracker);
+
+  /** Delete the temporary pages that have not been consumed and release the buffered records. */
+  ~ExternalSort();
+
+  DISALLOW_COPY_AND_MOVE(ExternalSort);
+
+  /** Add a tuple, spilling a run if the buffered records exceed the budget. */
+  void Insert(const Tuple &tuple);
+
+  /** Signal the end of the input and prepare the merge. */
+  void Finish();
+
+  /**
+   * Produce the next tuple in sort order. Only valid after Finish().
+   * @param[out] tuple the next tuple
+   * @return false if there are no more tuples
+   */
+  bool Next(Tuple *tuple);
+
+  /** @return the number of runs written to temporary pages so far, including those of intermediate merges */
+  uint32_t GetNumRuns() const { return num_runs_; }
+
+ private:
+  /** A sorted run: temporary pages whose records are in order, first page first. */
+  using Run = std::vector<page_id_t>;
+  class RunReader;
+  class LoserTree;
+
+  /** Sort the buffered records and write them out as a new run. */
+  void SpillRun();
+
+  /** Merge runs into a single new run. */
+  Run MergeRuns(std::vector<Run> runs);
+
+  /** @return true if record a sorts before record b */
+  bool Less(const char *a, const char *b) const;
+
+  /** @return true if the current record of run a comes before that of run b, where exhausted runs come last */
+  bool RunLess(const std::vector<std::unique_ptr<RunReader>> &readers, uint32_t a, uint32_t b) const;
+
+  /** @return a non-owning tuple of the tuple bytes of a record */
+  Tuple GetRecordTuple(const char *record) const;
+
+  SortKeyEncoder encoder_;
+  BufferPoolManager *bpm_;
+  size_t memory_budget_;
+  MemoryTracker *memory_tracker_;
+  uint32_t key_width_;
+
+  /** Buffered records: | PayloadSize (4) | Key | TupleSize (4) | TupleData |, the same layout as on a page. */
+  Arena arena_;
+  std::vector<const char *> records_;
+  size_t record_idx_{0};
+  /** Spilled runs waiting to be merged. */
+  std::vector<Run> runs_;
+  uint32_t num_runs_{0};
+  /** The final merge, empty if nothing was spilled. */
+  std::vector<std::unique_ptr<RunReader>> readers_;
+  std::unique_ptr<LoserTree> tree_;
+};
+
+}  // namespace bustub
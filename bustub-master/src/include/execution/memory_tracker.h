@@ -0,0 +1,141 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// memory_tracker.h
+//
+// Identification: src/include/execution/memory_tracker.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <string>
+
+#include "common/exception.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * MemoryTracker accounts for the bytes a query holds in memory and enforces a limit on them.
+ *
+ * The ExecutorContext owns the tracker of the query. Every materializing executor owns a tracker whose parent is the
+ * query tracker and charges what it builds up (hash tables, buffered tuples, ...) to it, so its charges add up in the
+ * query tracker while its own peak is kept for the profile. A charge that would take a tracker or one of its ancestors
+ * past its limit is refused: operators that can spill do so and try again, the others fail the query with an
+ * OUT_OF_MEMORY exception instead of exhausting the process.
+ *
+ * Charges may come from several threads at once.
+ */
+class MemoryTracker {
+ public:
+  /** The limit of a tracker without one. */
+  static constexpr size_t UNLIMITED = std::numeric_limits<size_t>::max();
+
+  /**
+   * Creates a tracker.
+   * @param limit the most bytes that may be charged at once
+   * @param parent the tracker that the charges also count against, nullptr if there is none
+   */
+  explicit MemoryTracker(size_t limit = UNLIMITED, MemoryTracker *parent = nullptr) : limit_(limit), parent_(parent) {}
+
+  /**
+   * Creates an unlimited tracker for an operator.
+   * @param parent the tracker that the charges also count against, usually that of the query
+   */
+  explicit MemoryTracker(MemoryTracker *parent) : MemoryTracker(UNLIMITED, parent) {}
+
+  /** Hand what is still charged back to the parent. */
+  ~MemoryTracker() { Release(usage_.load()); }
+
+  DISALLOW_COPY_AND_MOVE(MemoryTracker);
+
+  /**
+   * Charge bytes.
+   * @return false, charging nothing, if that would exceed the limit of this tracker or of an ancestor
+   */
+  bool TryConsume(size_t bytes) {
+    size_t usage = usage_.fetch_add(bytes) + bytes;
+    if (usage > limit_ || (parent_ != nullptr && !parent_->TryConsume(bytes))) {
+      usage_.fetch_sub(bytes);
+      return false;
+    }
+    size_t peak = peak_.load();
+    while (usage > peak && !peak_.compare_exchange_weak(peak, usage)) {
+    }
+    return true;
+  }
+
+  /**
+   * Charge bytes, failing the query if they do not fit.
+   * @param what the operator or structure that needs the memory, for the error message
+   */
+  void Consume(size_t bytes, const char *what) {
+    if (!TryConsume(bytes)) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, std::string(what) + " needs " + std::to_string(bytes) +
+                                                        " more bytes than the memory limit of the query allows.");
+    }
+  }
+
+  /** Hand back bytes charged before. */
+  void Release(size_t bytes) {
+    usage_.fetch_sub(bytes);
+    if (parent_ != nullptr) {
+      parent_->Release(bytes);
+    }
+  }
+
+  /**
+   * Grow or shrink the charge to the bytes the owner holds now. Only for trackers that a single thread charges.
+   * @return false, leaving the charge as it was, if growing it would exceed a limit
+   */
+  bool TrySetUsage(size_t bytes) {
+    size_t usage = usage_.load();
+    if (bytes > usage) {
+      return TryConsume(bytes - usage);
+    }
+    if (bytes < usage) {
+      Release(usage - bytes);
+    }
+    return true;
+  }
+
+  /**
+   * Grow or shrink the charge to the bytes the owner holds now, failing the query if they do not fit.
+   * @param what the operator or structure that needs the memory, for the error message
+   */
+  void SetUsage(size_t bytes, const char *what) {
+    size_t usage = usage_.load();
+    if (bytes > usage) {
+      Consume(bytes - usage, what);
+    } else if (bytes < usage) {
+      Release(usage - bytes);
+    }
+  }
+
+  /** @return the bytes charged now */
+  size_t GetUsage() const { return usage_.load(); }
+
+  /** @return the most bytes charged at once */
+  size_t GetPeakUsage() const { return peak_.load(); }
+
+  /** @return the most bytes that may be charged at once */
+  size_t GetLimit() const { return limit_; }
+
+  /** Set the most bytes that may be charged at once. Charges made before are not checked again. */
+  void SetLimit(size_t limit) { limit_ = limit; }
+
+ private:
+  std::atomic<size_t> usage_{0};
+  std::atomic<size_t> peak_{0};
+  size_t limit_;
+  MemoryTracker *parent_;
+};
+
+}  // namespace bustub
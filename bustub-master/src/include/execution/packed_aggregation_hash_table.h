@@ -0,0 +1,199 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// packed_aggregation_hash_table.h
+//
+// Identification: src/include/execution/packed_aggregation_hash_table.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "common/util/hash_util.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/aggregation_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/** AccumulatorOp is the typed update an aggregate performs on its state. */
+enum class AccumulatorOp : uint8_t {
+  Count,
+  SumInteger,
+  SumDecimal,
+  MinInteger,
+  MaxInteger,
+  MinDecimal,
+  MaxDecimal,
+  MinTimestamp,
+  MaxTimestamp,
+  ApproxCountDistinct,
+  Avg,
+  SumError,
+  AvgError
+};
+
+/**
+ * PackedAggregationHashTable is an aggregation hash table specialized for fixed-width inputs.
+ *
+ * Each group is one fixed-width row in a flat buffer: the group-by columns packed byte for byte as they are stored
+ * in the tuple, followed by one typed accumulator per aggregate and one NULL flag per aggregate. Most accumulators are
+ * 8 bytes (int64_t, double or uint64_t); AVG and the error aggregates keep SampleMoments, and APPROX_COUNT_DISTINCT
+ * keeps the registers of its HyperLogLog sketch inline, so that the row still merges and spills as plain bytes.
+ * Lookups go through an open-addressing (linear probing) slot array that stores the hash next to the row index, so
+ * most mismatches are rejected without touching the row. Updates read the input columns straight
+ * from the tuple bytes; no Value is created until the groups are read back.
+ *
+ * The table only handles group-bys and aggregates that are plain column references to fixed-width columns of the
+ * input, and rows of at most MAX_ROW_WIDTH bytes; use CanHandle() and fall back to SimpleAggregationHashTable
+ * otherwise. Results follow the conventions of SimpleAggregationHashTable: COUNT counts every row and is an INTEGER,
+ * SUM is at least an INTEGER, MIN and MAX keep the input type, and a NULL input makes SUM, MIN and MAX NULL. NULL
+ * group-by keys form a single group.
+ */
+class PackedAggregationHashTable {
+ public:
+  /** The widest row a group may have, so that a spilled row fits in a temporary page. */
+  static constexpr uint32_t MAX_ROW_WIDTH = PAGE_SIZE / 4 * 3;
+
+  /**
+   * @param input_schema the schema of the tuples to aggregate
+   * @param group_bys the group-by expressions
+   * @param aggregates the aggregate input expressions
+   * @param agg_types the aggregate functions
+   * @return true if this table can evaluate the aggregation
+   */
+  static bool CanHandle(const Schema *input_schema, const std::vector<const AbstractExpression *> &group_bys,
+                        const std::vector<const AbstractExpression *> &aggregates,
+                        const std::vector<AggregationType> &agg_types);
+
+  /**
+   * Create a new table. CanHandle() must hold for the arguments.
+   * @param sample_rate the fraction of the input rows the aggregation sees, to scale up COUNT and SUM by
+   */
+  PackedAggregationHashTable(const Schema *input_schema, const std::vector<const AbstractExpression *> &group_bys,
+                             const std::vector<const AbstractExpression *> &aggregates,
+                             const std::vector<AggregationType> &agg_types, double sample_rate = 1);
+
+  /** Find or create the group of the tuple and fold the tuple into its aggregates. */
+  void InsertCombine(const Tuple &tuple);
+
+  /** Fold a tuple into the aggregates of a group without looking up its key, which must be the key of the group. */
+  void Combine(uint32_t group_idx, const Tuple &tuple);
+
+  /** @return true if the tuple has the key of the group, comparing the stored bytes (so NULL matches NULL) */
+  bool KeyEquals(uint32_t group_idx, const Tuple &tuple) const;
+
+  /**
+   * Find or create the group of a row produced by another table with the same layout, e.g. a spilled row, and
+   * combine the partial aggregates of the row into it.
+   * @param row a row of GetRowWidth() bytes
+   */
+  void MergeRow(const char *row);
+
+  /** @return the number of groups */
+  uint32_t Size() const { return num_groups_; }
+
+  /** @return the width of the row of a group */
+  uint32_t GetRowWidth() const { return row_width_; }
+
+  /** @return the row of a group, holding its key and partial aggregates; valid until the next insert */
+  const char *GetRowData(uint32_t group_idx) const { return GetRow(group_idx); }
+
+  /** @return the hash of the key of a group */
+  hash_t GetRowHash(uint32_t group_idx) const;
+
+  /** @return the number of bytes held by the groups and the slot array */
+  size_t GetMemoryUsage() const {
+    return static_cast<size_t>(num_groups_) * row_width_ + slots_.size() * sizeof(Slot);
+  }
+
+  /**
+   * Read a group back as values.
+   * @param group_idx the group, in [0, Size())
+   * @param[out] group_bys the group-by values
+   * @param[out] aggregates the aggregate values
+   */
+  void GetGroup(uint32_t group_idx, std::vector<Value> *group_bys, std::vector<Value> *aggregates) const;
+
+  /**
+   * Remove all groups, keeping the memory of the rows for the next ones, e.g. when the table holds a single group at a
+   * time. GetMemoryUsage() only counts what is in use, so a table whose memory is charged should call Release().
+   */
+  void Clear();
+
+  /** Remove all groups and free the memory they held. */
+  void Release();
+
+ private:
+  /** A group-by column: where it is in the tuple and where it goes in the packed key. */
+  struct KeyColumn {
+    uint32_t tuple_offset_;
+    uint32_t key_offset_;
+    uint32_t size_;
+    TypeId type_;
+  };
+
+  /** An aggregate: its update, where it reads its input from and where its state is in the row. */
+  struct Accumulator {
+    AccumulatorOp op_;
+    uint32_t tuple_offset_;
+    TypeId input_type_;
+    uint32_t state_offset_;
+  };
+
+  /** A slot of the open-addressing table. */
+  struct Slot {
+    hash_t hash_;
+    uint32_t group_;
+  };
+
+  static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+  static constexpr uint32_t INITIAL_SLOTS = 64;
+
+  char *GetRow(uint32_t group_idx) { return rows_.data() + static_cast<size_t>(group_idx) * row_width_; }
+  const char *GetRow(uint32_t group_idx) const {
+    return rows_.data() + static_cast<size_t>(group_idx) * row_width_;
+  }
+
+  /** @return the bytes of the state of an accumulator */
+  static uint32_t GetStateWidth(AccumulatorOp op);
+
+  /** Fold the input tuple bytes into the aggregates of a row. */
+  void Accumulate(char *row, const char *data);
+
+  /** @return the hash of a packed key */
+  hash_t HashKey(const char *key) const;
+
+  /** @return the row of the group with the packed key in key_buffer_, created if it does not exist yet */
+  char *FindOrCreateGroup(hash_t hash);
+
+  /** Double the slot array and re-insert all groups. */
+  void Grow();
+
+  std::vector<KeyColumn> keys_;
+  std::vector<Accumulator> accumulators_;
+  double sample_rate_;
+  /** Width of the packed key. */
+  uint32_t key_width_{0};
+  /** Offset of the first accumulator in a row. */
+  uint32_t state_offset_{0};
+  /** Offset of the NULL flags in a row. */
+  uint32_t null_offset_{0};
+  /** Width of a row, a multiple of 8. */
+  uint32_t row_width_{0};
+  /** The rows of all groups, back to back. */
+  std::vector<char> rows_;
+  uint32_t num_groups_{0};
+  std::vector<Slot> slots_;
+  /** Scratch space the key of the current input tuple is packed into. */
+  std::vector<char> key_buffer_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// packed_key_set.h
+//
+// Identification: src/include/execution/packed_key_set.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/util/hash_util.h"
+
+namespace bustub {
+
+/**
+ * PackedKeySet is a hash set of byte-string keys.
+ *
+ * The keys are copied back to back into one flat buffer, and looked up through an open-addressing (linear probing)
+ * slot array of 8-byte slots holding the low half of the hash next to the key index, so that most mismatches are
+ * rejected without touching the keys. Keys compare byte for byte, so a key must be a canonical encoding of the value
+ * it stands for.
+ */
+class PackedKeySet {
+ public:
+  PackedKeySet() { slots_.assign(INITIAL_SLOTS, Slot{0, EMPTY_SLOT}); }
+
+  /** @return the hash of a key */
+  static hash_t Hash(const char *key, uint32_t size);
+
+  /**
+   * Add a key if it is not in the set yet.
+   * @param key the key
+   * @param size the length of the key
+   * @param hash the hash of the key, see Hash()
+   * @return true if the key was added, false if it was in the set already
+   */
+  bool Insert(const char *key, uint32_t size, hash_t hash);
+
+  /** @return the number of keys */
+  uint32_t Size() const { return static_cast<uint32_t>(entries_.size()); }
+
+  /** @return the key at idx, in [0, Size()), valid until the next insert; size is set to its length */
+  const char *GetKey(uint32_t idx, uint32_t *size) const {
+    *size = entries_[idx].size_;
+    return keys_.data() + entries_[idx].offset_;
+  }
+
+  /** @return the number of bytes held by the keys, their entries and the slot array */
+  size_t GetMemoryUsage() const {
+    return keys_.size() + entries_.size() * sizeof(Entry) + slots_.size() * sizeof(Slot);
+  }
+
+  /** Remove all keys and free the memory they held. */
+  void Clear();
+
+ private:
+  /** Where the bytes of a key are. */
+  struct Entry {
+    uint32_t offset_;
+    uint32_t size_;
+  };
+
+  /** A slot of the open-addressing table. */
+  struct Slot {
+    /** The low 32 bits of the hash of the key. */
+    uint32_t tag_;
+    uint32_t entry_;
+  };
+
+  static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+  static constexpr uint32_t INITIAL_SLOTS = 64;
+
+  /** Double the slot array and re-insert all keys. */
+  void Grow();
+
+  /** The bytes of all keys, back to back. */
+  std::vector<char> keys_;
+  std::vector<Entry> entries_;
+  std::vector<Slot> slots_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,135 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_aggregation.h
+//
+// Identification: src/include/execution/parallel_aggregation.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "common/macros.h"
+#include "execution/memory_tracker.h"
+#include "execution/packed_aggregation_hash_table.h"
+
+namespace bustub {
+
+/**
+ * ParallelAggregation evaluates an aggregation that fits a PackedAggregationHashTable on several threads, in two
+ * phases.
+ *
+ * 1. Local pre-aggregation: the input is split into morsels (e.g. table pages). Every worker grabs morsels from a
+ *    shared counter and aggregates them into its own private table, so workers never synchronize per tuple.
+ * 2. Partitioned merge: every worker radix-partitions its groups on the high bits of their hash. Partitions are then
+ *    merged in parallel, each into its own table, by combining the partial states of the same group from every local
+ *    table (COUNT and SUM add up, MIN and MAX take the min and max, sketches take the max of every register). A group
+ *    only ever lands in one partition, so the merged tables are disjoint and need no further combining.
+ *
+ * The groups are read back partition by partition with Next().
+ *
+ * The tables are kept in memory. Workers charge their growth to a MemoryTracker after every morsel and partition, and
+ * a refused charge stops all of them and fails the query. A morsel that cannot be read stops them as well.
+ */
+class ParallelAggregation {
+ public:
+  /** Number of hash bits the merge phase partitions on. */
+  static constexpr uint32_t PARTITION_BITS = 6;
+  /** Number of partitions of the merge phase. */
+  static constexpr uint32_t NUM_PARTITIONS = 1U << PARTITION_BITS;
+
+  /** Called by a worker for every tuple of a morsel. */
+  using Sink = std::function<void(const Tuple &tuple)>;
+  /**
+   * Produce the tuples of a morsel by calling sink on each. Called concurrently for different morsels.
+   * @return false if the morsel could not be read
+   */
+  using MorselScan = std::function<bool(uint32_t morsel_idx, const Sink &sink)>;
+
+  /**
+   * Create a new parallel aggregation. PackedAggregationHashTable::CanHandle() must hold for the arguments.
+   * @param input_schema the schema of the tuples to aggregate
+   * @param group_bys the group-by expressions
+   * @param aggregates the aggregate input expressions
+   * @param agg_types the aggregate functions
+   * @param num_threads the number of worker threads
+   * @param memory_tracker the tracker the tables are charged to
+   * @param sample_rate the fraction of the input rows the aggregation sees
+   */
+  ParallelAggregation(const Schema *input_schema, const std::vector<const AbstractExpression *> &group_bys,
+                      const std::vector<const AbstractExpression *> &aggregates,
+                      const std::vector<AggregationType> &agg_types, uint32_t num_threads,
+                      MemoryTracker *memory_tracker, double sample_rate = 1);
+
+  /** Release the charge of the tables. */
+  ~ParallelAggregation() { memory_tracker_->Release(charged_); }
+
+  DISALLOW_COPY_AND_MOVE(ParallelAggregation);
+
+  /**
+   * Aggregate all morsels. Any previous result is discarded. The first morsel that fails stops the workers; the
+   * tables are then dropped and the caller decides how to fail the query.
+   * @param num_morsels the number of morsels
+   * @param scan produces the tuples of a morsel
+   * @return false if a morsel could not be read
+   */
+  bool Run(uint32_t num_morsels, const MorselScan &scan);
+
+  /**
+   * Produce the next group of the last Run().
+   * @param[out] group_bys the group-by values
+   * @param[out] aggregates the aggregate values
+   * @return false if there are no more groups
+   */
+  bool Next(std::vector<Value> *group_bys, std::vector<Value> *aggregates);
+
+  /** @return the number of groups of the last Run() */
+  uint32_t Size() const;
+
+ private:
+  /** @return a new, empty table for this aggregation */
+  std::unique_ptr<PackedAggregationHashTable> MakeTable() const;
+
+  /**
+   * Charge the growth of a table since the last charge.
+   * @param table the table
+   * @param[in,out] charged the bytes of the table charged so far
+   * @return false if the tracker refused the charge
+   */
+  bool Charge(const PackedAggregationHashTable *table, size_t *charged) const;
+
+  /** Drop the tables and release their charge. */
+  void Discard();
+
+  /** Discard the tables and fail the query. */
+  [[noreturn]] void FailOutOfMemory();
+
+  /** Run fn(worker_idx) for every worker on the shared TaskPool and wait for all of them. */
+  void RunWorkers(const std::function<void(uint32_t worker_idx)> &fn) const;
+
+  const Schema *input_schema_;
+  const std::vector<const AbstractExpression *> &group_bys_;
+  const std::vector<const AbstractExpression *> &aggregates_;
+  const std::vector<AggregationType> &agg_types_;
+  uint32_t num_threads_;
+  MemoryTracker *memory_tracker_;
+  double sample_rate_;
+  /** The bytes charged for the tables that exist now. */
+  size_t charged_{0};
+  /** The private table of every worker. */
+  std::vector<std::unique_ptr<PackedAggregationHashTable>> local_tables_;
+  /** The merged table of every partition. */
+  std::vector<std::unique_ptr<PackedAggregationHashTable>> partition_tables_;
+  /** The partition and group Next() produces next. */
+  uint32_t partition_idx_{0};
+  uint32_t group_idx_{0};
+};
+
+}  // namespace bustub
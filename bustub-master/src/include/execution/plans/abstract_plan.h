@@ -20,7 +20,19 @@
 namespace bustub {
 
 /** PlanType represents the types of plans that we have in our system. */
-enum class PlanType { SeqScan, HashJoin, Insert, Aggregation };
+enum class PlanType {
+  SeqScan,
+  IndexScan,
+  HashJoin,
+  Insert,
+  Aggregation,
+  Sort,
+  TopN,
+  Limit,
+  Distinct,
+  LateMaterialize,
+  ViewScan
+};
 
 /**
  * AbstractPlanNode represents all the possible types of plan nodes in our system.
@@ -53,6 +65,18 @@ class AbstractPlanNode {
   /** @return the type of this plan node */
   virtual PlanType GetType() const = 0;
 
+  /**
+   * @return the output columns the tuples of this plan node are ordered on, most significant first. Tuples with equal
+   * values in these columns are adjacent. Empty if the output has no known order.
+   */
+  const std::vector<uint32_t> &GetOutputOrdering() const { return output_ordering_; }
+
+  /**
+   * Declare the order of the output, e.g. for a scan over a table that was loaded in key order.
+   * @param column_idxs the output columns the tuples are ordered on, most significant first
+   */
+  void SetOutputOrdering(std::vector<uint32_t> column_idxs) { output_ordering_ = std::move(column_idxs); }
+
  private:
   /**
    * The schema for the output of this plan node. In the volcano model, every plan node will spit out tuples,
@@ -61,5 +85,7 @@ class AbstractPlanNode {
   const Schema *output_schema_;
   /** The children of this plan node. */
   std::vector<const AbstractPlanNode *> children_;
+  /** The output columns the output is ordered on. */
+  std::vector<uint32_t> output_ordering_;
 };
 }  // namespace bustub
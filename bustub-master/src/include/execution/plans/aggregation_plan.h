@@ -15,14 +15,31 @@
 #include <utility>
 #include <vector>
 
+#include "common/hyperloglog.h"
 #include "common/util/hash_util.h"
+#include "execution/approximate_aggregate.h"
 #include "execution/plans/abstract_plan.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
-/** AggregationType enumerates all the possible aggregation functions in our system. */
-enum class AggregationType { CountAggregate, SumAggregate, MinAggregate, MaxAggregate };
+/**
+ * AggregationType enumerates all the possible aggregation functions in our system.
+ *
+ * ApproxCountDistinctAggregate estimates the number of distinct non-NULL inputs with a HyperLogLog sketch.
+ * AvgAggregate is the mean of the non-NULL inputs, a DECIMAL. SumErrorAggregate and AvgErrorAggregate are the 95%
+ * error bounds of SUM and AVG of their input in a sampled aggregation, and 0 otherwise. See ApproximateAggregate.
+ */
+enum class AggregationType {
+  CountAggregate,
+  SumAggregate,
+  MinAggregate,
+  MaxAggregate,
+  ApproxCountDistinctAggregate,
+  AvgAggregate,
+  SumErrorAggregate,
+  AvgErrorAggregate
+};
 
 /**
  * AggregationPlanNode represents the various SQL aggregation functions.
@@ -39,15 +56,22 @@ class AggregationPlanNode : public AbstractPlanNode {
    * @param group_bys the group by clause of the aggregation
    * @param aggregates the expressions that we are aggregating
    * @param agg_types the types that we are aggregating
+   * @param sample_rate the fraction of the input rows to aggregate, picked at random; 1 aggregates all of them
+   * @param sample_seed the seed the rows to aggregate are picked with
    */
   AggregationPlanNode(const Schema *output_schema, const AbstractPlanNode *child, const AbstractExpression *having,
                       std::vector<const AbstractExpression *> &&group_bys,
-                      std::vector<const AbstractExpression *> &&aggregates, std::vector<AggregationType> &&agg_types)
+                      std::vector<const AbstractExpression *> &&aggregates, std::vector<AggregationType> &&agg_types,
+                      double sample_rate = 1, uint64_t sample_seed = 0)
       : AbstractPlanNode(output_schema, {child}),
         having_(having),
         group_bys_(std::move(group_bys)),
         aggregates_(std::move(aggregates)),
-        agg_types_(std::move(agg_types)) {}
+        agg_types_(std::move(agg_types)),
+        sample_rate_(sample_rate),
+        sample_seed_(sample_seed) {
+    BUSTUB_ASSERT(sample_rate > 0 && sample_rate <= 1, "The sample rate must be in (0, 1].");
+  }
 
   PlanType GetType() const override { return PlanType::Aggregation; }
 
@@ -75,11 +99,19 @@ class AggregationPlanNode : public AbstractPlanNode {
   /** @return the aggregate types */
   const std::vector<AggregationType> &GetAggregateTypes() const { return agg_types_; }
 
+  /** @return the fraction of the input rows that are aggregated */
+  double GetSampleRate() const { return sample_rate_; }
+
+  /** @return the seed the rows to aggregate are picked with */
+  uint64_t GetSampleSeed() const { return sample_seed_; }
+
  private:
   const AbstractExpression *having_;
   std::vector<const AbstractExpression *> group_bys_;
   std::vector<const AbstractExpression *> aggregates_;
   std::vector<AggregationType> agg_types_;
+  double sample_rate_;
+  uint64_t sample_seed_;
 };
 
 struct AggregateKey {
@@ -102,6 +134,10 @@ struct AggregateKey {
 
 struct AggregateValue {
   std::vector<Value> aggregates_;
+  /** The running moments of every aggregate, empty unless there is an AVG or error aggregate. */
+  std::vector<SampleMoments> moments_;
+  /** The sketch of every APPROX_COUNT_DISTINCT aggregate, in the order of the aggregates. */
+  std::vector<HyperLogLog> sketches_;
 };
 }  // namespace bustub
 
@@ -0,0 +1,42 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// distinct_plan.h
+//
+// Identification: src/include/execution/plans/distinct_plan.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/**
+ * DistinctPlanNode represents SELECT DISTINCT: it outputs every tuple of its child once, dropping tuples that are
+ * equal to one output before in all columns. NULLs are equal to each other.
+ */
+class DistinctPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new DistinctPlanNode.
+   * @param output_schema the output format of this plan node, the same as the output format of the child
+   * @param child the child plan whose duplicates are removed
+   */
+  DistinctPlanNode(const Schema *output_schema, const AbstractPlanNode *child)
+      : AbstractPlanNode(output_schema, {child}) {}
+
+  PlanType GetType() const override { return PlanType::Distinct; }
+
+  /** @return the child of this distinct plan node */
+  const AbstractPlanNode *GetChildPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "Distinct expected to only have one child.");
+    return GetChildAt(0);
+  }
+};
+
+}  // namespace bustub
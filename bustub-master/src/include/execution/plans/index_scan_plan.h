@@ -0,0 +1,73 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_scan_plan.h
+//
+// Identification: src/include/execution/plans/index_scan_plan.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "catalog/simple_catalog.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * IndexScanPlanNode identifies a table that should be read through one of its indexes: only the tuples whose key is
+ * one of a list of lookup keys are read, e.g. for WHERE id = 5 or WHERE id IN (5, 7). The output has no particular
+ * order.
+ */
+class IndexScanPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new index scan plan node.
+   * @param output the output format of this scan plan node
+   * @param predicate the predicate to apply to the tuples found through the index, nullptr to accept all of them
+   * @param table_oid the identifier of the table to be scanned
+   * @param index_oid the identifier of the index of the table to look up
+   * @param keys the keys to look up, each holding one value per column of the index key schema
+   */
+  IndexScanPlanNode(const Schema *output, const AbstractExpression *predicate, table_oid_t table_oid,
+                    index_oid_t index_oid, std::vector<std::vector<Value>> &&keys)
+      : AbstractPlanNode(output, {}),
+        predicate_{predicate},
+        table_oid_(table_oid),
+        index_oid_(index_oid),
+        keys_(std::move(keys)) {}
+
+  PlanType GetType() const override { return PlanType::IndexScan; }
+
+  /** @return the predicate to test the tuples found through the index against */
+  const AbstractExpression *GetPredicate() const { return predicate_; }
+
+  /** @return the identifier of the table that should be scanned */
+  table_oid_t GetTableOid() const { return table_oid_; }
+
+  /** @return the identifier of the index to look up */
+  index_oid_t GetIndexOid() const { return index_oid_; }
+
+  /** @return the keys to look up */
+  const std::vector<std::vector<Value>> &GetKeys() const { return keys_; }
+
+ private:
+  /** The predicate that all returned tuples must satisfy. */
+  const AbstractExpression *predicate_;
+  /** The table whose tuples should be scanned. */
+  table_oid_t table_oid_;
+  /** The index of the table to look up. */
+  index_oid_t index_oid_;
+  /** The keys to look up. */
+  std::vector<std::vector<Value>> keys_;
+};
+
+}  // namespace bustub
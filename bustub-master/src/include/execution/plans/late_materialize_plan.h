@@ -0,0 +1,61 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// late_materialize_plan.h
+//
+// Identification: src/include/execution/plans/late_materialize_plan.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "catalog/simple_catalog.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/**
+ * LateMaterializePlanNode fetches columns of a table for the rows its child identifies by RID, so that the operators
+ * below it carry a RID (see RowIdExpression) instead of the columns themselves and only surviving rows are read.
+ *
+ * The output column expressions are evaluated as a join: tuple 0 is the child tuple and tuple 1 the table row, in
+ * the table schema. Child tuples whose row is gone are dropped.
+ */
+class LateMaterializePlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new LateMaterializePlanNode.
+   * @param output_schema the output format of this plan node
+   * @param child the child plan that carries the RIDs
+   * @param table_oid the table the rows are fetched from
+   * @param rid_col the index of the RID column in the output schema of the child
+   */
+  LateMaterializePlanNode(const Schema *output_schema, const AbstractPlanNode *child, table_oid_t table_oid,
+                          uint32_t rid_col)
+      : AbstractPlanNode(output_schema, {child}), table_oid_(table_oid), rid_col_(rid_col) {}
+
+  PlanType GetType() const override { return PlanType::LateMaterialize; }
+
+  /** @return the child of this plan node */
+  const AbstractPlanNode *GetChildPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "Late materialization expected to only have one child.");
+    return GetChildAt(0);
+  }
+
+  /** @return the identifier of the table the rows are fetched from */
+  table_oid_t GetTableOid() const { return table_oid_; }
+
+  /** @return the index of the RID column in the output schema of the child */
+  uint32_t GetRidColumn() const { return rid_col_; }
+
+ private:
+  /** The table the rows are fetched from. */
+  table_oid_t table_oid_;
+  /** The RID column of the child. */
+  uint32_t rid_col_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,50 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// limit_plan.h
+//
+// Identification: src/include/execution/plans/limit_plan.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/**
+ * LimitPlanNode represents LIMIT: it outputs the first tuples of its child, unchanged and in the same order.
+ */
+class LimitPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new LimitPlanNode.
+   * @param output_schema the output format of this plan node, the same as the output format of the child
+   * @param child the child plan whose tuples are limited
+   * @param limit the maximum number of tuples to output
+   */
+  LimitPlanNode(const Schema *output_schema, const AbstractPlanNode *child, size_t limit)
+      : AbstractPlanNode(output_schema, {child}), limit_(limit) {
+    SetOutputOrdering(child->GetOutputOrdering());
+  }
+
+  PlanType GetType() const override { return PlanType::Limit; }
+
+  /** @return the child of this limit plan node */
+  const AbstractPlanNode *GetChildPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "Limit expected to only have one child.");
+    return GetChildAt(0);
+  }
+
+  /** @return the maximum number of tuples to output */
+  size_t GetLimit() const { return limit_; }
+
+ private:
+  size_t limit_;
+};
+
+}  // namespace bustub
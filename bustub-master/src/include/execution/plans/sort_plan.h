@@ -0,0 +1,76 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_plan.h
+//
+// Identification: src/include/execution/plans/sort_plan.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "execution/expressions/abstract_expression.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/** OrderByType is the direction of an ORDER BY key. */
+enum class OrderByType { Asc, Desc };
+
+/** An ORDER BY key: an expression over the child tuple and its direction. */
+using OrderBy = std::pair<const AbstractExpression *, OrderByType>;
+
+/** @return the columns of the leading order-by keys that are plain columns, which describe the order of the output */
+inline std::vector<uint32_t> GetOrderingColumns(const std::vector<OrderBy> &order_bys) {
+  std::vector<uint32_t> ordering;
+  for (const auto &order_by : order_bys) {
+    const auto *col_expr = dynamic_cast<const ColumnValueExpression *>(order_by.first);
+    if (col_expr == nullptr) {
+      break;
+    }
+    ordering.push_back(col_expr->GetColIdx());
+  }
+  return ordering;
+}
+
+/**
+ * SortPlanNode represents ORDER BY. It outputs the tuples of its child unchanged, ordered on the order-by keys; the
+ * first key is the most significant. NULLs sort before all other values in ascending order and after them in
+ * descending order. Tuples with equal keys keep the order of the child.
+ */
+class SortPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new SortPlanNode.
+   * @param output_schema the output format of this plan node, the same as the output format of the child
+   * @param child the child plan whose tuples are sorted
+   * @param order_bys the order-by keys, evaluated against the child tuples
+   */
+  SortPlanNode(const Schema *output_schema, const AbstractPlanNode *child, std::vector<OrderBy> &&order_bys)
+      : AbstractPlanNode(output_schema, {child}), order_bys_(std::move(order_bys)) {
+    SetOutputOrdering(GetOrderingColumns(order_bys_));
+  }
+
+  PlanType GetType() const override { return PlanType::Sort; }
+
+  /** @return the child of this sort plan node */
+  const AbstractPlanNode *GetChildPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "Sort expected to only have one child.");
+    return GetChildAt(0);
+  }
+
+  /** @return the order-by keys */
+  const std::vector<OrderBy> &GetOrderBys() const { return order_bys_; }
+
+ private:
+  std::vector<OrderBy> order_bys_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,60 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// topn_plan.h
+//
+// Identification: src/include/execution/plans/topn_plan.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/sort_plan.h"
+
+namespace bustub {
+
+/**
+ * TopNPlanNode represents ORDER BY ... LIMIT n: it outputs the first n tuples that a SortPlanNode with the same
+ * order-by keys would output, in the same order.
+ */
+class TopNPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new TopNPlanNode.
+   * @param output_schema the output format of this plan node, the same as the output format of the child
+   * @param child the child plan whose tuples are sorted
+   * @param order_bys the order-by keys, evaluated against the child tuples
+   * @param n the number of tuples to output
+   */
+  TopNPlanNode(const Schema *output_schema, const AbstractPlanNode *child, std::vector<OrderBy> &&order_bys, size_t n)
+      : AbstractPlanNode(output_schema, {child}), order_bys_(std::move(order_bys)), n_(n) {
+    SetOutputOrdering(GetOrderingColumns(order_bys_));
+  }
+
+  PlanType GetType() const override { return PlanType::TopN; }
+
+  /** @return the child of this top-n plan node */
+  const AbstractPlanNode *GetChildPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "TopN expected to only have one child.");
+    return GetChildAt(0);
+  }
+
+  /** @return the order-by keys */
+  const std::vector<OrderBy> &GetOrderBys() const { return order_bys_; }
+
+  /** @return the number of tuples to output */
+  size_t GetN() const { return n_; }
+
+ private:
+  std::vector<OrderBy> order_bys_;
+  size_t n_;
+};
+
+}  // namespace bustub
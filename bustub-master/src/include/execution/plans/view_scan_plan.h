@@ -0,0 +1,46 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// view_scan_plan.h
+//
+// Identification: src/include/execution/plans/view_scan_plan.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "catalog/simple_catalog.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/**
+ * ViewScanPlanNode reads the groups of a materialized view instead of running its aggregation.
+ *
+ * It produces what the AggregationPlanNode that defines the view would: the HAVING clause of that plan filters the
+ * groups, and the output column expressions are evaluated on the group-bys and aggregates of every group.
+ */
+class ViewScanPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new ViewScanPlanNode.
+   * @param output_schema the output format of this plan node, usually that of the aggregation that defines the view
+   * @param view_oid the identifier of the view, see SimpleCatalog::CreateMaterializedView()
+   */
+  ViewScanPlanNode(const Schema *output_schema, table_oid_t view_oid)
+      : AbstractPlanNode(output_schema, {}), view_oid_(view_oid) {}
+
+  PlanType GetType() const override { return PlanType::ViewScan; }
+
+  /** @return the identifier of the view that should be scanned */
+  table_oid_t GetViewOid() const { return view_oid_; }
+
+ private:
+  /** The view whose groups should be scanned. */
+  table_oid_t view_oid_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,155 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// query_profile.h
+//
+// Identification: src/include/execution/query_profile.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+#include "execution/plans/abstract_plan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace bustub {
+
+/**
+ * The runtime metrics of one operator of a query. Times include the time spent in the children of the operator while
+ * it called them; QueryProfile::ToString derives the time of the operator by itself.
+ */
+struct OperatorProfile {
+  /** The number of first calls to Next() that are all timed. */
+  static constexpr uint64_t EXACT_CALLS = 64;
+  /** On average one in this many of the later calls to Next() is timed. */
+  static constexpr uint64_t SAMPLE_INTERVAL = 64;
+
+  /** The kind of executor that ran the operator. */
+  std::string name_;
+  /** Clock ticks spent in Init(), see QueryProfile::Now(). */
+  uint64_t init_ticks_{0};
+  /** The number of Next() calls. */
+  uint64_t next_calls_{0};
+  /** Clock ticks spent in the first EXACT_CALLS calls to Next(). */
+  uint64_t exact_next_ticks_{0};
+  /** The number of later calls to Next() that were timed, and their clock ticks. */
+  uint64_t sampled_next_calls_{0};
+  uint64_t sampled_next_ticks_{0};
+  /** The next call to Next() to time after the first EXACT_CALLS, see ScheduleSample(). */
+  uint64_t next_sample_call_{EXACT_CALLS};
+  /** The splitmix64 state that spaces the samples. */
+  uint64_t sample_state_{0};
+  /** The number of tuples produced by Next(). */
+  uint64_t rows_{0};
+  /**
+   * The buffer pool traffic of the operator by itself, not counting its children. Fetches made on other threads,
+   * e.g. by the workers of a parallel aggregation, are not counted.
+   */
+  BufferPoolStats buffer_pool_;
+  /** The most bytes the operator held in memory at once, see AbstractExecutor::GetPeakMemoryUsage(). */
+  size_t peak_memory_{0};
+
+  /**
+   * Pick the next call to time. The gaps are random, so the samples neither line up with periodic work, like the first
+   * tuple of every page, nor with the samples of the children of the operator.
+   */
+  void ScheduleSample() {
+    sample_state_ += 0x9E3779B97F4A7C15ULL;
+    uint64_t x = sample_state_;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    next_sample_call_ += 1 + x % (2 * SAMPLE_INTERVAL - 1);
+  }
+
+  /** @return the clock ticks spent in Next(), extrapolated from the sampled calls */
+  uint64_t GetNextTicks() const {
+    if (sampled_next_calls_ == 0 || next_calls_ <= EXACT_CALLS) {
+      return exact_next_ticks_;
+    }
+    return exact_next_ticks_ + static_cast<uint64_t>(static_cast<double>(sampled_next_ticks_) *
+                                                     static_cast<double>(next_calls_ - EXACT_CALLS) /
+                                                     static_cast<double>(sampled_next_calls_));
+  }
+
+  /** @return the clock ticks spent in Init() and Next() */
+  uint64_t GetTotalTicks() const { return init_ticks_ + GetNextTicks(); }
+};
+
+/**
+ * QueryProfile collects the metrics of every operator of a query, like EXPLAIN ANALYZE. Enable it on the
+ * ExecutorContext before the executors are created; ExecutorFactory then wraps every executor in a ProfilingExecutor
+ * that fills in the OperatorProfile of its plan node. Without a profile no wrapper is created, so the executors run
+ * exactly as before.
+ */
+class QueryProfile {
+ public:
+  QueryProfile() : start_ticks_(Now()), start_time_(std::chrono::steady_clock::now()) {}
+
+  /**
+   * @param plan the plan node of the operator
+   * @param name the kind of executor that runs it
+   * @return the profile of the operator, the existing one if the plan node was added before
+   */
+  OperatorProfile *AddOperator(const AbstractPlanNode *plan, std::string name) {
+    auto inserted = operators_.emplace(plan, OperatorProfile{});
+    OperatorProfile &profile = inserted.first->second;
+    if (inserted.second) {
+      profile.sample_state_ = operators_.size();
+    }
+    profile.name_ = std::move(name);
+    return &profile;
+  }
+
+  /** @return the profile of the operator of a plan node, nullptr if it was never added */
+  const OperatorProfile *GetOperator(const AbstractPlanNode *plan) const {
+    auto it = operators_.find(plan);
+    return it == operators_.end() ? nullptr : &it->second;
+  }
+
+  /**
+   * Render the plan tree with the metrics of every operator, one operator per line and children indented below their
+   * parent. Times are shown including the children and for the operator by itself.
+   * @param plan the root of the plan tree
+   * @return the rendered tree
+   */
+  std::string ToString(const AbstractPlanNode *plan) const;
+
+  /** @return the current time in clock ticks: cycles where a cycle counter is available, nanoseconds otherwise */
+  static uint64_t Now() {
+#if defined(__x86_64__) || defined(__i386__)
+    // Fence the counter read so it is neither hoisted above the work before it nor delayed past the work after it.
+    _mm_lfence();
+    uint64_t ticks = __rdtsc();
+    _mm_lfence();
+    return ticks;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+  }
+
+ private:
+  /** Append the lines of the subtree of plan to out. */
+  void Render(const AbstractPlanNode *plan, uint32_t depth, double ms_per_tick, std::string *out) const;
+
+  std::unordered_map<const AbstractPlanNode *, OperatorProfile> operators_;
+  /** Clock ticks and wall time when the profile was created, to convert ticks into time. */
+  uint64_t start_ticks_;
+  std::chrono::steady_clock::time_point start_time_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,173 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// result_cache.h
+//
+// Identification: src/include/execution/result_cache.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/util/hash_util.h"
+#include "execution/executor_context.h"
+#include "execution/plans/abstract_plan.h"
+#include "storage/table/table_heap.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/** The key of a cached result: the fingerprint of a plan and the values of its parameters. */
+struct ResultCacheKey {
+  std::string fingerprint_;
+  std::vector<Value> params_;
+
+  /** @return true if both keys have the same fingerprint and equal parameters, NULL equal to NULL */
+  bool operator==(const ResultCacheKey &other) const {
+    if (fingerprint_ != other.fingerprint_ || params_.size() != other.params_.size()) {
+      return false;
+    }
+    for (uint32_t i = 0; i < params_.size(); i++) {
+      if (params_[i].IsNull() || other.params_[i].IsNull()) {
+        if (params_[i].IsNull() != other.params_[i].IsNull()) {
+          return false;
+        }
+      } else if (params_[i].CompareEquals(other.params_[i]) != CmpBool::CmpTrue) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+}  // namespace bustub
+
+namespace std {
+
+/** Implements std::hash on ResultCacheKey. */
+template <>
+struct hash<bustub::ResultCacheKey> {
+  std::size_t operator()(const bustub::ResultCacheKey &key) const {
+    size_t curr_hash = std::hash<std::string>()(key.fingerprint_);
+    for (const auto &param : key.params_) {
+      if (!param.IsNull()) {
+        curr_hash = bustub::HashUtil::CombineHashes(curr_hash, bustub::HashUtil::HashValue(&param));
+      }
+    }
+    return curr_hash;
+  }
+};
+
+}  // namespace std
+
+namespace bustub {
+
+/** The counters of a result cache, see ResultCache::GetStats(). */
+struct ResultCacheStats {
+  /** The number of read-only queries answered from the cache, and of those that ran. */
+  uint64_t hits_{0};
+  uint64_t misses_{0};
+  /** The number of entries dropped because a table they read changed, and to make room. */
+  uint64_t invalidations_{0};
+  uint64_t evictions_{0};
+  /** The number of queries that write and ran without the cache. */
+  uint64_t uncacheable_{0};
+  /** The number of entries and the bytes they hold now. */
+  size_t entries_{0};
+  size_t memory_{0};
+
+  /** @return the fraction of the read-only queries answered from the cache */
+  double GetHitRate() const { return hits_ + misses_ == 0 ? 0 : static_cast<double>(hits_) / (hits_ + misses_); }
+};
+
+/**
+ * ResultCache keeps the results of read-only plans, so that a query that is repeated over tables that did not change
+ * is answered without running it.
+ *
+ * A result is keyed by the fingerprint of its plan and the values of its parameters. The fingerprint is a canonical
+ * description of the plan tree: the type and the fields of every node, its output schema and its expressions, in
+ * which every constant is a typed placeholder. Queries that differ only in their constants, e.g. WHERE id = 5 and
+ * WHERE id = 7, thus share a fingerprint, and the constants in the order of the plan are the parameters.
+ *
+ * Every entry records the modification count of each table its plan reads (see TableHeap::GetModificationCount()) as
+ * it was before the plan ran. A lookup drops the entry if a count moved since, so a result never outlives a write to
+ * its tables, including the writes made while it was computed. Like the executors, the cache does not tell committed
+ * from running transactions. The entries are evicted in LRU order to keep their bytes within the capacity.
+ */
+class ResultCache {
+ public:
+  /** The capacity of a cache by default. */
+  static constexpr size_t DEFAULT_CAPACITY = 64 * 1024 * 1024;
+
+  /** @param capacity the most bytes the cached results may hold */
+  explicit ResultCache(size_t capacity = DEFAULT_CAPACITY) : capacity_(capacity) {}
+
+  DISALLOW_COPY_AND_MOVE(ResultCache);
+
+  /** @return true if a plan only reads, so that its result may be cached */
+  static bool IsCacheable(const AbstractPlanNode *plan);
+
+  /**
+   * Compute the fingerprint of a plan.
+   * @param plan the root of the plan
+   * @param[out] params the values of the constants of the plan, in the order of their placeholders
+   * @return the fingerprint
+   */
+  static std::string Fingerprint(const AbstractPlanNode *plan, std::vector<Value> *params);
+
+  /**
+   * Run a plan, or take its result from the cache if it was run before and none of its tables changed since. The
+   * result of a read-only plan that ran is cached.
+   * @param exec_ctx the executor context to run the plan in
+   * @param plan the root of the plan
+   * @param[out] result the output tuples of the plan
+   * @return true if the result came from the cache
+   */
+  bool Execute(ExecutorContext *exec_ctx, const AbstractPlanNode *plan, std::vector<Tuple> *result);
+
+  /** Drop all entries. */
+  void Clear();
+
+  /** @return a snapshot of the counters */
+  ResultCacheStats GetStats();
+
+ private:
+  /** The modification count of every table a plan reads. */
+  using TableVersions = std::vector<std::pair<TableHeap *, uint64_t>>;
+
+  struct Entry {
+    ResultCacheKey key_;
+    TableVersions versions_;
+    std::vector<Tuple> tuples_;
+    /** The bytes the entry holds. */
+    size_t size_;
+  };
+
+  /** Collect the current modification counts of the tables a plan reads. */
+  static void CollectVersions(const AbstractPlanNode *plan, SimpleCatalog *catalog, TableVersions *versions);
+
+  /** Remove an entry; latch_ must be held. */
+  void Remove(std::list<Entry>::iterator entry);
+
+  const size_t capacity_;
+
+  /** Protects the members below. */
+  std::mutex latch_;
+  /** The entries, most recently used first. */
+  std::list<Entry> lru_;
+  std::unordered_map<ResultCacheKey, std::list<Entry>::iterator> entries_;
+  ResultCacheStats stats_;
+};
+
+}  // namespace bustub
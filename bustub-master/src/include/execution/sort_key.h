@@ -0,0 +1,73 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_key.h
+//
+// Identification: src/include/execution/sort_key.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "execution/plans/sort_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * SortKeyEncoder writes the order-by values of a tuple as a normalized key: comparing two keys with memcmp gives the
+ * order of the tuples. Every key column is a NULL flag byte followed by the value big-endian with the sign bit flipped
+ * (integers, timestamps), or the IEEE bits adjusted so negative numbers sort first (decimals), or the first
+ * VARCHAR_PREFIX bytes zero-padded (varchars); descending columns are inverted.
+ *
+ * Only truncated varchars can make the keys of two different tuples compare equal. If IsTruncating(), equal keys must
+ * be broken with CompareValues().
+ */
+class SortKeyEncoder {
+ public:
+  /** Number of leading bytes of a VARCHAR that go into the normalized key. */
+  static constexpr uint32_t VARCHAR_PREFIX = 16;
+
+  /**
+   * @param schema the schema of the tuples to encode
+   * @param order_bys the order-by keys, evaluated against schema
+   */
+  SortKeyEncoder(const Schema *schema, const std::vector<OrderBy> &order_bys);
+
+  /** @return the width of the normalized key */
+  uint32_t GetKeyWidth() const { return key_width_; }
+
+  /** @return true if equal keys do not imply equal order-by values */
+  bool IsTruncating() const { return has_varchar_; }
+
+  /**
+   * Write the normalized key of a tuple.
+   * @param tuple a tuple of the schema
+   * @param[out] key GetKeyWidth() bytes
+   */
+  void Encode(const Tuple &tuple, char *key) const;
+
+  /** @return <0, 0 or >0 as key a sorts before, with or after key b */
+  int CompareKeys(const char *a, const char *b) const { return memcmp(a, b, key_width_); }
+
+  /** @return <0, 0 or >0 as tuple a sorts before, with or after tuple b, comparing the order-by values in full */
+  int CompareValues(const Tuple &a, const Tuple &b) const;
+
+ private:
+  const Schema *schema_;
+  const std::vector<OrderBy> &order_bys_;
+  /** Offset of every order-by key in the normalized key. */
+  std::vector<uint32_t> key_offsets_;
+  uint32_t key_width_{0};
+  /** True if some key is a VARCHAR, whose normalized form may be truncated. */
+  bool has_varchar_{false};
+};
+
+}  // namespace bustub
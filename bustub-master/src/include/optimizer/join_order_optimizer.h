@@ -0,0 +1,164 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_order_optimizer.h
+//
+// Identification: src/include/optimizer/join_order_optimizer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "catalog/simple_catalog.h"
+#include "catalog/table_stats.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/**
+ * JoinOrderOptimizer picks the order of a multi-way equi-join and the build side of every hash join in it.
+ *
+ * The relations to join are added as plan nodes and the join predicates as pairs of equal columns. Optimize() then
+ * runs a dynamic program over the subsets of the relations, bottom up: the best plan for a subset is the cheapest hash
+ * join of the best plans for two of its halves, either of which may build. Only halves connected by a predicate are
+ * joined, so cross products appear only between parts of the join graph that no predicate connects.
+ *
+ * Cardinalities come from the statistics of the catalog (see SimpleCatalog::AnalyzeTable()). A sequential scan of an
+ * analyzed table has the row count of the table times the selectivity of its predicate, estimated from the column
+ * histograms; other relations, and scans of tables never analyzed, get DEFAULT_CARDINALITY rows. Every join predicate
+ * keeps 1 / max(NDV) of the pairs, where the number of distinct values (NDV) of a column is capped by the rows of its
+ * relation. The cost of a join is the cost of its inputs plus 2 per build row, 1 per probe row and 1 per output row.
+ *
+ * The output of every join, including the root, holds the columns of its relations in the order of the relations, see
+ * GetOutputColumnIdx(). The plan nodes, schemas and expressions created are owned by the optimizer.
+ */
+class JoinOrderOptimizer {
+ public:
+  /** The most relations a join may have; the dynamic program takes O(3^n) steps. */
+  static constexpr uint32_t MAX_RELATIONS = 16;
+  /** The rows assumed for a relation without statistics. */
+  static constexpr double DEFAULT_CARDINALITY = 1000;
+  /** The selectivity assumed for a predicate the statistics cannot estimate. */
+  static constexpr double DEFAULT_SELECTIVITY = 1.0 / 3;
+
+  /** @param catalog the catalog the tables and their statistics are looked up in */
+  explicit JoinOrderOptimizer(SimpleCatalog *catalog) : catalog_(catalog) {}
+
+  /**
+   * Add a relation to the join.
+   * @param plan the plan producing the relation, usually a sequential scan
+   * @return the index of the relation, counting from 0 in the order they were added
+   */
+  uint32_t AddRelation(const AbstractPlanNode *plan);
+
+  /**
+   * Add an equi-join predicate, left.left_col = right.right_col.
+   * @param left the index of a relation
+   * @param left_col the index of the column in the output schema of that relation
+   * @param right the index of another relation
+   * @param right_col the index of the column in the output schema of that relation
+   */
+  void AddJoinPredicate(uint32_t left, uint32_t left_col, uint32_t right, uint32_t right_col);
+
+  /**
+   * Pick the join order and build the plan.
+   * @return the root of the plan joining all relations
+   */
+  const AbstractPlanNode *Optimize();
+
+  /** @return the index in the output of the join of a column of a relation */
+  uint32_t GetOutputColumnIdx(uint32_t relation, uint32_t col) const;
+
+  /** @return the estimated rows of a relation on its own, including its predicate */
+  double GetEstimatedCardinality(uint32_t relation) const { return relations_[relation].cardinality_; }
+
+  /** @return the estimated rows of the whole join */
+  double GetEstimatedCardinality() const { return EstimateCardinality(AllRelations()); }
+
+  /**
+   * Estimate the selectivity of a predicate on a table.
+   * @param predicate a predicate over the columns of the table, i.e. tuple 0 in the table schema
+   * @param stats the statistics of the table
+   * @return the estimated fraction of the rows that satisfy the predicate
+   */
+  static double EstimateSelectivity(const AbstractExpression *predicate, const TableStats &stats);
+
+ private:
+  /** A set of relations, one bit per relation. */
+  using RelationSet = uint32_t;
+
+  struct Relation {
+    const AbstractPlanNode *plan_;
+    double cardinality_;
+    /** The statistics of every output column, nullptr where they are unknown. */
+    std::vector<const ColumnStats *> column_stats_;
+    /** The relations it shares a predicate with. */
+    RelationSet neighbors_{0};
+  };
+
+  struct JoinPredicate {
+    uint32_t left_;
+    uint32_t left_col_;
+    uint32_t right_;
+    uint32_t right_col_;
+    /** The fraction of the pairs of rows that satisfy the predicate. */
+    double selectivity_;
+  };
+
+  /** The best plan found for a set of relations. */
+  struct JoinPlan {
+    bool valid_{false};
+    /** True if the predicates connect all relations of the set. */
+    bool connected_{false};
+    double cost_{0};
+    /** The relations of the build (left) and probe (right) side, 0 for a single relation. */
+    RelationSet build_{0};
+    RelationSet probe_{0};
+  };
+
+  RelationSet AllRelations() const { return (RelationSet{1} << relations_.size()) - 1; }
+
+  /** @return the estimated distinct values of a column of a relation */
+  double EstimateDistinct(uint32_t relation, uint32_t col) const;
+
+  /** @return the estimated rows of the join of a set of relations, counted from scratch */
+  double EstimateCardinality(RelationSet set) const;
+
+  /** @return true if a predicate connects the two sets */
+  bool Connected(RelationSet a, RelationSet b) const;
+
+  /**
+   * Create the plan of a set of relations from the best plans in plans_.
+   * @param set the relations
+   * @param[out] columns the relation and column of every output column
+   * @return the plan
+   */
+  const AbstractPlanNode *BuildPlan(RelationSet set, std::vector<std::pair<uint32_t, uint32_t>> *columns);
+
+  /** @return a new expression owned by the optimizer */
+  const AbstractExpression *Own(std::unique_ptr<AbstractExpression> expr) {
+    expressions_.emplace_back(std::move(expr));
+    return expressions_.back().get();
+  }
+
+  SimpleCatalog *catalog_;
+  std::vector<Relation> relations_;
+  std::vector<JoinPredicate> predicates_;
+  /** The best plan and the estimated rows of every set of relations, indexed by the set. */
+  std::vector<JoinPlan> plans_;
+  std::vector<double> cardinalities_;
+
+  std::vector<std::unique_ptr<AbstractExpression>> expressions_;
+  std::vector<std::unique_ptr<Schema>> schemas_;
+  std::vector<std::unique_ptr<AbstractPlanNode>> plan_nodes_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,128 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// projection_pushdown.h
+//
+// Identification: src/include/optimizer/projection_pushdown.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/hash_join_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+
+namespace bustub {
+
+/**
+ * ProjectionPushdown narrows the scans of a plan to the columns the operators above them use.
+ *
+ * A scan materializes every column of its output schema for every tuple it returns, and plans often project whole
+ * rows, e.g. the joins built by JoinOrderOptimizer output all columns of their relations. The rewrite walks the plan
+ * from the root and passes down which output columns are used: all of them at the root, the columns of the group-bys
+ * and aggregates below an aggregation, and below a hash join the columns of its keys, of its predicate and of the
+ * output columns used above it. The scans keep only the used columns, and the expressions above them are rewritten
+ * to the new column indexes. The rewrite descends through hash joins and aggregations; other plan nodes keep their
+ * subtrees as they are.
+ *
+ * With late materialization, a hash join input that is a sequential scan carries only the columns of the keys and of
+ * the predicate, plus the RID of the row (see RowIdExpression). The other table columns the join outputs are fetched
+ * by a LateMaterializePlanNode above the join, for the rows that survive it. That trades a narrower build side and
+ * narrower intermediate tuples for a second read of the surviving rows, which pays off for selective joins of wide
+ * rows.
+ *
+ * The input plan is not modified. The plan nodes, schemas and expressions created are owned by the optimizer.
+ */
+class ProjectionPushdown {
+ public:
+  /** @param late_materialize true to defer the columns only a hash join outputs, see above */
+  explicit ProjectionPushdown(bool late_materialize = false) : late_materialize_(late_materialize) {}
+
+  /**
+   * Rewrite a plan.
+   * @param plan the root of the plan
+   * @return the root of the rewritten plan, which has the same output schema
+   */
+  const AbstractPlanNode *Optimize(const AbstractPlanNode *plan);
+
+ private:
+  /** The mapping of an output column that the rewritten plan does not produce. */
+  static constexpr uint32_t DROPPED = UINT32_MAX;
+
+  /**
+   * Rewrite a plan to produce the used columns.
+   * @param plan the plan
+   * @param used true for every output column of the plan that is used
+   * @param[out] mapping the index in the output of the rewritten plan of every output column of the plan, DROPPED
+   * for the columns it does not produce; every used column is produced
+   * @return the rewritten plan, plan itself if nothing changed
+   */
+  const AbstractPlanNode *Prune(const AbstractPlanNode *plan, const std::vector<bool> &used,
+                                std::vector<uint32_t> *mapping);
+
+  /** @param with_rid true to add the RID of the row as the last output column, see Prune() */
+  const AbstractPlanNode *PruneSeqScan(const SeqScanPlanNode *plan, const std::vector<bool> &used, bool with_rid,
+                                       std::vector<uint32_t> *mapping);
+
+  /** See Prune(). */
+  const AbstractPlanNode *PruneHashJoin(const HashJoinPlanNode *plan, const std::vector<bool> &used,
+                                        std::vector<uint32_t> *mapping);
+
+  /** See Prune(). */
+  const AbstractPlanNode *PruneAggregation(const AggregationPlanNode *plan, std::vector<uint32_t> *mapping);
+
+  /**
+   * Mark the columns an expression reads.
+   * @param expr the expression
+   * @param side the input the expression is evaluated on, or -1 if it is evaluated on a join and reads the input of
+   * the tuple index of each column
+   * @param[out] used the used columns of every input
+   */
+  static void Collect(const AbstractExpression *expr, int side, std::vector<std::vector<bool>> *used);
+
+  /**
+   * Rewrite an expression to the new column indexes of its inputs.
+   * @param expr the expression
+   * @param side see Collect()
+   * @param mappings the mapping of every input, see Prune()
+   * @return the rewritten expression, expr itself if nothing changed
+   */
+  const AbstractExpression *Remap(const AbstractExpression *expr, int side,
+                                  const std::vector<std::vector<uint32_t>> &mappings);
+
+  /** @return a new schema owned by the optimizer */
+  const Schema *OwnSchema(const std::vector<Column> &columns) {
+    schemas_.emplace_back(std::make_unique<Schema>(columns));
+    return schemas_.back().get();
+  }
+
+  /** @return a new expression owned by the optimizer */
+  const AbstractExpression *Own(std::unique_ptr<AbstractExpression> expr) {
+    expressions_.emplace_back(std::move(expr));
+    return expressions_.back().get();
+  }
+
+  /** @return a new plan node owned by the optimizer */
+  const AbstractPlanNode *Own(std::unique_ptr<AbstractPlanNode> plan) {
+    plan_nodes_.emplace_back(std::move(plan));
+    return plan_nodes_.back().get();
+  }
+
+  bool late_materialize_;
+  std::vector<std::unique_ptr<AbstractExpression>> expressions_;
+  std::vector<std::unique_ptr<Schema>> schemas_;
+  std::vector<std::unique_ptr<AbstractPlanNode>> plan_nodes_;
+};
+
+}  // namespace bustub
@@ -12,7 +12,10 @@
 
 #pragma once
 
+#include <chrono>  // NOLINT
+
 #include "buffer/buffer_pool_manager.h"
+#include "common/task_pool.h"
 #include "concurrency/transaction_manager.h"
 #include "recovery/log_manager.h"
 
@@ -29,15 +32,25 @@ class CheckpointManager {
         log_manager_(log_manager),
         buffer_pool_manager_(buffer_pool_manager) {}
 
-  ~CheckpointManager() = default;
+  ~CheckpointManager() { StopPeriodicCheckpoints(); }
 
   void BeginCheckpoint();
   void EndCheckpoint();
 
+  /**
+   * Take a checkpoint periodically, as a background task of the shared TaskPool.
+   * @param interval the time from the end of a checkpoint to the start of the next
+   */
+  void StartPeriodicCheckpoints(std::chrono::milliseconds interval);
+
+  /** Stop the periodic checkpoints, waiting for one in progress. */
+  void StopPeriodicCheckpoints();
+
  private:
   TransactionManager *transaction_manager_ __attribute__((__unused__));
   LogManager *log_manager_ __attribute__((__unused__));
   BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  periodic_task_id_t checkpoint_task_{TaskPool::NO_PERIODIC_TASK};
 };
 
 }  // namespace bustub
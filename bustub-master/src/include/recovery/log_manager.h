@@ -13,18 +13,18 @@
 #pragma once
 
 #include <algorithm>
-#include <condition_variable>  // NOLINT
-#include <future>              // NOLINT
-#include <mutex>               // NOLINT
+#include <future>  // NOLINT
+#include <mutex>   // NOLINT
 
+#include "common/task_pool.h"
 #include "recovery/log_record.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
 /**
- * LogManager maintains a separate thread that is awakened whenever the log buffer is full or whenever a timeout
- * happens. When the thread is awakened, the log buffer's content is written into the disk log file.
+ * LogManager writes the log buffer's content into the disk log file from a periodic background task of the shared
+ * TaskPool, every log_timeout, and on the calling thread whenever the log buffer is full or a flush is forced.
  */
 class LogManager {
  public:
@@ -36,6 +36,9 @@ class LogManager {
   }
 
   ~LogManager() {
+    if (flush_task_ != TaskPool::NO_PERIODIC_TASK) {
+      StopFlushThread();
+    }
     delete[] log_buffer_;
     delete[] flush_buffer_;
     log_buffer_ = nullptr;
@@ -56,6 +59,9 @@ class LogManager {
   inline char *GetLogBuffer() { return log_buffer_; }
 
  private:
+  /** Write the log buffer to the log file and advance the persistent LSN. */
+  void Flush();
+
   // TODO(students): you may add your own member variables
 
   /** The atomic counter which records the next log sequence number. */
@@ -69,9 +75,11 @@ class LogManager {
 
   std::mutex latch_;
 
-  std::thread *flush_thread_ __attribute__((__unused__));
+  /** Serializes the flushes, which swap the buffers. */
+  std::mutex flush_latch_;
+  /** The periodic flush task, see RunFlushThread(). */
+  periodic_task_id_t flush_task_{TaskPool::NO_PERIODIC_TASK};
   std::shared_future<void> flush_future_;
-  std::condition_variable cv_;
 
   DiskManager *disk_manager_ __attribute__((__unused__));
 };
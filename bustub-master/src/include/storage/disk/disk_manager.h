@@ -13,9 +13,14 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <fstream>
 #include <future>  // NOLINT
+#include <mutex>   // NOLINT
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/config.h"
 
@@ -33,7 +38,8 @@ class DiskManager {
    */
   explicit DiskManager(const std::string &db_file);
 
-  ~DiskManager() = default;
+  /** Stop the I/O threads, after the reads queued on them. */
+  ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
@@ -54,6 +60,15 @@ class DiskManager {
    */
   void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Read a page from the database file on a background I/O thread, so that the caller can do other work, or issue
+   * other reads, until it needs the page. The I/O threads are started by the first call.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, which must stay valid until the read completes
+   * @return a future that becomes ready once the page is in page_data
+   */
+  std::shared_future<void> ReadPageAsync(page_id_t page_id, char *page_data);
+
   /**
    * Append a log entry to the log file.
    * @param log_data raw log data
@@ -91,6 +106,9 @@ class DiskManager {
   /** @return the number of disk writes */
   int GetNumWrites() const;
 
+  /** @return the number of page reads, e.g. to measure the physical reads of scans */
+  int GetNumReads() const { return num_reads_; }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -101,6 +119,19 @@ class DiskManager {
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
  private:
+  /** The number of threads that serve ReadPageAsync(); reads of different pages proceed in parallel on the device. */
+  static constexpr size_t NUM_IO_THREADS = 8;
+
+  /** A read queued by ReadPageAsync(). */
+  struct ReadRequest {
+    page_id_t page_id_;
+    char *page_data_;
+    std::promise<void> done_;
+  };
+
+  /** The loop of an I/O thread. */
+  void RunIoThread();
+
   int GetFileSize(const std::string &file_name);
   // stream to write log file
   std::fstream log_io_;
@@ -111,8 +142,18 @@ class DiskManager {
   std::atomic<page_id_t> next_page_id_;
   int num_flushes_;
   int num_writes_;
+  /** Atomic, as the buffer pool reads pages outside its latch. */
+  std::atomic<int> num_reads_{0};
   bool flush_log_;
   std::future<void> *flush_log_f_;
+  /** A descriptor of the db file for the I/O threads, which read with pread() and so share no file position. */
+  int read_fd_{-1};
+  std::vector<std::thread> io_threads_;
+  /** Protects io_queue_ and io_shutdown_. */
+  std::mutex io_latch_;
+  std::condition_variable io_cv_;
+  std::deque<ReadRequest> io_queue_;
+  bool io_shutdown_{false};
 };
 
 }  // namespace bustub
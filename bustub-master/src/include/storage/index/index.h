@@ -130,7 +130,8 @@ class Index {
   // Point Modification
   ///////////////////////////////////////////////////////////////////
   // designed for secondary indexes.
-  virtual void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) = 0;
+  // returns false if the index could not take the entry, e.g. because it is full
+  virtual bool InsertEntry(const Tuple &key, RID rid, Transaction *transaction) = 0;
 
   // delete the index entry linked to given tuple
   virtual void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) = 0;
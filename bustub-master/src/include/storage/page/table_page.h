@@ -137,6 +137,18 @@ class TablePage : public Page {
    */
   bool GetNextTupleRid(const RID &cur_rid, RID *next_rid);
 
+  /** @return the number of slots in this page, some of which may be deleted or empty */
+  uint32_t GetSlotCount() { return GetTupleCount(); }
+
+  /**
+   * Get a view of a slot of this page without copying the tuple. No lock is taken on the tuple.
+   * The caller must keep the page pinned, and protected from writers, for as long as the view is used.
+   * @param slot_num the slot to read
+   * @param[out] view the view of the tuple bytes inside the page
+   * @return true if the slot holds a live tuple
+   */
+  bool GetTupleView(uint32_t slot_num, TupleView *view);
+
  private:
   static_assert(sizeof(page_id_t) == 4);
 
@@ -1,15 +1,14 @@
 #pragma once
 
+#include <cstring>
+
 #include "storage/page/page.h"
 #include "storage/table/tmp_tuple.h"
 #include "storage/table/tuple.h"
+#include "storage/table/tuple_view.h"
 
 namespace bustub {
 
-// To pass the test cases for this class, you must follow the existing TmpTuplePage format and implement the
-// existing functions exactly as they are! It may be helpful to look at TablePage.
-// Remember that this task is optional, you get full credit if you finish the next task.
-
 /**
  * TmpTuplePage format:
  *
@@ -17,17 +16,76 @@ namespace bustub {
  * | PageId (4) | LSN (4) | FreeSpace (4) | (free space) | TupleSize2 | TupleData2 | TupleSize1 | TupleData1 |
  *
  * We choose this format because DeserializeExpression expects to read Size followed by Data.
+ *
+ * FreeSpace is the offset of the most recently inserted record, i.e. the end of the free space. Records can be read
+ * back by walking from FreeSpace to the end of the page. Temporary pages are private to the operator that wrote them
+ * and are never logged.
  */
 class TmpTuplePage : public Page {
  public:
-  void Init(page_id_t page_id, uint32_t page_size) {}
+  /** Initialize an empty page. */
+  void Init(page_id_t page_id, uint32_t page_size) {
+    memcpy(GetData() + OFFSET_PAGE_ID, &page_id, sizeof(page_id_t));
+    lsn_t lsn = INVALID_LSN;
+    memcpy(GetData() + OFFSET_LSN, &lsn, sizeof(lsn_t));
+    SetFreeSpacePointer(page_size);
+  }
+
+  /** @return the page id stored in the page */
+  page_id_t GetTablePageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_PAGE_ID); }
 
-  page_id_t GetTablePageId() { return INVALID_PAGE_ID; }
+  /**
+   * Insert a tuple.
+   * @param tuple the tuple to insert
+   * @param[out] out where the record was stored
+   * @return false if the page is full
+   */
+  bool Insert(const Tuple &tuple, TmpTuple *out) { return Insert(tuple.GetData(), tuple.GetLength(), out); }
 
-  bool Insert(const Tuple &tuple, TmpTuple *out) { return false; }
+  /**
+   * Insert a record of raw bytes.
+   * @param data the bytes to insert
+   * @param size the number of bytes
+   * @param[out] out where the record was stored
+   * @return false if the page is full
+   */
+  bool Insert(const char *data, uint32_t size, TmpTuple *out) {
+    uint32_t free_space_pointer = GetFreeSpacePointer();
+    if (free_space_pointer < SIZE_HEADER + sizeof(uint32_t) + size) {
+      return false;
+    }
+    free_space_pointer -= sizeof(uint32_t) + size;
+    memcpy(GetData() + free_space_pointer, &size, sizeof(uint32_t));
+    memcpy(GetData() + free_space_pointer + sizeof(uint32_t), data, size);
+    SetFreeSpacePointer(free_space_pointer);
+    *out = TmpTuple(GetTablePageId(), free_space_pointer);
+    return true;
+  }
+
+  /** @return the offset of the most recently inserted record, or the page size if the page is empty */
+  uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
+
+  /**
+   * Read a record.
+   * @param offset the offset of the record, as returned in TmpTuple
+   * @return a view of the record bytes, valid while the page is pinned
+   */
+  TupleView Get(uint32_t offset) {
+    uint32_t size;
+    memcpy(&size, GetData() + offset, sizeof(uint32_t));
+    return TupleView(GetData() + offset + sizeof(uint32_t), size, RID());
+  }
 
  private:
   static_assert(sizeof(page_id_t) == 4);
+  static constexpr uint32_t OFFSET_PAGE_ID = 0;
+  static constexpr uint32_t OFFSET_LSN = 4;
+  static constexpr uint32_t OFFSET_FREE_SPACE = 8;
+  static constexpr uint32_t SIZE_HEADER = 12;
+
+  void SetFreeSpacePointer(uint32_t free_space_pointer) {
+    memcpy(GetData() + OFFSET_FREE_SPACE, &free_space_pointer, sizeof(uint32_t));
+  }
 };
 
 }  // namespace bustub
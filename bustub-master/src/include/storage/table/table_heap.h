@@ -12,7 +12,14 @@
 
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/coroutine_scheduler.h"
+#include "catalog/schema.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
 #include "storage/table/table_iterator.h"
@@ -20,6 +27,8 @@
 
 namespace bustub {
 
+class CompiledPredicate;
+
 /**
  * TableHeap represents a physical table on disk.
  * This is just a doubly-linked list of pages.
@@ -99,6 +108,116 @@ class TableHeap {
    */
   bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn);
 
+  /**
+   * Called by Scan for every qualifying tuple. The callee owns the tuple and may move from it.
+   * @return false to stop the scan
+   */
+  using ScanCallback = std::function<bool(Tuple *tuple)>;
+
+  /**
+   * Evaluated by ScanPage and FetchSlots on the raw tuples that pass the predicate, before they are materialized, e.g.
+   * to apply a Bloom filter pushed down from a join.
+   * @return false to drop the tuple
+   */
+  using RowFilter = std::function<bool(const Tuple &tuple)>;
+
+  /**
+   * Scan the whole table, evaluating the predicate in place on the bytes of the read-latched page.
+   * Only tuples that pass the predicate are materialized, and only with the columns of the projection.
+   * @param schema the schema of the table
+   * @param predicate predicate compiled against schema, nullptr to accept every tuple
+   * @param projection output schema whose column expressions are evaluated against schema, nullptr to copy the tuple
+   * @param callback called for every qualifying tuple, in table order
+   * @param txn transaction performing the scan
+   */
+  void Scan(const Schema *schema, const CompiledPredicate *predicate, const Schema *projection,
+            const ScanCallback &callback, Transaction *txn);
+
+  /**
+   * Scan a single page of the table, see Scan. The page is pinned and latched exactly once.
+   * @param page_id the page to scan
+   * @param schema the schema of the table
+   * @param predicate predicate compiled against schema, nullptr to accept every tuple
+   * @param projection output schema whose column expressions are evaluated against schema, nullptr to copy the tuple
+   * @param callback called for every qualifying tuple, in slot order
+   * @param txn transaction performing the scan, which is aborted if the page cannot be fetched; nullptr to take no
+   * locks and leave a failure to the caller, e.g. for scans on several threads
+   * @param[out] next_page_id the page following page_id, INVALID_PAGE_ID at the end of the table
+   * @param row_filter evaluated on the tuples that pass the predicate, nullptr to accept them all
+   * @param ring the ring to read the page into if it is not resident, nullptr to read it like any other page
+   * @return false if the callback stopped the scan or the scan failed
+   */
+  bool ScanPage(page_id_t page_id, const Schema *schema, const CompiledPredicate *predicate, const Schema *projection,
+                const ScanCallback &callback, Transaction *txn, page_id_t *next_page_id,
+                const RowFilter *row_filter = nullptr, BufferRing *ring = nullptr);
+
+  /**
+   * Read the given slots of a single page, see Scan. The page is pinned and latched exactly once however many slots
+   * are read, e.g. for the RIDs an index lookup produced on that page.
+   * @param page_id the page to read
+   * @param slots the slots to read, in the order the callback should see them; empty or deleted slots are skipped
+   * @param schema the schema of the table
+   * @param predicate predicate compiled against schema, nullptr to accept every tuple
+   * @param projection output schema whose column expressions are evaluated against schema, nullptr to copy the tuple
+   * @param callback called for every qualifying tuple
+   * @param txn transaction performing the read
+   * @param row_filter evaluated on the tuples that pass the predicate, nullptr to accept them all
+   * @return false if the callback stopped the read or the read failed
+   */
+  bool FetchSlots(page_id_t page_id, const std::vector<uint32_t> &slots, const Schema *schema,
+                  const CompiledPredicate *predicate, const Schema *projection, const ScanCallback &callback,
+                  Transaction *txn, const RowFilter *row_filter = nullptr);
+
+#ifdef BUSTUB_COROUTINES
+  /**
+   * FetchSlots for a coroutine run by a CoroutineScheduler: while the page is read from disk the coroutine suspends
+   * and the scheduler runs others. The slots, schemas, predicate and row filter must stay valid until the task ends.
+   * @return see FetchSlots
+   */
+  Task<bool> FetchSlotsAsync(CoroutineScheduler *scheduler, page_id_t page_id, const std::vector<uint32_t> &slots,
+                             const Schema *schema, const CompiledPredicate *predicate, const Schema *projection,
+                             ScanCallback callback, Transaction *txn, const RowFilter *row_filter = nullptr);
+#endif
+
+  /**
+   * Collect the pages of the table, e.g. to hand them out as units of work to parallel scans.
+   * @param txn transaction performing the read
+   * @return the ids of the pages of the table, in table order
+   */
+  std::vector<page_id_t> GetPageIds(Transaction *txn);
+
+  /**
+   * @param txn transaction performing the read
+   * @return the number of pages of the table
+   */
+  size_t GetNumPages(Transaction *txn);
+
+  /**
+   * Look up a page by its position without walking the pages before it, e.g. to read random pages of the table.
+   * @param idx the position of the page in table order, below GetNumPages()
+   * @return the id of the page
+   */
+  page_id_t GetPageId(size_t idx);
+
+  /**
+   * Start a sequential scan that shares its page reads with the scans of this table in progress, like synchronized
+   * scans in PostgreSQL. If another scan is running and the table is too large to stay resident in the buffer pool,
+   * the scan starts at the page that scan reported last: the two then read the same pages at about the same time, so
+   * each page is read from disk once for both. The scan wraps around from the last page of the table to the first one
+   * and stops when it is back at the page it started at. Call EndSharedScan() once the scan stops.
+   * @param txn transaction performing the scan
+   * @param ordered true if the scan must return the tuples in table order: it then starts at the first page and never
+   * attaches, though later scans may still attach to it
+   * @return the page to start at, the first page of the table unless the scan attaches to another
+   */
+  page_id_t StartSharedScan(Transaction *txn, bool ordered = false);
+
+  /** Report the page a shared scan is about to read, for the scans that start later to attach to. */
+  void ReportScanPosition(page_id_t page_id) { scan_position_.store(page_id); }
+
+  /** Unregister a scan started with StartSharedScan(). */
+  void EndSharedScan();
+
   /** @return the begin iterator of this table */
   TableIterator Begin(Transaction *txn);
 
@@ -108,11 +227,53 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /**
+   * @return the number of writes to this table so far: inserts, deletes, updates and their rollbacks. A write counts
+   * once its change is on the page, so a reader that sees the same count before and after a read saw no write.
+   */
+  uint64_t GetModificationCount() const { return modification_count_.load(); }
+
+  /** Count a write to data derived from this table, such as its indexes, as a write to the table. */
+  void MarkModified() { modification_count_++; }
+
  private:
+  /** Read the given slots of a pinned page for FetchSlots and FetchSlotsAsync. */
+  bool ReadSlots(TablePage *page, const std::vector<uint32_t> &slots, const Schema *schema,
+                 const CompiledPredicate *predicate, const Schema *projection, const ScanCallback &callback,
+                 Transaction *txn, const RowFilter *row_filter);
+
+  /**
+   * Evaluate the predicate on one slot of a read-latched page and hand the tuple to the callback if it qualifies.
+   * @param values scratch space for the projected values
+   * @return false if the callback stopped the scan or the tuple could not be locked
+   */
+  bool ScanSlot(TablePage *page, uint32_t slot, const Schema *schema, const CompiledPredicate *predicate,
+                const Schema *projection, const ScanCallback &callback, Transaction *txn, const RowFilter *row_filter,
+                std::vector<Value> *values);
+
+  /** Fill the page directory by walking the pages of a table that was opened. directory_latch_ must be held. */
+  void LoadPageDirectory(Transaction *txn);
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+
+  /** Guards the page directory. */
+  std::mutex directory_latch_;
+  /** The page directory: the ids of the pages of the table in table order, kept up to date as pages are appended. */
+  std::vector<page_id_t> page_ids_;
+  /** False until the directory of a table that was opened rather than created has been filled. */
+  bool directory_loaded_{false};
+
+  /** A scan only attaches to another if the table takes at least 1/SHARED_SCAN_POOL_FRACTION of the buffer pool. */
+  static constexpr size_t SHARED_SCAN_POOL_FRACTION = 4;
+  /** The number of shared scans running. */
+  std::atomic<uint32_t> num_shared_scans_{0};
+  /** The page a shared scan reported last, INVALID_PAGE_ID if none is running. */
+  std::atomic<page_id_t> scan_position_{INVALID_PAGE_ID};
+  /** The number of writes, see GetModificationCount(). */
+  std::atomic<uint64_t> modification_count_{0};
 };
 
 }  // namespace bustub
@@ -21,9 +21,16 @@
 namespace bustub {
 
 class TableHeap;
+class TablePage;
 
 /**
  * TableIterator enables the sequential scan of a TableHeap.
+ *
+ * The iterator pins the page it is positioned on once and keeps it pinned until it moves past the last slot of that
+ * page, so stepping within a page costs no buffer pool round trip. The tuple it yields is copied out of the page while
+ * the page latch is held, into a buffer the iterator reuses; it stays valid until the iterator is advanced or
+ * destroyed. Copy the tuple to keep it longer. The page latch is only held while the iterator looks for the next live
+ * slot. A page that cannot be fetched aborts the transaction and ends the iteration.
  */
 class TableIterator {
   friend class Cursor;
@@ -31,30 +38,20 @@ class TableIterator {
  public:
   TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
 
-  TableIterator() {
-    table_heap_ = nullptr;
-    tuple_ = nullptr;
-    txn_ = nullptr;
-  }
+  TableIterator() = default;
 
-  ~TableIterator() { if (tuple_) delete tuple_; }
+  ~TableIterator();
 
-  TableIterator(const TableIterator &itr) {
-    table_heap_ = itr.table_heap_;
-    txn_ = itr.txn_;
-    tuple_ = new Tuple(*itr.tuple_);
-  }
+  /** Copies share the position; each copy holds its own pin on the current page. */
+  TableIterator(const TableIterator &itr);
 
-  TableIterator& operator=(const TableIterator& itr) {
-    table_heap_ = itr.table_heap_;
-    txn_ = itr.txn_;
-    tuple_ = new Tuple(*itr.tuple_);
-    return *this;
-  }
+  TableIterator(TableIterator &&itr) noexcept;
 
-  inline bool operator==(const TableIterator &itr) const { 
-    return tuple_->rid_.Get() == itr.tuple_->rid_.Get();
-  }
+  TableIterator &operator=(const TableIterator &itr);
+
+  TableIterator &operator=(TableIterator &&itr) noexcept;
+
+  inline bool operator==(const TableIterator &itr) const { return tuple_.rid_.Get() == itr.tuple_.rid_.Get(); }
 
   inline bool operator!=(const TableIterator &itr) const { return !(*this == itr); }
 
@@ -67,9 +64,21 @@ class TableIterator {
   TableIterator operator++(int);
 
  private:
-  TableHeap *table_heap_;
-  Tuple *tuple_;
-  Transaction *txn_;
+  /** Position the iterator on the first live tuple at or after (page_id, slot_num), or at the end of the table. */
+  void Seek(page_id_t page_id, uint32_t slot_num);
+
+  /** Copy a tuple of page_ into tuple_; the page latch must be held. */
+  void CopyTuple(const TupleView &view);
+
+  /** Drop the pin on the current page, if any. */
+  void ReleasePage();
+
+  TableHeap *table_heap_{nullptr};
+  /** The page the iterator is positioned on, pinned by this iterator. nullptr at the end of the table. */
+  TablePage *page_{nullptr};
+  /** A copy of the current tuple. Its RID is invalid at the end of the table. */
+  Tuple tuple_{RID(INVALID_PAGE_ID, 0)};
+  Transaction *txn_{nullptr};
 };
 
 }  // namespace bustub
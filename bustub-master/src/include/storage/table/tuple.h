@@ -17,6 +17,7 @@
 
 #include "catalog/schema.h"
 #include "common/rid.h"
+#include "storage/table/tuple_view.h"
 #include "type/value.h"
 
 namespace bustub {
@@ -42,7 +43,11 @@ class Tuple {
   explicit Tuple(RID rid) : rid_(rid) {}
 
   // constructor for creating a new tuple based on input value
-  Tuple(std::vector<Value> values, const Schema *schema);
+  Tuple(const std::vector<Value> &values, const Schema *schema);
+
+  // constructor for a non-owning tuple that references the bytes of a view, no copy is made
+  explicit Tuple(const TupleView &view)
+      : rid_(view.GetRid()), size_(view.GetLength()), data_(const_cast<char *>(view.GetData())) {}
 
   // copy constructor, deep copy
   Tuple(const Tuple &other);
@@ -50,6 +55,12 @@ class Tuple {
   // assign operator, deep copy
   Tuple &operator=(const Tuple &other);
 
+  // move constructor, takes over the buffer of other
+  Tuple(Tuple &&other) noexcept;
+
+  // move assign operator, takes over the buffer of other
+  Tuple &operator=(Tuple &&other) noexcept;
+
   ~Tuple() {
     if (allocated_) {
       delete[] data_;
@@ -66,6 +77,9 @@ class Tuple {
   // return RID of current tuple
   inline RID GetRid() const { return rid_; }
 
+  // return a non-owning view of this tuple, valid as long as the tuple
+  inline TupleView GetView() const { return TupleView(data_, size_, rid_); }
+
   // Get the address of this tuple in the table's backing store
   inline char *GetData() const { return data_; }
 
@@ -76,6 +90,9 @@ class Tuple {
   // checks the schema to see how to return the Value.
   Value GetValue(const Schema *schema, uint32_t column_idx) const;
 
+  // Get the key_attrs columns of this tuple as a tuple of key_schema, e.g. to look it up in an index
+  Tuple KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) const;
+
   // Is the column value null ?
   inline bool IsNull(const Schema *schema, uint32_t column_idx) const {
     Value value = GetValue(schema, column_idx);
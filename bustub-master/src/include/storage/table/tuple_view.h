@@ -0,0 +1,120 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tuple_view.h
+//
+// Identification: src/include/storage/table/tuple_view.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/arena.h"
+#include "common/rid.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * TupleView is a non-owning reference to tuple bytes stored elsewhere, usually in a pinned table page or in the
+ * query's Arena. It has the same layout as Tuple but never allocates: copying a view copies a pointer, and VARCHAR
+ * values read through it point into the viewed bytes instead of being copied out.
+ *
+ * A view is only valid as long as the memory it points to, i.e. while the page is pinned or the arena is alive.
+ */
+class TupleView {
+ public:
+  TupleView() = default;
+
+  TupleView(const char *data, uint32_t size, RID rid) : data_(data), size_(size), rid_(rid) {}
+
+  /**
+   * Serialize values into the arena in tuple format.
+   * @param values the values of the tuple, one per column of schema
+   * @param schema the schema of the tuple
+   * @param arena the arena that owns the bytes
+   * @return a view of the new tuple
+   */
+  static TupleView Materialize(const std::vector<Value> &values, const Schema *schema, Arena *arena) {
+    uint32_t size = GetSerializedLength(values, schema);
+    char *data = arena->Allocate(size, alignof(uint64_t));
+    SerializeValues(values, schema, data);
+    return TupleView(data, size, RID());
+  }
+
+  /** @return a copy of the viewed bytes owned by the arena, e.g. to keep a page-resident tuple after unpinning */
+  TupleView CopyTo(Arena *arena) const {
+    char *data = arena->Allocate(size_, alignof(uint64_t));
+    memcpy(data, data_, size_);
+    return TupleView(data, size_, rid_);
+  }
+
+  /** @return the number of bytes a tuple holding values takes, including the varlen payloads */
+  static uint32_t GetSerializedLength(const std::vector<Value> &values, const Schema *schema) {
+    uint32_t size = schema->GetLength();
+    for (auto &i : schema->GetUnlinedColumns()) {
+      size += values[i].GetLength() + sizeof(uint32_t);
+    }
+    return size;
+  }
+
+  /** Serialize values in tuple format into storage, which must hold GetSerializedLength() bytes. */
+  static void SerializeValues(const std::vector<Value> &values, const Schema *schema, char *storage) {
+    uint32_t offset = schema->GetLength();
+    for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+      const auto &col = schema->GetColumn(i);
+      if (!col.IsInlined()) {
+        // Serialize the relative offset of the varchar payload, then the payload itself (size+data).
+        memcpy(storage + col.GetOffset(), &offset, sizeof(uint32_t));
+        values[i].SerializeTo(storage + offset);
+        offset += values[i].GetLength() + sizeof(uint32_t);
+      } else {
+        values[i].SerializeTo(storage + col.GetOffset());
+      }
+    }
+  }
+
+  /**
+   * Read a column. VARCHAR values reference the viewed bytes and are only valid as long as the view.
+   * @param schema the schema of the tuple
+   * @param column_idx the column to read
+   * @return the value of the column
+   */
+  Value GetValue(const Schema *schema, uint32_t column_idx) const {
+    const auto &col = schema->GetColumn(column_idx);
+    const char *ptr = data_ + col.GetOffset();
+    if (col.IsInlined()) {
+      return Value::DeserializeFrom(ptr, col.GetType());
+    }
+    uint32_t offset;
+    memcpy(&offset, ptr, sizeof(uint32_t));
+    uint32_t len;
+    memcpy(&len, data_ + offset, sizeof(uint32_t));
+    if (len == BUSTUB_VALUE_NULL) {
+      return Value(col.GetType(), nullptr, len, false);
+    }
+    return Value(col.GetType(), data_ + offset + sizeof(uint32_t), len, false);
+  }
+
+  /** @return the viewed bytes */
+  inline const char *GetData() const { return data_; }
+
+  /** @return the length of the tuple, including the varlen payloads */
+  inline uint32_t GetLength() const { return size_; }
+
+  /** @return the RID of the tuple, valid if the view points into the table heap */
+  inline RID GetRid() const { return rid_; }
+
+ private:
+  const char *data_{nullptr};
+  uint32_t size_{0};
+  RID rid_{};
+};
+
+}  // namespace bustub
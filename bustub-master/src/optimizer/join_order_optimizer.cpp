@@ -0,0 +1,302 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_order_optimizer.cpp
+//
+// Identification: src/optimizer/join_order_optimizer.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "optimizer/join_order_optimizer.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "execution/plans/hash_join_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return the comparison with its operands swapped, e.g. 5 < col as col > 5 */
+ComparisonType Flip(ComparisonType type) {
+  switch (type) {
+    case ComparisonType::LessThan:
+      return ComparisonType::GreaterThan;
+    case ComparisonType::LessThanOrEqual:
+      return ComparisonType::GreaterThanOrEqual;
+    case ComparisonType::GreaterThan:
+      return ComparisonType::LessThan;
+    case ComparisonType::GreaterThanOrEqual:
+      return ComparisonType::LessThanOrEqual;
+    default:
+      return type;
+  }
+}
+
+/** @return the index of a relation column in a join output */
+uint32_t FindColumn(const std::vector<std::pair<uint32_t, uint32_t>> &columns, uint32_t relation, uint32_t col) {
+  auto it = std::find(columns.begin(), columns.end(), std::make_pair(relation, col));
+  BUSTUB_ASSERT(it != columns.end(), "The column must be in the join output.");
+  return static_cast<uint32_t>(it - columns.begin());
+}
+
+}  // namespace
+
+uint32_t JoinOrderOptimizer::AddRelation(const AbstractPlanNode *plan) {
+  BUSTUB_ASSERT(relations_.size() < MAX_RELATIONS, "Too many relations to order.");
+  const Schema *schema = plan->OutputSchema();
+  Relation relation{plan, DEFAULT_CARDINALITY, std::vector<const ColumnStats *>(schema->GetColumnCount())};
+  if (plan->GetType() == PlanType::SeqScan) {
+    const auto *scan = static_cast<const SeqScanPlanNode *>(plan);
+    const TableStats *stats = catalog_->GetTableStats(scan->GetTableOid());
+    if (stats != nullptr) {
+      relation.cardinality_ = static_cast<double>(stats->num_rows_);
+      if (scan->GetPredicate() != nullptr) {
+        relation.cardinality_ *= EstimateSelectivity(scan->GetPredicate(), *stats);
+      }
+      // The output columns that are plain table columns share their statistics.
+      for (uint32_t i = 0; i < relation.column_stats_.size(); i++) {
+        const auto *col_expr = dynamic_cast<const ColumnValueExpression *>(schema->GetColumn(i).GetExpr());
+        if (col_expr != nullptr && col_expr->GetColIdx() < stats->columns_.size()) {
+          relation.column_stats_[i] = &stats->columns_[col_expr->GetColIdx()];
+        }
+      }
+    } else if (scan->GetPredicate() != nullptr) {
+      relation.cardinality_ *= DEFAULT_SELECTIVITY;
+    }
+  }
+  relations_.push_back(std::move(relation));
+  return static_cast<uint32_t>(relations_.size() - 1);
+}
+
+void JoinOrderOptimizer::AddJoinPredicate(uint32_t left, uint32_t left_col, uint32_t right, uint32_t right_col) {
+  BUSTUB_ASSERT(left != right && left < relations_.size() && right < relations_.size(), "Invalid join relations.");
+  double ndv = std::max(EstimateDistinct(left, left_col), EstimateDistinct(right, right_col));
+  predicates_.push_back({left, left_col, right, right_col, 1 / ndv});
+  relations_[left].neighbors_ |= RelationSet{1} << right;
+  relations_[right].neighbors_ |= RelationSet{1} << left;
+}
+
+double JoinOrderOptimizer::EstimateDistinct(uint32_t relation, uint32_t col) const {
+  const Relation &r = relations_[relation];
+  double ndv = r.cardinality_;
+  if (r.column_stats_[col] != nullptr) {
+    ndv = std::min(ndv, static_cast<double>(r.column_stats_[col]->num_distinct_));
+  }
+  return std::max(ndv, 1.0);
+}
+
+double JoinOrderOptimizer::EstimateCardinality(RelationSet set) const {
+  double cardinality = 1;
+  for (uint32_t i = 0; i < relations_.size(); i++) {
+    if ((set >> i & 1) != 0) {
+      cardinality *= relations_[i].cardinality_;
+    }
+  }
+  for (const auto &p : predicates_) {
+    if ((set >> p.left_ & 1) != 0 && (set >> p.right_ & 1) != 0) {
+      cardinality *= p.selectivity_;
+    }
+  }
+  return cardinality;
+}
+
+bool JoinOrderOptimizer::Connected(RelationSet a, RelationSet b) const {
+  for (uint32_t i = 0; i < relations_.size(); i++) {
+    if ((a >> i & 1) != 0 && (relations_[i].neighbors_ & b) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+double JoinOrderOptimizer::EstimateSelectivity(const AbstractExpression *predicate, const TableStats &stats) {
+  if (const auto *logic = dynamic_cast<const LogicExpression *>(predicate)) {
+    double left = EstimateSelectivity(logic->GetChildAt(0), stats);
+    double right = EstimateSelectivity(logic->GetChildAt(1), stats);
+    // Assume the operands are independent.
+    return logic->GetLogicType() == LogicType::And ? left * right : left + right - left * right;
+  }
+  const auto *comparison = dynamic_cast<const ComparisonExpression *>(predicate);
+  if (comparison == nullptr) {
+    return DEFAULT_SELECTIVITY;
+  }
+  ComparisonType type = comparison->GetComparisonType();
+  const auto *col_expr = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0));
+  const auto *const_expr = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1));
+  if (col_expr == nullptr) {
+    col_expr = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1));
+    const_expr = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0));
+    type = Flip(type);
+  }
+  if (col_expr == nullptr || const_expr == nullptr || col_expr->GetColIdx() >= stats.columns_.size()) {
+    return DEFAULT_SELECTIVITY;
+  }
+  const ColumnStats &column = stats.columns_[col_expr->GetColIdx()];
+  const Value &value = const_expr->GetValue();
+  if (value.IsNull()) {
+    return 0;
+  }
+  double non_null = 1 - column.GetNullFraction();
+  double selectivity;
+  switch (type) {
+    case ComparisonType::Equal:
+      selectivity = column.EstimateEqual(value);
+      break;
+    case ComparisonType::NotEqual:
+      selectivity = non_null - column.EstimateEqual(value);
+      break;
+    case ComparisonType::LessThan:
+      selectivity = column.EstimateLessThan(value, false);
+      break;
+    case ComparisonType::LessThanOrEqual:
+      selectivity = column.EstimateLessThan(value, true);
+      break;
+    case ComparisonType::GreaterThan:
+      selectivity = non_null - column.EstimateLessThan(value, true);
+      break;
+    case ComparisonType::GreaterThanOrEqual:
+      selectivity = non_null - column.EstimateLessThan(value, false);
+      break;
+    default:
+      selectivity = DEFAULT_SELECTIVITY;
+  }
+  return std::min(1.0, std::max(0.0, selectivity));
+}
+
+const AbstractPlanNode *JoinOrderOptimizer::Optimize() {
+  BUSTUB_ASSERT(!relations_.empty(), "There must be a relation to join.");
+  RelationSet all = AllRelations();
+  plans_.assign(all + 1, JoinPlan{});
+  cardinalities_.assign(all + 1, 0);
+  for (RelationSet set = 1; set <= all; set++) {
+    cardinalities_[set] = EstimateCardinality(set);
+  }
+  for (uint32_t i = 0; i < relations_.size(); i++) {
+    plans_[RelationSet{1} << i] = {true, true, 0, 0, 0};
+  }
+
+  // Every proper subset is smaller than its set, so the plans of both halves are known when a set is reached.
+  for (RelationSet set = 1; set <= all; set++) {
+    if ((set & (set - 1)) == 0) {
+      continue;
+    }
+    JoinPlan &best = plans_[set];
+    // First try to join two connected halves over a predicate. Failing that the set falls apart into pieces that no
+    // predicate connects, and only those are joined by cross products.
+    for (bool cross_product : {false, true}) {
+      for (RelationSet build = (set - 1) & set; build != 0; build = (build - 1) & set) {
+        RelationSet probe = set ^ build;
+        const JoinPlan &b = plans_[build];
+        const JoinPlan &p = plans_[probe];
+        bool connected = Connected(build, probe);
+        if (cross_product ? connected : !(connected && b.connected_ && p.connected_)) {
+          continue;
+        }
+        double cost = b.cost_ + p.cost_ + 2 * cardinalities_[build] + cardinalities_[probe] + cardinalities_[set];
+        if (!best.valid_ || cost < best.cost_) {
+          best = {true, !cross_product, cost, build, probe};
+        }
+      }
+      if (best.valid_) {
+        break;
+      }
+    }
+  }
+
+  std::vector<std::pair<uint32_t, uint32_t>> columns;
+  return BuildPlan(all, &columns);
+}
+
+const AbstractPlanNode *JoinOrderOptimizer::BuildPlan(RelationSet set,
+                                                      std::vector<std::pair<uint32_t, uint32_t>> *columns) {
+  const JoinPlan &plan = plans_[set];
+  if (plan.build_ == 0) {
+    // A single relation: find its bit.
+    uint32_t relation = 0;
+    while ((set & (RelationSet{1} << relation)) == 0) {
+      relation++;
+    }
+    const AbstractPlanNode *node = relations_[relation].plan_;
+    for (uint32_t col = 0; col < node->OutputSchema()->GetColumnCount(); col++) {
+      columns->emplace_back(relation, col);
+    }
+    return node;
+  }
+  std::vector<std::pair<uint32_t, uint32_t>> build_columns;
+  std::vector<std::pair<uint32_t, uint32_t>> probe_columns;
+  const AbstractPlanNode *build = BuildPlan(plan.build_, &build_columns);
+  const AbstractPlanNode *probe = BuildPlan(plan.probe_, &probe_columns);
+
+  // The output holds the columns of both sides in the order of the relations.
+  columns->insert(columns->end(), build_columns.begin(), build_columns.end());
+  columns->insert(columns->end(), probe_columns.begin(), probe_columns.end());
+  std::sort(columns->begin(), columns->end());
+  std::vector<Column> output;
+  for (const auto &rc : *columns) {
+    const Column &col = relations_[rc.first].plan_->OutputSchema()->GetColumn(rc.second);
+    bool on_build = (plan.build_ >> rc.first & 1) != 0;
+    uint32_t idx = FindColumn(on_build ? build_columns : probe_columns, rc.first, rc.second);
+    const AbstractExpression *expr =
+        Own(std::make_unique<ColumnValueExpression>(on_build ? 0 : 1, idx, col.GetType()));
+    if (col.GetType() == TypeId::VARCHAR) {
+      output.emplace_back(col.GetName(), col.GetType(), col.GetLength(), expr);
+    } else {
+      output.emplace_back(col.GetName(), col.GetType(), expr);
+    }
+  }
+  schemas_.emplace_back(std::make_unique<Schema>(output));
+
+  // Hash on the columns of the predicates between the sides. Equal hashes only narrow down the candidates, so the
+  // predicate compares the keys again.
+  std::vector<const AbstractExpression *> build_keys;
+  std::vector<const AbstractExpression *> probe_keys;
+  const AbstractExpression *predicate = nullptr;
+  for (const auto &p : predicates_) {
+    uint32_t build_rel = p.left_;
+    uint32_t build_col = p.left_col_;
+    uint32_t probe_rel = p.right_;
+    uint32_t probe_col = p.right_col_;
+    if ((plan.build_ >> build_rel & 1) == 0) {
+      std::swap(build_rel, probe_rel);
+      std::swap(build_col, probe_col);
+    }
+    if ((plan.build_ >> build_rel & 1) == 0 || (plan.probe_ >> probe_rel & 1) == 0) {
+      continue;
+    }
+    TypeId build_type = relations_[build_rel].plan_->OutputSchema()->GetColumn(build_col).GetType();
+    TypeId probe_type = relations_[probe_rel].plan_->OutputSchema()->GetColumn(probe_col).GetType();
+    build_keys.push_back(Own(std::make_unique<ColumnValueExpression>(
+        0, FindColumn(build_columns, build_rel, build_col), build_type)));
+    probe_keys.push_back(Own(std::make_unique<ColumnValueExpression>(
+        1, FindColumn(probe_columns, probe_rel, probe_col), probe_type)));
+    const AbstractExpression *equal =
+        Own(std::make_unique<ComparisonExpression>(build_keys.back(), probe_keys.back(), ComparisonType::Equal));
+    predicate = predicate == nullptr ? equal : Own(std::make_unique<LogicExpression>(predicate, equal, LogicType::And));
+  }
+  plan_nodes_.emplace_back(std::make_unique<HashJoinPlanNode>(schemas_.back().get(),
+                                                              std::vector<const AbstractPlanNode *>{build, probe},
+                                                              predicate, std::move(build_keys), std::move(probe_keys)));
+  return plan_nodes_.back().get();
+}
+
+uint32_t JoinOrderOptimizer::GetOutputColumnIdx(uint32_t relation, uint32_t col) const {
+  uint32_t idx = col;
+  for (uint32_t i = 0; i < relation; i++) {
+    idx += relations_[i].plan_->OutputSchema()->GetColumnCount();
+  }
+  return idx;
+}
+
+}  // namespace bustub
@@ -0,0 +1,309 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// projection_pushdown.cpp
+//
+// Identification: src/optimizer/projection_pushdown.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "optimizer/projection_pushdown.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "execution/expressions/row_id_expression.h"
+#include "execution/plans/late_materialize_plan.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return a copy of a column that computes expr */
+Column WithExpr(const Column &col, const AbstractExpression *expr) {
+  if (col.GetType() == TypeId::VARCHAR) {
+    return Column(col.GetName(), col.GetType(), col.GetLength(), expr);
+  }
+  return Column(col.GetName(), col.GetType(), expr);
+}
+
+/** @return the identity mapping of the output columns of a plan */
+std::vector<uint32_t> Identity(const AbstractPlanNode *plan) {
+  std::vector<uint32_t> mapping(plan->OutputSchema()->GetColumnCount());
+  for (uint32_t i = 0; i < mapping.size(); i++) {
+    mapping[i] = i;
+  }
+  return mapping;
+}
+
+/** @return the table column a scan output column reads, or nullptr if it computes something else */
+const ColumnValueExpression *GetTableColumn(const AbstractPlanNode *plan, uint32_t col) {
+  if (plan->GetType() != PlanType::SeqScan) {
+    return nullptr;
+  }
+  return dynamic_cast<const ColumnValueExpression *>(plan->OutputSchema()->GetColumn(col).GetExpr());
+}
+
+}  // namespace
+
+const AbstractPlanNode *ProjectionPushdown::Optimize(const AbstractPlanNode *plan) {
+  std::vector<uint32_t> mapping;
+  return Prune(plan, std::vector<bool>(plan->OutputSchema()->GetColumnCount(), true), &mapping);
+}
+
+const AbstractPlanNode *ProjectionPushdown::Prune(const AbstractPlanNode *plan, const std::vector<bool> &used,
+                                                  std::vector<uint32_t> *mapping) {
+  switch (plan->GetType()) {
+    case PlanType::SeqScan:
+      return PruneSeqScan(static_cast<const SeqScanPlanNode *>(plan), used, false, mapping);
+    case PlanType::HashJoin:
+      return PruneHashJoin(static_cast<const HashJoinPlanNode *>(plan), used, mapping);
+    case PlanType::Aggregation:
+      return PruneAggregation(static_cast<const AggregationPlanNode *>(plan), mapping);
+    default:
+      *mapping = Identity(plan);
+      return plan;
+  }
+}
+
+const AbstractPlanNode *ProjectionPushdown::PruneSeqScan(const SeqScanPlanNode *plan, const std::vector<bool> &used,
+                                                         bool with_rid, std::vector<uint32_t> *mapping) {
+  const Schema *schema = plan->OutputSchema();
+  std::vector<Column> columns;
+  mapping->assign(schema->GetColumnCount(), DROPPED);
+  for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+    if (used[i]) {
+      (*mapping)[i] = static_cast<uint32_t>(columns.size());
+      columns.push_back(schema->GetColumn(i));
+    }
+  }
+  if (columns.empty() && !with_rid) {
+    // A tuple needs a column even if none is read, e.g. below COUNT(*).
+    (*mapping)[0] = 0;
+    columns.push_back(schema->GetColumn(0));
+  }
+  if (columns.size() == schema->GetColumnCount() && !with_rid) {
+    return plan;
+  }
+  if (with_rid) {
+    columns.emplace_back("rid", TypeId::BIGINT, Own(std::make_unique<RowIdExpression>()));
+  }
+  return Own(std::make_unique<SeqScanPlanNode>(OwnSchema(columns), plan->GetPredicate(), plan->GetTableOid()));
+}
+
+const AbstractPlanNode *ProjectionPushdown::PruneHashJoin(const HashJoinPlanNode *plan, const std::vector<bool> &used,
+                                                          std::vector<uint32_t> *mapping) {
+  const Schema *schema = plan->OutputSchema();
+  const AbstractPlanNode *children[2] = {plan->GetLeftPlan(), plan->GetRightPlan()};
+  std::vector<std::vector<bool>> early(2);
+  for (int side = 0; side < 2; side++) {
+    early[side].assign(children[side]->OutputSchema()->GetColumnCount(), false);
+  }
+  for (const auto *key : plan->GetLeftKeys()) {
+    Collect(key, 0, &early);
+  }
+  for (const auto *key : plan->GetRightKeys()) {
+    Collect(key, 1, &early);
+  }
+  if (plan->Predicate() != nullptr) {
+    Collect(plan->Predicate(), -1, &early);
+  }
+
+  // An output column that is a plain table column of a scan input, and that the join itself does not read, can be
+  // fetched after the join instead.
+  std::vector<int> deferred(schema->GetColumnCount(), -1);
+  std::vector<const ColumnValueExpression *> candidates(schema->GetColumnCount(), nullptr);
+  for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+    if (!used[i]) {
+      continue;
+    }
+    const auto *col_expr = dynamic_cast<const ColumnValueExpression *>(schema->GetColumn(i).GetExpr());
+    if (late_materialize_ && col_expr != nullptr &&
+        GetTableColumn(children[col_expr->GetTupleIdx()], col_expr->GetColIdx()) != nullptr) {
+      candidates[i] = col_expr;
+    } else {
+      Collect(schema->GetColumn(i).GetExpr(), -1, &early);
+    }
+  }
+  bool late[2] = {false, false};
+  for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+    if (candidates[i] == nullptr) {
+      continue;
+    }
+    uint32_t side = candidates[i]->GetTupleIdx();
+    if (early[side][candidates[i]->GetColIdx()]) {
+      continue;
+    }
+    deferred[i] = static_cast<int>(side);
+    late[side] = true;
+  }
+  for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+    if (candidates[i] != nullptr && deferred[i] < 0) {
+      Collect(candidates[i], -1, &early);
+    }
+  }
+
+  std::vector<std::vector<uint32_t>> mappings(2);
+  const AbstractPlanNode *inputs[2];
+  uint32_t rid_cols[2] = {0, 0};
+  for (int side = 0; side < 2; side++) {
+    if (late[side]) {
+      inputs[side] = PruneSeqScan(static_cast<const SeqScanPlanNode *>(children[side]), early[side], true,
+                                  &mappings[side]);
+      rid_cols[side] = inputs[side]->OutputSchema()->GetColumnCount() - 1;
+    } else {
+      inputs[side] = Prune(children[side], early[side], &mappings[side]);
+    }
+  }
+  bool all_used = std::find(used.begin(), used.end(), false) == used.end();
+  if (inputs[0] == children[0] && inputs[1] == children[1] && all_used && !late[0] && !late[1]) {
+    *mapping = Identity(plan);
+    return plan;
+  }
+
+  // The join outputs the used columns it does not defer, then the RIDs of the inputs with deferred columns.
+  std::vector<Column> columns;
+  std::vector<uint32_t> positions(schema->GetColumnCount(), DROPPED);
+  for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+    if (used[i] && deferred[i] < 0) {
+      positions[i] = static_cast<uint32_t>(columns.size());
+      columns.push_back(WithExpr(schema->GetColumn(i), Remap(schema->GetColumn(i).GetExpr(), -1, mappings)));
+    }
+  }
+  uint32_t rid_positions[2] = {0, 0};
+  for (uint32_t side = 0; side < 2; side++) {
+    if (late[side]) {
+      rid_positions[side] = static_cast<uint32_t>(columns.size());
+      columns.emplace_back("rid", TypeId::BIGINT,
+                           Own(std::make_unique<ColumnValueExpression>(side, rid_cols[side], TypeId::BIGINT)));
+    }
+  }
+  std::vector<const AbstractExpression *> left_keys;
+  for (const auto *key : plan->GetLeftKeys()) {
+    left_keys.push_back(Remap(key, 0, mappings));
+  }
+  std::vector<const AbstractExpression *> right_keys;
+  for (const auto *key : plan->GetRightKeys()) {
+    right_keys.push_back(Remap(key, 1, mappings));
+  }
+  const AbstractExpression *predicate = plan->Predicate() == nullptr ? nullptr : Remap(plan->Predicate(), -1, mappings);
+  const AbstractPlanNode *node = Own(std::make_unique<HashJoinPlanNode>(
+      OwnSchema(columns), std::vector<const AbstractPlanNode *>{inputs[0], inputs[1]}, predicate, std::move(left_keys),
+      std::move(right_keys)));
+
+  // Fetch the deferred columns one input at a time. Every step passes on the columns available so far and the RIDs
+  // still to be used, so the last one outputs exactly the used columns in order.
+  for (uint32_t side = 0; side < 2; side++) {
+    if (!late[side]) {
+      continue;
+    }
+    columns.clear();
+    std::vector<uint32_t> next_positions(schema->GetColumnCount(), DROPPED);
+    for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+      const Column &col = schema->GetColumn(i);
+      const AbstractExpression *expr;
+      if (positions[i] != DROPPED) {
+        expr = Own(std::make_unique<ColumnValueExpression>(0, positions[i], col.GetType()));
+      } else if (deferred[i] == static_cast<int>(side)) {
+        const auto *table_col = GetTableColumn(children[side], candidates[i]->GetColIdx());
+        expr = Own(std::make_unique<ColumnValueExpression>(1, table_col->GetColIdx(), col.GetType()));
+      } else {
+        continue;
+      }
+      next_positions[i] = static_cast<uint32_t>(columns.size());
+      columns.push_back(WithExpr(col, expr));
+    }
+    if (side == 0 && late[1]) {
+      uint32_t rid_position = static_cast<uint32_t>(columns.size());
+      columns.emplace_back("rid", TypeId::BIGINT,
+                           Own(std::make_unique<ColumnValueExpression>(0, rid_positions[1], TypeId::BIGINT)));
+      rid_positions[1] = rid_position;
+    }
+    const auto *scan = static_cast<const SeqScanPlanNode *>(children[side]);
+    node = Own(std::make_unique<LateMaterializePlanNode>(OwnSchema(columns), node, scan->GetTableOid(),
+                                                         rid_positions[side]));
+    positions = std::move(next_positions);
+  }
+  *mapping = std::move(positions);
+  return node;
+}
+
+const AbstractPlanNode *ProjectionPushdown::PruneAggregation(const AggregationPlanNode *plan,
+                                                             std::vector<uint32_t> *mapping) {
+  *mapping = Identity(plan);
+  const AbstractPlanNode *child = plan->GetChildPlan();
+  std::vector<std::vector<bool>> used(1, std::vector<bool>(child->OutputSchema()->GetColumnCount(), false));
+  for (const auto *expr : plan->GetGroupBys()) {
+    Collect(expr, 0, &used);
+  }
+  for (const auto *expr : plan->GetAggregates()) {
+    Collect(expr, 0, &used);
+  }
+  std::vector<std::vector<uint32_t>> mappings(1);
+  const AbstractPlanNode *input = Prune(child, used[0], &mappings[0]);
+  if (input == child) {
+    return plan;
+  }
+  std::vector<const AbstractExpression *> group_bys;
+  for (const auto *expr : plan->GetGroupBys()) {
+    group_bys.push_back(Remap(expr, 0, mappings));
+  }
+  std::vector<const AbstractExpression *> aggregates;
+  for (const auto *expr : plan->GetAggregates()) {
+    aggregates.push_back(Remap(expr, 0, mappings));
+  }
+  std::vector<AggregationType> agg_types(plan->GetAggregateTypes());
+  return Own(std::make_unique<AggregationPlanNode>(plan->OutputSchema(), input, plan->GetHaving(), std::move(group_bys),
+                                                   std::move(aggregates), std::move(agg_types), plan->GetSampleRate(),
+                                                   plan->GetSampleSeed()));
+}
+
+void ProjectionPushdown::Collect(const AbstractExpression *expr, int side, std::vector<std::vector<bool>> *used) {
+  if (const auto *col_expr = dynamic_cast<const ColumnValueExpression *>(expr)) {
+    (*used)[side < 0 ? col_expr->GetTupleIdx() : side][col_expr->GetColIdx()] = true;
+    return;
+  }
+  for (const auto *child : expr->GetChildren()) {
+    Collect(child, side, used);
+  }
+}
+
+const AbstractExpression *ProjectionPushdown::Remap(const AbstractExpression *expr, int side,
+                                                    const std::vector<std::vector<uint32_t>> &mappings) {
+  if (const auto *col_expr = dynamic_cast<const ColumnValueExpression *>(expr)) {
+    uint32_t col = mappings[side < 0 ? col_expr->GetTupleIdx() : side][col_expr->GetColIdx()];
+    BUSTUB_ASSERT(col != DROPPED, "A column that is read must be produced.");
+    if (col == col_expr->GetColIdx()) {
+      return expr;
+    }
+    return Own(std::make_unique<ColumnValueExpression>(col_expr->GetTupleIdx(), col, col_expr->GetReturnType()));
+  }
+  if (const auto *comparison = dynamic_cast<const ComparisonExpression *>(expr)) {
+    const AbstractExpression *left = Remap(comparison->GetChildAt(0), side, mappings);
+    const AbstractExpression *right = Remap(comparison->GetChildAt(1), side, mappings);
+    if (left == comparison->GetChildAt(0) && right == comparison->GetChildAt(1)) {
+      return expr;
+    }
+    return Own(std::make_unique<ComparisonExpression>(left, right, comparison->GetComparisonType()));
+  }
+  if (const auto *logic = dynamic_cast<const LogicExpression *>(expr)) {
+    const AbstractExpression *left = Remap(logic->GetChildAt(0), side, mappings);
+    const AbstractExpression *right = Remap(logic->GetChildAt(1), side, mappings);
+    if (left == logic->GetChildAt(0) && right == logic->GetChildAt(1)) {
+      return expr;
+    }
+    return Own(std::make_unique<LogicExpression>(left, right, logic->GetLogicType()));
+  }
+  // Constants and aggregate values read no input column.
+  return expr;
+}
+
+}  // namespace bustub
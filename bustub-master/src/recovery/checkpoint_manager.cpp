@@ -28,4 +28,17 @@ void CheckpointManager::EndCheckpoint() {
   transaction_manager_->ResumeTransactions();
 }
 
+void CheckpointManager::StartPeriodicCheckpoints(std::chrono::milliseconds interval) {
+  StopPeriodicCheckpoints();
+  checkpoint_task_ = TaskPool::GetShared()->SchedulePeriodic(interval, [this] {
+    BeginCheckpoint();
+    EndCheckpoint();
+  });
+}
+
+void CheckpointManager::StopPeriodicCheckpoints() {
+  TaskPool::GetShared()->CancelPeriodic(checkpoint_task_);
+  checkpoint_task_ = TaskPool::NO_PERIODIC_TASK;
+}
+
 }  // namespace bustub
@@ -15,42 +15,38 @@
 namespace bustub {
 /*
  * set enable_logging = true
- * Start a separate thread to execute flush to disk operation periodically
- * The flush can be triggered when the log buffer is full or buffer pool
+ * Schedule the flush to disk operation periodically on the shared task pool
+ * The flush also runs when the log buffer is full or buffer pool
  * manager wants to force flush (it only happens when the flushed page has a
  * larger LSN than persistent LSN)
  */
 void LogManager::RunFlushThread() {
     enable_logging = true;
-    flush_thread_ = new std::thread([this] {
-        while (enable_logging) {
-            std::unique_lock<std::mutex> lck(latch_);
-            cv_.wait_for(lck, log_timeout);
-            std::promise<void> prom;
-            int last_lsn = next_lsn_ - 1;
-            flush_future_ = prom.get_future().share();
-            int flush_size = SwapBuffer();
-            lck.unlock();
-            disk_manager_->WriteLog(flush_buffer_, flush_size);
-            lck.lock();
-            SetPersistentLSN(last_lsn);
-            prom.set_value();
-        }
-    });
+    flush_task_ = TaskPool::GetShared()->SchedulePeriodic(
+        std::chrono::duration_cast<std::chrono::milliseconds>(log_timeout), [this] { Flush(); });
 }
 
 /*
- * Stop and join the flush thread, set enable_logging = false
+ * Cancel the periodic flush, waiting for one in progress, set enable_logging = false
  */
 void LogManager::StopFlushThread() {
     enable_logging = false;
+    TaskPool::GetShared()->CancelPeriodic(flush_task_);
+    flush_task_ = TaskPool::NO_PERIODIC_TASK;
+}
+
+void LogManager::Flush() {
+    std::lock_guard<std::mutex> flush_guard(flush_latch_);
     std::unique_lock<std::mutex> lck(latch_);
-    cv_.notify_one();
+    std::promise<void> prom;
+    lsn_t last_lsn = next_lsn_ - 1;
+    flush_future_ = prom.get_future().share();
+    int flush_size = SwapBuffer();
     lck.unlock();
-
-    if (flush_thread_ && flush_thread_->joinable())
-        flush_thread_->join();
-    flush_thread_ = nullptr;
+    disk_manager_->WriteLog(flush_buffer_, flush_size);
+    lck.lock();
+    SetPersistentLSN(last_lsn);
+    prom.set_value();
 }
 
 void LogManager::WaitForFlushFinish() {
@@ -61,11 +57,7 @@ void LogManager::WaitForFlushFinish() {
 }
 
 void LogManager::ForceFlush() {
-    std::unique_lock<std::mutex> lck(latch_);
-    cv_.notify_one();
-    std::shared_future<void> fut = flush_future_;
-    if (fut.valid())
-        fut.wait();
+    Flush();
 }
 
 int  LogManager::SwapBuffer() {
@@ -98,13 +90,9 @@ int  LogManager::SwapBuffer() {
 lsn_t LogManager::AppendLogRecord(LogRecord *log_record) { 
     std::unique_lock<std::mutex> lck(latch_);
 
-    if (offset_ + log_record->GetSize() >= LOG_BUFFER_SIZE) {
-        cv_.notify_one();
+    while (offset_ + log_record->GetSize() >= LOG_BUFFER_SIZE) {
         lck.unlock();
-        
-        std::shared_future<void> fut = flush_future_;
-        if (fut.valid())
-            fut.wait();
+        Flush();
         lck.lock();
     }
 
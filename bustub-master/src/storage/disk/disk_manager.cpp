@@ -10,7 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <cassert>
 #include <cstring>
 #include <iostream>
@@ -58,6 +60,21 @@ DiskManager::DiskManager(const std::string &db_file)
     // reopen with original mode
     db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
   }
+  read_fd_ = open(db_file.c_str(), O_RDONLY);
+}
+
+DiskManager::~DiskManager() {
+  {
+    std::lock_guard<std::mutex> lock(io_latch_);
+    io_shutdown_ = true;
+  }
+  io_cv_.notify_all();
+  for (auto &thread : io_threads_) {
+    thread.join();
+  }
+  if (read_fd_ >= 0) {
+    close(read_fd_);
+  }
 }
 
 /**
@@ -97,6 +114,7 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
     // std::cerr << "I/O error while reading" << std::endl;
   } else {
     // set read cursor to offset
+    num_reads_ += 1;
     db_io_.seekp(offset);
     db_io_.read(page_data, PAGE_SIZE);
     // if file ends before reading PAGE_SIZE
@@ -109,6 +127,52 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
   }
 }
 
+/**
+ * Queue a read of the specified page for the I/O threads
+ */
+std::shared_future<void> DiskManager::ReadPageAsync(page_id_t page_id, char *page_data) {
+  std::shared_future<void> done;
+  {
+    std::lock_guard<std::mutex> lock(io_latch_);
+    if (io_threads_.empty()) {
+      for (size_t i = 0; i < NUM_IO_THREADS; i++) {
+        io_threads_.emplace_back(&DiskManager::RunIoThread, this);
+      }
+    }
+    io_queue_.push_back(ReadRequest{page_id, page_data, std::promise<void>()});
+    done = io_queue_.back().done_.get_future().share();
+  }
+  io_cv_.notify_one();
+  return done;
+}
+
+void DiskManager::RunIoThread() {
+  while (true) {
+    std::unique_lock<std::mutex> lock(io_latch_);
+    io_cv_.wait(lock, [this] { return io_shutdown_ || !io_queue_.empty(); });
+    if (io_queue_.empty()) {
+      return;
+    }
+    ReadRequest request = std::move(io_queue_.front());
+    io_queue_.pop_front();
+    lock.unlock();
+
+    // Same as ReadPage, but pread() leaves the stream of the synchronous reads and writes alone.
+    off_t offset = static_cast<off_t>(request.page_id_) * PAGE_SIZE;
+    ssize_t read_count = pread(read_fd_, request.page_data_, PAGE_SIZE, offset);
+    if (read_count < 0) {
+      LOG_DEBUG("I/O error while reading");
+    } else {
+      num_reads_ += 1;
+      if (read_count < PAGE_SIZE) {
+        LOG_DEBUG("Read less than a page");
+        memset(request.page_data_ + read_count, 0, PAGE_SIZE - read_count);
+      }
+    }
+    request.done_.set_value();
+  }
+}
+
 /**
  * Write the contents of the log into disk file
  * Only return when sync is done, and only perform sequence write
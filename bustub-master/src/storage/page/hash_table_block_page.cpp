@@ -72,7 +72,8 @@ template<typename KeyType, typename ValueType, typename KeyComparator>
 int HASH_TABLE_BLOCK_TYPE::SlotNum() {
 //    int slot_num = (PAGE_SIZE - sizeof(readable_) - sizeof(occupied_)) / sizeof(MappingType);
 //    LOG_INFO("slot num in block page: %d\n", slot_num);
-    int slot_num = sizeof(readable_) * 8;
+    // The bitmaps are rounded up to whole bytes, but only BLOCK_ARRAY_SIZE pairs fit into the page.
+    int slot_num = BLOCK_ARRAY_SIZE;
     LOG_INFO("slot num: %d\n", slot_num);
     return slot_num;
 }
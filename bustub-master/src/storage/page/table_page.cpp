@@ -304,6 +304,18 @@ bool TablePage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockMan
   return true;
 }
 
+bool TablePage::GetTupleView(uint32_t slot_num, TupleView *view) {
+  if (slot_num >= GetTupleCount()) {
+    return false;
+  }
+  uint32_t tuple_size = GetTupleSize(slot_num);
+  if (IsDeleted(tuple_size)) {
+    return false;
+  }
+  *view = TupleView(GetData() + GetTupleOffsetAtSlot(slot_num), tuple_size, RID(GetTablePageId(), slot_num));
+  return true;
+}
+
 bool TablePage::GetFirstTupleRid(RID *first_rid) {
   // Find and return the first valid tuple.
   for (uint32_t i = 0; i < GetTupleCount(); ++i) {
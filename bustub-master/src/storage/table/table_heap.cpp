@@ -11,8 +11,10 @@
 //===----------------------------------------------------------------------===//
 
 #include <cassert>
+#include <vector>
 
 #include "common/logger.h"
+#include "execution/compiled_predicate.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
@@ -34,6 +36,8 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_m
   first_page->Init(first_page_id_, PAGE_SIZE, INVALID_LSN, log_manager_, txn);
   first_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(first_page_id_, true);
+  page_ids_.push_back(first_page_id_);
+  directory_loaded_ = true;
 }
 
 bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) {
@@ -83,12 +87,20 @@ bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) {
       cur_page->WUnlatch();
       buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
       cur_page = new_page;
+      {
+        // A directory that is being loaded may have picked the page up already.
+        std::lock_guard<std::mutex> guard(directory_latch_);
+        if (directory_loaded_ && page_ids_.back() != next_page_id) {
+          page_ids_.push_back(next_page_id);
+        }
+      }
     }
   }
   // This line has caused most of us to double-take and "whoa double unlatch".
   // We are not, in fact, double unlatching. See the invariant above.
   cur_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
+  modification_count_++;
   // Update the transaction's write set.
   txn->GetWriteSet()->emplace_back(*rid, WType::INSERT, Tuple{}, this);
   return true;
@@ -108,6 +120,7 @@ bool TableHeap::MarkDelete(const RID &rid, Transaction *txn) {
   page->MarkDelete(rid, txn, lock_manager_, log_manager_);
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  modification_count_++;
   // Update the transaction's write set.
   txn->GetWriteSet()->emplace_back(rid, WType::DELETE, Tuple{}, this);
   return true;
@@ -127,6 +140,9 @@ bool TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn
   bool is_updated = page->UpdateTuple(tuple, &old_tuple, rid, txn, lock_manager_, log_manager_);
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), is_updated);
+  if (is_updated) {
+    modification_count_++;
+  }
   // Update the transaction's write set.
   if (is_updated && txn->GetState() != TransactionState::ABORTED) {
     txn->GetWriteSet()->emplace_back(rid, WType::UPDATE, old_tuple, this);
@@ -144,6 +160,7 @@ void TableHeap::ApplyDelete(const RID &rid, Transaction *txn) {
   lock_manager_->Unlock(txn, rid);
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  modification_count_++;
 }
 
 void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
@@ -155,6 +172,7 @@ void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
   page->RollbackDelete(rid, txn, log_manager_);
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  modification_count_++;
 }
 
 bool TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) {
@@ -173,16 +191,182 @@ bool TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) {
   return res;
 }
 
-TableIterator TableHeap::Begin(Transaction *txn) {
-  // Start an iterator from the first page.
-  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+void TableHeap::Scan(const Schema *schema, const CompiledPredicate *predicate, const Schema *projection,
+                     const ScanCallback &callback, Transaction *txn) {
+  page_id_t page_id = first_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    if (!ScanPage(page_id, schema, predicate, projection, callback, txn, &page_id)) {
+      return;
+    }
+  }
+}
+
+std::vector<page_id_t> TableHeap::GetPageIds(Transaction *txn) {
+  std::lock_guard<std::mutex> guard(directory_latch_);
+  LoadPageDirectory(txn);
+  return page_ids_;
+}
+
+size_t TableHeap::GetNumPages(Transaction *txn) {
+  std::lock_guard<std::mutex> guard(directory_latch_);
+  LoadPageDirectory(txn);
+  return page_ids_.size();
+}
+
+page_id_t TableHeap::GetPageId(size_t idx) {
+  std::lock_guard<std::mutex> guard(directory_latch_);
+  BUSTUB_ASSERT(directory_loaded_ && idx < page_ids_.size(), "The page must be in the page directory.");
+  return page_ids_[idx];
+}
+
+page_id_t TableHeap::StartSharedScan(Transaction *txn, bool ordered) {
+  page_id_t position = scan_position_.load();
+  bool attach = num_shared_scans_++ > 0 && !ordered && position != INVALID_PAGE_ID &&
+                GetNumPages(txn) * SHARED_SCAN_POOL_FRACTION >= buffer_pool_manager_->GetPoolSize();
+  return attach ? position : first_page_id_;
+}
+
+void TableHeap::EndSharedScan() {
+  if (--num_shared_scans_ == 0) {
+    // A position is only worth attaching to while the scan that reported it may still be reading near it.
+    scan_position_.store(INVALID_PAGE_ID);
+  }
+}
+
+void TableHeap::LoadPageDirectory(Transaction *txn) {
+  if (directory_loaded_) {
+    return;
+  }
+  page_id_t page_id = first_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      // Leave the directory unloaded, so the next call tries again.
+      txn->SetState(TransactionState::ABORTED);
+      page_ids_.clear();
+      return;
+    }
+    page_ids_.push_back(page_id);
+    page->RLatch();
+    page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  directory_loaded_ = true;
+}
+
+bool TableHeap::ScanPage(page_id_t page_id, const Schema *schema, const CompiledPredicate *predicate,
+                         const Schema *projection, const ScanCallback &callback, Transaction *txn,
+                         page_id_t *next_page_id, const RowFilter *row_filter, BufferRing *ring) {
+  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPageWithRing(page_id, ring));
+  if (page == nullptr) {
+    if (txn != nullptr) {
+      txn->SetState(TransactionState::ABORTED);
+    }
+    *next_page_id = INVALID_PAGE_ID;
+    return false;
+  }
   page->RLatch();
-  RID rid;
-  // If this fails because there is no tuple, then RID will be the default-constructed value, which means EOF.
-  page->GetFirstTupleRid(&rid);
+  *next_page_id = page->GetNextPageId();
+  bool keep_going = true;
+  std::vector<Value> values;
+  const uint32_t slot_count = page->GetSlotCount();
+  for (uint32_t slot = 0; keep_going && slot < slot_count; slot++) {
+    keep_going = ScanSlot(page, slot, schema, predicate, projection, callback, txn, row_filter, &values);
+  }
   page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(first_page_id_, false);
-  return TableIterator(this, rid, txn);
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  return keep_going;
+}
+
+bool TableHeap::FetchSlots(page_id_t page_id, const std::vector<uint32_t> &slots, const Schema *schema,
+                           const CompiledPredicate *predicate, const Schema *projection, const ScanCallback &callback,
+                           Transaction *txn, const RowFilter *row_filter) {
+  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  if (page == nullptr) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  bool keep_going = ReadSlots(page, slots, schema, predicate, projection, callback, txn, row_filter);
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  return keep_going;
+}
+
+#ifdef BUSTUB_COROUTINES
+Task<bool> TableHeap::FetchSlotsAsync(CoroutineScheduler *scheduler, page_id_t page_id,
+                                      const std::vector<uint32_t> &slots, const Schema *schema,
+                                      const CompiledPredicate *predicate, const Schema *projection,
+                                      ScanCallback callback, Transaction *txn, const RowFilter *row_filter) {
+  auto page = static_cast<TablePage *>(co_await scheduler->FetchPage(page_id));
+  if (page == nullptr) {
+    txn->SetState(TransactionState::ABORTED);
+    co_return false;
+  }
+  bool keep_going = ReadSlots(page, slots, schema, predicate, projection, callback, txn, row_filter);
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  co_return keep_going;
+}
+#endif
+
+bool TableHeap::ReadSlots(TablePage *page, const std::vector<uint32_t> &slots, const Schema *schema,
+                          const CompiledPredicate *predicate, const Schema *projection, const ScanCallback &callback,
+                          Transaction *txn, const RowFilter *row_filter) {
+  page->RLatch();
+  bool keep_going = true;
+  std::vector<Value> values;
+  const uint32_t slot_count = page->GetSlotCount();
+  for (auto it = slots.begin(); keep_going && it != slots.end(); ++it) {
+    if (*it < slot_count) {
+      keep_going = ScanSlot(page, *it, schema, predicate, projection, callback, txn, row_filter, &values);
+    }
+  }
+  page->RUnlatch();
+  return keep_going;
+}
+
+bool TableHeap::ScanSlot(TablePage *page, uint32_t slot, const Schema *schema, const CompiledPredicate *predicate,
+                         const Schema *projection, const ScanCallback &callback, Transaction *txn,
+                         const RowFilter *row_filter, std::vector<Value> *values) {
+  // The view points into the page, so nothing is copied for tuples that fail the predicate.
+  TupleView view;
+  if (!page->GetTupleView(slot, &view)) {
+    return true;
+  }
+  Tuple tuple(view);
+  if (predicate != nullptr && !predicate->Evaluate(&tuple)) {
+    return true;
+  }
+  if (row_filter != nullptr && !(*row_filter)(tuple)) {
+    return true;
+  }
+  // Same locking as GetTuple, but only for the tuples we actually return.
+  RID rid = view.GetRid();
+  if (enable_logging && txn != nullptr && !txn->IsSharedLocked(rid) && !txn->IsExclusiveLocked(rid) &&
+      !lock_manager_->LockShared(txn, rid)) {
+    return false;
+  }
+  Tuple result;
+  if (projection == nullptr) {
+    result.allocated_ = true;
+    result.rid_ = rid;
+    result.size_ = view.GetLength();
+    result.data_ = new char[view.GetLength()];
+    memcpy(result.data_, view.GetData(), view.GetLength());
+  } else {
+    values->clear();
+    for (const auto &col : projection->GetColumns()) {
+      values->emplace_back(col.GetExpr()->Evaluate(&tuple, schema));
+    }
+    result = Tuple(*values, projection);
+    result.rid_ = rid;
+  }
+  return callback(&result);
+}
+
+TableIterator TableHeap::Begin(Transaction *txn) {
+  // The iterator skips forward to the first live tuple by itself, pinning the first page only once.
+  return TableIterator(this, RID(first_page_id_, 0), txn);
 }
 
 TableIterator TableHeap::End() { 
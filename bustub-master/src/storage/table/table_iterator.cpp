@@ -11,63 +11,140 @@
 //===----------------------------------------------------------------------===//
 
 #include <cassert>
+#include <cstring>
+#include <utility>
 
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn) : table_heap_(table_heap), txn_(txn) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
-    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+    Seek(rid.GetPageId(), rid.GetSlotNum());
   }
 }
 
+TableIterator::~TableIterator() { ReleasePage(); }
+
+TableIterator::TableIterator(const TableIterator &itr)
+    : table_heap_(itr.table_heap_), page_(itr.page_), tuple_(itr.tuple_), txn_(itr.txn_) {
+  if (page_ != nullptr) {
+    // Take our own pin, the page is already resident because itr pins it.
+    table_heap_->buffer_pool_manager_->FetchPage(page_->GetTablePageId());
+  }
+}
+
+TableIterator::TableIterator(TableIterator &&itr) noexcept
+    : table_heap_(itr.table_heap_), page_(itr.page_), tuple_(std::move(itr.tuple_)), txn_(itr.txn_) {
+  itr.page_ = nullptr;
+  itr.tuple_ = Tuple(RID(INVALID_PAGE_ID, 0));
+}
+
+TableIterator &TableIterator::operator=(const TableIterator &itr) {
+  if (this != &itr) {
+    TableIterator copy(itr);
+    *this = std::move(copy);
+  }
+  return *this;
+}
+
+TableIterator &TableIterator::operator=(TableIterator &&itr) noexcept {
+  if (this != &itr) {
+    ReleasePage();
+    table_heap_ = itr.table_heap_;
+    page_ = itr.page_;
+    tuple_ = std::move(itr.tuple_);
+    txn_ = itr.txn_;
+    itr.page_ = nullptr;
+    itr.tuple_ = Tuple(RID(INVALID_PAGE_ID, 0));
+  }
+  return *this;
+}
+
 const Tuple &TableIterator::operator*() {
-  assert(*this != table_heap_->End());
-  return *tuple_;
+  assert(page_ != nullptr);
+  return tuple_;
 }
 
 Tuple *TableIterator::operator->() {
-  assert(*this != table_heap_->End());
-  return tuple_;
+  assert(page_ != nullptr);
+  return &tuple_;
 }
 
 TableIterator &TableIterator::operator++() {
+  assert(page_ != nullptr);
+  Seek(tuple_.rid_.GetPageId(), tuple_.rid_.GetSlotNum() + 1);
+  return *this;
+}
+
+TableIterator TableIterator::operator++(int) {
+  TableIterator clone(*this);
+  ++(*this);
+  return clone;
+}
+
+void TableIterator::Seek(page_id_t page_id, uint32_t slot_num) {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  cur_page->RLatch();
-  assert(cur_page != nullptr);  // all pages are pinned
-
-  RID next_tuple_rid;
-  if (!cur_page->GetNextTupleRid(tuple_->rid_,
-                                 &next_tuple_rid)) {  // end of this page
-    while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
-      if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
+  while (page_id != INVALID_PAGE_ID) {
+    // Only go through the buffer pool when we move to a different page.
+    if (page_ == nullptr || page_->GetTablePageId() != page_id) {
+      ReleasePage();
+      page_ = static_cast<TablePage *>(buffer_pool_manager->FetchPage(page_id));
+      if (page_ == nullptr) {
+        // Same as TableHeap::GetTuple: a page that cannot be fetched aborts the transaction. End the scan.
+        if (txn_ != nullptr) {
+          txn_->SetState(TransactionState::ABORTED);
+        }
         break;
       }
     }
+    page_->RLatch();
+    const uint32_t slot_count = page_->GetSlotCount();
+    TupleView view;
+    for (; slot_num < slot_count; slot_num++) {
+      if (page_->GetTupleView(slot_num, &view)) {
+        // Same locking as TablePage::GetTuple: the tuple is only read once the shared lock is granted.
+        RID rid = view.GetRid();
+        if (enable_logging && txn_ != nullptr && !txn_->IsSharedLocked(rid) && !txn_->IsExclusiveLocked(rid) &&
+            !table_heap_->lock_manager_->LockShared(txn_, rid)) {
+          break;
+        }
+        // Copy the tuple before the latch goes, a writer may move it within the page afterwards.
+        CopyTuple(view);
+        page_->RUnlatch();
+        return;
+      }
+    }
+    if (slot_num < slot_count) {
+      // The shared lock was refused, which aborts the transaction. End the scan.
+      page_->RUnlatch();
+      break;
+    }
+    page_id = page_->GetNextPageId();
+    page_->RUnlatch();
+    slot_num = 0;
   }
-  tuple_->rid_ = next_tuple_rid;
+  ReleasePage();
+  tuple_ = Tuple(RID(INVALID_PAGE_ID, 0));
+}
 
-  if (*this != table_heap_->End()) {
-    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+void TableIterator::CopyTuple(const TupleView &view) {
+  // Tuples of a table mostly have the same length, so the buffer of the previous one can usually be reused.
+  if (!tuple_.allocated_ || tuple_.size_ != view.GetLength()) {
+    tuple_ = Tuple(view.GetRid());
+    tuple_.allocated_ = true;
+    tuple_.size_ = view.GetLength();
+    tuple_.data_ = new char[tuple_.size_];
   }
-  // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
-  return *this;
+  tuple_.rid_ = view.GetRid();
+  memcpy(tuple_.data_, view.GetData(), tuple_.size_);
 }
 
-TableIterator TableIterator::operator++(int) {
-  TableIterator clone(*this);
-  ++(*this);
-  return clone;
+void TableIterator::ReleasePage() {
+  if (page_ != nullptr) {
+    table_heap_->buffer_pool_manager_->UnpinPage(page_->GetTablePageId(), false);
+    page_ = nullptr;
+  }
 }
 
 }  // namespace bustub
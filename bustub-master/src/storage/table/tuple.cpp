@@ -21,35 +21,11 @@
 namespace bustub {
 
 // TODO(Amadou): It does not look like nulls are supported. Add a null bitmap?
-Tuple::Tuple(std::vector<Value> values, const Schema *schema) : allocated_(true) {
+Tuple::Tuple(const std::vector<Value> &values, const Schema *schema) : allocated_(true) {
   assert(values.size() == schema->GetColumnCount());
-
-  // 1. Calculate the size of the tuple.
-  uint32_t tuple_size = schema->GetLength();
-  for (auto &i : schema->GetUnlinedColumns()) {
-    tuple_size += (values[i].GetLength() + sizeof(uint32_t));
-  }
-
-  // 2. Allocate memory.
-  size_ = tuple_size;
+  size_ = TupleView::GetSerializedLength(values, schema);
   data_ = new char[size_];
-
-  // 3. Serialize each attribute based on the input value.
-  uint32_t column_count = schema->GetColumnCount();
-  uint32_t offset = schema->GetLength();
-
-  for (uint32_t i = 0; i < column_count; i++) {
-    const auto &col = schema->GetColumn(i);
-    if (!col.IsInlined()) {
-      // Serialize relative offset, where the actual varchar data is stored.
-      *reinterpret_cast<uint32_t *>(data_ + col.GetOffset()) = offset;
-      // Serialize varchar value, in place (size+data).
-      values[i].SerializeTo(data_ + offset);
-      offset += (values[i].GetLength() + sizeof(uint32_t));
-    } else {
-      values[i].SerializeTo(data_ + col.GetOffset());
-    }
-  }
+  TupleView::SerializeValues(values, schema, data_);
 }
 
 Tuple::Tuple(const Tuple &other) : allocated_(other.allocated_), rid_(other.rid_), size_(other.size_) {
@@ -86,6 +62,30 @@ Tuple &Tuple::operator=(const Tuple &other) {
   return *this;
 }
 
+Tuple::Tuple(Tuple &&other) noexcept
+    : allocated_(other.allocated_), rid_(other.rid_), size_(other.size_), data_(other.data_) {
+  other.allocated_ = false;
+  other.size_ = 0;
+  other.data_ = nullptr;
+}
+
+Tuple &Tuple::operator=(Tuple &&other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  if (allocated_) {
+    delete[] data_;
+  }
+  allocated_ = other.allocated_;
+  rid_ = other.rid_;
+  size_ = other.size_;
+  data_ = other.data_;
+  other.allocated_ = false;
+  other.size_ = 0;
+  other.data_ = nullptr;
+  return *this;
+}
+
 Value Tuple::GetValue(const Schema *schema, const uint32_t column_idx) const {
   assert(schema);
   assert(data_);
@@ -140,6 +140,16 @@ void Tuple::SerializeTo(char *storage) const {
   memcpy(storage + sizeof(int32_t), data_, size_);
 }
 
+Tuple Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema,
+                          const std::vector<uint32_t> &key_attrs) const {
+  std::vector<Value> values;
+  values.reserve(key_attrs.size());
+  for (uint32_t idx : key_attrs) {
+    values.emplace_back(GetValue(&schema, idx));
+  }
+  return Tuple(values, &key_schema);
+}
+
 void Tuple::DeserializeFrom(const char *storage) {
   uint32_t size = *reinterpret_cast<const uint32_t *>(storage);
   // Construct a tuple.
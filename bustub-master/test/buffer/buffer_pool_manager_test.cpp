@@ -75,4 +75,58 @@ TEST(BufferPoolManagerTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, BufferRingTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const page_id_t num_cold_pages = 30;
+  const page_id_t num_hot_pages = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Pages 0 to 29 are read once, pages 30 to 34 are the working set that is resident.
+  for (page_id_t i = 0; i < num_cold_pages + num_hot_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+  auto count_hot_misses = [&]() {
+    BufferPoolStats stats;
+    BufferPoolStats *saved = BufferPoolManager::SetThreadStats(&stats);
+    for (page_id_t i = num_cold_pages; i < num_cold_pages + num_hot_pages; i++) {
+      EXPECT_NE(nullptr, bpm->FetchPage(i));
+      bpm->UnpinPage(i, false);
+    }
+    BufferPoolManager::SetThreadStats(saved);
+    return static_cast<page_id_t>(stats.misses_);
+  };
+  auto read_cold_pages = [&](BufferRing *ring) {
+    for (page_id_t i = 0; i < num_cold_pages; i++) {
+      Page *page = bpm->FetchPageWithRing(i, ring);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+      bpm->UnpinPage(i, false);
+    }
+  };
+  EXPECT_EQ(0, count_hot_misses());
+
+  // Through a ring of two frames the cold pages evict at most two pages of the working set.
+  BufferRing ring(2);
+  read_cold_pages(&ring);
+  EXPECT_LE(count_hot_misses(), 2);
+
+  // Without a ring they flush the whole working set out.
+  read_cold_pages(nullptr);
+  EXPECT_EQ(num_hot_pages, count_hot_misses());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
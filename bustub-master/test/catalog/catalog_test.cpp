@@ -16,6 +16,7 @@
 
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/simple_catalog.h"
+#include "concurrency/transaction.h"
 #include "gtest/gtest.h"
 #include "type/value_factory.h"
 
@@ -48,4 +49,117 @@ TEST(CatalogTest, CreateTableTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(CatalogTest, AnalyzeTableTest) {
+  auto disk_manager = new DiskManager("catalog_test.db");
+  auto bpm = new BufferPoolManager(32, disk_manager);
+  auto catalog = new SimpleCatalog(bpm, nullptr, nullptr);
+  Transaction txn(0);
+
+  // A is unique, B is 7 in half of the rows and otherwise spread over 50 values, C is NULL in every fourth row.
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::INTEGER);
+  columns.emplace_back("B", TypeId::INTEGER);
+  columns.emplace_back("C", TypeId::INTEGER);
+  Schema schema(columns);
+  TableMetadata *table = catalog->CreateTable(&txn, "stats", schema);
+  EXPECT_EQ(nullptr, catalog->GetTableStats(table->oid_));
+  const uint32_t num_rows = 2000;
+  for (uint32_t i = 0; i < num_rows; i++) {
+    std::vector<Value> values{ValueFactory::GetIntegerValue(i),
+                              ValueFactory::GetIntegerValue(i < num_rows / 2 ? 7 : i % 50),
+                              i % 4 == 0 ? ValueFactory::GetNullValueByType(TypeId::INTEGER)
+                                         : ValueFactory::GetIntegerValue(i % 5)};
+    RID rid;
+    ASSERT_TRUE(table->table_->InsertTuple(Tuple(values, &schema), &rid, &txn));
+  }
+
+  const TableStats *stats = catalog->AnalyzeTable(&txn, "stats");
+  ASSERT_EQ(stats, catalog->GetTableStats(table->oid_));
+  EXPECT_EQ(num_rows, stats->num_rows_);
+  ASSERT_EQ(3, stats->columns_.size());
+  const ColumnStats &a = stats->columns_[0];
+  const ColumnStats &b = stats->columns_[1];
+  const ColumnStats &c = stats->columns_[2];
+  EXPECT_EQ(num_rows, a.num_distinct_);
+  EXPECT_EQ(50, b.num_distinct_);
+  EXPECT_EQ(5, c.num_distinct_);
+  EXPECT_EQ(num_rows / 4, c.num_nulls_);
+  EXPECT_EQ(Histogram::MAX_BUCKETS, a.histogram_.GetNumBuckets());
+
+  // Range estimates on the uniform column are close, and nothing lies outside the range.
+  EXPECT_NEAR(0.25, a.EstimateLessThan(ValueFactory::GetIntegerValue(500), false), 0.01);
+  EXPECT_NEAR(0.5, a.EstimateLessThan(ValueFactory::GetIntegerValue(999), true), 0.01);
+  EXPECT_EQ(0, a.EstimateLessThan(ValueFactory::GetIntegerValue(-1), true));
+  EXPECT_EQ(1, a.EstimateLessThan(ValueFactory::GetIntegerValue(num_rows), false));
+  EXPECT_EQ(0, a.EstimateEqual(ValueFactory::GetIntegerValue(num_rows)));
+
+  // The heavy hitter fills buckets of its own; the other values share what is left.
+  EXPECT_NEAR(0.5, b.EstimateEqual(ValueFactory::GetIntegerValue(7)), 0.05);
+  EXPECT_NEAR(1.0 / 50, b.EstimateEqual(ValueFactory::GetIntegerValue(8)), 0.001);
+
+  // NULLs never match.
+  EXPECT_NEAR(0.75 / 5, c.EstimateEqual(ValueFactory::GetIntegerValue(3)), 0.01);
+  EXPECT_NEAR(0.75, c.EstimateLessThan(ValueFactory::GetIntegerValue(4), true), 0.001);
+
+  delete catalog;
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, SampleAnalyzeTest) {
+  auto disk_manager = new DiskManager("catalog_test.db");
+  auto bpm = new BufferPoolManager(32, disk_manager);
+  auto catalog = new SimpleCatalog(bpm, nullptr, nullptr);
+  Transaction txn(0);
+
+  // A is unique, B takes 100 values, C is NULL in every fourth row.
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::INTEGER);
+  columns.emplace_back("B", TypeId::INTEGER);
+  columns.emplace_back("C", TypeId::INTEGER);
+  Schema schema(columns);
+  TableMetadata *table = catalog->CreateTable(&txn, "sample", schema);
+  const uint32_t num_rows = 20000;
+  for (uint32_t i = 0; i < num_rows; i++) {
+    std::vector<Value> values{ValueFactory::GetIntegerValue(i), ValueFactory::GetIntegerValue(i * 7 % 100),
+                              i % 4 == 0 ? ValueFactory::GetNullValueByType(TypeId::INTEGER)
+                                         : ValueFactory::GetIntegerValue(i)};
+    RID rid;
+    ASSERT_TRUE(table->table_->InsertTuple(Tuple(values, &schema), &rid, &txn));
+  }
+  size_t num_pages = table->table_->GetNumPages(&txn);
+  ASSERT_GT(num_pages, 40);
+  EXPECT_EQ(table->table_->GetPageIds(&txn).back(), table->table_->GetPageId(num_pages - 1));
+
+  // A fifth of the pages, and a reservoir of 2000 rows. Whole pages are sampled, so the values of the serial column A
+  // come in clusters and only the histograms of B and C are as good as those of a row sample of the same size.
+  auto sample = TableStats::AnalyzeSample(table->table_.get(), schema, &txn, num_pages / 5, 2000, 42);
+  const TableStats *stats = sample.get();
+  EXPECT_NEAR(num_rows, stats->num_rows_, num_rows * 0.05);
+  EXPECT_EQ(2000, stats->num_sampled_rows_);
+  const ColumnStats &a = stats->columns_[0];
+  const ColumnStats &b = stats->columns_[1];
+  const ColumnStats &c = stats->columns_[2];
+  EXPECT_NEAR(num_rows, a.num_distinct_, num_rows * 0.1);
+  EXPECT_NEAR(100, b.num_distinct_, 5);
+  EXPECT_NEAR(num_rows * 0.75, c.num_distinct_, num_rows * 0.1);
+  EXPECT_NEAR(0.25, c.GetNullFraction(), 0.02);
+  EXPECT_NEAR(0.5, b.EstimateLessThan(ValueFactory::GetIntegerValue(50), false), 0.05);
+  EXPECT_NEAR(0.01, b.EstimateEqual(ValueFactory::GetIntegerValue(42)), 0.005);
+
+  // Sampling every page counts the distinct values with the sketches alone.
+  stats = catalog->AnalyzeTable(&txn, "sample", num_pages);
+  EXPECT_EQ(stats, catalog->GetTableStats(table->oid_));
+  EXPECT_EQ(num_rows, stats->num_rows_);
+  EXPECT_NEAR(num_rows, stats->columns_[0].num_distinct_, num_rows * 0.04);
+  EXPECT_NEAR(100, stats->columns_[1].num_distinct_, 2);
+  EXPECT_EQ(num_rows / 4, stats->columns_[2].num_nulls_);
+
+  delete catalog;
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// task_pool_test.cpp
+//
+// Identification: test/common/task_pool_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <future>  // NOLINT
+#include <mutex>   // NOLINT
+#include <stdexcept>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/task_pool.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(TaskPoolTest, ParallelForTest) {
+  TaskPool pool(4);
+  std::atomic<int> sum{0};
+  pool.ParallelFor(100, [&sum](size_t i) { sum += static_cast<int>(i); });
+  EXPECT_EQ(4950, sum);
+
+  // Nested calls run on the workers and on the calling task.
+  std::atomic<int> count{0};
+  pool.ParallelFor(8, [&pool, &count](size_t) { pool.ParallelFor(8, [&count](size_t) { count++; }); });
+  EXPECT_EQ(64, count);
+
+  EXPECT_THROW(pool.ParallelFor(10,
+                                [](size_t i) {
+                                  if (i == 7) {
+                                    throw std::runtime_error("fail");
+                                  }
+                                }),
+               std::runtime_error);
+
+  std::future<std::string> result = pool.Submit([] { return std::string("done"); });
+  EXPECT_EQ("done", result.get());
+}
+
+// NOLINTNEXTLINE
+TEST(TaskPoolTest, PriorityTest) {
+  TaskPool pool(1);
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::promise<void> started;
+  pool.Post([&started, released] {
+    started.set_value();
+    released.wait();
+  });
+  started.get_future().wait();
+
+  // The only worker is busy, so all tasks are queued when it takes the next one.
+  std::mutex latch;
+  std::vector<std::string> order;
+  auto record = [&latch, &order](const std::string &name) {
+    return [&latch, &order, name] {
+      std::lock_guard<std::mutex> guard(latch);
+      order.push_back(name);
+    };
+  };
+  std::future<void> background1 = pool.Submit(record("background 1"), TaskPriority::BACKGROUND);
+  std::future<void> background2 = pool.Submit(record("background 2"), TaskPriority::BACKGROUND);
+  std::future<void> foreground1 = pool.Submit(record("foreground 1"));
+  std::future<void> foreground2 = pool.Submit(record("foreground 2"));
+  release.set_value();
+  background1.wait();
+  background2.wait();
+  foreground1.wait();
+  foreground2.wait();
+
+  // Foreground tasks go first, and tasks posted from outside the pool run in the order they were posted.
+  std::vector<std::string> expected{"foreground 1", "foreground 2", "background 1", "background 2"};
+  EXPECT_EQ(expected, order);
+  TaskPoolStats stats = pool.GetStats();
+  EXPECT_EQ(3, stats.foreground_tasks_);
+  EXPECT_EQ(2, stats.background_tasks_);
+}
+
+// NOLINTNEXTLINE
+TEST(TaskPoolTest, PeriodicTest) {
+  TaskPool pool(2);
+  std::atomic<int> runs{0};
+  periodic_task_id_t id = pool.SchedulePeriodic(std::chrono::milliseconds(5), [&runs] { runs++; });
+  while (runs < 3) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  pool.CancelPeriodic(id);
+  int cancelled_runs = runs;
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  EXPECT_EQ(cancelled_runs, runs);
+  EXPECT_GE(pool.GetStats().periodic_runs_, 3);
+
+  // Cancelling twice is harmless.
+  pool.CancelPeriodic(id);
+  pool.CancelPeriodic(TaskPool::NO_PERIODIC_TASK);
+}
+
+}  // namespace bustub
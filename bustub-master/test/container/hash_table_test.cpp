@@ -139,6 +139,58 @@ TEST(HashTableTest, ResizeTest) {
 }
 
 
+// NOLINTNEXTLINE
+TEST(HashTableTest, GrowFailureTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 1, HashFunction<int>());
+
+  // The most slots the header page can hold blocks for, and a size the table can only grow to that from.
+  const size_t max_size = (PAGE_SIZE - 32) / sizeof(page_id_t) * ht.GetSize();
+  const size_t size = max_size / 5 * 3;
+  ht.Resize(size);
+  ASSERT_EQ(size, ht.GetSize());
+
+  // Keys that hash to the last 100 slots of the largest table, but are spread over the current one.
+  HashFunction<int> hash_fn;
+  std::vector<int> inserted;
+  int key = 0;
+  while (inserted.size() < 150) {
+    if (hash_fn.GetHash(key) % max_size >= max_size - 100) {
+      ASSERT_TRUE(ht.Insert(nullptr, key, key));
+      inserted.push_back(key);
+    }
+    key++;
+  }
+
+  // Fill the last slots of the current table until a key runs off its end. The table cannot grow: the keys above do
+  // not fit at the end of the largest one.
+  bool failed = false;
+  for (; !failed && key < 100000000; key++) {
+    if (hash_fn.GetHash(key) % size < size - 10) {
+      continue;
+    }
+    if (ht.Insert(nullptr, key, key)) {
+      inserted.push_back(key);
+    } else {
+      failed = true;
+    }
+  }
+  EXPECT_TRUE(failed);
+  EXPECT_EQ(size, ht.GetSize());
+
+  // The insert that could not fit failed, and the table kept every pair it held.
+  for (int inserted_key : inserted) {
+    std::vector<int> values;
+    EXPECT_TRUE(ht.GetValue(nullptr, inserted_key, &values)) << "Lost " << inserted_key;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 std::mutex ht_mtx;
 void ConcurrencyThreadFunc(LinearProbeHashTable<int, int, IntComparator> *ht, int n) {
 
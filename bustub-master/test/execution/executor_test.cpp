@@ -10,27 +10,62 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <cstring>
+#include <map>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <numeric>
+#include <set>
 #include <string>
+#include <thread>  // NOLINT
+#include <tuple>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/table_generator.h"
+#include "execution/admission_controller.h"
+#include "execution/bloom_filter.h"
+#include "execution/compiled_predicate.h"
 #include "concurrency/transaction_manager.h"
 #include "execution/executor_context.h"
 #include "execution/executor_factory.h"
 #include "execution/executors/aggregation_executor.h"
+#include "execution/executors/distinct_executor.h"
 #include "execution/executors/hash_join_executor.h"
+#include "execution/executors/index_scan_executor.h"
 #include "execution/executors/insert_executor.h"
+#include "execution/executors/limit_executor.h"
+#include "execution/executors/seq_scan_executor.h"
+#include "execution/executors/sort_executor.h"
+#include "execution/executors/stream_aggregation_executor.h"
+#include "execution/executors/topn_executor.h"
 #include "execution/expressions/aggregate_value_expression.h"
 #include "execution/expressions/column_value_expression.h"
 #include "execution/expressions/comparison_expression.h"
 #include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "execution/external_aggregation.h"
+#include "execution/external_distinct.h"
+#include "execution/memory_tracker.h"
+#include "execution/parallel_aggregation.h"
+#include "execution/packed_aggregation_hash_table.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/limit_plan.h"
 #include "execution/plans/seq_scan_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/plans/topn_plan.h"
+#include "execution/plans/view_scan_plan.h"
+#include "execution/query_profile.h"
+#include "execution/result_cache.h"
 #include "gtest/gtest.h"
+#include "optimizer/join_order_optimizer.h"
+#include "optimizer/projection_pushdown.h"
 #include "type/value_factory.h"
 
 namespace bustub {
@@ -67,6 +102,12 @@ class ExecutorTest : public ::testing::Test {
   /** @return the executor context in our test class */
   ExecutorContext *GetExecutorContext() { return exec_ctx_.get(); }
 
+  /** @return the disk manager in our test class */
+  DiskManager *GetDiskManager() { return disk_manager_.get(); }
+
+  /** @return the transaction manager in our test class */
+  TransactionManager *GetTxnManager() { return txn_mgr_.get(); }
+
   // The below helper functions are useful for testing.
 
   const AbstractExpression *MakeColumnValueExpression(const Schema &schema, uint32_t tuple_idx,
@@ -88,6 +129,12 @@ class ExecutorTest : public ::testing::Test {
     return allocated_exprs_.back().get();
   }
 
+  const AbstractExpression *MakeLogicExpression(const AbstractExpression *lhs, const AbstractExpression *rhs,
+                                                LogicType logic_type) {
+    allocated_exprs_.emplace_back(std::make_unique<LogicExpression>(lhs, rhs, logic_type));
+    return allocated_exprs_.back().get();
+  }
+
   const AbstractExpression *MakeAggregateValueExpression(bool is_group_by_term, uint32_t term_idx) {
     allocated_exprs_.emplace_back(
         std::make_unique<AggregateValueExpression>(is_group_by_term, term_idx, TypeId::INTEGER));
@@ -318,6 +365,40 @@ TEST_F(ExecutorTest, SimpleHashJoinTest) {
     num_tuples++;
   }
   ASSERT_EQ(num_tuples, 100);
+
+  // Output columns come from the side their expressions refer to, and the join keys match.
+  executor->Init();
+  num_tuples = 0;
+  while (executor->Next(&tuple)) {
+    ASSERT_EQ(tuple.GetLength(), out_final->GetLength());
+    auto colA_val = tuple.GetValue(out_final, out_final->GetColIdx("colA")).GetAs<int32_t>();
+    auto col1_val = tuple.GetValue(out_final, out_final->GetColIdx("col1")).GetAs<int16_t>();
+    ASSERT_EQ(colA_val, col1_val);
+    num_tuples++;
+  }
+  ASSERT_EQ(num_tuples, 100);
+
+  // Without a predicate the join compares the keys. NULLs are left out of the hash, so (colA, NULL) and (NULL, col1)
+  // hash alike where colA = col1, but NULL equals nothing.
+  auto colA = MakeColumnValueExpression(*out_schema1, 0, "colA");
+  auto col1 = MakeColumnValueExpression(*out_schema2, 1, "col1");
+  auto null_key = MakeConstantValueExpression(ValueFactory::GetNullValueByType(TypeId::INTEGER));
+  auto count = [&](std::vector<const AbstractExpression *> left_keys,
+                   std::vector<const AbstractExpression *> right_keys) {
+    HashJoinPlanNode plan(out_final, {scan_plan1.get(), scan_plan2.get()}, nullptr, std::move(left_keys),
+                          std::move(right_keys));
+    auto join = ExecutorFactory::CreateExecutor(GetExecutorContext(), &plan);
+    join->Init();
+    uint32_t num_joined = 0;
+    while (join->Next(&tuple)) {
+      EXPECT_EQ(tuple.GetValue(out_final, out_final->GetColIdx("colA")).GetAs<int32_t>(),
+                tuple.GetValue(out_final, out_final->GetColIdx("col1")).GetAs<int16_t>());
+      num_joined++;
+    }
+    return num_joined;
+  };
+  EXPECT_EQ(100, count({colA}, {col1}));
+  EXPECT_EQ(0, count({colA, null_key}, {null_key, col1}));
 }
 
 // NOLINTNEXTLINE
@@ -433,4 +514,1801 @@ TEST_F(ExecutorTest, SimpleGroupByAggregation) {
   }
 }
 
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, TableIteratorTest) {
+  auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto *table = table_info->table_.get();
+  auto *txn = GetExecutorContext()->GetTransaction();
+
+  // Every tuple comes out once, in order, copied out of the page, and matches what GetTuple copies.
+  int32_t expected_colA = 0;
+  for (auto iter = table->Begin(txn); iter != table->End(); ++iter) {
+    ASSERT_TRUE(iter->IsAllocated());
+    Tuple copy;
+    ASSERT_TRUE(table->GetTuple(iter->GetRid(), &copy, txn));
+    ASSERT_EQ(copy.GetLength(), iter->GetLength());
+    ASSERT_EQ(memcmp(copy.GetData(), iter->GetData(), copy.GetLength()), 0);
+    ASSERT_EQ(iter->GetValue(&schema, 0).GetAs<int32_t>(), expected_colA++);
+  }
+  ASSERT_EQ(expected_colA, TEST1_SIZE);
+
+  // Copies keep their own position; postfix increment returns the old one.
+  auto iter = table->Begin(txn);
+  auto copy = iter;
+  auto old = iter++;
+  ASSERT_EQ(copy, old);
+  ASSERT_EQ(copy->GetValue(&schema, 0).GetAs<int32_t>(), 0);
+  ASSERT_EQ(iter->GetValue(&schema, 0).GetAs<int32_t>(), 1);
+  copy = iter;
+  ASSERT_EQ(copy->GetValue(&schema, 0).GetAs<int32_t>(), 1);
+  copy = table->End();
+  ASSERT_EQ(copy, table->End());
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, TableHeapFilteredScanTest) {
+  // SELECT colC, colA FROM test_1 WHERE colB = 3 AND colA >= 100
+  auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto *colA = MakeColumnValueExpression(schema, 0, "colA");
+  auto *colB = MakeColumnValueExpression(schema, 0, "colB");
+  auto *colC = MakeColumnValueExpression(schema, 0, "colC");
+  auto *predicate = MakeLogicExpression(
+      MakeComparisonExpression(colB, MakeConstantValueExpression(ValueFactory::GetIntegerValue(3)),
+                               ComparisonType::Equal),
+      MakeComparisonExpression(colA, MakeConstantValueExpression(ValueFactory::GetIntegerValue(100)),
+                               ComparisonType::GreaterThanOrEqual),
+      LogicType::And);
+  auto *out_schema = MakeOutputSchema({{"colC", colC}, {"colA", colA}});
+  auto compiled = CompiledPredicate::Compile(predicate, &schema);
+  auto *txn = GetExecutorContext()->GetTransaction();
+
+  // The expected result, computed by copying every tuple out through the iterator.
+  std::vector<RID> expected;
+  for (auto iter = table_info->table_->Begin(txn); iter != table_info->table_->End(); ++iter) {
+    if (predicate->Evaluate(&*iter, &schema).GetAs<bool>()) {
+      expected.push_back(iter->GetRid());
+    }
+  }
+  ASSERT_FALSE(expected.empty());
+
+  std::vector<RID> actual;
+  table_info->table_->Scan(&schema, compiled.get(), out_schema,
+                           [&](Tuple *tuple) {
+                             EXPECT_EQ(tuple->GetLength(), out_schema->GetLength());
+                             Tuple full;
+                             EXPECT_TRUE(table_info->table_->GetTuple(tuple->GetRid(), &full, txn));
+                             EXPECT_EQ(tuple->GetValue(out_schema, 0).GetAs<int32_t>(),
+                                       full.GetValue(&schema, schema.GetColIdx("colC")).GetAs<int32_t>());
+                             EXPECT_EQ(tuple->GetValue(out_schema, 1).GetAs<int32_t>(),
+                                       full.GetValue(&schema, schema.GetColIdx("colA")).GetAs<int32_t>());
+                             actual.push_back(tuple->GetRid());
+                             return true;
+                           },
+                           txn);
+  ASSERT_EQ(actual, expected);
+
+  // Returning false from the callback stops the scan.
+  uint32_t num_seen = 0;
+  table_info->table_->Scan(&schema, nullptr, nullptr,
+                           [&](Tuple *tuple) {
+                             EXPECT_EQ(tuple->GetLength(), schema.GetLength());
+                             return ++num_seen < 10;
+                           },
+                           txn);
+  ASSERT_EQ(num_seen, 10);
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, CompiledPredicateTest) {
+  auto *const_true = MakeComparisonExpression(MakeConstantValueExpression(ValueFactory::GetIntegerValue(1)),
+                                              MakeConstantValueExpression(ValueFactory::GetIntegerValue(2)),
+                                              ComparisonType::LessThan);
+  auto *const_null = MakeConstantValueExpression(ValueFactory::GetNullValueByType(TypeId::INTEGER));
+
+  // Every predicate must agree with the interpreter on every tuple, where NULL counts as false.
+  auto check_same = [&](const TableMetadata *table_info, const AbstractExpression *predicate) {
+    auto compiled = CompiledPredicate::Compile(predicate, &table_info->schema_);
+    uint32_t num_matched = 0;
+    auto *table = table_info->table_.get();
+    for (auto iter = table->Begin(GetExecutorContext()->GetTransaction()); iter != table->End(); ++iter) {
+      Value expected = predicate->Evaluate(&*iter, &table_info->schema_);
+      bool expected_match = !expected.IsNull() && expected.GetAs<int8_t>() != 0;
+      EXPECT_EQ(compiled->Evaluate(&*iter), expected_match);
+      num_matched += expected_match ? 1 : 0;
+    }
+    return num_matched;
+  };
+
+  {
+    // test_1: colA < 500 AND colB = 3, colB > 7 OR colC <= 100, colA < 500.5
+    auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+    auto &schema = table_info->schema_;
+    auto *colA = MakeColumnValueExpression(schema, 0, "colA");
+    auto *colB = MakeColumnValueExpression(schema, 0, "colB");
+    auto *colC = MakeColumnValueExpression(schema, 0, "colC");
+    auto *and_pred = MakeLogicExpression(
+        MakeComparisonExpression(colA, MakeConstantValueExpression(ValueFactory::GetIntegerValue(500)),
+                                 ComparisonType::LessThan),
+        MakeComparisonExpression(colB, MakeConstantValueExpression(ValueFactory::GetIntegerValue(3)),
+                                 ComparisonType::Equal),
+        LogicType::And);
+    auto *or_pred = MakeLogicExpression(
+        MakeComparisonExpression(colB, MakeConstantValueExpression(ValueFactory::GetIntegerValue(7)),
+                                 ComparisonType::GreaterThan),
+        MakeComparisonExpression(colC, MakeConstantValueExpression(ValueFactory::GetIntegerValue(100)),
+                                 ComparisonType::LessThanOrEqual),
+        LogicType::Or);
+    auto *decimal_pred = MakeComparisonExpression(
+        colA, MakeConstantValueExpression(ValueFactory::GetDecimalValue(500.5)), ComparisonType::LessThan);
+
+    ASSERT_TRUE(CompiledPredicate::Compile(and_pred, &schema)->IsFullyCompiled());
+    ASSERT_TRUE(CompiledPredicate::Compile(or_pred, &schema)->IsFullyCompiled());
+    check_same(table_info, and_pred);
+    check_same(table_info, or_pred);
+    ASSERT_EQ(check_same(table_info, decimal_pred), 501);
+
+    // Constant folding: TRUE AND p is p, FALSE AND p is FALSE, comparisons against NULL are never true.
+    auto *colA_lt_10 = MakeComparisonExpression(colA, MakeConstantValueExpression(ValueFactory::GetIntegerValue(10)),
+                                                ComparisonType::LessThan);
+    auto folded = CompiledPredicate::Compile(MakeLogicExpression(const_true, colA_lt_10, LogicType::And), &schema);
+    ASSERT_EQ(folded->GetProgram().size(), 1);
+    ASSERT_EQ(folded->GetProgram()[0].op_, PredicateOpCode::Compare);
+    ASSERT_EQ(check_same(table_info, MakeLogicExpression(const_true, colA_lt_10, LogicType::And)), 10);
+
+    auto *const_false = MakeComparisonExpression(const_null, const_null, ComparisonType::Equal);
+    auto always_false =
+        CompiledPredicate::Compile(MakeLogicExpression(colA_lt_10, const_false, LogicType::And), &schema);
+    ASSERT_TRUE(always_false->IsConstant());
+    auto *null_cmp = MakeComparisonExpression(colA, const_null, ComparisonType::NotEqual);
+    ASSERT_TRUE(CompiledPredicate::Compile(null_cmp, &schema)->IsConstant());
+    ASSERT_EQ(check_same(table_info, null_cmp), 0);
+  }
+
+  {
+    // test_2 mixes SMALLINT, BIGINT and nullable INTEGER columns.
+    auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_2");
+    auto &schema = table_info->schema_;
+    auto *col1 = MakeColumnValueExpression(schema, 0, "col1");
+    auto *col2 = MakeColumnValueExpression(schema, 0, "col2");
+    auto *col3 = MakeColumnValueExpression(schema, 0, "col3");
+    auto *col4 = MakeColumnValueExpression(schema, 0, "col4");
+    auto *col1_ge_50 = MakeComparisonExpression(col1, MakeConstantValueExpression(ValueFactory::GetBigIntValue(50)),
+                                                ComparisonType::GreaterThanOrEqual);
+    auto *pred = MakeLogicExpression(
+        MakeLogicExpression(col1_ge_50, MakeComparisonExpression(col3, col1, ComparisonType::LessThan), LogicType::And),
+        MakeComparisonExpression(col4, col2, ComparisonType::GreaterThan), LogicType::Or);
+    ASSERT_TRUE(CompiledPredicate::Compile(pred, &schema)->IsFullyCompiled());
+    check_same(table_info, pred);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, PackedAggregationTest) {
+  // SELECT col2, COUNT(col1), SUM(col3), MIN(col1), MAX(col4) FROM test_2 GROUP BY col2
+  auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_2");
+  auto &schema = table_info->schema_;
+  std::unique_ptr<AbstractPlanNode> scan_plan;
+  const Schema *scan_schema;
+  {
+    auto col1 = MakeColumnValueExpression(schema, 0, "col1");
+    auto col2 = MakeColumnValueExpression(schema, 0, "col2");
+    auto col3 = MakeColumnValueExpression(schema, 0, "col3");
+    auto col4 = MakeColumnValueExpression(schema, 0, "col4");
+    scan_schema = MakeOutputSchema({{"col1", col1}, {"col2", col2}, {"col3", col3}, {"col4", col4}});
+    scan_plan = std::make_unique<SeqScanPlanNode>(scan_schema, nullptr, table_info->oid_);
+  }
+
+  std::unique_ptr<AbstractPlanNode> agg_plan;
+  const Schema *agg_schema;
+  std::vector<const AbstractExpression *> group_by_cols;
+  std::vector<const AbstractExpression *> aggregate_cols;
+  std::vector<AggregationType> agg_types{AggregationType::CountAggregate, AggregationType::SumAggregate,
+                                         AggregationType::MinAggregate, AggregationType::MaxAggregate};
+  {
+    const AbstractExpression *col1 = MakeColumnValueExpression(*scan_schema, 0, "col1");
+    const AbstractExpression *col2 = MakeColumnValueExpression(*scan_schema, 0, "col2");
+    const AbstractExpression *col3 = MakeColumnValueExpression(*scan_schema, 0, "col3");
+    const AbstractExpression *col4 = MakeColumnValueExpression(*scan_schema, 0, "col4");
+    group_by_cols = {col2};
+    aggregate_cols = {col1, col3, col1, col4};
+    agg_schema = MakeOutputSchema({{"col2", MakeAggregateValueExpression(true, 0)},
+                                   {"count1", MakeAggregateValueExpression(false, 0)},
+                                   {"sum3", MakeAggregateValueExpression(false, 1)},
+                                   {"min1", MakeAggregateValueExpression(false, 2)},
+                                   {"max4", MakeAggregateValueExpression(false, 3)}});
+    agg_plan = std::make_unique<AggregationPlanNode>(
+        agg_schema, scan_plan.get(), nullptr, std::vector<const AbstractExpression *>(group_by_cols),
+        std::vector<const AbstractExpression *>(aggregate_cols), std::vector<AggregationType>(agg_types));
+  }
+  ASSERT_TRUE(PackedAggregationHashTable::CanHandle(scan_schema, group_by_cols, aggregate_cols, agg_types));
+
+  // Compute the expected groups by hand.
+  struct Expected {
+    int32_t count_{0};
+    int64_t sum_{0};
+    int16_t min_{BUSTUB_INT16_MAX};
+    int32_t max_{BUSTUB_INT32_MIN};
+  };
+  std::unordered_map<int32_t, Expected> expected;
+  for (auto iter = table_info->table_->Begin(GetExecutorContext()->GetTransaction()); iter != table_info->table_->End();
+       ++iter) {
+    auto &group = expected[iter->GetValue(&schema, 1).GetAs<int32_t>()];
+    group.count_++;
+    group.sum_ += iter->GetValue(&schema, 2).GetAs<int64_t>();
+    group.min_ = std::min(group.min_, iter->GetValue(&schema, 0).GetAs<int16_t>());
+    group.max_ = std::max(group.max_, iter->GetValue(&schema, 3).GetAs<int32_t>());
+  }
+
+  auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), agg_plan.get());
+  executor->Init();
+  Tuple tuple;
+  uint32_t num_groups = 0;
+  while (executor->Next(&tuple)) {
+    auto key = tuple.GetValue(agg_schema, 0).GetAs<int32_t>();
+    ASSERT_EQ(expected.count(key), 1);
+    const auto &group = expected[key];
+    EXPECT_EQ(tuple.GetValue(agg_schema, 1).GetAs<int32_t>(), group.count_);
+    EXPECT_EQ(tuple.GetValue(agg_schema, 2).GetAs<int32_t>(), group.sum_);
+    EXPECT_EQ(tuple.GetValue(agg_schema, 3).GetAs<int16_t>(), group.min_);
+    EXPECT_EQ(tuple.GetValue(agg_schema, 4).GetAs<int32_t>(), group.max_);
+    num_groups++;
+  }
+  EXPECT_EQ(num_groups, expected.size());
+
+  // NULL keys form one group, and NULL inputs make SUM, MIN and MAX NULL.
+  PackedAggregationHashTable aht(scan_schema, group_by_cols, aggregate_cols, agg_types);
+  auto null_int = ValueFactory::GetNullValueByType(TypeId::INTEGER);
+  for (int32_t i = 0; i < 10; i++) {
+    std::vector<Value> values{ValueFactory::GetSmallIntValue(static_cast<int16_t>(i)),
+                              i % 2 == 0 ? null_int : ValueFactory::GetIntegerValue(1),
+                              ValueFactory::GetBigIntValue(i), i == 1 ? null_int : ValueFactory::GetIntegerValue(i)};
+    aht.InsertCombine(Tuple(values, scan_schema));
+  }
+  ASSERT_EQ(aht.Size(), 2);
+  std::vector<Value> group_bys;
+  std::vector<Value> aggregates;
+  for (uint32_t i = 0; i < aht.Size(); i++) {
+    aht.GetGroup(i, &group_bys, &aggregates);
+    EXPECT_EQ(aggregates[0].GetAs<int32_t>(), 5);
+    if (group_bys[0].IsNull()) {
+      EXPECT_EQ(aggregates[1].GetAs<int64_t>(), 0 + 2 + 4 + 6 + 8);
+      EXPECT_EQ(aggregates[2].GetAs<int16_t>(), 0);
+      EXPECT_EQ(aggregates[3].GetAs<int32_t>(), 8);
+    } else {
+      EXPECT_EQ(aggregates[1].GetAs<int64_t>(), 1 + 3 + 5 + 7 + 9);
+      EXPECT_EQ(aggregates[2].GetAs<int16_t>(), 1);
+      EXPECT_TRUE(aggregates[3].IsNull());
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, ExternalAggregationTest) {
+  // SELECT k, COUNT(v), SUM(v), MIN(v), MAX(v) FROM t GROUP BY k, over 10x more groups than fit in the budget.
+  Schema schema({Column("k", TypeId::INTEGER), Column("v", TypeId::BIGINT)});
+  ColumnValueExpression k(0, 0, TypeId::INTEGER);
+  ColumnValueExpression v(0, 1, TypeId::BIGINT);
+  std::vector<const AbstractExpression *> group_bys{&k};
+  std::vector<const AbstractExpression *> aggregates{&v, &v, &v, &v};
+  std::vector<AggregationType> agg_types{AggregationType::CountAggregate, AggregationType::SumAggregate,
+                                         AggregationType::MinAggregate, AggregationType::MaxAggregate};
+  const int32_t num_groups = 20000;
+  std::vector<Tuple> tuples;
+  for (int64_t round = 0; round < 3; round++) {
+    for (int32_t i = 0; i < num_groups; i++) {
+      int32_t key = (i * 7919) % num_groups;
+      tuples.emplace_back(std::vector<Value>{ValueFactory::GetIntegerValue(key),
+                                             ValueFactory::GetBigIntValue(key + round * num_groups)},
+                          &schema);
+    }
+  }
+
+  PackedAggregationHashTable in_memory(&schema, group_bys, aggregates, agg_types);
+  for (const auto &tuple : tuples) {
+    in_memory.InsertCombine(tuple);
+  }
+  size_t budget = in_memory.GetMemoryUsage() / 10;
+
+  PackedAggregationHashTable table(&schema, group_bys, aggregates, agg_types);
+  ExternalAggregation external(&table, GetExecutorContext()->GetBufferPoolManager(), budget,
+                               GetExecutorContext()->GetMemoryTracker());
+  for (const auto &tuple : tuples) {
+    external.Insert(tuple);
+    ASSERT_LE(table.GetMemoryUsage(), budget);
+  }
+  external.Finish();
+  EXPECT_GT(external.GetNumSpilledPages(), 0);
+
+  std::vector<Value> group_by_vals;
+  std::vector<Value> aggregate_vals;
+  std::vector<bool> seen(num_groups, false);
+  while (external.Next(&group_by_vals, &aggregate_vals)) {
+    int32_t key = group_by_vals[0].GetAs<int32_t>();
+    ASSERT_FALSE(seen[key]);
+    seen[key] = true;
+    EXPECT_EQ(aggregate_vals[0].GetAs<int32_t>(), 3);
+    EXPECT_EQ(aggregate_vals[1].GetAs<int64_t>(), 3 * key + 3 * num_groups);
+    EXPECT_EQ(aggregate_vals[2].GetAs<int64_t>(), key);
+    EXPECT_EQ(aggregate_vals[3].GetAs<int64_t>(), key + 2 * num_groups);
+  }
+  EXPECT_EQ(std::count(seen.begin(), seen.end(), true), num_groups);
+
+  // A partition that cannot get a page to spill its children fails the query and leaves no page pinned.
+  BufferPoolManager *bpm = GetExecutorContext()->GetBufferPoolManager();
+  std::vector<page_id_t> pinned;
+  {
+    PackedAggregationHashTable small_table(&schema, group_bys, aggregates, agg_types);
+    ExternalAggregation small(&small_table, bpm, budget / 4, GetExecutorContext()->GetMemoryTracker());
+    for (const auto &tuple : tuples) {
+      small.Insert(tuple);
+    }
+    small.Finish();
+    // Leave a single free frame, which the first page of the partition takes.
+    page_id_t page_id;
+    while (bpm->NewPage(&page_id) != nullptr) {
+      pinned.push_back(page_id);
+    }
+    ASSERT_TRUE(bpm->UnpinPage(pinned.back(), false));
+    ASSERT_TRUE(bpm->DeletePage(pinned.back()));
+    pinned.pop_back();
+    EXPECT_THROW(small.Next(&group_by_vals, &aggregate_vals), Exception);
+  }
+  for (page_id_t page_id : pinned) {
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    ASSERT_TRUE(bpm->DeletePage(page_id));
+  }
+  pinned.resize(bpm->GetPoolSize());
+  for (auto &page_id : pinned) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  for (page_id_t page_id : pinned) {
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    ASSERT_TRUE(bpm->DeletePage(page_id));
+  }
+
+  // The executor spills under a small budget and produces the same groups.
+  // SELECT colA, COUNT(colA), SUM(colC) FROM test_1 GROUP BY colA
+  auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto colA = MakeColumnValueExpression(table_info->schema_, 0, "colA");
+  auto colC = MakeColumnValueExpression(table_info->schema_, 0, "colC");
+  auto *scan_schema = MakeOutputSchema({{"colA", colA}, {"colC", colC}});
+  SeqScanPlanNode scan_plan(scan_schema, nullptr, table_info->oid_);
+  auto *agg_schema = MakeOutputSchema({{"colA", MakeAggregateValueExpression(true, 0)},
+                                       {"countA", MakeAggregateValueExpression(false, 0)},
+                                       {"sumC", MakeAggregateValueExpression(false, 1)}});
+  AggregationPlanNode agg_plan(
+      agg_schema, &scan_plan, nullptr, {MakeColumnValueExpression(*scan_schema, 0, "colA")},
+      {MakeColumnValueExpression(*scan_schema, 0, "colA"), MakeColumnValueExpression(*scan_schema, 0, "colC")},
+      {AggregationType::CountAggregate, AggregationType::SumAggregate});
+  auto run = [&]() {
+    std::unordered_map<int32_t, std::pair<int32_t, int32_t>> groups;
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &agg_plan);
+    executor->Init();
+    Tuple tuple;
+    while (executor->Next(&tuple)) {
+      groups[tuple.GetValue(agg_schema, 0).GetAs<int32_t>()] = {tuple.GetValue(agg_schema, 1).GetAs<int32_t>(),
+                                                                 tuple.GetValue(agg_schema, 2).GetAs<int32_t>()};
+    }
+    return groups;
+  };
+  auto expected = run();
+  GetExecutorContext()->SetMemoryBudget(4096);
+  auto spilled = run();
+  GetExecutorContext()->SetMemoryBudget(ExecutorContext::DEFAULT_MEMORY_BUDGET);
+  EXPECT_EQ(expected.size(), TEST1_SIZE);
+  EXPECT_EQ(spilled, expected);
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, ParallelAggregationTest) {
+  // Morsels of in-memory tuples: SELECT k, COUNT(v), SUM(v), MIN(v), MAX(v) FROM t GROUP BY k
+  Schema schema({Column("k", TypeId::INTEGER), Column("v", TypeId::BIGINT)});
+  ColumnValueExpression k(0, 0, TypeId::INTEGER);
+  ColumnValueExpression v(0, 1, TypeId::BIGINT);
+  std::vector<const AbstractExpression *> group_bys{&k};
+  std::vector<const AbstractExpression *> aggregates{&v, &v, &v, &v};
+  std::vector<AggregationType> agg_types{AggregationType::CountAggregate, AggregationType::SumAggregate,
+                                         AggregationType::MinAggregate, AggregationType::MaxAggregate};
+  const uint32_t num_morsels = 64;
+  const uint32_t morsel_size = 1000;
+  std::vector<Tuple> tuples;
+  for (uint32_t i = 0; i < num_morsels * morsel_size; i++) {
+    tuples.emplace_back(std::vector<Value>{ValueFactory::GetIntegerValue(i % 4000), ValueFactory::GetBigIntValue(i)},
+                        &schema);
+  }
+  ParallelAggregation parallel(&schema, group_bys, aggregates, agg_types, 4, GetExecutorContext()->GetMemoryTracker());
+  EXPECT_TRUE(parallel.Run(num_morsels, [&](uint32_t morsel_idx, const ParallelAggregation::Sink &sink) {
+    for (uint32_t i = morsel_idx * morsel_size; i < (morsel_idx + 1) * morsel_size; i++) {
+      sink(tuples[i]);
+    }
+    return true;
+  }));
+  EXPECT_EQ(parallel.Size(), 4000);
+  std::vector<Value> group_by_vals;
+  std::vector<Value> aggregate_vals;
+  uint32_t num_groups = 0;
+  while (parallel.Next(&group_by_vals, &aggregate_vals)) {
+    int64_t key = group_by_vals[0].GetAs<int32_t>();
+    // The group holds key, key + 4000, ..., key + 4000 * 15.
+    EXPECT_EQ(aggregate_vals[0].GetAs<int32_t>(), 16);
+    EXPECT_EQ(aggregate_vals[1].GetAs<int64_t>(), 16 * key + 4000 * 120);
+    EXPECT_EQ(aggregate_vals[2].GetAs<int64_t>(), key);
+    EXPECT_EQ(aggregate_vals[3].GetAs<int64_t>(), key + 4000 * 15);
+    num_groups++;
+  }
+  EXPECT_EQ(num_groups, 4000);
+
+  // A morsel that cannot be read stops the workers and drops the result.
+  EXPECT_FALSE(parallel.Run(num_morsels, [&](uint32_t morsel_idx, const ParallelAggregation::Sink &sink) {
+    sink(tuples[morsel_idx]);
+    return morsel_idx != 3;
+  }));
+  EXPECT_EQ(parallel.Size(), 0);
+
+  // The executor scans the pages of test_1 in parallel and agrees with the serial plan, for few and many groups.
+  // SELECT <group>, COUNT(colA), SUM(colC), MAX(colD) FROM test_1 GROUP BY <group>
+  auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &table_schema = table_info->schema_;
+  auto *scan_schema = MakeOutputSchema({{"colA", MakeColumnValueExpression(table_schema, 0, "colA")},
+                                        {"colB", MakeColumnValueExpression(table_schema, 0, "colB")},
+                                        {"colC", MakeColumnValueExpression(table_schema, 0, "colC")},
+                                        {"colD", MakeColumnValueExpression(table_schema, 0, "colD")}});
+  SeqScanPlanNode scan_plan(scan_schema, nullptr, table_info->oid_);
+  auto *agg_schema = MakeOutputSchema({{"key", MakeAggregateValueExpression(true, 0)},
+                                       {"countA", MakeAggregateValueExpression(false, 0)},
+                                       {"sumC", MakeAggregateValueExpression(false, 1)},
+                                       {"maxD", MakeAggregateValueExpression(false, 2)}});
+  for (const char *group_col : {"colB", "colA"}) {
+    AggregationPlanNode agg_plan(agg_schema, &scan_plan, nullptr,
+                                 {MakeColumnValueExpression(*scan_schema, 0, group_col)},
+                                 {MakeColumnValueExpression(*scan_schema, 0, "colA"),
+                                  MakeColumnValueExpression(*scan_schema, 0, "colC"),
+                                  MakeColumnValueExpression(*scan_schema, 0, "colD")},
+                                 {AggregationType::CountAggregate, AggregationType::SumAggregate,
+                                  AggregationType::MaxAggregate});
+    auto run = [&](uint32_t num_threads) {
+      GetExecutorContext()->SetNumThreads(num_threads);
+      std::unordered_map<int32_t, std::vector<int32_t>> groups;
+      auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &agg_plan);
+      executor->Init();
+      Tuple tuple;
+      while (executor->Next(&tuple)) {
+        auto &group = groups[tuple.GetValue(agg_schema, 0).GetAs<int32_t>()];
+        EXPECT_TRUE(group.empty());
+        for (uint32_t i = 1; i < 4; i++) {
+          group.push_back(tuple.GetValue(agg_schema, i).GetAs<int32_t>());
+        }
+      }
+      GetExecutorContext()->SetNumThreads(1);
+      return groups;
+    };
+    auto expected = run(1);
+    EXPECT_EQ(run(4), expected);
+    EXPECT_EQ(run(32), expected);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, StreamAggregationTest) {
+  // A table loaded in key order: every key appears 7 times, followed by a run of NULL keys.
+  auto *txn = GetExecutorContext()->GetTransaction();
+  Schema schema({Column("k", TypeId::INTEGER), Column("v", TypeId::INTEGER)});
+  auto *table_info = GetExecutorContext()->GetCatalog()->CreateTable(txn, "sorted", schema);
+  RID rid;
+  for (int32_t i = 0; i < 710; i++) {
+    Value key = i < 700 ? ValueFactory::GetIntegerValue(i / 7) : ValueFactory::GetNullValueByType(TypeId::INTEGER);
+    ASSERT_TRUE(table_info->table_->InsertTuple(Tuple({key, ValueFactory::GetIntegerValue(i)}, &schema), &rid, txn));
+  }
+
+  // SELECT k, COUNT(v), SUM(v), MAX(v) FROM sorted GROUP BY k HAVING COUNT(v) > 5
+  auto *scan_schema = MakeOutputSchema({{"k", MakeColumnValueExpression(schema, 0, "k")},
+                                        {"v", MakeColumnValueExpression(schema, 0, "v")}});
+  SeqScanPlanNode scan_plan(scan_schema, nullptr, table_info->oid_);
+  const AbstractExpression *count_v = MakeAggregateValueExpression(false, 0);
+  auto *agg_schema = MakeOutputSchema({{"k", MakeAggregateValueExpression(true, 0)},
+                                       {"countV", count_v},
+                                       {"sumV", MakeAggregateValueExpression(false, 1)},
+                                       {"maxV", MakeAggregateValueExpression(false, 2)}});
+  const AbstractExpression *v = MakeColumnValueExpression(*scan_schema, 0, "v");
+  AggregationPlanNode agg_plan(
+      agg_schema, &scan_plan,
+      MakeComparisonExpression(count_v, MakeConstantValueExpression(ValueFactory::GetIntegerValue(5)),
+                               ComparisonType::GreaterThan),
+      {MakeColumnValueExpression(*scan_schema, 0, "k")}, {v, v, v},
+      {AggregationType::CountAggregate, AggregationType::SumAggregate, AggregationType::MaxAggregate});
+
+  auto run = [&](bool expect_stream) {
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &agg_plan);
+    EXPECT_EQ(dynamic_cast<StreamAggregationExecutor *>(executor.get()) != nullptr, expect_stream);
+    executor->Init();
+    std::map<int32_t, std::vector<int32_t>> groups;
+    Tuple tuple;
+    while (executor->Next(&tuple)) {
+      Value key = tuple.GetValue(agg_schema, 0);
+      auto &group = groups[key.IsNull() ? -1 : key.GetAs<int32_t>()];
+      EXPECT_TRUE(group.empty());
+      for (uint32_t i = 1; i < 4; i++) {
+        group.push_back(tuple.GetValue(agg_schema, i).GetAs<int32_t>());
+      }
+    }
+    return groups;
+  };
+  auto hashed = run(false);
+  scan_plan.SetOutputOrdering({0});
+  auto streamed = run(true);
+  EXPECT_EQ(streamed, hashed);
+  ASSERT_EQ(streamed.size(), 101);
+  EXPECT_EQ(streamed[3], (std::vector<int32_t>{7, 21 + 22 + 23 + 24 + 25 + 26 + 27, 27}));
+  EXPECT_EQ(streamed[-1][0], 10);
+
+  // A scan ordered on another column does not qualify.
+  scan_plan.SetOutputOrdering({1});
+  EXPECT_EQ(run(false), hashed);
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, SortTest) {
+  // k has NULLs and repeats, s shares a prefix longer than the normalized key, id records the input order.
+  auto *txn = GetExecutorContext()->GetTransaction();
+  Schema schema({Column("k", TypeId::INTEGER), Column("s", TypeId::VARCHAR, 64), Column("id", TypeId::INTEGER)});
+  auto *table_info = GetExecutorContext()->GetCatalog()->CreateTable(txn, "unsorted", schema);
+  const uint32_t num_rows = 2000;
+  RID rid;
+  for (uint32_t i = 0; i < num_rows; i++) {
+    Value key = i % 13 == 0 ? ValueFactory::GetNullValueByType(TypeId::INTEGER)
+                            : ValueFactory::GetIntegerValue(static_cast<int32_t>(i * 7919 % 50) - 25);
+    std::string str = "a common prefix " + std::to_string(i * 31 % 5);
+    ASSERT_TRUE(table_info->table_->InsertTuple(
+        Tuple({key, ValueFactory::GetVarcharValue(str), ValueFactory::GetIntegerValue(i)}, &schema), &rid, txn));
+  }
+
+  // SELECT k, s, id FROM unsorted ORDER BY k DESC, s ASC
+  auto *scan_schema = MakeOutputSchema({{"k", MakeColumnValueExpression(schema, 0, "k")},
+                                        {"s", MakeColumnValueExpression(schema, 0, "s")},
+                                        {"id", MakeColumnValueExpression(schema, 0, "id")}});
+  SeqScanPlanNode scan_plan(scan_schema, nullptr, table_info->oid_);
+  SortPlanNode sort_plan(scan_schema, &scan_plan,
+                         {{MakeColumnValueExpression(*scan_schema, 0, "k"), OrderByType::Desc},
+                          {MakeColumnValueExpression(*scan_schema, 0, "s"), OrderByType::Asc}});
+  EXPECT_EQ(sort_plan.GetOutputOrdering(), (std::vector<uint32_t>{0, 1}));
+
+  auto run = [&](size_t memory_budget) {
+    GetExecutorContext()->SetMemoryBudget(memory_budget);
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &sort_plan);
+    executor->Init();
+    std::vector<Tuple> result;
+    Tuple tuple;
+    while (executor->Next(&tuple)) {
+      result.push_back(tuple);
+    }
+    return std::make_pair(result, dynamic_cast<SortExecutor *>(executor.get())->GetNumRuns());
+  };
+  auto [in_memory, in_memory_runs] = run(ExecutorContext::DEFAULT_MEMORY_BUDGET);
+  EXPECT_EQ(in_memory_runs, 0);
+  // Runs of a few dozen tuples: more runs than the buffer pool can merge at once.
+  auto [spilled, spilled_runs] = run(4096);
+  EXPECT_GT(spilled_runs, GetExecutorContext()->GetBufferPoolManager()->GetPoolSize() / 2);
+  GetExecutorContext()->SetMemoryBudget(ExecutorContext::DEFAULT_MEMORY_BUDGET);
+
+  for (const auto &result : {in_memory, spilled}) {
+    ASSERT_EQ(result.size(), num_rows);
+    for (uint32_t i = 1; i < num_rows; i++) {
+      Value prev_k = result[i - 1].GetValue(scan_schema, 0);
+      Value k = result[i].GetValue(scan_schema, 0);
+      // NULLs come last in descending order.
+      ASSERT_TRUE(k.IsNull() || (!prev_k.IsNull() && prev_k.CompareGreaterThanEquals(k) == CmpBool::CmpTrue));
+      if (k.IsNull() != prev_k.IsNull() || (!k.IsNull() && k.CompareEquals(prev_k) != CmpBool::CmpTrue)) {
+        continue;
+      }
+      Value prev_s = result[i - 1].GetValue(scan_schema, 1);
+      Value s = result[i].GetValue(scan_schema, 1);
+      ASSERT_EQ(prev_s.CompareLessThanEquals(s), CmpBool::CmpTrue);
+      // Ties keep the input order.
+      if (s.CompareEquals(prev_s) == CmpBool::CmpTrue) {
+        ASSERT_LT(result[i - 1].GetValue(scan_schema, 2).GetAs<int32_t>(),
+                  result[i].GetValue(scan_schema, 2).GetAs<int32_t>());
+      }
+    }
+  }
+  for (uint32_t i = 0; i < num_rows; i++) {
+    EXPECT_EQ(spilled[i].GetValue(scan_schema, 2).GetAs<int32_t>(),
+              in_memory[i].GetValue(scan_schema, 2).GetAs<int32_t>());
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, TopNLimitTest) {
+  // SELECT colA, colB, colC FROM test_1 ORDER BY colB DESC, colC ASC LIMIT n
+  TableMetadata *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  Schema &schema = table_info->schema_;
+  auto *out_schema = MakeOutputSchema({{"colA", MakeColumnValueExpression(schema, 0, "colA")},
+                                       {"colB", MakeColumnValueExpression(schema, 0, "colB")},
+                                       {"colC", MakeColumnValueExpression(schema, 0, "colC")}});
+  SeqScanPlanNode scan_plan(out_schema, nullptr, table_info->oid_);
+  auto order_bys = [&]() {
+    return std::vector<OrderBy>{{MakeColumnValueExpression(*out_schema, 0, "colB"), OrderByType::Desc},
+                                {MakeColumnValueExpression(*out_schema, 0, "colC"), OrderByType::Asc}};
+  };
+  auto run = [&](const AbstractPlanNode *plan) {
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), plan);
+    executor->Init();
+    std::vector<int32_t> col_a;
+    Tuple tuple;
+    while (executor->Next(&tuple)) {
+      col_a.push_back(tuple.GetValue(out_schema, 0).GetAs<int32_t>());
+    }
+    return col_a;
+  };
+
+  // LIMIT alone returns the first tuples of its child.
+  auto scanned = run(&scan_plan);
+  ASSERT_EQ(scanned.size(), 1000);
+  LimitPlanNode scan_limit_plan(out_schema, &scan_plan, 5);
+  EXPECT_EQ(run(&scan_limit_plan), std::vector<int32_t>(scanned.begin(), scanned.begin() + 5));
+
+  // TopN returns the same tuples as a full sort followed by LIMIT.
+  SortPlanNode sort_plan(out_schema, &scan_plan, order_bys());
+  auto sorted = run(&sort_plan);
+  for (size_t n : {0, 1, 37, 1000, 5000}) {
+    LimitPlanNode limit_plan(out_schema, &sort_plan, n);
+    TopNPlanNode topn_plan(out_schema, &scan_plan, order_bys(), n);
+    auto expected = std::vector<int32_t>(sorted.begin(), sorted.begin() + std::min<size_t>(n, sorted.size()));
+    EXPECT_EQ(run(&limit_plan), expected);
+    EXPECT_EQ(run(&topn_plan), expected);
+  }
+
+  // Once the heap holds the best tuples, most tuples are rejected before they are copied.
+  TopNPlanNode topn_plan(out_schema, &scan_plan, order_bys(), 10);
+  TopNExecutor executor(GetExecutorContext(), &topn_plan,
+                        ExecutorFactory::CreateExecutor(GetExecutorContext(), &scan_plan));
+  executor.Init();
+  EXPECT_GT(executor.GetNumPruned(), 900);
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, IndexScanTest) {
+  // CREATE INDEX test_1_colB ON test_1 (colB)
+  auto *txn = GetExecutorContext()->GetTransaction();
+  auto *catalog = GetExecutorContext()->GetCatalog();
+  TableMetadata *table_info = catalog->GetTable("test_1");
+  Schema &schema = table_info->schema_;
+  Schema key_schema({Column("colB", TypeId::INTEGER)});
+  IndexInfo *index_info = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
+      txn, "test_1_colB", "test_1", schema, key_schema, {1}, 8);
+  EXPECT_EQ(catalog->GetIndex("test_1_colB", "test_1"), index_info);
+  EXPECT_EQ(catalog->GetTableIndexes("test_1"), std::vector<IndexInfo *>{index_info});
+
+  // SELECT colA, colB FROM test_1 WHERE colB IN (3, 7) AND colA < 500
+  auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto *out_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  auto *predicate = MakeComparisonExpression(col_a, MakeConstantValueExpression(ValueFactory::GetIntegerValue(500)),
+                                             ComparisonType::LessThan);
+  auto in_3_7 = MakeLogicExpression(
+      MakeComparisonExpression(col_b, MakeConstantValueExpression(ValueFactory::GetIntegerValue(3)),
+                               ComparisonType::Equal),
+      MakeComparisonExpression(col_b, MakeConstantValueExpression(ValueFactory::GetIntegerValue(7)),
+                               ComparisonType::Equal),
+      LogicType::Or);
+  SeqScanPlanNode seq_plan(out_schema, MakeLogicExpression(in_3_7, predicate, LogicType::And), table_info->oid_);
+  IndexScanPlanNode index_plan(out_schema, predicate, table_info->oid_, index_info->index_oid_,
+                               {{ValueFactory::GetIntegerValue(3)}, {ValueFactory::GetIntegerValue(7)}});
+  auto run = [&](const AbstractPlanNode *plan) {
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), plan);
+    executor->Init();
+    std::vector<std::pair<int32_t, int32_t>> result;
+    Tuple tuple;
+    while (executor->Next(&tuple)) {
+      result.emplace_back(tuple.GetValue(out_schema, 0).GetAs<int32_t>(),
+                          tuple.GetValue(out_schema, 1).GetAs<int32_t>());
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  };
+  auto expected = run(&seq_plan);
+  EXPECT_FALSE(expected.empty());
+  EXPECT_EQ(run(&index_plan), expected);
+
+  // Every heap page is read once, however many tuples on it match.
+  IndexScanExecutor executor(GetExecutorContext(), &index_plan);
+  executor.Init();
+  EXPECT_LT(executor.GetNumPages(), table_info->table_->GetPageIds(txn).size() + 1);
+  EXPECT_LT(executor.GetNumPages(), expected.size());
+
+  // Inserted tuples are added to the index.
+  InsertPlanNode insert_plan{{{ValueFactory::GetIntegerValue(-1), ValueFactory::GetIntegerValue(3),
+                               ValueFactory::GetIntegerValue(0), ValueFactory::GetIntegerValue(0)}},
+                             table_info->oid_};
+  auto insert_executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &insert_plan);
+  insert_executor->Init();
+  ASSERT_TRUE(insert_executor->Next(nullptr));
+  expected.insert(expected.begin(), std::make_pair(-1, 3));
+  EXPECT_EQ(run(&index_plan), expected);
+
+  // A heap page that cannot be read aborts the scan instead of ending it early.
+  executor.Init();
+  BufferPoolManager *bpm = GetExecutorContext()->GetBufferPoolManager();
+  std::vector<page_id_t> pinned(bpm->GetPoolSize());
+  for (auto &page_id : pinned) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  Tuple tuple;
+  EXPECT_THROW(executor.Next(&tuple), TransactionAbortException);
+  EXPECT_EQ(TransactionState::ABORTED, txn->GetState());
+  for (auto page_id : pinned) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, BloomFilterPushDownTest) {
+  // The filter never rejects an inserted hash and rarely accepts another one.
+  BloomFilter filter(10000);
+  for (hash_t h = 0; h < 10000; h++) {
+    filter.Insert(HashUtil::Hash(&h));
+  }
+  size_t false_positives = 0;
+  for (hash_t h = 0; h < 100000; h++) {
+    hash_t hash = HashUtil::Hash(&h);
+    if (h < 10000) {
+      ASSERT_TRUE(filter.MayContain(hash));
+    } else {
+      false_positives += filter.MayContain(hash) ? 1 : 0;
+    }
+  }
+  EXPECT_LT(false_positives, 90000 / 50);
+
+  // SELECT b.colA, b.colB FROM test_1 a JOIN test_1 b ON a.colA = b.colA WHERE a.colA < 10
+  TableMetadata *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  Schema &schema = table_info->schema_;
+  auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto *scan_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  auto *predicate = MakeComparisonExpression(col_a, MakeConstantValueExpression(ValueFactory::GetIntegerValue(10)),
+                                             ComparisonType::LessThan);
+  SeqScanPlanNode build_plan(scan_schema, predicate, table_info->oid_);
+  SeqScanPlanNode probe_plan(scan_schema, nullptr, table_info->oid_);
+  auto *left_a = MakeColumnValueExpression(*scan_schema, 0, "colA");
+  auto *right_a = MakeColumnValueExpression(*scan_schema, 1, "colA");
+  auto *right_b = MakeColumnValueExpression(*scan_schema, 1, "colB");
+  auto *out_schema = MakeOutputSchema({{"colA", right_a}, {"colB", right_b}});
+  HashJoinPlanNode join_plan(out_schema, {&build_plan, &probe_plan},
+                             MakeComparisonExpression(left_a, right_a, ComparisonType::Equal), {left_a}, {right_a});
+
+  auto probe = std::make_unique<SeqScanExecutor>(GetExecutorContext(), &probe_plan);
+  SeqScanExecutor *probe_scan = probe.get();
+  HashJoinExecutor join(GetExecutorContext(), &join_plan,
+                        ExecutorFactory::CreateExecutor(GetExecutorContext(), &build_plan), std::move(probe));
+  join.Init();
+  std::vector<int32_t> result;
+  Tuple tuple;
+  while (join.Next(&tuple)) {
+    result.push_back(tuple.GetValue(out_schema, 0).GetAs<int32_t>());
+  }
+  std::sort(result.begin(), result.end());
+  std::vector<int32_t> expected(10);
+  std::iota(expected.begin(), expected.end(), 0);
+  EXPECT_EQ(result, expected);
+
+  // Nearly all of the probe side is dropped inside the scan.
+  EXPECT_LE(probe_scan->GetNumFiltered(), TEST1_SIZE - expected.size());
+  EXPECT_GT(probe_scan->GetNumFiltered(), (TEST1_SIZE - expected.size()) * 9 / 10);
+
+  // A scan below two joins applies both filters: one on colA < 100 and one on colB = 3.
+  BloomFilter filter_a(100);
+  for (int32_t a = 0; a < 100; a++) {
+    Value val = ValueFactory::GetIntegerValue(a);
+    filter_a.Insert(HashUtil::CombineHashes(0, HashUtil::HashValue(&val)));
+  }
+  BloomFilter filter_b(1);
+  Value three = ValueFactory::GetIntegerValue(3);
+  filter_b.Insert(HashUtil::CombineHashes(0, HashUtil::HashValue(&three)));
+  SeqScanExecutor scan(GetExecutorContext(), &probe_plan);
+  scan.Init();
+  EXPECT_TRUE(scan.PushDownBloomFilter(&filter_a, {0}));
+  EXPECT_TRUE(scan.PushDownBloomFilter(&filter_b, {1}));
+  std::vector<std::pair<int32_t, int32_t>> both;
+  while (scan.Next(&tuple)) {
+    both.emplace_back(tuple.GetValue(scan_schema, 0).GetAs<int32_t>(), tuple.GetValue(scan_schema, 1).GetAs<int32_t>());
+  }
+  // No row that passes both is dropped, while either filter alone keeps around a tenth of the table.
+  size_t num_expected = 0;
+  for (auto iter = table_info->table_->Begin(GetExecutorContext()->GetTransaction()); iter != table_info->table_->End();
+       ++iter) {
+    int32_t a = iter->GetValue(&schema, 0).GetAs<int32_t>();
+    int32_t b = iter->GetValue(&schema, 1).GetAs<int32_t>();
+    if (a < 100 && b == 3) {
+      num_expected++;
+      EXPECT_NE(std::find(both.begin(), both.end(), std::make_pair(a, b)), both.end());
+    }
+  }
+  EXPECT_GT(num_expected, 0);
+  EXPECT_LT(both.size(), TEST1_SIZE / 20);
+  EXPECT_EQ(scan.GetNumFiltered(), TEST1_SIZE - both.size());
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, QueryProfileTest) {
+  // SELECT COUNT(b.colB) FROM test_1 a JOIN test_1 b ON a.colA = b.colA WHERE a.colA < 10, profiled
+  GetExecutorContext()->EnableProfiling();
+  TableMetadata *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  Schema &schema = table_info->schema_;
+  auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto *scan_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  auto *predicate = MakeComparisonExpression(col_a, MakeConstantValueExpression(ValueFactory::GetIntegerValue(10)),
+                                             ComparisonType::LessThan);
+  SeqScanPlanNode build_plan(scan_schema, predicate, table_info->oid_);
+  SeqScanPlanNode probe_plan(scan_schema, nullptr, table_info->oid_);
+  auto *left_a = MakeColumnValueExpression(*scan_schema, 0, "colA");
+  auto *right_a = MakeColumnValueExpression(*scan_schema, 1, "colA");
+  auto *right_b = MakeColumnValueExpression(*scan_schema, 1, "colB");
+  auto *join_schema = MakeOutputSchema({{"colA", right_a}, {"colB", right_b}});
+  HashJoinPlanNode join_plan(join_schema, {&build_plan, &probe_plan},
+                             MakeComparisonExpression(left_a, right_a, ComparisonType::Equal), {left_a}, {right_a});
+  auto *agg_b = MakeColumnValueExpression(*join_schema, 0, "colB");
+  auto *out_schema = MakeOutputSchema({{"countB", MakeAggregateValueExpression(false, 0)}});
+  AggregationPlanNode agg_plan(out_schema, &join_plan, nullptr, {}, {agg_b}, {AggregationType::CountAggregate});
+
+  auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &agg_plan);
+  executor->Init();
+  Tuple tuple;
+  ASSERT_TRUE(executor->Next(&tuple));
+  EXPECT_EQ(tuple.GetValue(out_schema, 0).GetAs<int32_t>(), 10);
+  ASSERT_FALSE(executor->Next(&tuple));
+
+  const QueryProfile *profile = GetExecutorContext()->GetProfile();
+  const OperatorProfile *agg = profile->GetOperator(&agg_plan);
+  const OperatorProfile *join = profile->GetOperator(&join_plan);
+  const OperatorProfile *build = profile->GetOperator(&build_plan);
+  const OperatorProfile *probe = profile->GetOperator(&probe_plan);
+  ASSERT_NE(agg, nullptr);
+  EXPECT_EQ(agg->name_, "Aggregation");
+  EXPECT_EQ(agg->rows_, 1);
+  EXPECT_EQ(join->rows_, 10);
+  EXPECT_EQ(build->rows_, 10);
+  EXPECT_LT(probe->rows_, TEST1_SIZE);
+  // Fetches are charged to the operator that made them, times include the children.
+  EXPECT_GT(build->buffer_pool_.fetches_, 0);
+  EXPECT_GT(probe->buffer_pool_.fetches_, 0);
+  EXPECT_EQ(join->buffer_pool_.fetches_, 0);
+  EXPECT_LE(probe->buffer_pool_.misses_, probe->buffer_pool_.fetches_);
+  EXPECT_GE(agg->init_ticks_, join->init_ticks_);
+  EXPECT_GT(join->peak_memory_, 0);
+  EXPECT_EQ(probe->peak_memory_, 0);
+
+  std::string text = profile->ToString(&agg_plan);
+  EXPECT_EQ(text.find("Aggregation (rows=1,"), 0) << text;
+  EXPECT_NE(text.find("\n  HashJoin (rows=10,"), std::string::npos) << text;
+  EXPECT_NE(text.find("\n    SeqScan (rows=10,"), std::string::npos) << text;
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, MemoryLimitTest) {
+  TableMetadata *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  Schema &schema = table_info->schema_;
+  auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto *scan_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  SeqScanPlanNode scan_plan(scan_schema, nullptr, table_info->oid_);
+  SeqScanPlanNode probe_plan(scan_schema, nullptr, table_info->oid_);
+  MemoryTracker *tracker = GetExecutorContext()->GetMemoryTracker();
+  const size_t memory_limit = 16 * 1024;
+  GetExecutorContext()->SetMemoryLimit(memory_limit);
+
+  // SELECT colA, colB FROM test_1 ORDER BY colB: the sort spills to stay under the limit.
+  SortPlanNode sort_plan(scan_schema, &scan_plan,
+                         {{MakeColumnValueExpression(*scan_schema, 0, "colB"), OrderByType::Asc}});
+  {
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &sort_plan);
+    executor->Init();
+    size_t num_rows = 0;
+    Tuple tuple;
+    while (executor->Next(&tuple)) {
+      num_rows++;
+    }
+    EXPECT_EQ(num_rows, TEST1_SIZE);
+    EXPECT_GT(dynamic_cast<SortExecutor *>(executor.get())->GetNumRuns(), 0);
+    EXPECT_GT(executor->GetPeakMemoryUsage(), 0);
+    EXPECT_LE(executor->GetPeakMemoryUsage(), memory_limit);
+  }
+  EXPECT_EQ(tracker->GetUsage(), 0);
+
+  // SELECT a.colB, b.colB FROM test_1 a JOIN test_1 b ON a.colA = b.colA: the build side cannot spill, so it fails.
+  auto *left_a = MakeColumnValueExpression(*scan_schema, 0, "colA");
+  auto *left_b = MakeColumnValueExpression(*scan_schema, 0, "colB");
+  auto *right_a = MakeColumnValueExpression(*scan_schema, 1, "colA");
+  auto *right_b = MakeColumnValueExpression(*scan_schema, 1, "colB");
+  auto *join_schema = MakeOutputSchema({{"leftB", left_b}, {"rightB", right_b}});
+  HashJoinPlanNode join_plan(join_schema, {&scan_plan, &probe_plan},
+                             MakeComparisonExpression(left_a, right_a, ComparisonType::Equal), {left_a}, {right_a});
+  {
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &join_plan);
+    EXPECT_THROW(executor->Init(), Exception);
+    EXPECT_LE(tracker->GetUsage(), memory_limit);
+  }
+  EXPECT_EQ(tracker->GetUsage(), 0);
+  EXPECT_LE(tracker->GetPeakUsage(), memory_limit);
+
+  // Without the limit the same join runs.
+  GetExecutorContext()->SetMemoryLimit(MemoryTracker::UNLIMITED);
+  auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &join_plan);
+  executor->Init();
+  EXPECT_GT(tracker->GetUsage(), memory_limit);
+  EXPECT_EQ(executor->GetPeakMemoryUsage(), tracker->GetUsage());
+
+  // Building the table again frees the first build, so the usage stays the same.
+  size_t usage = tracker->GetUsage();
+  executor->Init();
+  EXPECT_EQ(usage, tracker->GetUsage());
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, JoinOrderTest) {
+  // SELECT * FROM test_1 a, test_1 b, test_1 c WHERE a.colA = b.colA AND b.colA = c.colA AND c.colA < 20
+  SimpleCatalog *catalog = GetExecutorContext()->GetCatalog();
+  TableMetadata *table_info = catalog->GetTable("test_1");
+  Schema &schema = table_info->schema_;
+  auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto *col_c = MakeColumnValueExpression(schema, 0, "colC");
+  auto *predicate = MakeComparisonExpression(col_a, MakeConstantValueExpression(ValueFactory::GetIntegerValue(20)),
+                                             ComparisonType::LessThan);
+  SeqScanPlanNode scan_a(MakeOutputSchema({{"colA", col_a}, {"colB", col_b}}), nullptr, table_info->oid_);
+  SeqScanPlanNode scan_b(MakeOutputSchema({{"colA", col_a}}), nullptr, table_info->oid_);
+  SeqScanPlanNode scan_c(MakeOutputSchema({{"colA", col_a}, {"colC", col_c}}), predicate, table_info->oid_);
+  catalog->AnalyzeTable(GetExecutorContext()->GetTransaction(), "test_1");
+
+  JoinOrderOptimizer optimizer(catalog);
+  uint32_t a = optimizer.AddRelation(&scan_a);
+  uint32_t b = optimizer.AddRelation(&scan_b);
+  uint32_t c = optimizer.AddRelation(&scan_c);
+  optimizer.AddJoinPredicate(a, 0, b, 0);
+  optimizer.AddJoinPredicate(b, 0, c, 0);
+  EXPECT_NEAR(20, optimizer.GetEstimatedCardinality(c), 2);
+  EXPECT_NEAR(20, optimizer.GetEstimatedCardinality(), 2);
+
+  // The filtered scan is joined first and builds, and the small result builds again.
+  const AbstractPlanNode *root = optimizer.Optimize();
+  ASSERT_EQ(PlanType::HashJoin, root->GetType());
+  const AbstractPlanNode *build = root->GetChildAt(0);
+  ASSERT_EQ(PlanType::HashJoin, build->GetType());
+  EXPECT_EQ(&scan_c, build->GetChildAt(0));
+  EXPECT_EQ(&scan_b, build->GetChildAt(1));
+  EXPECT_EQ(&scan_a, root->GetChildAt(1));
+
+  auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), root);
+  executor->Init();
+  std::vector<int32_t> result;
+  Tuple tuple;
+  while (executor->Next(&tuple)) {
+    int32_t value = tuple.GetValue(root->OutputSchema(), optimizer.GetOutputColumnIdx(a, 0)).GetAs<int32_t>();
+    EXPECT_EQ(value, tuple.GetValue(root->OutputSchema(), optimizer.GetOutputColumnIdx(b, 0)).GetAs<int32_t>());
+    EXPECT_EQ(value, tuple.GetValue(root->OutputSchema(), optimizer.GetOutputColumnIdx(c, 0)).GetAs<int32_t>());
+    result.push_back(value);
+  }
+  std::sort(result.begin(), result.end());
+  std::vector<int32_t> expected(20);
+  std::iota(expected.begin(), expected.end(), 0);
+  EXPECT_EQ(expected, result);
+  EXPECT_EQ(5, root->OutputSchema()->GetColumnCount());
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, ApproximateAggregationTest) {
+  // SELECT k, APPROX_COUNT_DISTINCT(v), AVG(v) FROM t GROUP BY k, where every group has 5000 distinct values.
+  Schema schema({Column("k", TypeId::INTEGER), Column("v", TypeId::BIGINT)});
+  ColumnValueExpression k(0, 0, TypeId::INTEGER);
+  ColumnValueExpression v(0, 1, TypeId::BIGINT);
+  std::vector<const AbstractExpression *> group_bys{&k};
+  std::vector<const AbstractExpression *> aggregates{&v, &v};
+  std::vector<AggregationType> agg_types{AggregationType::ApproxCountDistinctAggregate, AggregationType::AvgAggregate};
+  const uint32_t num_morsels = 60;
+  const uint32_t morsel_size = 1000;
+  std::vector<Tuple> tuples;
+  for (uint32_t i = 0; i < num_morsels * morsel_size; i++) {
+    tuples.emplace_back(
+        std::vector<Value>{ValueFactory::GetIntegerValue(i % 4), ValueFactory::GetBigIntValue(i % 20000)}, &schema);
+  }
+  ASSERT_TRUE(PackedAggregationHashTable::CanHandle(&schema, group_bys, aggregates, agg_types));
+
+  // Every path hashes the values alike and merges sketches exactly, so all of them agree on every estimate.
+  std::map<int32_t, std::vector<Value>> simple_groups;
+  SimpleAggregationHashTable simple(aggregates, agg_types);
+  for (const auto &tuple : tuples) {
+    simple.InsertCombine({{tuple.GetValue(&schema, 0)}},
+                         {{tuple.GetValue(&schema, 1), tuple.GetValue(&schema, 1)}, {}, {}});
+  }
+  for (auto it = simple.Begin(); it != simple.End(); ++it) {
+    simple.FinalizeAggregateValue(it.Val(), &simple_groups[it.Key().group_bys_[0].GetAs<int32_t>()]);
+  }
+  ASSERT_EQ(simple_groups.size(), 4);
+  for (const auto &group : simple_groups) {
+    EXPECT_NEAR(group.second[0].GetAs<int32_t>(), 5000, 500);
+    EXPECT_DOUBLE_EQ(group.second[1].GetAs<double>(), 9998 + group.first);
+  }
+  auto check = [&](std::vector<Value> *group_by_vals, std::vector<Value> *aggregate_vals, auto &&next) {
+    uint32_t num_groups = 0;
+    while (next(group_by_vals, aggregate_vals)) {
+      const auto &expected = simple_groups[(*group_by_vals)[0].GetAs<int32_t>()];
+      EXPECT_EQ((*aggregate_vals)[0].GetAs<int32_t>(), expected[0].GetAs<int32_t>());
+      EXPECT_DOUBLE_EQ((*aggregate_vals)[1].GetAs<double>(), expected[1].GetAs<double>());
+      num_groups++;
+    }
+    EXPECT_EQ(num_groups, 4);
+  };
+  std::vector<Value> group_by_vals;
+  std::vector<Value> aggregate_vals;
+
+  ParallelAggregation parallel(&schema, group_bys, aggregates, agg_types, 4, GetExecutorContext()->GetMemoryTracker());
+  EXPECT_TRUE(parallel.Run(num_morsels, [&](uint32_t morsel_idx, const ParallelAggregation::Sink &sink) {
+    for (uint32_t i = morsel_idx * morsel_size; i < (morsel_idx + 1) * morsel_size; i++) {
+      sink(tuples[i]);
+    }
+    return true;
+  }));
+  check(&group_by_vals, &aggregate_vals, [&](auto *g, auto *a) { return parallel.Next(g, a); });
+
+  // Under half the memory of the groups the table spills, so groups are merged from spilled partial sketches.
+  PackedAggregationHashTable table(&schema, group_bys, aggregates, agg_types);
+  for (uint32_t i = 0; i < 4; i++) {
+    table.InsertCombine(tuples[i]);
+  }
+  size_t budget = table.GetMemoryUsage() / 2;
+  table.Clear();
+  ExternalAggregation external(&table, GetExecutorContext()->GetBufferPoolManager(), budget,
+                               GetExecutorContext()->GetMemoryTracker());
+  for (const auto &tuple : tuples) {
+    external.Insert(tuple);
+  }
+  external.Finish();
+  EXPECT_GT(external.GetNumSpilledPages(), 0);
+  check(&group_by_vals, &aggregate_vals, [&](auto *g, auto *a) { return external.Next(g, a); });
+
+  // A sampled plan scales up COUNT and SUM and bounds the error of SUM and AVG, serially and in parallel.
+  // SELECT COUNT(colA), SUM(colC), SUM_ERROR(colC), AVG(colC), AVG_ERROR(colC) FROM test_1
+  auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto *scan_schema = MakeOutputSchema({{"colA", MakeColumnValueExpression(table_info->schema_, 0, "colA")},
+                                        {"colC", MakeColumnValueExpression(table_info->schema_, 0, "colC")}});
+  SeqScanPlanNode scan_plan(scan_schema, nullptr, table_info->oid_);
+  AggregateValueExpression sum_error(false, 2, TypeId::DECIMAL);
+  AggregateValueExpression avg(false, 3, TypeId::DECIMAL);
+  AggregateValueExpression avg_error(false, 4, TypeId::DECIMAL);
+  auto *agg_schema = MakeOutputSchema({{"count", MakeAggregateValueExpression(false, 0)},
+                                       {"sum", MakeAggregateValueExpression(false, 1)},
+                                       {"sum_error", &sum_error},
+                                       {"avg", &avg},
+                                       {"avg_error", &avg_error}});
+  auto run = [&](double sample_rate, uint32_t num_threads) {
+    auto *col_a = MakeColumnValueExpression(*scan_schema, 0, "colA");
+    auto *col_c = MakeColumnValueExpression(*scan_schema, 0, "colC");
+    AggregationPlanNode agg_plan(agg_schema, &scan_plan, nullptr, {}, {col_a, col_c, col_c, col_c, col_c},
+                                 {AggregationType::CountAggregate, AggregationType::SumAggregate,
+                                  AggregationType::SumErrorAggregate, AggregationType::AvgAggregate,
+                                  AggregationType::AvgErrorAggregate},
+                                 sample_rate, 7);
+    GetExecutorContext()->SetNumThreads(num_threads);
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &agg_plan);
+    executor->Init();
+    Tuple tuple;
+    EXPECT_TRUE(executor->Next(&tuple));
+    GetExecutorContext()->SetNumThreads(1);
+    std::vector<double> result;
+    for (uint32_t i = 0; i < 5; i++) {
+      result.push_back(ValueFactory::CastAsDecimal(tuple.GetValue(agg_schema, i)).GetAs<double>());
+    }
+    return result;
+  };
+  auto exact = run(1, 1);
+  EXPECT_EQ(exact[0], TEST1_SIZE);
+  EXPECT_EQ(exact[2], 0);
+  EXPECT_EQ(exact[4], 0);
+  EXPECT_NEAR(exact[3], exact[1] / TEST1_SIZE, 1e-9);
+  for (uint32_t num_threads : {1, 4}) {
+    auto sampled = run(0.3, num_threads);
+    EXPECT_NEAR(sampled[0], TEST1_SIZE, 0.2 * TEST1_SIZE);
+    EXPECT_GT(sampled[2], 0);
+    EXPECT_NEAR(sampled[1], exact[1], 2 * sampled[2]);
+    EXPECT_GT(sampled[4], 0);
+    EXPECT_NEAR(sampled[3], exact[3], 2 * sampled[4]);
+  }
+}
+
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, DistinctTest) {
+  // SELECT DISTINCT colB FROM test_1, with fixed-width keys.
+  auto *test_1 = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto *colb_schema = MakeOutputSchema({{"colB", MakeColumnValueExpression(test_1->schema_, 0, "colB")}});
+  SeqScanPlanNode colb_scan(colb_schema, nullptr, test_1->oid_);
+  DistinctPlanNode colb_distinct(colb_schema, &colb_scan);
+  auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &colb_distinct);
+  executor->Init();
+  std::set<int32_t> colb;
+  Tuple tuple;
+  while (executor->Next(&tuple)) {
+    ASSERT_TRUE(colb.insert(tuple.GetValue(colb_schema, 0).GetAs<int32_t>()).second);
+  }
+  EXPECT_EQ(colb, (std::set<int32_t>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+  // SELECT DISTINCT k, s FROM dups, where each of 700 rows appears 4 or 5 times and some k are NULL.
+  auto *txn = GetExecutorContext()->GetTransaction();
+  Schema schema({Column("k", TypeId::INTEGER), Column("s", TypeId::VARCHAR, 64)});
+  auto *table_info = GetExecutorContext()->GetCatalog()->CreateTable(txn, "dups", schema);
+  const uint32_t num_rows = 3000;
+  const uint32_t num_distinct = 700;
+  RID rid;
+  for (uint32_t i = 0; i < num_rows; i++) {
+    uint32_t row = i * 7919 % num_distinct;
+    Value k = row % 13 == 0 ? ValueFactory::GetNullValueByType(TypeId::INTEGER) : ValueFactory::GetIntegerValue(row);
+    Value s = ValueFactory::GetVarcharValue("value " + std::to_string(row * 31 % 1000));
+    ASSERT_TRUE(table_info->table_->InsertTuple(Tuple({k, s}, &schema), &rid, txn));
+  }
+  auto *scan_schema = MakeOutputSchema({{"k", MakeColumnValueExpression(schema, 0, "k")},
+                                        {"s", MakeColumnValueExpression(schema, 0, "s")}});
+  SeqScanPlanNode scan_plan(scan_schema, nullptr, table_info->oid_);
+  DistinctPlanNode distinct_plan(scan_schema, &scan_plan);
+
+  auto run = [&](size_t memory_budget) {
+    GetExecutorContext()->SetMemoryBudget(memory_budget);
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &distinct_plan);
+    executor->Init();
+    std::vector<std::string> result;
+    Tuple tuple;
+    while (executor->Next(&tuple)) {
+      result.push_back(tuple.ToString(scan_schema));
+    }
+    auto *distinct = dynamic_cast<DistinctExecutor *>(executor.get());
+    return std::make_tuple(result, distinct->GetNumSpilledPages(), distinct->GetPeakMemoryUsage());
+  };
+  auto [in_memory, in_memory_pages, peak_memory] = run(ExecutorContext::DEFAULT_MEMORY_BUDGET);
+  EXPECT_EQ(in_memory_pages, 0);
+  // Rows stream out in the order they are first seen, which is the order of the first 700 input rows.
+  ASSERT_EQ(in_memory.size(), num_distinct);
+  {
+    auto first_rows = table_info->table_->Begin(txn);
+    for (uint32_t i = 0; i < num_distinct; i++, ++first_rows) {
+      ASSERT_EQ(in_memory[i], first_rows->ToString(&schema));
+    }
+  }
+
+  auto [spilled, spilled_pages, spilled_peak_memory] = run(peak_memory / 4);
+  GetExecutorContext()->SetMemoryBudget(ExecutorContext::DEFAULT_MEMORY_BUDGET);
+  EXPECT_GT(spilled_pages, 0);
+  EXPECT_LT(spilled_peak_memory, peak_memory);
+  std::sort(in_memory.begin(), in_memory.end());
+  std::sort(spilled.begin(), spilled.end());
+  EXPECT_EQ(spilled, in_memory);
+
+  // A pass that cannot get a page to spill to while it loads the seen keys fails the query and leaves no page pinned.
+  // The keys agree on the partitioning bits of the first two passes, so the second one spills them all again.
+  const uint32_t shift = sizeof(hash_t) * 8 - 2 * ExternalDistinct::FANOUT_BITS;
+  auto partition_of = [shift](int64_t key) {
+    return PackedKeySet::Hash(reinterpret_cast<const char *>(&key), sizeof(key)) >> shift;
+  };
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; keys.size() < 4000; key++) {
+    if (partition_of(key) == partition_of(0)) {
+      keys.push_back(key);
+    }
+  }
+  BufferPoolManager *bpm = GetExecutorContext()->GetBufferPoolManager();
+  std::vector<page_id_t> pinned;
+  {
+    MemoryTracker tracker;
+    ExternalDistinct external(bpm, 64 * 1024, &tracker);
+    for (int64_t round = 0; round < 2; round++) {
+      for (int64_t key : keys) {
+        external.Insert(reinterpret_cast<const char *>(&key), sizeof(key));
+      }
+    }
+    external.Finish();
+    // Leave a single free frame, which the seen page being loaded takes.
+    page_id_t page_id;
+    while (bpm->NewPage(&page_id) != nullptr) {
+      pinned.push_back(page_id);
+    }
+    ASSERT_TRUE(bpm->UnpinPage(pinned.back(), false));
+    ASSERT_TRUE(bpm->DeletePage(pinned.back()));
+    pinned.pop_back();
+    const char *key;
+    uint32_t size;
+    EXPECT_THROW(
+        {
+          while (external.Next(&key, &size)) {
+          }
+        },
+        Exception);
+  }
+  for (page_id_t page_id : pinned) {
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    ASSERT_TRUE(bpm->DeletePage(page_id));
+  }
+  pinned.resize(bpm->GetPoolSize());
+  for (auto &page_id : pinned) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  for (page_id_t page_id : pinned) {
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    ASSERT_TRUE(bpm->DeletePage(page_id));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, SharedScanTest) {
+  // A table of about 80 pages, over twice the size of the buffer pool.
+  auto *txn = GetExecutorContext()->GetTransaction();
+  // The table is loaded in the order of k, which repeats every id 10 times.
+  Schema schema({Column("id", TypeId::INTEGER), Column("k", TypeId::INTEGER), Column("pad", TypeId::VARCHAR, 128)});
+  auto *table_info = GetExecutorContext()->GetCatalog()->CreateTable(txn, "big", schema);
+  const int32_t num_rows = 2500;
+  RID rid;
+  for (int32_t i = 0; i < num_rows; i++) {
+    Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetIntegerValue(i / 10),
+                 ValueFactory::GetVarcharValue(std::string(100, 'x'))},
+                &schema);
+    ASSERT_TRUE(table_info->table_->InsertTuple(tuple, &rid, txn));
+  }
+  size_t num_pages = table_info->table_->GetNumPages(txn);
+  ASSERT_GT(num_pages, GetExecutorContext()->GetBufferPoolManager()->GetPoolSize() * 2);
+
+  // SELECT id FROM big, twice: the second scan starts when the first one is halfway through the table.
+  auto *scan_schema = MakeOutputSchema({{"id", MakeColumnValueExpression(schema, 0, "id")}});
+  SeqScanPlanNode scan_plan(scan_schema, nullptr, table_info->oid_);
+  auto first = ExecutorFactory::CreateExecutor(GetExecutorContext(), &scan_plan);
+  auto second = ExecutorFactory::CreateExecutor(GetExecutorContext(), &scan_plan);
+  std::vector<int32_t> first_ids;
+  std::vector<int32_t> second_ids;
+  Tuple tuple;
+  first->Init();
+  while (first_ids.size() < num_rows / 2 && first->Next(&tuple)) {
+    first_ids.push_back(tuple.GetValue(scan_schema, 0).GetAs<int32_t>());
+  }
+  int reads = GetDiskManager()->GetNumReads();
+  second->Init();
+  bool first_done = false;
+  bool second_done = false;
+  while (!first_done || !second_done) {
+    if (!first_done && !(first_done = !first->Next(&tuple))) {
+      first_ids.push_back(tuple.GetValue(scan_schema, 0).GetAs<int32_t>());
+    }
+    if (!second_done && !(second_done = !second->Next(&tuple))) {
+      second_ids.push_back(tuple.GetValue(scan_schema, 0).GetAs<int32_t>());
+    }
+  }
+  reads = GetDiskManager()->GetNumReads() - reads;
+
+  // The first scan ran alone at the start, so it reads in table order.
+  std::vector<int32_t> all_ids(num_rows);
+  std::iota(all_ids.begin(), all_ids.end(), 0);
+  EXPECT_EQ(first_ids, all_ids);
+  // The second one attached in the middle of the table and wrapped around to the start.
+  ASSERT_EQ(second_ids.size(), num_rows);
+  EXPECT_GT(second_ids.front(), num_rows / 4);
+  std::sort(second_ids.begin(), second_ids.end());
+  EXPECT_EQ(second_ids, all_ids);
+  // The second half of the table was read once for both scans: the scans together read the table about once, not
+  // one and a half times.
+  EXPECT_LE(reads, num_pages + 2);
+
+  // SELECT k, COUNT(id) FROM big GROUP BY k over a scan that declares the table order, while another scan is halfway
+  // through the table: the ordered scan must not attach, or the stream aggregation would split the groups at the
+  // point where the scan wraps around.
+  auto *ordered_schema = MakeOutputSchema(
+      {{"id", MakeColumnValueExpression(schema, 0, "id")}, {"k", MakeColumnValueExpression(schema, 0, "k")}});
+  SeqScanPlanNode ordered_plan(ordered_schema, nullptr, table_info->oid_);
+  ordered_plan.SetOutputOrdering({1});
+  auto *agg_schema = MakeOutputSchema(
+      {{"k", MakeAggregateValueExpression(true, 0)}, {"count", MakeAggregateValueExpression(false, 0)}});
+  AggregationPlanNode agg_plan(agg_schema, &ordered_plan, nullptr, {MakeColumnValueExpression(*ordered_schema, 0, "k")},
+                               {MakeColumnValueExpression(*ordered_schema, 0, "id")},
+                               {AggregationType::CountAggregate});
+  first = ExecutorFactory::CreateExecutor(GetExecutorContext(), &scan_plan);
+  first->Init();
+  for (int32_t i = 0; i < num_rows / 2; i++) {
+    ASSERT_TRUE(first->Next(&tuple));
+  }
+  auto agg = ExecutorFactory::CreateExecutor(GetExecutorContext(), &agg_plan);
+  ASSERT_NE(dynamic_cast<StreamAggregationExecutor *>(agg.get()), nullptr);
+  agg->Init();
+  std::vector<int32_t> keys;
+  while (agg->Next(&tuple)) {
+    keys.push_back(tuple.GetValue(agg_schema, 0).GetAs<int32_t>());
+    EXPECT_EQ(tuple.GetValue(agg_schema, 1).GetAs<int32_t>(), 10);
+    first->Next(&tuple);
+  }
+  std::vector<int32_t> all_keys(num_rows / 10);
+  std::iota(all_keys.begin(), all_keys.end(), 0);
+  EXPECT_EQ(keys, all_keys);
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, ProjectionPushdownTest) {
+  // SELECT * FROM test_1, test_2 WHERE colA = col1, with scans that output whole rows.
+  auto *catalog = GetExecutorContext()->GetCatalog();
+  auto *table1 = catalog->GetTable("test_1");
+  auto *table2 = catalog->GetTable("test_2");
+  std::vector<std::pair<std::string, const AbstractExpression *>> scan_cols1;
+  for (const auto &col : table1->schema_.GetColumns()) {
+    scan_cols1.emplace_back(col.GetName(), MakeColumnValueExpression(table1->schema_, 0, col.GetName()));
+  }
+  std::vector<std::pair<std::string, const AbstractExpression *>> scan_cols2;
+  for (const auto &col : table2->schema_.GetColumns()) {
+    scan_cols2.emplace_back(col.GetName(), MakeColumnValueExpression(table2->schema_, 0, col.GetName()));
+  }
+  const Schema *scan_schema1 = MakeOutputSchema(scan_cols1);
+  const Schema *scan_schema2 = MakeOutputSchema(scan_cols2);
+  SeqScanPlanNode scan1(scan_schema1, nullptr, table1->oid_);
+  SeqScanPlanNode scan2(scan_schema2, nullptr, table2->oid_);
+  std::vector<std::pair<std::string, const AbstractExpression *>> join_cols;
+  for (const auto &col : scan_schema1->GetColumns()) {
+    join_cols.emplace_back(col.GetName(), MakeColumnValueExpression(*scan_schema1, 0, col.GetName()));
+  }
+  for (const auto &col : scan_schema2->GetColumns()) {
+    join_cols.emplace_back(col.GetName(), MakeColumnValueExpression(*scan_schema2, 1, col.GetName()));
+  }
+  const Schema *join_schema = MakeOutputSchema(join_cols);
+  auto *col_a = MakeColumnValueExpression(*scan_schema1, 0, "colA");
+  auto *col_1 = MakeColumnValueExpression(*scan_schema2, 1, "col1");
+  HashJoinPlanNode join(join_schema, {&scan1, &scan2}, nullptr, {col_a}, {col_1});
+
+  // SELECT colB, SUM(colC) FROM test_1, test_2 WHERE colA = col1 GROUP BY colB
+  auto *col_b = MakeColumnValueExpression(*join_schema, 0, "colB");
+  auto *col_c = MakeColumnValueExpression(*join_schema, 0, "colC");
+  const Schema *agg_schema = MakeOutputSchema(
+      {{"colB", MakeAggregateValueExpression(true, 0)}, {"sum", MakeAggregateValueExpression(false, 0)}});
+  AggregationPlanNode agg(agg_schema, &join, nullptr, {col_b}, {col_c}, {AggregationType::SumAggregate});
+
+  auto run = [&](const AbstractPlanNode *plan) {
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), plan);
+    executor->Init();
+    std::vector<std::string> rows;
+    Tuple tuple;
+    while (executor->Next(&tuple)) {
+      rows.push_back(tuple.ToString(plan->OutputSchema()));
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+  };
+  std::vector<std::string> join_rows = run(&join);
+  std::vector<std::string> agg_rows = run(&agg);
+  ASSERT_EQ(100, join_rows.size());
+
+  // The aggregation reads colB and colC, and the join colA, so the other columns of test_1 are not scanned; test_2
+  // keeps its key.
+  ProjectionPushdown pushdown;
+  EXPECT_EQ(&join, pushdown.Optimize(&join));
+  const AbstractPlanNode *pruned = pushdown.Optimize(&agg);
+  ASSERT_EQ(PlanType::Aggregation, pruned->GetType());
+  const AbstractPlanNode *pruned_join = pruned->GetChildAt(0);
+  EXPECT_EQ(2, pruned_join->OutputSchema()->GetColumnCount());
+  EXPECT_EQ(3, pruned_join->GetChildAt(0)->OutputSchema()->GetColumnCount());
+  EXPECT_EQ(1, pruned_join->GetChildAt(1)->OutputSchema()->GetColumnCount());
+  EXPECT_EQ(agg_rows, run(pruned));
+
+  // With late materialization the join carries only the keys and RIDs, and the rows are fetched after it.
+  ProjectionPushdown late(true);
+  const AbstractPlanNode *root = late.Optimize(&join);
+  ASSERT_EQ(PlanType::LateMaterialize, root->GetType());
+  ASSERT_EQ(PlanType::LateMaterialize, root->GetChildAt(0)->GetType());
+  const AbstractPlanNode *late_join = root->GetChildAt(0)->GetChildAt(0);
+  ASSERT_EQ(PlanType::HashJoin, late_join->GetType());
+  EXPECT_EQ(2, late_join->GetChildAt(0)->OutputSchema()->GetColumnCount());
+  EXPECT_EQ(2, late_join->GetChildAt(1)->OutputSchema()->GetColumnCount());
+  EXPECT_EQ(join_schema->GetColumnCount(), root->OutputSchema()->GetColumnCount());
+  EXPECT_EQ(join_rows, run(root));
+  EXPECT_EQ(agg_rows, run(late.Optimize(&agg)));
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, AsyncFetchTest) {
+  // A table of about 80 pages, over twice the size of the buffer pool, with an index on id.
+  auto *txn = GetExecutorContext()->GetTransaction();
+  auto *catalog = GetExecutorContext()->GetCatalog();
+  auto *bpm = GetExecutorContext()->GetBufferPoolManager();
+  Schema schema({Column("id", TypeId::INTEGER), Column("pad", TypeId::VARCHAR, 128)});
+  auto *table_info = catalog->CreateTable(txn, "big", schema);
+  Schema key_schema({Column("id", TypeId::INTEGER)});
+  IndexInfo *index_info =
+      catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(txn, "big_id", "big", schema, key_schema, {0}, 8);
+  const int32_t num_rows = 2500;
+  RID rid;
+  for (int32_t i = 0; i < num_rows; i++) {
+    Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(100, 'x'))}, &schema);
+    ASSERT_TRUE(table_info->table_->InsertTuple(tuple, &rid, txn));
+    index_info->index_->InsertEntry(Tuple({ValueFactory::GetIntegerValue(i)}, &key_schema), rid, txn);
+  }
+  bpm->FlushAllPages();
+
+  // The first page was evicted by the later ones, so it is read on an I/O thread; fetching it again meanwhile pins
+  // the same frame.
+  page_id_t page_id = table_info->table_->GetFirstPageId();
+  std::shared_future<void> ready;
+  Page *page = bpm->FetchPageAsync(page_id, &ready);
+  ASSERT_NE(page, nullptr);
+  ASSERT_TRUE(ready.valid());
+  std::shared_future<void> ready_again;
+  EXPECT_EQ(page, bpm->FetchPageAsync(page_id, &ready_again));
+  ready.wait();
+  char expected[PAGE_SIZE];
+  GetDiskManager()->ReadPage(page_id, expected);
+  EXPECT_EQ(0, memcmp(expected, page->GetData(), PAGE_SIZE));
+  EXPECT_EQ(page, bpm->FetchPage(page_id));
+  for (int i = 0; i < 3; i++) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // SELECT id FROM big WHERE id IN (0, 7, 14, ...), with synchronous reads and with coroutines.
+  auto *out_schema = MakeOutputSchema({{"id", MakeColumnValueExpression(schema, 0, "id")}});
+  std::vector<std::vector<Value>> keys;
+  for (int32_t i = 0; i < num_rows; i += 7) {
+    keys.push_back({ValueFactory::GetIntegerValue(i)});
+  }
+  IndexScanPlanNode index_plan(out_schema, nullptr, table_info->oid_, index_info->index_oid_, std::move(keys));
+  auto run = [&]() {
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &index_plan);
+    executor->Init();
+    std::vector<int32_t> result;
+    Tuple tuple;
+    while (executor->Next(&tuple)) {
+      result.push_back(tuple.GetValue(out_schema, 0).GetAs<int32_t>());
+    }
+    return result;
+  };
+  std::vector<int32_t> result = run();
+  ASSERT_EQ((num_rows + 6) / 7, result.size());
+  for (size_t i = 0; i < result.size(); i++) {
+    EXPECT_EQ(static_cast<int32_t>(i) * 7, result[i]);
+  }
+  // Builds without BUSTUB_COROUTINES read synchronously either way.
+  GetExecutorContext()->SetMaxInFlightReads(8);
+  EXPECT_EQ(result, run());
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, MaterializedViewTest) {
+  // SELECT region, COUNT(amount), SUM(amount), MIN(amount), MAX(amount) FROM sales GROUP BY region
+  auto *catalog = GetExecutorContext()->GetCatalog();
+  Schema sales_schema({Column("region", TypeId::INTEGER), Column("amount", TypeId::INTEGER)});
+  auto *sales = catalog->CreateTable(GetExecutorContext()->GetTransaction(), "sales", sales_schema);
+  auto insert = [&](Transaction *txn, std::vector<std::vector<Value>> rows) {
+    ExecutorContext exec_ctx(txn, catalog, GetExecutorContext()->GetBufferPoolManager());
+    InsertPlanNode insert_plan{std::move(rows), sales->oid_};
+    auto executor = ExecutorFactory::CreateExecutor(&exec_ctx, &insert_plan);
+    executor->Init();
+    ASSERT_TRUE(executor->Next(nullptr));
+  };
+  std::vector<std::vector<Value>> rows;
+  for (int32_t i = 0; i < 40; i++) {
+    rows.push_back({ValueFactory::GetIntegerValue(i % 4), ValueFactory::GetIntegerValue(i)});
+  }
+  insert(GetExecutorContext()->GetTransaction(), std::move(rows));
+
+  auto *region = MakeColumnValueExpression(sales->schema_, 0, "region");
+  auto *amount = MakeColumnValueExpression(sales->schema_, 0, "amount");
+  const Schema *scan_schema = MakeOutputSchema({{"region", region}, {"amount", amount}});
+  SeqScanPlanNode scan_plan(scan_schema, nullptr, sales->oid_);
+  auto *scan_region = MakeColumnValueExpression(*scan_schema, 0, "region");
+  auto *scan_amount = MakeColumnValueExpression(*scan_schema, 0, "amount");
+  const Schema *agg_schema = MakeOutputSchema(
+      {{"region", MakeAggregateValueExpression(true, 0)}, {"count", MakeAggregateValueExpression(false, 0)},
+       {"sum", MakeAggregateValueExpression(false, 1)}, {"min", MakeAggregateValueExpression(false, 2)},
+       {"max", MakeAggregateValueExpression(false, 3)}});
+  AggregationPlanNode agg_plan(agg_schema, &scan_plan, nullptr, {scan_region},
+                               {scan_amount, scan_amount, scan_amount, scan_amount},
+                               {AggregationType::CountAggregate, AggregationType::SumAggregate,
+                                AggregationType::MinAggregate, AggregationType::MaxAggregate});
+  MaterializedView *view =
+      catalog->CreateMaterializedView(GetExecutorContext()->GetTransaction(), "sales_by_region", &agg_plan);
+  ViewScanPlanNode view_plan(agg_schema, catalog->GetTable("sales_by_region")->oid_);
+
+  // The groups in region order, as strings so that NULLs compare.
+  auto run = [&](const AbstractPlanNode *plan) {
+    std::map<int32_t, std::vector<std::string>> result;
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), plan);
+    executor->Init();
+    Tuple tuple;
+    while (executor->Next(&tuple)) {
+      auto &group = result[tuple.GetValue(agg_schema, 0).GetAs<int32_t>()];
+      for (uint32_t i = 1; i < agg_schema->GetColumnCount(); i++) {
+        group.push_back(tuple.GetValue(agg_schema, i).ToString());
+      }
+    }
+    return result;
+  };
+  auto expected = run(&agg_plan);
+  ASSERT_EQ(4, expected.size());
+  EXPECT_EQ(expected, run(&view_plan));
+
+  // Inserts show up when their transaction commits, and a NULL amount makes SUM, MIN and MAX NULL.
+  Transaction *txn = GetTxnManager()->Begin();
+  Value null_amount = ValueFactory::GetNullValueByType(TypeId::INTEGER);
+  insert(txn, {{ValueFactory::GetIntegerValue(1), ValueFactory::GetIntegerValue(100)},
+               {ValueFactory::GetIntegerValue(7), ValueFactory::GetIntegerValue(5)},
+               {ValueFactory::GetIntegerValue(2), null_amount}});
+  EXPECT_EQ(expected, run(&view_plan));
+  auto scan_before_commit = ExecutorFactory::CreateExecutor(GetExecutorContext(), &view_plan);
+  scan_before_commit->Init();
+  GetTxnManager()->Commit(txn);
+  delete txn;
+  expected = run(&agg_plan);
+  EXPECT_EQ(5, expected.size());
+  EXPECT_EQ(expected, run(&view_plan));
+  // A scan that started before the commit reads the view as it was then.
+  size_t num_groups = 0;
+  Tuple tuple;
+  while (scan_before_commit->Next(&tuple)) {
+    num_groups++;
+  }
+  EXPECT_EQ(4, num_groups);
+  std::vector<Value> aggregates;
+  ASSERT_TRUE(view->Lookup({ValueFactory::GetIntegerValue(1)}, &aggregates));
+  EXPECT_EQ(100, aggregates[3].GetAs<int32_t>());
+  EXPECT_TRUE(view->Lookup({ValueFactory::GetIntegerValue(2)}, &aggregates));
+  EXPECT_TRUE(aggregates[1].IsNull());
+
+  // Deleting the maximum of region 1, the NULL of region 2 and the only row of region 7, and moving the minimum of
+  // region 0 up, in a transaction that aborts and then in one that commits.
+  for (bool commit : {false, true}) {
+    txn = GetTxnManager()->Begin();
+    TableHeap *table = sales->table_.get();
+    std::vector<RID> rids;
+    for (auto it = table->Begin(txn); it != table->End(); ++it) {
+      rids.push_back(it->GetRid());
+    }
+    for (const auto &rid : rids) {
+      Tuple row;
+      ASSERT_TRUE(table->GetTuple(rid, &row, txn));
+      int32_t row_region = row.GetValue(&sales->schema_, 0).GetAs<int32_t>();
+      Value row_amount = row.GetValue(&sales->schema_, 1);
+      if ((row_region == 1 && row_amount.GetAs<int32_t>() == 100) || row_region == 7 || row_amount.IsNull()) {
+        ASSERT_TRUE(table->MarkDelete(rid, txn));
+        view->Delete(row, txn);
+      } else if (row_region == 0 && row_amount.GetAs<int32_t>() == 0) {
+        Tuple new_row({ValueFactory::GetIntegerValue(0), ValueFactory::GetIntegerValue(50)}, &sales->schema_);
+        ASSERT_TRUE(table->UpdateTuple(new_row, rid, txn));
+        view->Update(row, new_row, txn);
+      }
+    }
+    insert(txn, {{ValueFactory::GetIntegerValue(9), ValueFactory::GetIntegerValue(9)}});
+    if (commit) {
+      GetTxnManager()->Commit(txn);
+    } else {
+      GetTxnManager()->Abort(txn);
+    }
+    delete txn;
+    auto after = run(&agg_plan);
+    EXPECT_EQ(after, run(&view_plan));
+    EXPECT_EQ(commit, after != expected);
+  }
+  EXPECT_EQ(5, view->GetNumGroups());
+  EXPECT_FALSE(view->Lookup({ValueFactory::GetIntegerValue(7)}, &aggregates));
+  ASSERT_TRUE(view->Lookup({ValueFactory::GetIntegerValue(0)}, &aggregates));
+  EXPECT_EQ(4, aggregates[2].GetAs<int32_t>());
+
+  // A commit that cannot write the stored rows, as every frame is pinned, makes the view stale rather than wrong:
+  // reading it fails until it can be rebuilt from the base table.
+  txn = GetTxnManager()->Begin();
+  insert(txn, {{ValueFactory::GetIntegerValue(1), ValueFactory::GetIntegerValue(200)},
+               {ValueFactory::GetIntegerValue(11), ValueFactory::GetIntegerValue(3)}});
+  BufferPoolManager *bpm = GetExecutorContext()->GetBufferPoolManager();
+  std::vector<page_id_t> pinned;
+  page_id_t page_id;
+  while (bpm->NewPage(&page_id) != nullptr) {
+    pinned.push_back(page_id);
+  }
+  GetTxnManager()->Commit(txn);
+  delete txn;
+  EXPECT_THROW(view->Lookup({ValueFactory::GetIntegerValue(1)}, &aggregates), Exception);
+  for (page_id_t pinned_id : pinned) {
+    ASSERT_TRUE(bpm->UnpinPage(pinned_id, false));
+    ASSERT_TRUE(bpm->DeletePage(pinned_id));
+  }
+  expected = run(&agg_plan);
+  EXPECT_EQ(6, expected.size());
+  EXPECT_EQ(expected, run(&view_plan));
+  EXPECT_EQ(6, view->GetNumGroups());
+  ASSERT_TRUE(view->Lookup({ValueFactory::GetIntegerValue(1)}, &aggregates));
+  EXPECT_EQ(200, aggregates[3].GetAs<int32_t>());
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, AdmissionControlTest) {
+  auto *catalog = GetExecutorContext()->GetCatalog();
+  auto *txn = GetExecutorContext()->GetTransaction();
+  auto *bpm = GetExecutorContext()->GetBufferPoolManager();
+  catalog->AnalyzeTable(txn, "test_1");
+
+  // SELECT colA, colB FROM test_1 ORDER BY colB reads and holds every row.
+  TableMetadata *table_info = catalog->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto *colA = MakeColumnValueExpression(schema, 0, "colA");
+  auto *colB = MakeColumnValueExpression(schema, 0, "colB");
+  const Schema *scan_schema = MakeOutputSchema({{"colA", colA}, {"colB", colB}});
+  SeqScanPlanNode scan_plan(scan_schema, nullptr, table_info->oid_);
+  SortPlanNode sort_plan(scan_schema, &scan_plan,
+                         {{MakeColumnValueExpression(*scan_schema, 0, "colB"), OrderByType::Asc}});
+  QueryEstimate sort_estimate =
+      AdmissionController::Estimate(&sort_plan, catalog, ExecutorContext::DEFAULT_MEMORY_BUDGET);
+  EXPECT_DOUBLE_EQ(TEST1_SIZE, sort_estimate.rows_);
+  EXPECT_GT(sort_estimate.cpu_cost_, 2 * TEST1_SIZE);
+  EXPECT_EQ(TEST1_SIZE * (scan_schema->GetLength() + AdmissionController::TUPLE_OVERHEAD), sort_estimate.memory_);
+
+  // Only one sort fits in the memory limit at a time.
+  AdmissionController controller(sort_estimate.memory_ * 3 / 2, 4);
+  EXPECT_FALSE(controller.IsPointQuery(sort_estimate));
+  ExecutorContext exec_ctx(txn, catalog, bpm);
+  exec_ctx.SetAdmissionControl(&controller);
+  auto sort_executor = ExecutorFactory::CreateExecutor(&exec_ctx, &sort_plan);
+  ASSERT_NE(nullptr, exec_ctx.GetAdmissionTicket());
+
+  // Two more sorts wait: the high priority one is admitted ahead of the low priority one that came first.
+  std::mutex latch;
+  std::vector<std::string> order;
+  auto admit_sort = [&](QueryPriority priority, const std::string &name) {
+    ExecutorContext sort_ctx(txn, catalog, bpm);
+    sort_ctx.SetAdmissionControl(&controller, priority);
+    ExecutorFactory::CreateExecutor(&sort_ctx, &sort_plan);
+    std::lock_guard<std::mutex> guard(latch);
+    order.push_back(name);
+  };
+  auto wait_for_queue = [&controller](uint64_t waiting) {
+    while (controller.GetStats().waiting_ < waiting) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  };
+  std::thread low(admit_sort, QueryPriority::LOW, "low");
+  wait_for_queue(1);
+  std::thread high(admit_sort, QueryPriority::HIGH, "high");
+  wait_for_queue(2);
+
+  // INSERT INTO empty_table2 VALUES (1, 2) is a point query, which does not wait behind them.
+  InsertPlanNode insert_plan{{{ValueFactory::GetIntegerValue(1), ValueFactory::GetIntegerValue(2)}},
+                             catalog->GetTable("empty_table2")->oid_};
+  ExecutorContext point_ctx(txn, catalog, bpm);
+  point_ctx.SetAdmissionControl(&controller, QueryPriority::LOW);
+  ExecutorFactory::CreateExecutor(&point_ctx, &insert_plan);
+  EXPECT_EQ(1, controller.GetStats().point_queries_);
+
+  sort_executor->Init();
+  Tuple tuple;
+  uint32_t num_tuples = 0;
+  while (sort_executor->Next(&tuple)) {
+    num_tuples++;
+  }
+  EXPECT_EQ(TEST1_SIZE, num_tuples);
+  EXPECT_EQ(2, controller.GetStats().waiting_);
+  exec_ctx.ReleaseAdmission();
+  high.join();
+  low.join();
+  EXPECT_EQ((std::vector<std::string>{"high", "low"}), order);
+
+  AdmissionStats stats = controller.GetStats();
+  EXPECT_EQ(4, stats.admitted_);
+  EXPECT_EQ(0, stats.waiting_);
+  EXPECT_EQ(1, stats.queued_[static_cast<int>(QueryPriority::HIGH)]);
+  EXPECT_EQ(0, stats.queued_[static_cast<int>(QueryPriority::NORMAL)]);
+  EXPECT_EQ(1, stats.queued_[static_cast<int>(QueryPriority::LOW)]);
+  EXPECT_GE(stats.max_queue_wait_[static_cast<int>(QueryPriority::LOW)],
+            stats.max_queue_wait_[static_cast<int>(QueryPriority::HIGH)]);
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, ResultCacheTest) {
+  // SELECT colA, colB FROM test_1 WHERE colA = ?
+  TableMetadata *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  Schema &schema = table_info->schema_;
+  auto *colA = MakeColumnValueExpression(schema, 0, "colA");
+  auto *colB = MakeColumnValueExpression(schema, 0, "colB");
+  auto *out_schema = MakeOutputSchema({{"colA", colA}, {"colB", colB}});
+  auto make_plan = [&](int32_t a) {
+    auto *predicate = MakeComparisonExpression(colA, MakeConstantValueExpression(ValueFactory::GetIntegerValue(a)),
+                                               ComparisonType::Equal);
+    return std::make_unique<SeqScanPlanNode>(out_schema, predicate, table_info->oid_);
+  };
+  auto plan5 = make_plan(5);
+  auto plan7 = make_plan(7);
+
+  // Queries that differ in their constants share a fingerprint.
+  std::vector<Value> params5;
+  std::vector<Value> params7;
+  EXPECT_EQ(ResultCache::Fingerprint(plan5.get(), &params5), ResultCache::Fingerprint(plan7.get(), &params7));
+  ASSERT_EQ(1, params5.size());
+  EXPECT_EQ(5, params5[0].GetAs<int32_t>());
+
+  ResultCache cache;
+  std::vector<Tuple> result;
+  auto col_a = [&](uint32_t i) { return result[i].GetValue(out_schema, 0).GetAs<int32_t>(); };
+  EXPECT_FALSE(cache.Execute(GetExecutorContext(), plan5.get(), &result));
+  ASSERT_EQ(1, result.size());
+  EXPECT_TRUE(cache.Execute(GetExecutorContext(), plan5.get(), &result));
+  ASSERT_EQ(1, result.size());
+  EXPECT_EQ(5, col_a(0));
+  EXPECT_FALSE(cache.Execute(GetExecutorContext(), plan7.get(), &result));
+  EXPECT_TRUE(cache.Execute(GetExecutorContext(), plan7.get(), &result));
+  ASSERT_EQ(1, result.size());
+  EXPECT_EQ(7, col_a(0));
+
+  // INSERT INTO test_1 VALUES (5, 1, 2, 3) runs without the cache and invalidates what read test_1.
+  std::vector<std::vector<Value>> rows{{ValueFactory::GetIntegerValue(5), ValueFactory::GetIntegerValue(1),
+                                        ValueFactory::GetIntegerValue(2), ValueFactory::GetIntegerValue(3)}};
+  InsertPlanNode insert_plan{std::move(rows), table_info->oid_};
+  EXPECT_FALSE(cache.Execute(GetExecutorContext(), &insert_plan, &result));
+  EXPECT_FALSE(cache.Execute(GetExecutorContext(), plan5.get(), &result));
+  EXPECT_EQ(2, result.size());
+  EXPECT_TRUE(cache.Execute(GetExecutorContext(), plan5.get(), &result));
+  EXPECT_EQ(2, result.size());
+
+  ResultCacheStats stats = cache.GetStats();
+  EXPECT_EQ(3, stats.hits_);
+  EXPECT_EQ(3, stats.misses_);
+  EXPECT_EQ(1, stats.invalidations_);
+  EXPECT_EQ(1, stats.uncacheable_);
+  EXPECT_EQ(2, stats.entries_);
+  EXPECT_DOUBLE_EQ(0.5, stats.GetHitRate());
+
+  // A cache with room for one result evicts the least recently used one.
+  ResultCache small_cache(stats.memory_ * 3 / 4);
+  small_cache.Execute(GetExecutorContext(), plan5.get(), &result);
+  small_cache.Execute(GetExecutorContext(), plan7.get(), &result);
+  EXPECT_FALSE(small_cache.Execute(GetExecutorContext(), plan5.get(), &result));
+  EXPECT_EQ(2, small_cache.GetStats().evictions_);
+  EXPECT_EQ(1, small_cache.GetStats().entries_);
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExecutorTest, ScanAbortTest) {
+  // Pin every frame, so that no page of the table can be read.
+  BufferPoolManager *bpm = GetExecutorContext()->GetBufferPoolManager();
+  std::vector<page_id_t> pinned(bpm->GetPoolSize());
+  for (auto &page_id : pinned) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+
+  // SELECT colA FROM test_1 aborts instead of returning an empty result.
+  TableMetadata *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto *out_schema = MakeOutputSchema({{"colA", MakeColumnValueExpression(table_info->schema_, 0, "colA")}});
+  SeqScanPlanNode scan_plan{out_schema, nullptr, table_info->oid_};
+  auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &scan_plan);
+  executor->Init();
+  Tuple tuple;
+  EXPECT_THROW(executor->Next(&tuple), TransactionAbortException);
+  EXPECT_EQ(TransactionState::ABORTED, GetExecutorContext()->GetTransaction()->GetState());
+
+  // So does SELECT colA, COUNT(colA) FROM test_1 GROUP BY colA on several threads.
+  GetExecutorContext()->GetTransaction()->SetState(TransactionState::GROWING);
+  GetExecutorContext()->SetNumThreads(4);
+  AggregationPlanNode agg_plan{MakeOutputSchema({{"colA", MakeAggregateValueExpression(true, 0)},
+                                                 {"countA", MakeAggregateValueExpression(false, 0)}}),
+                               &scan_plan,
+                               nullptr,
+                               {MakeColumnValueExpression(*out_schema, 0, "colA")},
+                               {MakeColumnValueExpression(*out_schema, 0, "colA")},
+                               {AggregationType::CountAggregate}};
+  auto agg_executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &agg_plan);
+  EXPECT_THROW(agg_executor->Init(), TransactionAbortException);
+  EXPECT_EQ(TransactionState::ABORTED, GetExecutorContext()->GetTransaction()->GetState());
+  GetExecutorContext()->SetNumThreads(1);
+
+  // The table iterator ends at once and aborts as well.
+  Transaction txn(1);
+  TableHeap *table = table_info->table_.get();
+  EXPECT_TRUE(table->Begin(&txn) == table->End());
+  EXPECT_EQ(TransactionState::ABORTED, txn.GetState());
+
+  // A profiled scan that aborts stops charging its profile, which goes away with the executor context.
+  GetExecutorContext()->GetTransaction()->SetState(TransactionState::GROWING);
+  GetExecutorContext()->EnableProfiling();
+  auto profiled = ExecutorFactory::CreateExecutor(GetExecutorContext(), &scan_plan);
+  profiled->Init();
+  EXPECT_THROW(profiled->Next(&tuple), TransactionAbortException);
+  EXPECT_EQ(nullptr, BufferPoolManager::SetThreadStats(nullptr));
+
+  for (auto page_id : pinned) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+}
+
 }  // namespace bustub
@@ -19,7 +19,7 @@
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(TmpTuplePageTest, DISABLED_BasicTest) {
+TEST(TmpTuplePageTest, BasicTest) {
   // There are many ways to do this assignment, and this is only one of them.
   // If you don't like the TmpTuplePage idea, please feel free to delete this test case entirely.
   // You will get full credit as long as you are correctly using a linear probe hash table.
@@ -46,6 +46,21 @@ TEST(TmpTuplePageTest, DISABLED_BasicTest) {
   ASSERT_EQ(*reinterpret_cast<uint32_t *>(data + sizeof(page_id_t) + sizeof(lsn_t)), PAGE_SIZE - 8);
   ASSERT_EQ(*reinterpret_cast<uint32_t *>(data + PAGE_SIZE - 8), 4);
   ASSERT_EQ(*reinterpret_cast<uint32_t *>(data + PAGE_SIZE - 4), 123);
+  ASSERT_EQ(tmp_tuple.GetPageId(), page_id);
+  ASSERT_EQ(tmp_tuple.GetOffset(), PAGE_SIZE - 8);
+  ASSERT_EQ(Tuple(page.Get(tmp_tuple.GetOffset())).GetValue(&schema, 0).GetAs<int32_t>(), 123);
+
+  // Fill the page up; the records read back newest first.
+  uint32_t num_inserted = 1;
+  while (page.Insert(tuple, &tmp_tuple)) {
+    num_inserted++;
+  }
+  ASSERT_EQ(num_inserted, (PAGE_SIZE - 12) / 8);
+  for (uint32_t offset = page.GetFreeSpacePointer(); offset < PAGE_SIZE; offset += 8) {
+    ASSERT_EQ(page.Get(offset).GetLength(), 4);
+    num_inserted--;
+  }
+  ASSERT_EQ(num_inserted, 0);
 }
 
 }  // namespace bustub
@@ -21,6 +21,7 @@
 #include "logging/common.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/tuple.h"
+#include "storage/table/tuple_view.h"
 
 namespace bustub {
 // NOLINTNEXTLINE
@@ -71,4 +72,56 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(TupleTest, TupleViewTest) {
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  Column col3{"c", TypeId::BIGINT};
+  Column col4{"d", TypeId::VARCHAR, 16};
+  std::vector<Column> cols{col1, col2, col3, col4};
+  Schema schema{cols};
+  Tuple tuple = ConstructTuple(&schema);
+
+  // A view of an owning tuple sees the same bytes, and VARCHAR values point into them instead of copying.
+  TupleView view = tuple.GetView();
+  ASSERT_EQ(view.GetData(), tuple.GetData());
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    ASSERT_EQ(view.GetValue(&schema, i).CompareEquals(tuple.GetValue(&schema, i)), CmpBool::CmpTrue);
+  }
+  Value varchar = view.GetValue(&schema, 0);
+  ASSERT_GE(varchar.GetData(), tuple.GetData());
+  ASSERT_LT(varchar.GetData(), tuple.GetData() + tuple.GetLength());
+
+  // Materializing into an arena produces the same layout as an owning tuple.
+  Arena arena;
+  std::vector<Value> values;
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    values.push_back(tuple.GetValue(&schema, i));
+  }
+  TupleView materialized = TupleView::Materialize(values, &schema, &arena);
+  ASSERT_EQ(materialized.GetLength(), tuple.GetLength());
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    ASSERT_EQ(materialized.GetValue(&schema, i).CompareEquals(values[i]), CmpBool::CmpTrue);
+  }
+
+  // Copies outlive the source, and non-owning tuples over a view copy nothing.
+  TupleView copy;
+  {
+    Tuple temp = tuple;
+    copy = temp.GetView().CopyTo(&arena);
+  }
+  Tuple wrapped(copy);
+  ASSERT_FALSE(wrapped.IsAllocated());
+  ASSERT_EQ(wrapped.GetData(), copy.GetData());
+  ASSERT_EQ(wrapped.GetValue(&schema, 3).CompareEquals(tuple.GetValue(&schema, 3)), CmpBool::CmpTrue);
+
+  // Large requests get their own block; everything is released at once.
+  char *large = arena.Allocate(Arena::BLOCK_SIZE * 2);
+  memset(large, 0, Arena::BLOCK_SIZE * 2);
+  ASSERT_GE(arena.GetBytesReserved(), arena.GetBytesAllocated());
+  arena.Reset();
+  ASSERT_EQ(arena.GetBytesAllocated(), 0);
+  ASSERT_EQ(arena.GetBytesReserved(), 0);
+}
+
 }  // namespace bustub